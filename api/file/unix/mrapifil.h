@@ -22,6 +22,11 @@ union MFILE_HANDLE {
    MAUG_MHANDLE mem;
 };
 
+#ifdef MFILE_MMAP
+struct MFILE_CADDY;
+void mfile_plt_unmap( struct MFILE_CADDY* p_file );
+#endif /* MFILE_MMAP */
+
 #elif defined( MFILE_C )
 
 #  ifdef RETROFLAT_OS_WASM
@@ -147,33 +152,6 @@ static MERROR_RETVAL _mfile_plt_open(
 ) {
    MERROR_RETVAL retval = MERROR_OK;
 
-#  if defined( MFILE_MMAP )
-
-   in_file = open( filename,
-      MFILE_FLAG_READ_ONLY == (MFILE_FLAG_READ_ONLY & flags) ? O_RDONLY : 0 );
-   if( 0 >= in_file ) {
-      error_printf( "could not open file: %s", filename );
-      retval = MERROR_FILE;
-      goto cleanup;
-   } else {
-      debug_printf( MFILE_SEEK_TRACE_LVL, "opened file: %s", filename );
-   }
-
-   fstat( in_file, &st );
-
-   *p_bytes_ptr_h = 
-      mmap( (caddr_t)0, st.st_size, PROT_READ, MAP_SHARED,  in_file, 0 );
-   maug_cleanup_if_null_alloc( uint8_t*, *p_bytes_ptr_h );
-   *p_bytes_sz = st.st_size;
-
-cleanup:
-
-   if( 0 < in_file ) {
-      close( in_file );
-   }
-
-#  else
-
    p_file->sz = sz;
 
    /* Open the permanent file handle. */
@@ -222,8 +200,6 @@ cleanup:
 
 cleanup:
 
-#  endif /* MFILE_MMAP */
-
    return retval;
 }
 
@@ -269,7 +245,10 @@ MERROR_RETVAL mfile_file_write_block(
 
    cursor = p_f->cursor( p_f );
 
-   if( 0 < p_f->sz && cursor < p_f->sz ) {
+   if(
+      0 < p_f->sz && cursor < p_f->sz &&
+      MFILE_FLAG_OVERWRITE != (MFILE_FLAG_OVERWRITE & p_f->flags)
+   ) {
       /* Grab the rest of the file to shift down if we're not at the end. */
       end_buf_sz = p_f->sz - cursor;
 #if MFILE_WRITE_TRACE_LVL > 0
@@ -310,7 +289,12 @@ MERROR_RETVAL mfile_file_write_block(
       goto cleanup;
    }
 
-   p_f->sz += written;
+   if( MFILE_FLAG_OVERWRITE != (MFILE_FLAG_OVERWRITE & p_f->flags) ) {
+      p_f->sz += written;
+   } else if( cursor + written > p_f->sz ) {
+      /* Overwrote past the end. */
+      p_f->sz = cursor + written;
+   }
 
    if( NULL != end_buf ) {
       cursor += written;
@@ -348,19 +332,84 @@ cleanup:
    return retval;
 }
 
+#  ifdef MFILE_MMAP
+
+static MERROR_RETVAL _mfile_plt_open_mmap(
+   const char* filename, off_t sz, mfile_t* p_file
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   uint8_t* bytes_ptr = NULL;
+   int in_file = -1;
+
+   if( 0 >= sz ) {
+      /* Empty files can't be mapped. */
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   in_file = open( filename, O_RDONLY );
+   if( 0 > in_file ) {
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   bytes_ptr = mmap( NULL, sz, PROT_READ, MAP_PRIVATE, in_file, 0 );
+   if( MAP_FAILED == bytes_ptr ) {
+      error_printf( "could not map file: %s", filename );
+      bytes_ptr = NULL;
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+#     ifdef MADV_SEQUENTIAL
+   /* Most of our parsers read front to back, so ask for aggressive
+    * read-ahead. This is only a hint, so ignore failures.
+    */
+   madvise( bytes_ptr, sz, MADV_SEQUENTIAL );
+#     endif /* MADV_SEQUENTIAL */
+
+   /* Present the mapping as a plain read-only memory buffer. */
+   retval = mfile_lock_buffer( (MAUG_MHANDLE)NULL, bytes_ptr, sz, p_file );
+   maug_cleanup_if_not_ok();
+
+   p_file->flags |= MFILE_FLAG_READ_ONLY | MFILE_FLAG_MMAP;
+
+#if MFILE_SEEK_TRACE_LVL > 0
+   debug_printf( MFILE_SEEK_TRACE_LVL, "mapped file %s (" OFF_T_FMT
+      " bytes) at %p", filename, sz, bytes_ptr );
+#endif /* MFILE_SEEK_TRACE_LVL */
+
+cleanup:
+
+   /* The mapping outlives the descriptor. */
+   if( 0 <= in_file ) {
+      close( in_file );
+   }
+
+   if( MERROR_OK != retval && NULL != bytes_ptr ) {
+      munmap( bytes_ptr, sz );
+   }
+
+   return retval;
+}
+
+/* === */
+
+void mfile_plt_unmap( struct MFILE_CADDY* p_file ) {
+   assert( MFILE_FLAG_MMAP == (MFILE_FLAG_MMAP & p_file->flags) );
+   munmap( p_file->mem_buffer, p_file->sz );
+}
+
 /* === */
 
+#  endif /* MFILE_MMAP */
+
 MERROR_RETVAL mfile_plt_open_read(
    const maug_path filename, mfile_t* p_file
 ) {
    MERROR_RETVAL retval = MERROR_OK;
    size_t st_size = 0;
    maug_path filename_prefixed;
-#  if defined( MFILE_MMAP )
-   uint8_t* bytes_ptr = NULL;
-   struct stat st;
-   int in_file = 0;
-#  endif /* MFILE_MMAP */
 #  ifndef MAUG_NO_STAT
    struct stat file_stat;
    int stat_r = 0;
@@ -399,6 +448,14 @@ MERROR_RETVAL mfile_plt_open_read(
    }
 #  endif /* !MAUG_NO_STAT */
 
+#  if defined( MFILE_MMAP ) && !defined( MAUG_NO_STAT )
+   retval = _mfile_plt_open_mmap( filename_prefixed, st_size, p_file );
+   if( MERROR_OK == retval ) {
+      goto cleanup;
+   }
+   debug_printf( 1, "falling back to stdio for file: %s", filename_prefixed );
+#  endif /* MFILE_MMAP && !MAUG_NO_STAT */
+
    retval = _mfile_plt_open(
       MFILE_FLAG_READ_ONLY, st_size, filename_prefixed, p_file );
    if( MERROR_OK == retval ) {
@@ -2,6 +2,67 @@
 #if !defined( MAUG_API_FON_H_DEFS )
 #define MAUG_API_FON_H_DEFS
 
+/**
+ * \brief Number of color/outline combinations each font keeps a pre-rendered
+ *        glyph atlas for before the least recently used one is evicted.
+ */
+#ifndef RETROFONT_ATLAS_SLOTS
+#  define RETROFONT_ATLAS_SLOTS 4
+#endif /* !RETROFONT_ATLAS_SLOTS */
+
+/**
+ * \brief Number of glyphs past RETROFONT::first_glyph that can be kept in a
+ *        glyph atlas. Glyphs beyond this are drawn directly. Must be a
+ *        multiple of 8.
+ */
+#ifndef RETROFONT_ATLAS_GLYPHS_MAX
+#  define RETROFONT_ATLAS_GLYPHS_MAX 128
+#endif /* !RETROFONT_ATLAS_GLYPHS_MAX */
+
+/**
+ * \brief Number of glyph cells in each row of a glyph atlas bitmap.
+ */
+#ifndef RETROFONT_ATLAS_COLS
+#  define RETROFONT_ATLAS_COLS 16
+#endif /* !RETROFONT_ATLAS_COLS */
+
+/**
+ * \brief Size in pixels of one glyph atlas bitmap for a font with the given
+ *        glyph size. Each cell leaves room for outlines and the closing pixel
+ *        of each glyph "scanline."
+ */
+#define retrofont_atlas_px( glyph_w, glyph_h ) \
+   ((size_t)RETROFONT_ATLAS_COLS * ((glyph_w) + 2) * \
+   ((RETROFONT_ATLAS_GLYPHS_MAX + RETROFONT_ATLAS_COLS - 1) / \
+      RETROFONT_ATLAS_COLS) * ((glyph_h) + 2))
+
+#if !defined( RETROFONT_NO_ATLAS ) && \
+   (0 != RETROFLAT_TXP_R || 0 != RETROFLAT_TXP_G || 0 != RETROFLAT_TXP_B)
+/* Atlas cells are cleared to black, so they only blit cleanly if black is
+ * the transparent color.
+ */
+#  define RETROFONT_NO_ATLAS
+#endif /* !RETROFONT_NO_ATLAS && RETROFLAT_TXP_* */
+
+/**
+ * \brief Bitmap holding every glyph of a ::RETROFONT that has been drawn in a
+ *        given color and outline style, so it can be blitted instead of
+ *        redrawn line-by-line.
+ */
+struct RETROFONT_ATLAS {
+   /*! \brief Color the glyphs in this atlas were drawn in. */
+   RETROFLAT_COLOR color;
+   /*! \brief RETROFONT_FLAG_OUTLINE bits the glyphs were drawn with. */
+   uint8_t flags;
+   /*! \brief Nonzero if RETROFONT_ATLAS::bmp has been created. */
+   uint8_t in_use;
+   /*! \brief Value of RETROFONT::atlas_tick when this atlas was last used. */
+   uint16_t last_used;
+   /*! \brief Bitfield of glyphs that have been drawn into the atlas. */
+   uint8_t drawn[RETROFONT_ATLAS_GLYPHS_MAX / 8];
+   retroflat_blit_t bmp;
+};
+
 struct RETROFONT {
    uint16_t sz;
    uint16_t first_glyph;
@@ -9,6 +70,13 @@ struct RETROFONT {
    uint8_t glyph_w;
    uint8_t glyph_h;
    uint8_t glyph_sz;
+#ifndef RETROFONT_NO_ATLAS
+   /*! \brief Incremented every time a glyph is blitted from an atlas. */
+   uint16_t atlas_tick;
+   /*! \brief Nonzero if creating an atlas failed, so don't try again. */
+   uint8_t atlas_failed;
+   struct RETROFONT_ATLAS atlases[RETROFONT_ATLAS_SLOTS];
+#endif /* !RETROFONT_NO_ATLAS */
 };
 
 #if defined( RETROFNT_C )
@@ -129,6 +197,7 @@ MERROR_RETVAL retrofont_load(
    maug_cleanup_if_null_alloc( struct RETROFONT*, font );
 
    /* Set initial font parameters. */
+   maug_mzero( font, sizeof( struct RETROFONT ) );
    font->sz = sizeof( struct RETROFONT );
    font->first_glyph = first_glyph;
    font->glyph_w = glyph_w;
@@ -298,6 +367,168 @@ static void retrofont_blit_glyph(
 
 /* === */
 
+#ifndef RETROFONT_NO_ATLAS
+
+/**
+ * \brief Get the atlas for glyphs drawn in the given color and outline style,
+ *        creating it (or replacing the least recently used one) if needed.
+ * \return The atlas, or NULL if one could not be created.
+ */
+static struct RETROFONT_ATLAS* retrofont_get_atlas(
+   struct RETROFONT* font, RETROFLAT_COLOR color, uint8_t flags
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t i = 0;
+   struct RETROFONT_ATLAS* atlas = NULL;
+   retroflat_pxxy_t atlas_w = 0;
+   retroflat_pxxy_t atlas_h = 0;
+
+   flags &= RETROFONT_FLAG_OUTLINE_LIGHT;
+
+   for( i = 0 ; RETROFONT_ATLAS_SLOTS > i ; i++ ) {
+      if(
+         font->atlases[i].in_use &&
+         color == font->atlases[i].color &&
+         flags == font->atlases[i].flags
+      ) {
+         atlas = &(font->atlases[i]);
+         goto cleanup;
+      }
+
+      /* Prefer an empty slot, then the one unused for longest. */
+      if(
+         NULL == atlas || (
+            atlas->in_use && (!font->atlases[i].in_use ||
+            (uint16_t)(font->atlas_tick - font->atlases[i].last_used) >
+               (uint16_t)(font->atlas_tick - atlas->last_used))
+         )
+      ) {
+         atlas = &(font->atlases[i]);
+      }
+   }
+
+   if( atlas->in_use ) {
+#if RETROFONT_TRACE_LVL > 0
+      debug_printf( RETROFONT_TRACE_LVL,
+         "evicting glyph atlas for color %d...", atlas->color );
+#endif /* RETROFONT_TRACE_LVL */
+      retroflat_2d_destroy_bitmap( &(atlas->bmp) );
+   }
+   maug_mzero( atlas, sizeof( struct RETROFONT_ATLAS ) );
+
+   /* Leave room in each cell for outlines and the closing pixel of each
+    * glyph "scanline."
+    */
+   atlas_w = RETROFONT_ATLAS_COLS * (font->glyph_w + 2);
+   atlas_h = ((RETROFONT_ATLAS_GLYPHS_MAX + RETROFONT_ATLAS_COLS - 1) /
+      RETROFONT_ATLAS_COLS) * (font->glyph_h + 2);
+
+#if RETROFONT_TRACE_LVL > 0
+   debug_printf( RETROFONT_TRACE_LVL,
+      "creating " PXXY_FMT "x" PXXY_FMT " glyph atlas for color %d...",
+      atlas_w, atlas_h, color );
+#endif /* RETROFONT_TRACE_LVL */
+
+   retval = retroflat_2d_create_bitmap( atlas_w, atlas_h, &(atlas->bmp), 0 );
+   maug_cleanup_if_not_ok();
+
+   /* Clear the atlas to the transparent color. */
+   retroflat_2d_lock_bitmap( &(atlas->bmp) );
+   retroflat_2d_rect( &(atlas->bmp), RETROFLAT_COLOR_BLACK,
+      0, 0, atlas_w, atlas_h, RETROFLAT_DRAW_FLAG_FILL );
+   retroflat_2d_release_bitmap( &(atlas->bmp) );
+
+   atlas->color = color;
+   atlas->flags = flags;
+   atlas->in_use = 1;
+
+cleanup:
+
+   if( MERROR_OK != retval ) {
+      error_printf( "could not create glyph atlas!" );
+      atlas = NULL;
+   }
+
+   return atlas;
+}
+
+#endif /* !RETROFONT_NO_ATLAS */
+
+/* === */
+
+/**
+ * \brief Draw a glyph from the atlas for its color and outline style,
+ *        drawing it into the atlas first if this is its first use.
+ *
+ * Falls back to retrofont_blit_glyph() for glyphs that can't be cached.
+ */
+static void retrofont_blit_glyph_cached(
+   retroflat_blit_t* target, RETROFLAT_COLOR color,
+   char c, struct RETROFONT* font,
+   retroflat_pxxy_t x, retroflat_pxxy_t y, uint8_t flags
+) {
+#ifndef RETROFONT_NO_ATLAS
+   struct RETROFONT_ATLAS* atlas = NULL;
+   size_t glyph_idx = (uint8_t)c - font->first_glyph;
+   retroflat_pxxy_t s_x = 0;
+   retroflat_pxxy_t s_y = 0;
+   uint8_t outline = 0;
+
+   outline = RETROFONT_FLAG_OUTLINE == (RETROFONT_FLAG_OUTLINE & flags);
+
+   if(
+      /* Black is the transparent color, so it can't be kept in an atlas. */
+      RETROFLAT_COLOR_BLACK == color ||
+      RETROFONT_ATLAS_GLYPHS_MAX <= glyph_idx ||
+      /* Outlines start one row above the glyph. */
+      (outline && 0 == y)
+   ) {
+      goto draw_direct;
+   }
+
+   if( font->atlas_failed ) {
+      goto draw_direct;
+   }
+
+   atlas = retrofont_get_atlas( font, color, flags );
+   if( NULL == atlas ) {
+      font->atlas_failed = 1;
+      goto draw_direct;
+   }
+
+   s_x = (glyph_idx % RETROFONT_ATLAS_COLS) * (font->glyph_w + 2);
+   s_y = (glyph_idx / RETROFONT_ATLAS_COLS) * (font->glyph_h + 2);
+
+   if( !(atlas->drawn[glyph_idx >> 3] & (1 << (glyph_idx & 0x07))) ) {
+      /* Draw the glyph one row down in its cell to leave room for outline. */
+      retroflat_2d_lock_bitmap( &(atlas->bmp) );
+      retrofont_blit_glyph(
+         &(atlas->bmp), color, c, font, s_x, s_y + 1, flags );
+      retroflat_2d_release_bitmap( &(atlas->bmp) );
+      atlas->drawn[glyph_idx >> 3] |= (1 << (glyph_idx & 0x07));
+   }
+
+   font->atlas_tick++;
+   atlas->last_used = font->atlas_tick;
+
+   if( outline ) {
+      retroflat_2d_blit_bitmap( target, &(atlas->bmp), s_x, s_y, x, y - 1,
+         font->glyph_w + 2, font->glyph_h + 2, RETROFLAT_INSTANCE_NULL );
+   } else {
+      retroflat_2d_blit_bitmap( target, &(atlas->bmp), s_x, s_y + 1, x, y,
+         font->glyph_w + 2, font->glyph_h, RETROFLAT_INSTANCE_NULL );
+   }
+
+   return;
+
+draw_direct:
+#endif /* !RETROFONT_NO_ATLAS */
+
+   retrofont_blit_glyph( target, color, c, font, x, y, flags );
+}
+
+/* === */
+
 void retrofont_string_indent(
    retroflat_blit_t* target, RETROFLAT_COLOR color,
    const char* str, size_t str_sz,
@@ -350,7 +581,7 @@ void retrofont_string_indent(
 
       /* TODO: More dynamic way to determine space character? */
       if( ' ' != str[i] ) {
-         retrofont_blit_glyph(
+         retrofont_blit_glyph_cached(
             target, color, str[i], font, x_iter, y_iter, flags );
       }
 
@@ -466,6 +697,21 @@ cleanup:
 /* === */
 
 void retrofont_free( MAUG_MHANDLE* p_font_h ) {
+#ifndef RETROFONT_NO_ATLAS
+   struct RETROFONT* font = NULL;
+   size_t i = 0;
+
+   maug_mlock( *p_font_h, font );
+   if( NULL != font ) {
+      for( i = 0 ; RETROFONT_ATLAS_SLOTS > i ; i++ ) {
+         if( font->atlases[i].in_use ) {
+            retroflat_2d_destroy_bitmap( &(font->atlases[i].bmp) );
+         }
+      }
+      maug_munlock( *p_font_h, font );
+   }
+#endif /* !RETROFONT_NO_ATLAS */
+
    maug_mfree( *p_font_h );
 }
 
@@ -20,6 +20,10 @@
 #     include <SDL_getenv.h>
 #  endif /* RETROFLAT_OS_WASM */
 
+#  ifndef RETROFLAT_OS_WASM
+#     define retroflat_sleep_ms( ms ) SDL_Delay( ms )
+#  endif /* !RETROFLAT_OS_WASM */
+
 #  if !defined( RETROFLAT_SOFT_SHAPES )
 #     define RETROFLAT_SOFT_SHAPES
 #  endif /* !RETROFLAT_SOFT_SHAPES */
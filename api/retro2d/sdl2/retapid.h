@@ -20,10 +20,19 @@
 
 #  include <SDL.h>
 
+#  ifndef RETROFLAT_OS_WASM
+#     define retroflat_sleep_ms( ms ) SDL_Delay( ms )
+#  endif /* !RETROFLAT_OS_WASM */
+
 #  if !defined( RETROFLAT_SOFT_SHAPES )
 #     define RETROFLAT_SOFT_SHAPES
 #  endif /* !RETROFLAT_SOFT_SHAPES */
 
+#  ifndef RETROFLAT_OPENGL
+/* Spans become a single line on the bitmap's software renderer. */
+#     define RETROFLAT_NATIVE_SPAN
+#  endif /* !RETROFLAT_OPENGL */
+
 #  if !defined( RETROFLAT_SOFT_LINES )
 /* TODO: Do we need soft lines for this? */
 #     define RETROFLAT_SOFT_LINES
@@ -44,8 +53,16 @@ struct RETROFLAT_BITMAP {
    size_t sz;
    uint8_t flags;
    SDL_Surface* surface;
+   /* Rows of the surface changed since the last texture upload. */
+   int dirty_y1;
+   int dirty_y2;
+   /* Rows of the surface drawn on since retroflat_draw_lock(). */
+   int draw_y1;
+   int draw_y2;
 #  endif /* RETROFLAT_BMP_TEX */
-   /* SDL2 texture pointers. */
+   /* SDL2 texture pointers. The texture is a streaming copy of the surface
+    * for off-screen bitmaps, and the render target for the screen.
+    */
    SDL_Texture* texture;
    SDL_Renderer* renderer;
 };
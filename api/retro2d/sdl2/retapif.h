@@ -49,6 +49,130 @@ cleanup:
    return bmp_out;
 }
 
+/* === */
+
+static void _retroflat_sdl_draw_rows(
+   struct RETROFLAT_BITMAP* bmp, int y, int h
+) {
+   if( NULL == bmp->surface || 0 >= h ) {
+      /* The screen is drawn on directly, so there is nothing to upload. */
+      return;
+   }
+
+   if( bmp->draw_y2 <= bmp->draw_y1 ) {
+      bmp->draw_y1 = y;
+      bmp->draw_y2 = y + h;
+   } else {
+      if( y < bmp->draw_y1 ) {
+         bmp->draw_y1 = y;
+      }
+      if( y + h > bmp->draw_y2 ) {
+         bmp->draw_y2 = y + h;
+      }
+   }
+}
+
+/* === */
+
+static MERROR_RETVAL _retroflat_sdl_create_texture(
+   struct RETROFLAT_BITMAP* bmp
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   uint32_t key = 0;
+
+   assert( NULL != bmp->surface );
+   assert( NULL == bmp->texture );
+
+   /* Color-keyed surfaces become an alpha channel in the texture, which is
+    * what SDL_CreateTextureFromSurface() would do, but this texture is kept
+    * and updated in place.
+    */
+   bmp->texture = SDL_CreateTexture(
+      g_retroflat_state->platform.screen_buffer.renderer,
+      SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+      bmp->surface->w, bmp->surface->h );
+   if( NULL == bmp->texture ) {
+      error_printf( "could not create texture: %s", SDL_GetError() );
+   }
+   maug_cleanup_if_null(
+      SDL_Texture*, bmp->texture, MERROR_GUI );
+
+   if( 0 == SDL_GetColorKey( bmp->surface, &key ) ) {
+      SDL_SetTextureBlendMode( bmp->texture, SDL_BLENDMODE_BLEND );
+   } else {
+      SDL_SetTextureBlendMode( bmp->texture, SDL_BLENDMODE_NONE );
+   }
+
+   /* Upload everything the first time it's blitted. */
+   bmp->dirty_y1 = 0;
+   bmp->dirty_y2 = bmp->surface->h;
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL _retroflat_sdl_upload_texture(
+   struct RETROFLAT_BITMAP* bmp
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   SDL_Rect rows;
+   uint32_t key = 0;
+   int keyed = 0;
+   uint8_t* tex_px = NULL;
+   int tex_pitch = 0;
+   uint32_t* src_row = NULL;
+   uint32_t* tex_row = NULL;
+   int x = 0,
+      y = 0;
+
+   if( bmp->dirty_y2 <= bmp->dirty_y1 ) {
+      /* Texture is up to date. */
+      goto cleanup;
+   }
+
+   assert( SDL_PIXELFORMAT_RGB888 == bmp->surface->format->format );
+
+   rows.x = 0;
+   rows.y = bmp->dirty_y1;
+   rows.w = bmp->surface->w;
+   rows.h = bmp->dirty_y2 - bmp->dirty_y1;
+
+   keyed = (0 == SDL_GetColorKey( bmp->surface, &key ));
+
+   if( 0 != SDL_LockTexture( bmp->texture, &rows, (void**)&tex_px, &tex_pitch ) ) {
+      error_printf( "could not lock texture: %s", SDL_GetError() );
+      retval = MERROR_GUI;
+      goto cleanup;
+   }
+
+   SDL_LockSurface( bmp->surface );
+   for( y = 0 ; rows.h > y ; y++ ) {
+      src_row = (uint32_t*)&(((uint8_t*)(bmp->surface->pixels))[
+         (rows.y + y) * bmp->surface->pitch]);
+      tex_row = (uint32_t*)&(tex_px[y * tex_pitch]);
+      for( x = 0 ; rows.w > x ; x++ ) {
+         if( keyed && (src_row[x] & 0x00ffffff) == (key & 0x00ffffff) ) {
+            tex_row[x] = 0;
+         } else {
+            tex_row[x] = src_row[x] | 0xff000000;
+         }
+      }
+   }
+   SDL_UnlockSurface( bmp->surface );
+
+   SDL_UnlockTexture( bmp->texture );
+
+   bmp->dirty_y1 = 0;
+   bmp->dirty_y2 = 0;
+
+cleanup:
+
+   return retval;
+}
+
 #endif /* !RETROFLAT_OPENGL */
 
 /* === */
@@ -278,6 +402,8 @@ MERROR_RETVAL retroflat_draw_lock( struct RETROFLAT_BITMAP* bmp ) {
    assert( NULL == bmp->renderer );
    assert( NULL != bmp->surface );
    bmp->renderer = SDL_CreateSoftwareRenderer( bmp->surface );
+   bmp->draw_y1 = 0;
+   bmp->draw_y2 = 0;
 
 cleanup:
 #endif /* RETROFLAT_OPENGL */
@@ -333,16 +459,31 @@ MERROR_RETVAL retroflat_draw_release( struct RETROFLAT_BITMAP* bmp ) {
    SDL_DestroyRenderer( bmp->renderer );
    bmp->renderer = NULL;
 
-   /* Scrap the old texture and recreate it from the updated surface. */
-   /* The renderer should be a software renderer pointing to the surface,
-    * created in retroflat_lock() above.
+   /* Mark the rows drawn on for upload the next time the bitmap is blitted
+    * to the screen. If nothing was tracked, the pixels may have been changed
+    * directly, so mark the whole surface.
     */
-   assert( NULL != bmp->texture );
-   SDL_DestroyTexture( bmp->texture );
-   bmp->texture = SDL_CreateTextureFromSurface(
-      g_retroflat_state->platform.screen_buffer.renderer, bmp->surface );
-   maug_cleanup_if_null(
-      SDL_Texture*, bmp->texture, MERROR_GUI );
+   if( bmp->draw_y2 <= bmp->draw_y1 ) {
+      bmp->draw_y1 = 0;
+      bmp->draw_y2 = bmp->surface->h;
+   }
+   if( bmp->dirty_y2 <= bmp->dirty_y1 ) {
+      bmp->dirty_y1 = bmp->draw_y1;
+      bmp->dirty_y2 = bmp->draw_y2;
+   } else {
+      if( bmp->draw_y1 < bmp->dirty_y1 ) {
+         bmp->dirty_y1 = bmp->draw_y1;
+      }
+      if( bmp->draw_y2 > bmp->dirty_y2 ) {
+         bmp->dirty_y2 = bmp->draw_y2;
+      }
+   }
+   if( 0 > bmp->dirty_y1 ) {
+      bmp->dirty_y1 = 0;
+   }
+   if( bmp->surface->h < bmp->dirty_y2 ) {
+      bmp->dirty_y2 = bmp->surface->h;
+   }
 
 cleanup:
 #  endif /* RETROFLAT_OPENGL */
@@ -440,12 +581,9 @@ MERROR_RETVAL retroflat_load_bitmap(
             RETROFLAT_TXP_R, RETROFLAT_TXP_G, RETROFLAT_TXP_B ) );
    }
 
-   /* Create a texture from the surface. */
-   bmp_out->texture = SDL_CreateTextureFromSurface(
-      g_retroflat_state->platform.screen_buffer.renderer, bmp_out->surface );
-   if( NULL == bmp_out->texture ) {
-      error_printf( "SDL unable to create texture: %s", SDL_GetError() );
-      retval = MERROR_GUI;
+   /* Create a texture for the surface. */
+   retval = _retroflat_sdl_create_texture( bmp_out );
+   if( MERROR_OK != retval ) {
       if( NULL != bmp_out->surface ) {
          SDL_FreeSurface( bmp_out->surface );
          bmp_out->surface = NULL;
@@ -506,15 +644,11 @@ MERROR_RETVAL retroflat_create_bitmap(
             RETROFLAT_TXP_R, RETROFLAT_TXP_G, RETROFLAT_TXP_B ) );
    }
 
-   /* Convert new surface to texture. */
-   bmp_out->texture = SDL_CreateTextureFromSurface(
-      g_retroflat_state->platform.screen_buffer.renderer, bmp_out->surface );
-   if( NULL == bmp_out->texture ) {
-      error_printf( "could not create texture: %s", SDL_GetError() );
-   }
-   maug_cleanup_if_null(
-      SDL_Texture*, bmp_out->texture, MERROR_GUI );
-      
+   /* Create a texture for the new surface. */
+   retval = _retroflat_sdl_create_texture( bmp_out );
+   maug_cleanup_if_not_ok();
+
+
 cleanup:
 #  endif /* RETROFLAT_OPENGL */
 
@@ -567,7 +701,6 @@ MERROR_RETVAL retroflat_blit_bitmap(
 #  ifndef RETROFLAT_OPENGL
    SDL_Rect src_rect = { s_x, s_y, w, h };
    SDL_Rect dest_rect = { d_x, d_y, w, h };
-   SDL_Texture* tmp_tex = NULL;
    int is_screen = 0;
 #  endif /* !RETROFLAT_OPENGL */
 
@@ -631,35 +764,33 @@ MERROR_RETVAL retroflat_blit_bitmap(
 
    assert( retroflat_bitmap_locked( target ) );
    
-   if( is_screen ) {
-      tmp_tex = src->texture;
-
-   } else {
-      assert( !retroflat_bitmap_locked( src ) );
-      retroflat_draw_lock( src );
-      /* This little roundabout song-and-dance allows us to copy from a surface
-       * updated by a software renderer (off-screen bitmap) onto another
-       * software renderer (off-screen bitmap) without getting the dreaded
-       * "Texture was not created with this renderer" error.
+   if( !is_screen ) {
+      /* Textures belong to the renderer they were created with, and the
+       * target's software renderer only lasts until it's released. Both
+       * bitmaps are just surfaces underneath, though, so copy the region
+       * directly.
        */
-      tmp_tex = SDL_CreateTexture(
-         target->renderer,
-         SDL_GetWindowPixelFormat( g_retroflat_state->platform.window ),
-         SDL_TEXTUREACCESS_STREAMING,
-         retroflat_bitmap_w( src ),
-         retroflat_bitmap_h( src ) );
-      if( NULL == tmp_tex ) {
-         error_printf(
-            "could not create temporary texture: %s", SDL_GetError() );
+      assert( !retroflat_bitmap_locked( src ) );
+#     if SDL_VERSION_ATLEAST( 2, 0, 10 )
+      SDL_RenderFlush( target->renderer );
+#     endif /* SDL_VERSION_ATLEAST( 2, 0, 10 ) */
+      if( 0 != SDL_BlitSurface(
+         src->surface, &src_rect, target->surface, &dest_rect )
+      ) {
+         error_printf( "could not blit surface: %s", SDL_GetError() );
          retval = MERROR_GUI;
+         goto cleanup;
       }
-      SDL_UpdateTexture(
-         tmp_tex, NULL, src->surface->pixels, src->surface->pitch );
-      retroflat_draw_release( src );
+      _retroflat_sdl_draw_rows( target, d_y, h );
+      goto cleanup;
    }
 
+   /* Bring the source texture up to date if it was drawn on. */
+   retval = _retroflat_sdl_upload_texture( src );
+   maug_cleanup_if_not_ok();
+
    retval = SDL_RenderCopy(
-      target->renderer, tmp_tex, &src_rect, &dest_rect );
+      target->renderer, src->texture, &src_rect, &dest_rect );
    if( 0 != retval ) {
       error_printf( "could not blit surface: %s", SDL_GetError() );
       retval = MERROR_GUI;
@@ -713,12 +844,46 @@ void retroflat_px(
    SDL_SetRenderDrawColor(
       target->renderer,  color->r, color->g, color->b, 255 );
    SDL_RenderDrawPoint( target->renderer, x, y );
+   _retroflat_sdl_draw_rows( target, y, 1 );
 
 #  endif /* RETROFLAT_OPENGL */
 }
 
 /* === */
 
+#  ifdef RETROFLAT_NATIVE_SPAN
+
+void retroflat_span(
+   struct RETROFLAT_BITMAP* target, const RETROFLAT_COLOR color_idx,
+   retroflat_pxxy_t x, retroflat_pxxy_t y, retroflat_pxxy_t w, uint8_t flags
+) {
+   RETROFLAT_COLOR_DEF* color = &(g_retroflat_state->palette[color_idx]);
+
+   if( RETROFLAT_COLOR_NULL == color_idx ) {
+      return;
+   }
+
+   if( NULL == target ) {
+      target = retroflat_screen_buffer();
+   }
+
+   if( retroflat_bitmap_has_flags( target, RETROFLAT_BITMAP_FLAG_RO ) ) {
+      return;
+   }
+
+   assert( retroflat_bitmap_locked( target ) );
+   assert( 0 < w );
+
+   SDL_SetRenderDrawColor(
+      target->renderer,  color->r, color->g, color->b, 255 );
+   SDL_RenderDrawLine( target->renderer, x, y, x + w - 1, y );
+   _retroflat_sdl_draw_rows( target, y, 1 );
+}
+
+/* === */
+
+#  endif /* RETROFLAT_NATIVE_SPAN */
+
 #  ifndef RETROFLAT_SOFT_SHAPES
 
 void retroflat_rect(
@@ -774,6 +939,8 @@ void retroflat_rect(
       SDL_RenderDrawRect( target->renderer, &area );
    }
 
+   _retroflat_sdl_draw_rows( target, y, h );
+
 #  endif /* RETROFLAT_OPENGL */
 }
 
@@ -829,6 +996,12 @@ void retroflat_line(
    SDL_SetRenderDrawColor(
       target->renderer, color->r, color->g, color->b, 255 );
    SDL_RenderDrawLine( target->renderer, x1, y1, x2, y2 );
+
+   if( y1 < y2 ) {
+      _retroflat_sdl_draw_rows( target, y1, (y2 - y1) + 1 );
+   } else {
+      _retroflat_sdl_draw_rows( target, y2, (y1 - y2) + 1 );
+   }
  
 #  endif /* RETROFLAT_OPENGL */
 }
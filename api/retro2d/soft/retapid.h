@@ -0,0 +1,157 @@
+
+#ifndef RETPLTD_H
+#define RETPLTD_H
+
+/**
+ * \file retpltd.h
+ * \brief RetroFlat platform definition header.
+ *
+ * This is a headless platform that draws into 8-bit indexed buffers in
+ * memory. It doesn't need a display, so it's useful for profiling the drawing
+ * code and for comparing rendered frames against known-good images. The
+ * screen buffer can be dumped to a bitmap every few frames with the -rfd
+ * argument or RETROFLAT_PLATFORM_ARGS::dump_every.
+ */
+
+#define RETROPLAT_PRESENT 1
+
+#define RETROFLAT_SOFT_VIEWPORT
+#define RETROFLAT_NO_VIEWPORT_REFRESH
+
+#define RETROFLAT_SOFT_SHAPES
+
+#define RETROFLAT_SOFT_LINES
+
+#define RETROFLAT_NATIVE_SPAN
+
+#define RETROFLAT_LOAD_BITMAP_GENERIC 1
+
+#include <time.h>
+
+#ifndef RETROFLAT_SOFT_TRACE_LVL
+#  define RETROFLAT_SOFT_TRACE_LVL 0
+#endif /* !RETROFLAT_SOFT_TRACE_LVL */
+
+/**
+ * \brief Format used to build the filename of each screen dump. It is passed
+ *        the number of the frame being dumped.
+ */
+#ifndef RETROFLAT_SOFT_DUMP_FMT
+#  define RETROFLAT_SOFT_DUMP_FMT "frame" U32_FMT ".bmp"
+#endif /* !RETROFLAT_SOFT_DUMP_FMT */
+
+/**
+ * \addtogroup maug_retroflt_bitmap
+ * \{
+ */
+
+/**
+ * \brief Platform-specific bitmap structure. retroflat_bitmap_ok() can be
+ *        used on a pointer to it to determine if a valid bitmap is loaded.
+ *
+ * Please see the \ref maug_retroflt_bitmap for more information.
+ */
+struct RETROFLAT_BITMAP {
+   /*! \brief Size of the bitmap structure, used to check VDP compatibility. */
+   size_t sz;
+   /*! \brief Platform-specific bitmap flags. */
+   uint8_t flags;
+   /*! \brief Palette index of each pixel, row by row from the top. */
+   uint8_t* px;
+   retroflat_pxxy_t w;
+   retroflat_pxxy_t h;
+};
+
+/**
+ * \relates RETROFLAT_BITMAP
+ * \brief Check to see if a bitmap is loaded.
+ */
+#  define retroflat_bitmap_ok( bitmap ) (NULL != (bitmap)->px)
+
+/**
+ * \relates RETROFLAT_BITMAP
+ * \brief Check to see if a bitmap is currently locked.
+ */
+#  define retroflat_bitmap_locked( bitmap ) (0)
+
+/**
+ * \relates RETROFLAT_BITMAP
+ * \brief Get the width of this bitmap using underlying mechanisms.
+ * \warn The bitmap must be valid!
+ */
+#  define retroflat_bitmap_w( bitmap ) ((bitmap)->w)
+
+/**
+ * \relates RETROFLAT_BITMAP
+ * \brief Get the height of this bitmap using underlying mechanisms.
+ * \warn The bitmap must be valid!
+ */
+#  define retroflat_bitmap_h( bitmap ) ((bitmap)->h)
+
+/*! \} */ /* maug_retroflt_bitmap */
+
+/*! \brief Get the current screen width in pixels. */
+#  define retroflat_screen_w() (g_retroflat_state->screen_v_w)
+
+/*! \brief Get the current screen height in pixels. */
+#  define retroflat_screen_h() (g_retroflat_state->screen_v_h)
+
+/*! \brief Get the direct screen buffer or the VDP buffer if a VDP is loaded. */
+#  define retroflat_screen_buffer() \
+      (&(g_retroflat_state->platform.screen_buffer))
+
+/*! \brief Lock a surface for pixel drawing if needed. */
+#  define retroflat_px_lock( bmp )
+
+/*! \brief Release a surface for pixel drawing if needed. */
+#  define retroflat_px_release( bmp )
+
+/**
+ * \brief This should be called in order to quit a program using RetroFlat.
+ * \param retval The return value to pass back to the operating system.
+ */
+#  define retroflat_quit( retval_in ) \
+      debug_printf( 1, "quit called, retval: %d", retval_in ); \
+      g_retroflat_state->retroflat_flags &= ~RETROFLAT_STATE_FLAG_RUNNING; \
+      g_retroflat_state->retval = retval_in;
+
+/*! \brief Defined for backward-compatibility with Allegro. */
+#  define END_OF_MAIN()
+
+/**
+ * \addtogroup maug_retroflt_drawing
+ * \{
+ *
+ * \addtogroup maug_retroflt_color RetroFlat Colors
+ * \brief Color definitions RetroFlat is aware of, for use with the
+ *        \ref maug_retroflt_drawing.
+ *
+ * The precise type and values of these constants vary by platform.
+ *
+ * \{
+ */
+
+/*! \brief 0x00RRGGBB, only used when dumping the screen to a bitmap. */
+typedef uint32_t RETROFLAT_COLOR_DEF;
+
+/*! \} */ /* maug_retroflt_color */
+
+/*! \} */ /* maug_retroflt_drawing */
+
+struct RETROFLAT_PLATFORM_ARGS {
+   uint8_t flags;
+   /*! \brief Dump the screen to a bitmap every this many frames if > 0. */
+   uint32_t dump_every;
+};
+
+struct RETROFLAT_PLATFORM {
+   uint8_t flags;
+   struct RETROFLAT_BITMAP screen_buffer;
+   uint32_t s_launch;
+   /*! \brief Number of times the screen has been released so far. */
+   uint32_t frames;
+   uint32_t dump_every;
+};
+
+#endif /* !RETPLTD_H */
+
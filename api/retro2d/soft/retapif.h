@@ -0,0 +1,501 @@
+
+#ifndef RETPLTF_H
+#define RETPLTF_H
+
+#define RETROFLAT_SOFT_BMP_HDR_SZ 54
+
+static MERROR_RETVAL retroflat_cli_rfd(
+   const char* arg, ssize_t arg_c, struct RETROFLAT_ARGS* args
+) {
+   if( 1 < arg_c ) {
+      args->platform.dump_every = atoi( arg );
+      debug_printf( 3, "dumping screen every " U32_FMT " frames",
+         args->platform.dump_every );
+   }
+   return MERROR_OK;
+}
+
+/* === */
+
+static void _retroflat_soft_u32_lsbf( uint8_t* buf, uint32_t val ) {
+   buf[0] = val & 0xff;
+   buf[1] = (val >> 8) & 0xff;
+   buf[2] = (val >> 16) & 0xff;
+   buf[3] = (val >> 24) & 0xff;
+}
+
+/* === */
+
+/**
+ * \brief Write an indexed bitmap to an uncompressed 8-bit BMP file, with the
+ *        current palette as its color table.
+ */
+static MERROR_RETVAL _retroflat_soft_dump_bmp(
+   struct RETROFLAT_BITMAP* bmp, const maug_path path
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   mfile_t bmp_file;
+   uint8_t hdr[RETROFLAT_SOFT_BMP_HDR_SZ];
+   uint8_t pal_entry[4];
+   uint8_t pad[4];
+   uint32_t row_sz = 0;
+   uint32_t pal_sz = RETROFLAT_COLORS_CT_MAX * 4;
+   size_t i = 0;
+   retroflat_pxxy_t y = 0;
+
+   maug_mzero( &bmp_file, sizeof( mfile_t ) );
+   maug_mzero( hdr, RETROFLAT_SOFT_BMP_HDR_SZ );
+   maug_mzero( pad, 4 );
+
+   /* BMP rows are padded out to 4 bytes. */
+   row_sz = (bmp->w + 3) & ~3;
+
+   hdr[0] = 'B';
+   hdr[1] = 'M';
+   _retroflat_soft_u32_lsbf( &(hdr[2]),
+      RETROFLAT_SOFT_BMP_HDR_SZ + pal_sz + (row_sz * bmp->h) );
+   _retroflat_soft_u32_lsbf( &(hdr[10]), RETROFLAT_SOFT_BMP_HDR_SZ + pal_sz );
+   _retroflat_soft_u32_lsbf( &(hdr[14]), 40 );
+   _retroflat_soft_u32_lsbf( &(hdr[18]), bmp->w );
+   /* Positive height means rows are stored bottom-up. */
+   _retroflat_soft_u32_lsbf( &(hdr[22]), bmp->h );
+   hdr[26] = 1; /* Planes */
+   hdr[28] = 8; /* BPP */
+   _retroflat_soft_u32_lsbf( &(hdr[34]), row_sz * bmp->h );
+   _retroflat_soft_u32_lsbf( &(hdr[46]), RETROFLAT_COLORS_CT_MAX );
+
+   retval = mfile_open_write( path, &bmp_file );
+   maug_cleanup_if_not_ok();
+
+   retval = bmp_file.write_block( &bmp_file, hdr, RETROFLAT_SOFT_BMP_HDR_SZ );
+   maug_cleanup_if_not_ok();
+
+   for( i = 0 ; RETROFLAT_COLORS_CT_MAX > i ; i++ ) {
+      /* Palette entries are stored as BGR0. */
+      pal_entry[0] = g_retroflat_state->palette[i] & 0xff;
+      pal_entry[1] = (g_retroflat_state->palette[i] >> 8) & 0xff;
+      pal_entry[2] = (g_retroflat_state->palette[i] >> 16) & 0xff;
+      pal_entry[3] = 0;
+      retval = bmp_file.write_block( &bmp_file, pal_entry, 4 );
+      maug_cleanup_if_not_ok();
+   }
+
+   for( y = bmp->h - 1 ; 0 <= y ; y-- ) {
+      retval = bmp_file.write_block(
+         &bmp_file, &(bmp->px[(size_t)y * bmp->w]), bmp->w );
+      maug_cleanup_if_not_ok();
+      if( row_sz > (uint32_t)bmp->w ) {
+         retval = bmp_file.write_block( &bmp_file, pad, row_sz - bmp->w );
+         maug_cleanup_if_not_ok();
+      }
+   }
+
+   debug_printf( RETROFLAT_SOFT_TRACE_LVL, "dumped bitmap to: %s", path );
+
+cleanup:
+
+   mfile_close( &bmp_file );
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL retroflat_init_platform(
+   int argc, char* argv[], struct RETROFLAT_ARGS* args
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+#  ifdef RETROFLAT_OS_UNIX
+   struct timespec spec;
+#  endif /* RETROFLAT_OS_UNIX */
+   time_t tm;
+
+   /* There's no window to scale up to, so the buffer is the virtual size. */
+   retval = retroflat_create_bitmap(
+      g_retroflat_state->screen_v_w, g_retroflat_state->screen_v_h,
+      &(g_retroflat_state->platform.screen_buffer),
+      RETROFLAT_BITMAP_FLAG_OPAQUE );
+   maug_cleanup_if_not_ok();
+
+   g_retroflat_state->platform.dump_every = args->platform.dump_every;
+
+#  ifdef RETROFLAT_OS_UNIX
+   clock_gettime( CLOCK_MONOTONIC, &spec );
+   g_retroflat_state->platform.s_launch = spec.tv_sec;
+#  endif /* RETROFLAT_OS_UNIX */
+
+   srand( (unsigned int)time( &tm ) );
+
+#  define RETROFLAT_COLOR_TABLE_SOFT( idx, name_l, name_u, rd, gd, bd, cgac, cgad ) \
+      g_retroflat_state->palette[idx] = \
+         (((rd) & 0xff) << 16) | (((gd) & 0xff) << 8) | ((bd) & 0xff);
+   RETROFLAT_COLOR_TABLE( RETROFLAT_COLOR_TABLE_SOFT )
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+void retroflat_shutdown_platform( MERROR_RETVAL retval ) {
+   if( retroflat_bitmap_ok( &(g_retroflat_state->platform.screen_buffer) ) ) {
+      retroflat_destroy_bitmap( &(g_retroflat_state->platform.screen_buffer) );
+   }
+}
+
+/* === */
+
+MERROR_RETVAL retroflat_loop(
+   retroflat_loop_iter frame_iter, retroflat_loop_iter loop_iter, void* data
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+
+   /* Just skip to the generic loop. */
+   retval = retroflat_loop_generic( frame_iter, loop_iter, data );
+
+   /* This should be set by retroflat_quit(). */
+   return retval;
+}
+
+/* === */
+
+void retroflat_message(
+   uint8_t flags, const char* title, const char* format, ...
+) {
+   char msg_out[RETROFLAT_MSG_MAX + 1];
+   va_list vargs;
+
+   maug_mzero( msg_out, RETROFLAT_MSG_MAX + 1 );
+   va_start( vargs, format );
+   maug_vsnprintf( msg_out, RETROFLAT_MSG_MAX, format, vargs );
+
+   /* There's nowhere else to show it. */
+   error_printf( "%s: %s", title, msg_out );
+
+   va_end( vargs );
+}
+
+/* === */
+
+void retroflat_set_title( const char* format, ... ) {
+   /* Platform has no window to title. */
+}
+
+/* === */
+
+retroflat_ms_t retroflat_get_ms( void ) {
+#  ifdef RETROFLAT_OS_UNIX
+   struct timespec spec;
+   uint32_t ms_out = 0,
+      ms_launch_delta = 0;
+
+   clock_gettime( CLOCK_MONOTONIC, &spec );
+
+   /* Get the seconds since program launched. Multiply by 1000, so we want a
+    * smaller number than seconds since the epoch. */
+   ms_launch_delta = spec.tv_sec - g_retroflat_state->platform.s_launch;
+   ms_out += ms_launch_delta * 1000;
+   ms_out += spec.tv_nsec / 1000000;
+
+   return ms_out;
+#  else
+   return (retroflat_ms_t)(((uint32_t)clock() * 1000) / CLOCKS_PER_SEC);
+#  endif /* RETROFLAT_OS_UNIX */
+}
+
+/* === */
+
+uint32_t retroflat_get_rand( void ) {
+   return rand();
+}
+
+/* === */
+
+MERROR_RETVAL retroflat_draw_lock( struct RETROFLAT_BITMAP* bmp ) {
+   /* Bitmaps are always in memory, so there's nothing to lock. */
+   return MERROR_OK;
+}
+
+/* === */
+
+MERROR_RETVAL retroflat_draw_release( struct RETROFLAT_BITMAP* bmp ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   maug_path dump_path;
+
+   if( NULL != bmp && retroflat_screen_buffer() != bmp ) {
+      goto cleanup;
+   }
+
+   /* Releasing the screen is where a frame would be presented. */
+   g_retroflat_state->platform.frames++;
+
+   if(
+      0 == g_retroflat_state->platform.dump_every ||
+      0 != g_retroflat_state->platform.frames %
+         g_retroflat_state->platform.dump_every
+   ) {
+      goto cleanup;
+   }
+
+   maug_mzero( dump_path, sizeof( maug_path ) );
+   maug_snprintf( dump_path, MAUG_PATH_SZ_MAX - 1, RETROFLAT_SOFT_DUMP_FMT,
+      g_retroflat_state->platform.frames );
+
+   retval = _retroflat_soft_dump_bmp( retroflat_screen_buffer(), dump_path );
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL retroflat_load_bitmap_px_cb(
+   void* data, uint8_t px, int32_t x, int32_t y,
+   void* header_info, uint8_t flags
+) {
+   struct RETROFLAT_BITMAP* b = (struct RETROFLAT_BITMAP*)data;
+
+   if(
+      MFMT_PX_FLAG_NEW_LINE != (MFMT_PX_FLAG_NEW_LINE & flags) &&
+      0 <= x && 0 <= y && b->w > x && b->h > y
+   ) {
+      b->px[((size_t)y * b->w) + x] = px;
+   }
+
+   return MERROR_OK;
+}
+
+/* === */
+
+MERROR_RETVAL retroflat_create_bitmap(
+   retroflat_pxxy_t w, retroflat_pxxy_t h,
+   struct RETROFLAT_BITMAP* bmp_out, uint8_t flags
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+
+   maug_mzero( bmp_out, sizeof( struct RETROFLAT_BITMAP ) );
+
+   bmp_out->sz = sizeof( struct RETROFLAT_BITMAP );
+
+   bmp_out->flags = flags;
+
+   if( 0 >= w || 0 >= h ) {
+      error_printf( "invalid bitmap size: %d x %d", w, h );
+      retval = MERROR_GUI;
+      goto cleanup;
+   }
+
+   /* Zeroed pixels start out as the transparent color. */
+   bmp_out->px = calloc( (size_t)w * h, 1 );
+   if( NULL == bmp_out->px ) {
+      error_printf( "could not allocate bitmap pixels!" );
+      retval = MERROR_ALLOC;
+      goto cleanup;
+   }
+   bmp_out->w = w;
+   bmp_out->h = h;
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+void retroflat_destroy_bitmap( struct RETROFLAT_BITMAP* bmp ) {
+
+   if( NULL != bmp->px ) {
+      free( bmp->px );
+   }
+   bmp->px = NULL;
+   bmp->w = 0;
+   bmp->h = 0;
+
+}
+
+/* === */
+
+MERROR_RETVAL retroflat_blit_bitmap(
+   struct RETROFLAT_BITMAP* target, struct RETROFLAT_BITMAP* src,
+   retroflat_pxxy_t s_x, retroflat_pxxy_t s_y,
+   retroflat_pxxy_t d_x, retroflat_pxxy_t d_y,
+   retroflat_pxxy_t w, retroflat_pxxy_t h,
+   int16_t instance
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   retroflat_pxxy_t x = 0,
+      y = 0;
+   uint8_t* src_row = NULL;
+   uint8_t* tgt_row = NULL;
+
+   assert( NULL != src );
+
+   if( NULL == target || retroflat_screen_buffer() == target ) {
+      target = retroflat_screen_buffer();
+
+      retval = _retroview_hwscroll( &d_x, &d_y, w, h, instance );
+      maug_cleanup_if_not_ok();
+   }
+
+   if(
+      RETROFLAT_BITMAP_FLAG_RO == (RETROFLAT_BITMAP_FLAG_RO & target->flags)
+   ) {
+      retval = MERROR_GUI;
+      goto cleanup;
+   }
+
+   /* Trim sprite to stay on-screen. */
+   retval = _retroview_trim_px(
+      target, instance, &s_x, &s_y, &d_x, &d_y, &w, &h );
+   maug_cleanup_if_not_ok();
+
+   /* The trim above only covers the target, so keep inside the source too. */
+   if( s_x + w > src->w ) {
+      w = src->w - s_x;
+   }
+   if( s_y + h > src->h ) {
+      h = src->h - s_y;
+   }
+   if( 0 >= w || 0 >= h || 0 > s_x || 0 > s_y ) {
+      goto cleanup;
+   }
+
+   assert( d_x >= 0 );
+   assert( d_y >= 0 );
+   assert( d_x < retroflat_bitmap_w( target ) );
+   assert( d_y < retroflat_bitmap_h( target ) );
+
+   for( y = 0 ; h > y ; y++ ) {
+      src_row = &(src->px[((size_t)(s_y + y) * src->w) + s_x]);
+      tgt_row = &(target->px[((size_t)(d_y + y) * target->w) + d_x]);
+      if(
+         RETROFLAT_BITMAP_FLAG_OPAQUE ==
+         (RETROFLAT_BITMAP_FLAG_OPAQUE & src->flags)
+      ) {
+         /* Bitmap is opaque, so copy the whole row. The source may be the
+          * target, so allow for overlap.
+          */
+         memmove( tgt_row, src_row, w );
+         continue;
+      }
+
+      /* Bitmap is transparent, so skip transparent pixels. */
+      for( x = 0 ; w > x ; x++ ) {
+         if( RETROFLAT_TXP_PAL_IDX != src_row[x] ) {
+            tgt_row[x] = src_row[x];
+         }
+      }
+   }
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+void retroflat_px(
+   struct RETROFLAT_BITMAP* target, const RETROFLAT_COLOR color_idx,
+   retroflat_pxxy_t x, retroflat_pxxy_t y, uint8_t flags
+) {
+   if( RETROFLAT_COLOR_NULL == color_idx ) {
+      return;
+   }
+
+   if( NULL == target ) {
+      target = retroflat_screen_buffer();
+   }
+
+   if(
+      RETROFLAT_BITMAP_FLAG_RO == (RETROFLAT_BITMAP_FLAG_RO & target->flags)
+   ) {
+      return;
+   }
+
+   retroflat_viewport_constrain_px( x, y, target, return );
+
+   target->px[((size_t)y * target->w) + x] = (uint8_t)color_idx;
+}
+
+/* === */
+
+void retroflat_span(
+   struct RETROFLAT_BITMAP* target, const RETROFLAT_COLOR color_idx,
+   retroflat_pxxy_t x, retroflat_pxxy_t y, retroflat_pxxy_t w, uint8_t flags
+) {
+   if( RETROFLAT_COLOR_NULL == color_idx ) {
+      return;
+   }
+
+   if( NULL == target ) {
+      target = retroflat_screen_buffer();
+   }
+
+   if(
+      RETROFLAT_BITMAP_FLAG_RO == (RETROFLAT_BITMAP_FLAG_RO & target->flags)
+   ) {
+      return;
+   }
+
+   assert( 0 <= x && 0 <= y && 0 < w );
+   assert( x + w <= target->w && y < target->h );
+
+   memset( &(target->px[((size_t)y * target->w) + x]), (uint8_t)color_idx, w );
+}
+
+/* === */
+
+void retroflat_get_palette( uint8_t idx, uint32_t* p_rgb ) {
+   *p_rgb = g_retroflat_state->palette[idx];
+}
+
+/* === */
+
+MERROR_RETVAL retroflat_set_palette( uint8_t idx, uint32_t rgb ) {
+
+   debug_printf( RETROFLAT_SOFT_TRACE_LVL,
+      "setting palette #%u to " X32_FMT "...", idx, rgb );
+
+   /* Pixels are stored as indexes, so this changes them all at once. */
+   g_retroflat_state->palette[idx] = rgb & 0xffffff;
+
+   return MERROR_OK;
+}
+
+/* === */
+
+void retroflat_resize_v( void ) {
+   /* Platform does not support resizing. */
+}
+
+/* === */
+
+uint8_t retroflat_focus_platform( void ) {
+   /* Nothing else can take focus from a headless platform. */
+   return RETROFLAT_FOCUS_FLAG_VISIBLE | RETROFLAT_FOCUS_FLAG_ACTIVE;
+}
+
+/* === */
+
+uint8_t retroview_move_x( retroflat_pxxy_t x ) {
+   uint8_t move; /* Really a boolean. */
+
+   _retroview_move_xy( x, move, x, w, RETROFLAT_TILE_W );
+
+   return move;
+}
+
+/* === */
+
+uint8_t retroview_move_y( retroflat_pxxy_t y ) {
+   uint8_t move; /* Really a boolean. */
+
+   _retroview_move_xy( y, move, y, h, RETROFLAT_TILE_H );
+
+   return move;
+}
+
+#endif /* !RETPLTF_H */
+
@@ -8,6 +8,20 @@
 #define MSERIALIZE_ASN_TYPE_SEQUENCE   0x30
 #define MSERIALIZE_ASN_TYPE_REAL       0x09
 
+/**
+ * \brief Application-specific ASN type for vectors of fixed-size integers.
+ *
+ * Packed vectors are written as a single header, followed by the element
+ * width (1 byte), the element count (4 bytes, LSBF), and the raw elements
+ * themselves, LSBF. mserialize_vector() uses this automatically for vectors
+ * serialized with the (u)int8/16/32_t callbacks unless MSERIALIZE_NO_PACKED
+ * is defined. mdeserialize_vector() always understands it.
+ */
+#define MSERIALIZE_ASN_TYPE_PACKED     0x44
+
+/*! \brief Size of the width and count fields preceding packed elements. */
+#define MSERIALIZE_PACKED_HDR_SZ       5
+
 #elif defined( MSERIAL_C )
 
 static MERROR_RETVAL _mserialize_asn_int_value(
@@ -90,6 +104,36 @@ MERROR_RETVAL _mserialize_asn_sz( mfile_t* ser_out, size_t sz ) {
 
 /* === */
 
+static size_t _mserialize_asn_sz_sz( size_t sz ) {
+   if( 127 < sz ) {
+      return 1 + _mserialize_asn_get_int_sz( sz );
+   } else {
+      return 1;
+   }
+}
+
+/* === */
+
+static size_t _mserialize_asn_sz_buf( uint8_t* buf, size_t sz ) {
+   int8_t sz_of_sz = 0;
+   int8_t i = 0;
+
+   if( 127 < sz ) {
+      /* Same layout as _mserialize_asn_sz(), but straight into memory. */
+      sz_of_sz = _mserialize_asn_get_int_sz( sz );
+      buf[0] = 0x80 | sz_of_sz;
+      for( i = 0 ; sz_of_sz > i ; i++ ) {
+         buf[1 + i] = (sz >> ((sz_of_sz - 1 - i) * 8)) & 0xff;
+      }
+      return 1 + sz_of_sz;
+   }
+
+   buf[0] = sz;
+   return 1;
+}
+
+/* === */
+
 MERROR_RETVAL mserialize_int( mfile_t* ser_out, int32_t value, int array ) {
    MERROR_RETVAL retval = MERROR_OK;
    int8_t val_sz = 0;
@@ -141,6 +185,115 @@ cleanup:
 
 /* === */
 
+static size_t _mserialize_packed_sz( mserialize_cb_t cb ) {
+#ifndef MSERIALIZE_NO_PACKED
+   if(
+      (mserialize_cb_t)mserialize_uint8_t == cb ||
+      (mserialize_cb_t)mserialize_int8_t == cb
+   ) {
+      return 1;
+   } else if(
+      (mserialize_cb_t)mserialize_uint16_t == cb ||
+      (mserialize_cb_t)mserialize_int16_t == cb
+   ) {
+      return 2;
+   } else if(
+      (mserialize_cb_t)mserialize_uint32_t == cb ||
+      (mserialize_cb_t)mserialize_int32_t == cb
+   ) {
+      return 4;
+   }
+#endif /* !MSERIALIZE_NO_PACKED */
+   return 0;
+}
+
+/* === */
+
+#ifdef MAUG_MSBF
+
+static void _mserialize_packed_swap( uint8_t* item, size_t item_sz ) {
+   size_t i = 0;
+   uint8_t swap = 0;
+
+   for( i = 0 ; item_sz / 2 > i ; i++ ) {
+      swap = item[i];
+      item[i] = item[item_sz - 1 - i];
+      item[item_sz - 1 - i] = swap;
+   }
+}
+
+#endif /* MAUG_MSBF */
+
+/* === */
+
+static MERROR_RETVAL _mserialize_vector_packed(
+   mfile_t* ser_out, struct MDATA_VECTOR* p_ser_vec
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   uint8_t type_val = MSERIALIZE_ASN_TYPE_PACKED;
+   uint8_t packed_hdr[MSERIALIZE_PACKED_HDR_SZ];
+   size_t ct = 0;
+   int autolock = 0;
+#ifdef MAUG_MSBF
+   size_t i = 0;
+   uint8_t item[4];
+#endif /* MAUG_MSBF */
+
+   ct = mdata_vector_ct( p_ser_vec );
+
+   /* Width and count, both LSBF regardless of platform. */
+   packed_hdr[0] = p_ser_vec->item_sz;
+   packed_hdr[1] = ct & 0xff;
+   packed_hdr[2] = (ct >> 8) & 0xff;
+   packed_hdr[3] = (ct >> 16) & 0xff;
+   packed_hdr[4] = (ct >> 24) & 0xff;
+
+   retval = ser_out->write_block( ser_out, &type_val, 1 );
+   maug_cleanup_if_not_ok();
+   retval = _mserialize_asn_sz(
+      ser_out, MSERIALIZE_PACKED_HDR_SZ + (ct * p_ser_vec->item_sz) );
+   maug_cleanup_if_not_ok();
+   retval = ser_out->write_block(
+      ser_out, packed_hdr, MSERIALIZE_PACKED_HDR_SZ );
+   maug_cleanup_if_not_ok();
+
+   if( !mdata_vector_is_locked( p_ser_vec ) ) {
+      mdata_vector_lock( p_ser_vec );
+      autolock = 1;
+   }
+
+#ifdef MAUG_MSBF
+   for( i = 0 ; ct > i ; i++ ) {
+      memcpy( item, _mdata_vector_item_ptr( p_ser_vec, i ),
+         p_ser_vec->item_sz );
+      _mserialize_packed_swap( item, p_ser_vec->item_sz );
+      retval = ser_out->write_block( ser_out, item, p_ser_vec->item_sz );
+      maug_cleanup_if_not_ok();
+   }
+#else
+   /* Elements are already in the on-disk byte order, so write them as-is. */
+   retval = ser_out->write_block(
+      ser_out, p_ser_vec->data_bytes, ct * p_ser_vec->item_sz );
+   maug_cleanup_if_not_ok();
+#endif /* MAUG_MSBF */
+
+#if MSERIALIZE_TRACE_LVL > 0
+   debug_printf( MSERIALIZE_TRACE_LVL,
+      "serialized packed vector of " SIZE_T_FMT " " SIZE_T_FMT "-byte items.",
+      ct, p_ser_vec->item_sz );
+#endif /* MSERIALIZE_TRACE_LVL */
+
+cleanup:
+
+   if( autolock ) {
+      mdata_vector_unlock( p_ser_vec );
+   }
+
+   return retval;
+}
+
+/* === */
+
 MERROR_RETVAL mserialize_vector(
    mfile_t* ser_out, struct MDATA_VECTOR* p_ser_vec, int array,
    mserialize_cb_t cb
@@ -150,17 +303,33 @@ MERROR_RETVAL mserialize_vector(
    off_t header = 0,
       header_array = 0;
    int autolock = 0;
+   size_t packed_sz = 0;
    
 #if MSERIALIZE_TRACE_LVL > 0
    debug_printf( MSERIALIZE_TRACE_LVL, "serializing vector %p of %d...",
       p_ser_vec, mdata_vector_ct( p_ser_vec ) );
 #endif /* MSERIALIZE_TRACE_LVL */
+
+   packed_sz = _mserialize_packed_sz( cb );
    
    if( 1 < array ) {
       header_array = mserialize_header( ser_out, MSERIALIZE_TYPE_ARRAY, 0 );
    }
 
    for( i = 0 ; array > i ; i++ ) {
+      if(
+         0 < packed_sz &&
+         0 < mdata_vector_ct( &(p_ser_vec[i]) ) &&
+         packed_sz == p_ser_vec[i].item_sz &&
+         0x7fffffff / packed_sz >
+            mdata_vector_ct( &(p_ser_vec[i]) ) + MSERIALIZE_PACKED_HDR_SZ
+      ) {
+         /* Fixed-size integers can skip the per-item headers entirely. */
+         retval = _mserialize_vector_packed( ser_out, &(p_ser_vec[i]) );
+         maug_cleanup_if_not_ok();
+         continue;
+      }
+
       header = mserialize_header( ser_out, MSERIALIZE_TYPE_ARRAY, 0 );
       
       if( 0 == mdata_vector_ct( &(p_ser_vec[i]) ) ) {
@@ -341,9 +510,171 @@ cleanup:
 
 /* === */
 
+static MERROR_RETVAL _mserialize_writer_header(
+   struct MSERIALIZE_WRITER* writer
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MSERIALIZE_FIXUP fixup;
+   ssize_t idx_fixup = 0;
+   ssize_t idx_stack = 0;
+
+   /* The size goes right after the type, wherever the buffer ends now. */
+   fixup.pos = writer->buf.cursor( &(writer->buf) );
+   fixup.fix_bytes = writer->fix_bytes;
+   fixup.sz = 0;
+
+   idx_fixup = mdata_vector_append(
+      &(writer->fixups), &fixup, sizeof( struct MSERIALIZE_FIXUP ) );
+   if( 0 > idx_fixup ) {
+      retval = merror_sz_to_retval( idx_fixup );
+      goto cleanup;
+   }
+
+   idx_stack = mdata_vector_append(
+      &(writer->stack), &idx_fixup, sizeof( ssize_t ) );
+   if( 0 > idx_stack ) {
+      retval = merror_sz_to_retval( idx_stack );
+      goto cleanup;
+   }
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL _mserialize_writer_footer(
+   struct MSERIALIZE_WRITER* writer, off_t header
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   ssize_t* p_idx = NULL;
+   ssize_t idx = 0;
+   struct MSERIALIZE_FIXUP* fixup = NULL;
+
+   mdata_vector_lock( &(writer->stack) );
+   p_idx = mdata_vector_get_last( &(writer->stack), ssize_t );
+   if( NULL != p_idx ) {
+      idx = *p_idx;
+   }
+   mdata_vector_unlock( &(writer->stack) );
+
+   if( NULL == p_idx ) {
+      error_printf( "footer without a header!" );
+      retval = MERROR_OVERFLOW;
+      goto cleanup;
+   }
+
+   retval = mdata_vector_remove_last( &(writer->stack) );
+   maug_cleanup_if_not_ok();
+
+   mdata_vector_lock( &(writer->fixups) );
+   fixup = mdata_vector_get( &(writer->fixups), idx, struct MSERIALIZE_FIXUP );
+   assert( NULL != fixup );
+   assert( header == fixup->pos );
+
+   /* Count the sizes of any nested sequences, which aren't in the buffer. */
+   fixup->sz = (writer->buf.sz - fixup->pos) +
+      (writer->fix_bytes - fixup->fix_bytes);
+   writer->fix_bytes += _mserialize_asn_sz_sz( fixup->sz );
+
+#if MSERIALIZE_TRACE_LVL > 0
+   debug_printf( MSERIALIZE_TRACE_LVL,
+      "recorded sequence of " SIZE_T_FMT " bytes at " OFF_T_FMT,
+      fixup->sz, fixup->pos );
+#endif /* MSERIALIZE_TRACE_LVL */
+
+   mdata_vector_unlock( &(writer->fixups) );
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL mserialize_writer_flush(
+   struct MSERIALIZE_WRITER* writer, mfile_t* ser_out
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   MAUG_MHANDLE out_h = (MAUG_MHANDLE)NULL;
+   uint8_t* out = NULL;
+   uint8_t* raw = NULL;
+   size_t out_sz = 0;
+   size_t out_pos = 0;
+   size_t raw_pos = 0;
+   size_t i = 0;
+   struct MSERIALIZE_FIXUP* fixup = NULL;
+
+   if( 0 < mdata_vector_ct( &(writer->stack) ) ) {
+      error_printf( SIZE_T_FMT " sequence(s) were never closed!",
+         mdata_vector_ct( &(writer->stack) ) );
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   out_sz = writer->buf.sz + writer->fix_bytes;
+   if( 0 == out_sz ) {
+      goto cleanup;
+   }
+
+#if MSERIALIZE_TRACE_LVL > 0
+   debug_printf( MSERIALIZE_TRACE_LVL,
+      "flushing " SIZE_T_FMT " bytes (" SIZE_T_FMT " sequences)...",
+      out_sz, mdata_vector_ct( &(writer->fixups) ) );
+#endif /* MSERIALIZE_TRACE_LVL */
+
+   maug_malloc_test( out_h, out_sz, 1 );
+   maug_mlock( out_h, out );
+   maug_cleanup_if_null_lock( uint8_t*, out );
+
+   maug_mlock( writer->buf.h.mem, raw );
+   maug_cleanup_if_null_lock( uint8_t*, raw );
+
+   mdata_vector_lock( &(writer->fixups) );
+
+   /* Fixups are in order of offset, so splice each size in as we go. */
+   for( i = 0 ; mdata_vector_ct( &(writer->fixups) ) > i ; i++ ) {
+      fixup = mdata_vector_get( &(writer->fixups), i, struct MSERIALIZE_FIXUP );
+      memcpy( &(out[out_pos]), &(raw[raw_pos]), fixup->pos - raw_pos );
+      out_pos += fixup->pos - raw_pos;
+      raw_pos = fixup->pos;
+      out_pos += _mserialize_asn_sz_buf( &(out[out_pos]), fixup->sz );
+   }
+   memcpy( &(out[out_pos]), &(raw[raw_pos]), writer->buf.sz - raw_pos );
+   out_pos += writer->buf.sz - raw_pos;
+
+   assert( out_pos == out_sz );
+
+   retval = ser_out->write_block( ser_out, out, out_sz );
+
+cleanup:
+
+   if( mdata_vector_is_locked( &(writer->fixups) ) ) {
+      mdata_vector_unlock( &(writer->fixups) );
+   }
+
+   if( NULL != raw ) {
+      maug_munlock( writer->buf.h.mem, raw );
+   }
+
+   if( NULL != out ) {
+      maug_munlock( out_h, out );
+   }
+
+   if( (MAUG_MHANDLE)NULL != out_h ) {
+      maug_mfree( out_h );
+   }
+
+   return retval;
+}
+
+/* === */
+
 off_t mserialize_header( mfile_t* ser_out, uint8_t type, uint8_t flags ) {
    MERROR_RETVAL retval = MERROR_USR;
    uint8_t asn_seq = MSERIALIZE_ASN_TYPE_SEQUENCE;
+   struct MSERIALIZE_WRITER* writer = NULL;
    
    /* Don't let us use this for integers! */
    assert(
@@ -380,6 +711,12 @@ off_t mserialize_header( mfile_t* ser_out, uint8_t type, uint8_t flags ) {
 
    assert( MERROR_OK == retval );
 
+   if( MFILE_FLAG_SER_WRITER == (MFILE_FLAG_SER_WRITER & ser_out->flags) ) {
+      writer = (struct MSERIALIZE_WRITER*)ser_out;
+      assert( &(writer->buf) == ser_out );
+      retval = _mserialize_writer_header( writer );
+   }
+
 cleanup:
 
    if( MERROR_OK == retval ) {
@@ -396,6 +733,13 @@ MERROR_RETVAL mserialize_footer(
 ) {
    MERROR_RETVAL retval = MERROR_OK;
    size_t seq_sz = 0;
+   struct MSERIALIZE_WRITER* writer = NULL;
+
+   if( MFILE_FLAG_SER_WRITER == (MFILE_FLAG_SER_WRITER & ser_out->flags) ) {
+      writer = (struct MSERIALIZE_WRITER*)ser_out;
+      assert( &(writer->buf) == ser_out );
+      return _mserialize_writer_footer( writer, header );
+   }
 
    seq_sz = ser_out->sz - header;
 #if MSERIALIZE_TRACE_LVL > 0
@@ -798,6 +1142,78 @@ cleanup:
    return retval;
 }
 
+static MERROR_RETVAL _mdeserialize_vector_packed(
+   mfile_t* ser_in, struct MDATA_VECTOR* p_ser_vec, size_t item_sz,
+   ssize_t sz_vec
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   uint8_t packed_hdr[MSERIALIZE_PACKED_HDR_SZ];
+   size_t ct = 0;
+   size_t ct_prev = 0;
+   int autolock = 0;
+#ifdef MAUG_MSBF
+   size_t i = 0;
+#endif /* MAUG_MSBF */
+
+   retval = ser_in->read_block( ser_in, packed_hdr, MSERIALIZE_PACKED_HDR_SZ );
+   maug_cleanup_if_not_ok_msg( "error reading packed vector header" );
+
+   ct = packed_hdr[1] | (packed_hdr[2] << 8) |
+      ((size_t)packed_hdr[3] << 16) | ((size_t)packed_hdr[4] << 24);
+
+   if(
+      packed_hdr[0] != item_sz ||
+      MSERIALIZE_PACKED_HDR_SZ + (ct * item_sz) != (size_t)sz_vec
+   ) {
+      error_printf( "invalid packed vector: " SIZE_T_FMT " " SIZE_T_FMT
+         "-byte items in " SSIZE_T_FMT " bytes (expected " SIZE_T_FMT
+         "-byte items)", ct, (size_t)packed_hdr[0], sz_vec, item_sz );
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   if( 0 == ct ) {
+      goto cleanup;
+   }
+
+   /* Size the vector once and read the elements straight into it. */
+   ct_prev = mdata_vector_ct( p_ser_vec );
+   retval = mdata_vector_alloc( p_ser_vec, item_sz, ct_prev + ct );
+   maug_cleanup_if_not_ok();
+
+   mdata_vector_lock( p_ser_vec );
+   autolock = 1;
+
+   retval = ser_in->read_block(
+      ser_in, _mdata_vector_item_ptr( p_ser_vec, ct_prev ), ct * item_sz );
+   maug_cleanup_if_not_ok_msg( "error reading packed vector items" );
+
+#ifdef MAUG_MSBF
+   for( i = 0 ; ct > i ; i++ ) {
+      _mserialize_packed_swap(
+         _mdata_vector_item_ptr( p_ser_vec, ct_prev + i ), item_sz );
+   }
+#endif /* MAUG_MSBF */
+
+   p_ser_vec->ct = ct_prev + ct;
+
+#if MSERIALIZE_TRACE_LVL > 0
+   debug_printf( MSERIALIZE_TRACE_LVL,
+      "deserialized packed vector of " SIZE_T_FMT " " SIZE_T_FMT
+         "-byte items.", ct, item_sz );
+#endif /* MSERIALIZE_TRACE_LVL */
+
+cleanup:
+
+   if( autolock ) {
+      mdata_vector_unlock( p_ser_vec );
+   }
+
+   return retval;
+}
+
+/* === */
+
 MERROR_RETVAL mdeserialize_vector(
    mfile_t* ser_in, struct MDATA_VECTOR* p_ser_vec, int array,
    mdeserialize_cb_t cb, uint8_t* buf, size_t buf_sz, ssize_t* p_ser_sz
@@ -856,6 +1272,13 @@ MERROR_RETVAL mdeserialize_vector(
          sz_vec = sz_vec_arr;
       }
 
+      if( MSERIALIZE_ASN_TYPE_PACKED == type ) {
+         retval = _mdeserialize_vector_packed(
+            ser_in, &(p_ser_vec[i]), buf_sz, sz_vec );
+         maug_cleanup_if_not_ok();
+         continue;
+      }
+
       if( MSERIALIZE_ASN_TYPE_SEQUENCE != type ) {
          error_printf( "expected sequence! found: 0x%02x", type );
          retval = MERROR_FILE;
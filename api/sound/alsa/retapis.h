@@ -304,12 +304,10 @@ void retrosnd_note_on_deadline(
 /* === */
 
 void retrosnd_pump( void ) {
-   int i = 0;
    int16_t out[RETROSND_SAMPLES_CT];
 
-   for( i = 0 ; RETROSND_SAMPLES_CT > i ; i++ ) {
-      out[i] = _retrosnd_generate_note( g_retroflat_state->sound.channels );
-   }
+   _retrosnd_render_block( g_retroflat_state->sound.channels,
+      retroflat_get_ms(), out, RETROSND_SAMPLES_CT );
 
    snd_pcm_writei(
       g_retroflat_state->sound.pcm_handle, out, RETROSND_SAMPLES_CT );
@@ -0,0 +1,431 @@
+#if !defined( RETPLTS_H_DEFS )
+#define RETPLTS_H_DEFS
+
+/* Sound backend that renders the software synthesizer to a file instead of
+ * a sound card, for headless builds and profiling. The output is a WAV file
+ * if the path ends in ".wav", or raw signed 16-bit little-endian mono PCM
+ * otherwise.
+ */
+
+#ifndef RETROSND_FILE_DEFAULT
+#  define RETROSND_FILE_DEFAULT "retrosnd.wav"
+#endif /* !RETROSND_FILE_DEFAULT */
+
+/**
+ * \brief Flag in RETROFLAT_SOUND_STATE::flags indicating the output has a WAV
+ *        header, whose size fields are filled in on retrosnd_shutdown().
+ */
+#define RETROSND_FILE_FLAG_WAV 0x10
+
+struct RETROFLAT_SOUND_ARGS {
+   uint8_t flags;
+   /*! \brief Output path. Set by -rsd or MAUG_SND_FILE if RETROSND_ARGS. */
+   maug_path out_path;
+};
+
+struct RETROFLAT_SOUND_STATE {
+   uint8_t flags;
+   struct RETROSND_CHANNEL channels[RETROSND_CHANNEL_CT_MAX];
+   mfile_t out;
+   /**
+    * \brief Double buffer: one block is rendered into bufs[buf_fill] while
+    *        the other, if buf_pending, waits to be written to the file.
+    */
+   int16_t bufs[2][RETROSND_SAMPLES_CT];
+   uint8_t buf_fill;
+   uint8_t buf_pending;
+   uint8_t buf_bytes[RETROSND_SAMPLES_CT * sizeof( int16_t )];
+   retroflat_ms_t start_ms;
+   /*! \brief Samples rendered since retrosnd_init(), including silence. */
+   uint32_t samples_ct;
+   /*! \brief Blocks rendered by the synthesizer. */
+   uint32_t blocks_ct;
+   /**
+    * \brief Times retrosnd_pump() was called too late to keep the virtual
+    *        device fed, so silence was written to cover the gap.
+    */
+   uint32_t underrun_ct;
+   /**
+    * \brief Wall-clock microseconds spent rendering the last block.
+    *
+    * Only UNIX has a clock fine enough for this; elsewhere it falls back to
+    * retroflat_get_ms(), so short blocks may read as 0.
+    */
+   uint32_t block_us_last;
+   /*! \brief Most wall-clock microseconds spent rendering a single block. */
+   uint32_t block_us_max;
+   /*! \brief Microseconds spent rendering during the last retrosnd_pump(). */
+   uint32_t pump_us_last;
+   /*! \brief Total microseconds spent rendering since retrosnd_init(). */
+   uint32_t render_us_total;
+};
+
+#elif defined( RETROFLT_C )
+
+#ifdef RETROFLAT_OS_UNIX
+#  include <time.h>
+#endif /* RETROFLAT_OS_UNIX */
+
+/**
+ * \brief Get a monotonic time in microseconds for the render counters in
+ *        ::RETROFLAT_SOUND_STATE. Wraps around every 71 minutes or so, which
+ *        is fine for differences.
+ */
+static uint32_t _retrosnd_file_get_us( void ) {
+#ifdef RETROFLAT_OS_UNIX
+   struct timespec spec;
+
+   clock_gettime( CLOCK_MONOTONIC, &spec );
+   return (uint32_t)((spec.tv_sec * 1000000) + (spec.tv_nsec / 1000));
+#else
+   return (uint32_t)retroflat_get_ms() * 1000;
+#endif /* RETROFLAT_OS_UNIX */
+}
+
+/* === */
+
+static MERROR_RETVAL _retrosnd_file_write(
+   const int16_t* buf, size_t buf_ct
+) {
+   uint8_t* bytes = g_retroflat_state->sound.buf_bytes;
+
+   _retrosnd_pcm_lsbf( buf, buf_ct, bytes );
+
+   return g_retroflat_state->sound.out.write_block(
+      &(g_retroflat_state->sound.out), bytes, buf_ct * sizeof( int16_t ) );
+}
+
+/* === */
+
+static MERROR_RETVAL _retrosnd_file_flush( void ) {
+   MERROR_RETVAL retval = MERROR_OK;
+
+   if( !g_retroflat_state->sound.buf_pending ) {
+      goto cleanup;
+   }
+
+   /* The pending block is always the one not being filled. */
+   retval = _retrosnd_file_write(
+      g_retroflat_state->sound.bufs[1 - g_retroflat_state->sound.buf_fill],
+      RETROSND_SAMPLES_CT );
+   g_retroflat_state->sound.buf_pending = 0;
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL _retrosnd_file_write_wav_sz( void ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   mfile_t* out = &(g_retroflat_state->sound.out);
+
+   /* Rewrite the header in place now the sizes are known, rather than
+    * shifting all the samples down to insert it.
+    */
+   out->flags |= MFILE_FLAG_OVERWRITE;
+   retval = out->seek( out, 0 );
+   maug_cleanup_if_not_ok();
+   retval = _retrosnd_write_wav_hdr(
+      out, g_retroflat_state->sound.samples_ct );
+
+cleanup:
+
+   out->flags &= ~MFILE_FLAG_OVERWRITE;
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL retrosnd_cli_rsd(
+   const char* arg, ssize_t arg_c, struct RETROFLAT_ARGS* args
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   char* env_var = NULL;
+
+   if( 0 > arg_c ) {
+      if( '\0' == args->sound.out_path[0] ) {
+         env_var = getenv( "MAUG_SND_FILE" );
+         if( NULL != env_var ) {
+            debug_printf( 2, "env: MAUG_SND_FILE: %s", env_var );
+            maug_strncpy( args->sound.out_path, env_var, MAUG_PATH_SZ_MAX - 1 );
+         }
+      }
+   } else if(
+      0 == strncmp( MAUG_CLI_SIGIL "rsd", arg, MAUG_CLI_SIGIL_SZ + 4 )
+   ) {
+      /* The next arg must be the new path. */
+   } else {
+      maug_strncpy( args->sound.out_path, arg, MAUG_PATH_SZ_MAX - 1 );
+   }
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL retrosnd_init( struct RETROFLAT_ARGS* args ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   maug_path out_path;
+   size_t out_path_sz = 0;
+
+   maug_mzero(
+      &g_retroflat_state->sound, sizeof( struct RETROFLAT_SOUND_STATE ) );
+
+   maug_mzero( out_path, sizeof( maug_path ) );
+   if( '\0' != args->sound.out_path[0] ) {
+      maug_strncpy( out_path, args->sound.out_path, MAUG_PATH_SZ_MAX - 1 );
+   } else {
+      maug_strncpy( out_path, RETROSND_FILE_DEFAULT, MAUG_PATH_SZ_MAX - 1 );
+   }
+
+   retval = mfile_open_write( out_path, &(g_retroflat_state->sound.out) );
+   maug_cleanup_if_not_ok();
+
+   out_path_sz = maug_strlen( out_path );
+   if(
+      4 <= out_path_sz &&
+      0 == maug_strncmp( &(out_path[out_path_sz - 4]), ".wav", 4 )
+   ) {
+      g_retroflat_state->sound.flags |= RETROSND_FILE_FLAG_WAV;
+      /* The sizes are placeholders until _retrosnd_file_write_wav_sz(). */
+      retval = _retrosnd_write_wav_hdr( &(g_retroflat_state->sound.out), 0 );
+      maug_cleanup_if_not_ok();
+   }
+
+   debug_printf( 3, "rendering sound to: %s", out_path );
+
+   /* Set the init flag first so the channel defaults below stick. */
+   g_retroflat_state->sound.flags |= RETROSND_FLAG_INIT;
+
+   retval = _retrosnd_channels_init( g_retroflat_state->sound.channels );
+   maug_cleanup_if_not_ok();
+
+   g_retroflat_state->sound.start_ms = retroflat_get_ms();
+
+cleanup:
+
+   if( MERROR_OK != retval ) {
+      mfile_close( &(g_retroflat_state->sound.out) );
+      g_retroflat_state->sound.flags = 0;
+   }
+
+   return retval;
+}
+
+/* === */
+
+void retrosnd_set_voice( uint8_t channel, uint8_t voice ) {
+
+   if(
+      RETROSND_FLAG_INIT !=
+      (RETROSND_FLAG_INIT & g_retroflat_state->sound.flags)
+   ) {
+      return;
+   }
+
+   if( RETROSND_CHANNEL_CT_MAX <= channel ) {
+      error_printf( "invalid channel: %d", channel );
+      return;
+   }
+
+#if RETROSND_TRACE_LVL > 0
+   debug_printf( RETROSND_TRACE_LVL, "setting channel %u voice: %u",
+      channel, voice );
+#endif /* RETROSND_TRACE_LVL */
+
+   g_retroflat_state->sound.channels[channel].voice = voice;
+}
+
+/* === */
+
+void retrosnd_set_control( uint8_t channel, uint8_t key, uint8_t val ) {
+
+   if(
+      RETROSND_FLAG_INIT !=
+      (RETROSND_FLAG_INIT & g_retroflat_state->sound.flags)
+   ) {
+      return;
+   }
+
+   if( RETROSND_CHANNEL_CT_MAX <= channel ) {
+      error_printf( "invalid channel: %d", channel );
+      return;
+   }
+
+#if RETROSND_TRACE_LVL > 0
+   debug_printf( RETROSND_TRACE_LVL, "setting control %u: %u on %u",
+      key, val, channel );
+#endif /* RETROSND_TRACE_LVL */
+
+   _retrosnd_set_control(
+      &(g_retroflat_state->sound.channels[channel]), key, val );
+}
+
+/* === */
+
+void retrosnd_note_on( uint8_t channel, uint8_t pitch, uint8_t vel ) {
+
+   if(
+      RETROSND_FLAG_INIT !=
+      (RETROSND_FLAG_INIT & g_retroflat_state->sound.flags) ||
+      RETROSND_CHANNEL_CT_MAX <= channel
+   ) {
+      return;
+   }
+
+   if( g_retroflat_state->sound.channels[channel].note == pitch ) {
+      return;
+   }
+
+   g_retroflat_state->sound.channels[channel].note = pitch;
+   g_retroflat_state->sound.channels[channel].deadline = 0;
+}
+
+/* === */
+
+void retrosnd_note_off( uint8_t channel, uint8_t pitch, uint8_t vel ) {
+
+   if(
+      RETROSND_FLAG_INIT !=
+      (RETROSND_FLAG_INIT & g_retroflat_state->sound.flags) ||
+      RETROSND_CHANNEL_CT_MAX <= channel
+   ) {
+      return;
+   }
+
+   g_retroflat_state->sound.channels[channel].note =
+      RETROSND_TUNE_NOTE_DISABLED;
+   g_retroflat_state->sound.channels[channel].deadline = 0;
+}
+
+/* === */
+
+void retrosnd_shutdown( void ) {
+
+   if(
+      RETROSND_FLAG_INIT !=
+      (RETROSND_FLAG_INIT & g_retroflat_state->sound.flags)
+   ) {
+      return;
+   }
+
+   if( MERROR_OK != _retrosnd_file_flush() ) {
+      error_printf( "could not flush sound output!" );
+   }
+
+   if(
+      RETROSND_FILE_FLAG_WAV ==
+      (RETROSND_FILE_FLAG_WAV & g_retroflat_state->sound.flags) &&
+      MERROR_OK != _retrosnd_file_write_wav_sz()
+   ) {
+      error_printf( "could not write WAV sizes!" );
+   }
+
+   mfile_close( &(g_retroflat_state->sound.out) );
+
+   debug_printf( 3, "rendered " U32_FMT " samples in " U32_FMT " blocks ("
+      U32_FMT " us total, " U32_FMT " us max per block, " U32_FMT
+      " underruns)",
+      g_retroflat_state->sound.samples_ct,
+      g_retroflat_state->sound.blocks_ct,
+      g_retroflat_state->sound.render_us_total,
+      g_retroflat_state->sound.block_us_max,
+      g_retroflat_state->sound.underrun_ct );
+
+   g_retroflat_state->sound.flags = 0;
+}
+
+/* === */
+
+void retrosnd_note_on_deadline(
+   uint8_t channel, uint8_t pitch, retroflat_ms_t deadline
+) {
+   retrosnd_note_on( channel, pitch, 0 );
+   if( RETROSND_CHANNEL_CT_MAX > channel ) {
+      g_retroflat_state->sound.channels[channel].deadline = deadline;
+   }
+}
+
+/* === */
+
+void retrosnd_pump( void ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROFLAT_SOUND_STATE* sound = &(g_retroflat_state->sound);
+   retroflat_ms_t elapsed_ms = 0;
+   retroflat_ms_t block_ms = 0;
+   uint32_t played_ct = 0;
+   uint32_t gap_ct = 0;
+   uint32_t block_start = 0;
+
+   if( RETROSND_FLAG_INIT != (RETROSND_FLAG_INIT & sound->flags) ) {
+      return;
+   }
+
+   sound->pump_us_last = 0;
+
+   /* Figure out how far a real device would have played by now. */
+   elapsed_ms = retroflat_get_ms() - sound->start_ms;
+   played_ct = ((elapsed_ms / 1000) * RETROSND_SAMPLE_RATE) +
+      (((elapsed_ms % 1000) * RETROSND_SAMPLE_RATE) / 1000);
+
+   if( played_ct > sound->samples_ct ) {
+      /* The device would have run dry, so fill the gap with silence. */
+      sound->underrun_ct++;
+#if RETROSND_TRACE_LVL > 0
+      debug_printf( RETROSND_TRACE_LVL, "underrun: " U32_FMT " samples",
+         played_ct - sound->samples_ct );
+#endif /* RETROSND_TRACE_LVL */
+      retval = _retrosnd_file_flush();
+      maug_cleanup_if_not_ok();
+      maug_mzero( sound->bufs[sound->buf_fill],
+         RETROSND_SAMPLES_CT * sizeof( int16_t ) );
+      while( played_ct > sound->samples_ct ) {
+         gap_ct = played_ct - sound->samples_ct;
+         if( RETROSND_SAMPLES_CT < gap_ct ) {
+            gap_ct = RETROSND_SAMPLES_CT;
+         }
+         retval = _retrosnd_file_write( sound->bufs[sound->buf_fill], gap_ct );
+         maug_cleanup_if_not_ok();
+         sound->samples_ct += gap_ct;
+      }
+   }
+
+   /* Keep a block rendered ahead of the virtual device. */
+   while( played_ct + RETROSND_SAMPLES_CT > sound->samples_ct ) {
+      block_ms = sound->start_ms +
+         ((sound->samples_ct / RETROSND_SAMPLE_RATE) * 1000) +
+         (((sound->samples_ct % RETROSND_SAMPLE_RATE) * 1000) /
+            RETROSND_SAMPLE_RATE);
+
+      block_start = _retrosnd_file_get_us();
+      _retrosnd_render_block( sound->channels, block_ms,
+         sound->bufs[sound->buf_fill], RETROSND_SAMPLES_CT );
+      sound->block_us_last = _retrosnd_file_get_us() - block_start;
+
+      sound->pump_us_last += sound->block_us_last;
+      sound->render_us_total += sound->block_us_last;
+      if( sound->block_us_last > sound->block_us_max ) {
+         sound->block_us_max = sound->block_us_last;
+      }
+      sound->blocks_ct++;
+      sound->samples_ct += RETROSND_SAMPLES_CT;
+
+      /* Write out the previous block and swap buffers. */
+      retval = _retrosnd_file_flush();
+      maug_cleanup_if_not_ok();
+      sound->buf_fill = 1 - sound->buf_fill;
+      sound->buf_pending = 1;
+   }
+
+cleanup:
+
+   if( MERROR_OK != retval ) {
+      error_printf( "could not write sound output!" );
+   }
+}
+
+#endif /* !RETPLTS_H_DEFS || RETROFLT_C */
+
@@ -24,15 +24,12 @@ void __cdecl retrosnd_sdl_audio_callback( void* userdata, Uint8* stream, int len
 void retrosnd_sdl_audio_callback( void* userdata, Uint8* stream, int len ) {
 #endif /* RETROFLAT_OS_WIN */
    int16_t* out = (int16_t*)stream;
-   int i = 0;
    int samples = len / sizeof( int16_t );
    struct RETROFLAT_SOUND_STATE* state =
       (struct RETROFLAT_SOUND_STATE*)userdata;
 
    state->lock = 1;
-   for( i = 0 ; i < samples ; i++ ) {
-      out[i] = _retrosnd_generate_note( state->channels );
-   }
+   _retrosnd_render_block( state->channels, retroflat_get_ms(), out, samples );
    state->lock = 0;
 }
 
@@ -1,6 +1,8 @@
 
 #include "maugchck.h"
 
+#include <time.h>
+
 struct MDATA_VECTOR g_vector_test_append;
 struct MDATA_VECTOR g_vector_test_insert;
 
@@ -88,7 +90,7 @@ void vector_teardown() {
 START_TEST( test_mdat_table_set ) {
    int* p_int = NULL;
 
-   debug_printf( MDATA_TRACE_LVL, "test_mdat_table_set" );
+   debug_printf( MDATA_TABLE_TRACE_LVL, "test_mdat_table_set" );
 
    mdata_table_lock( &g_table_test_set );
 
@@ -171,6 +173,69 @@ START_TEST( test_mdat_table_overwrite ) {
 }
 END_TEST
 
+static MERROR_RETVAL _test_mdat_table_order_iter(
+   const struct MDATA_TABLE_KEY* key, void* data, size_t data_sz,
+   void* cb_data, size_t cb_data_sz, size_t idx
+) {
+   int* p_last = (int*)cb_data;
+
+   /* Values were set in ascending order, so they should iterate that way. */
+   if( *((int*)data) <= *p_last ) {
+      return MERROR_OVERFLOW;
+   }
+   *p_last = *((int*)data);
+
+   return MERROR_OK;
+}
+
+START_TEST( test_mdat_table_many ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MDATA_TABLE table_test;
+   char key[MDATA_TABLE_KEY_SZ_MAX + 1];
+   int i = 0;
+   int last = -1;
+   int* p_int = NULL;
+
+   maug_mzero( &table_test, sizeof( struct MDATA_TABLE ) );
+
+   for( i = 0 ; 500 > i ; i++ ) {
+      maug_snprintf( key, MDATA_TABLE_KEY_SZ_MAX, "k%d", i );
+      retval = mdata_table_set( &table_test, key, &i, sizeof( int ) );
+      ck_assert_uint_eq( retval, MERROR_OK );
+   }
+
+   /* Remove every third key, leaving tombstones in the index. */
+   for( i = 0 ; 500 > i ; i += 3 ) {
+      maug_snprintf( key, MDATA_TABLE_KEY_SZ_MAX, "k%d", i );
+      retval = mdata_table_unset( &table_test, key );
+      ck_assert_uint_eq( retval, MERROR_OK );
+   }
+
+   ck_assert_int_eq( mdata_table_ct( &table_test ), 333 );
+
+   mdata_table_lock( &table_test );
+
+   for( i = 0 ; 500 > i ; i++ ) {
+      maug_snprintf( key, MDATA_TABLE_KEY_SZ_MAX, "k%d", i );
+      p_int = mdata_table_get( &table_test, key, int );
+      if( 0 == i % 3 ) {
+         ck_assert_ptr_eq( p_int, NULL );
+      } else {
+         ck_assert_ptr_ne( p_int, NULL );
+         ck_assert_int_eq( *p_int, i );
+      }
+   }
+
+   mdata_table_unlock( &table_test );
+
+   retval = mdata_table_iter(
+      &table_test, _test_mdat_table_order_iter, &last, sizeof( int ) );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   mdata_table_free( &table_test );
+}
+END_TEST
+
 void table_setup() {
    size_t i = 0;
    MERROR_RETVAL retval = MERROR_OK;
@@ -293,6 +358,171 @@ START_TEST( test_mdat_strpool_extract ) {
 END_TEST
 
 START_TEST( test_mdat_strpool_remove ) {
+   struct MDATA_STRPOOL sp_test;
+   mdata_strpool_idx_t idx_foo = 0;
+   mdata_strpool_idx_t idx_fii = 0;
+   MERROR_RETVAL retval = MERROR_OK;
+
+   maug_mzero( &sp_test, sizeof( struct MDATA_STRPOOL ) );
+
+   idx_foo = mdata_strpool_append(
+      &sp_test, "foo", maug_strlen( "foo" ), MDATA_STRPOOL_FLAG_DEDUPE );
+   idx_fii = mdata_strpool_append(
+      &sp_test, "fii", maug_strlen( "fii" ), MDATA_STRPOOL_FLAG_DEDUPE );
+   mdata_strpool_append(
+      &sp_test, "fee", maug_strlen( "fee" ), MDATA_STRPOOL_FLAG_DEDUPE );
+   ck_assert_int_eq( mdata_strpool_ct( &sp_test ), 3 );
+
+   retval = mdata_strpool_remove( &sp_test, idx_foo );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   ck_assert_int_eq( mdata_strpool_ct( &sp_test ), 2 );
+
+   /* Removed string is gone, and subsequent strings moved down. */
+   ck_assert_int_eq(
+      mdata_strpool_find( &sp_test, "foo", maug_strlen( "foo" ) ),
+      MDATA_STRPOOL_IDX_ERROR );
+   ck_assert_int_eq(
+      mdata_strpool_find( &sp_test, "fii", maug_strlen( "fii" ) ), idx_foo );
+   ck_assert_int_eq(
+      mdata_strpool_find( &sp_test, "fee", maug_strlen( "fee" ) ), idx_fii );
+
+   /* Sizes past the null hash the same as the string itself. */
+   ck_assert_int_eq(
+      mdata_strpool_find( &sp_test, "fee\0xx", 6 ), idx_fii );
+
+   /* Invalid indexes are rejected. */
+   retval = mdata_strpool_remove( &sp_test, idx_foo + 1 );
+   ck_assert_uint_eq( retval, MERROR_OVERFLOW );
+
+   /* Removing from a locked strpool fails without unlocking it. */
+   mdata_strpool_lock( &sp_test );
+   retval = mdata_strpool_remove( &sp_test, idx_foo );
+   ck_assert_uint_eq( retval, MERROR_ALLOC );
+   ck_assert_int_eq( mdata_strpool_is_locked( &sp_test ), 1 );
+   mdata_strpool_unlock( &sp_test );
+
+cleanup:
+
+   mdata_strpool_free( &sp_test );
+}
+END_TEST
+
+START_TEST( test_mdat_strpool_intern ) {
+   struct MDATA_STRPOOL sp_test;
+   size_t str_ct = 0 == _i ? 10000 : 100000;
+   size_t i = 0;
+   char str_buf[32];
+   mdata_strpool_idx_t idx = 0;
+   mdata_strpool_idx_t idx_first = 0;
+   clock_t start = 0;
+
+   maug_mzero( &sp_test, sizeof( struct MDATA_STRPOOL ) );
+
+   start = clock();
+
+   for( i = 0 ; str_ct > i ; i++ ) {
+      maug_snprintf( str_buf, 32, "tok" SIZE_T_FMT, i );
+      idx = mdata_strpool_append(
+         &sp_test, str_buf, maug_strlen( str_buf ),
+         MDATA_STRPOOL_FLAG_DEDUPE );
+      ck_assert( MDATA_STRPOOL_IDX_ERROR != idx );
+      if( 0 == i ) {
+         idx_first = idx;
+      }
+   }
+
+   /* Intern everything a second time; nothing new should be added. */
+   for( i = 0 ; str_ct > i ; i++ ) {
+      maug_snprintf( str_buf, 32, "tok" SIZE_T_FMT, i );
+      idx = mdata_strpool_append(
+         &sp_test, str_buf, maug_strlen( str_buf ),
+         MDATA_STRPOOL_FLAG_DEDUPE );
+      if( 0 == i ) {
+         ck_assert_int_eq( idx, idx_first );
+      }
+   }
+
+   debug_printf( 1, "interned " SIZE_T_FMT " strings twice in %ld ms",
+      str_ct, (long)((clock() - start) * 1000 / CLOCKS_PER_SEC) );
+
+   ck_assert_int_eq( mdata_strpool_ct( &sp_test ), str_ct );
+
+   mdata_strpool_free( &sp_test );
+}
+END_TEST
+
+/* Keys for the index tests. "bb" is in twice, and "eeeee" is left out. */
+static const char* gc_index_keys[] = {
+   "a", "bb", "ccc", "bb", "dddd", "eeeee", "ffffff" };
+
+#define INDEX_KEYS_CT (sizeof( gc_index_keys ) / sizeof( gc_index_keys[0] ))
+
+#define INDEX_KEY_SKIP 5
+
+static int index_hash( void* data, size_t idx, uint32_t* p_hash ) {
+   if( INDEX_KEY_SKIP == idx ) {
+      return 0;
+   }
+   /* Either hash every key alike to make one long probe chain, or not. */
+   *p_hash = NULL != data ? *((uint32_t*)data) :
+      mdata_hash( gc_index_keys[idx], maug_strlen( gc_index_keys[idx] ) );
+   return 1;
+}
+
+static int index_match( void* data, size_t idx, const void* key ) {
+   return 0 == strcmp( gc_index_keys[idx], (const char*)key );
+}
+
+START_TEST( test_mdat_index_probe ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MDATA_INDEX index;
+   uint32_t collide = 7;
+   uint32_t hash = 0;
+   size_t i = 0;
+   size_t probe = 0;
+   ssize_t idx = 0;
+
+   maug_mzero( &index, sizeof( struct MDATA_INDEX ) );
+
+   retval = mdata_index_rebuild(
+      &index, INDEX_KEYS_CT, 2, index_hash, 0 == _i ? NULL : &collide );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   /* Grown to keep it at most half full. */
+   ck_assert_uint_eq( index.slots_sz, 16 );
+
+   mdata_index_lock( &index );
+
+   for( i = 0 ; INDEX_KEYS_CT > i ; i++ ) {
+      hash = 0 == _i ? mdata_hash( gc_index_keys[i],
+         maug_strlen( gc_index_keys[i] ) ) : collide;
+      probe = 0;
+      idx = mdata_index_probe(
+         &index, hash, &probe, index_match, NULL, gc_index_keys[i] );
+      if( INDEX_KEY_SKIP == i ) {
+         ck_assert_int_eq( idx, -1 );
+      } else if( 3 == i ) {
+         /* Duplicates come back in the order they were inserted. */
+         ck_assert_int_eq( idx, 1 );
+         idx = mdata_index_probe(
+            &index, hash, &probe, index_match, NULL, gc_index_keys[i] );
+         ck_assert_int_eq( idx, 3 );
+      } else {
+         ck_assert_int_eq( idx, i );
+      }
+   }
+
+   /* Missing keys aren't found. */
+   probe = 0;
+   hash = 0 == _i ? mdata_hash( "zz", 2 ) : collide;
+   idx = mdata_index_probe( &index, hash, &probe, index_match, NULL, "zz" );
+   ck_assert_int_eq( idx, -1 );
+
+cleanup:
+
+   mdata_index_free( &index );
+
+   ck_assert_uint_eq( retval, MERROR_OK );
 }
 END_TEST
 
@@ -301,6 +531,7 @@ Suite* mdat_suite( void ) {
    TCase* tc_vector;
    TCase* tc_table;
    TCase* tc_strpool;
+   TCase* tc_index;
 
    s = suite_create( "mdat" );
 
@@ -324,6 +555,7 @@ Suite* mdat_suite( void ) {
    tcase_add_loop_test( tc_table, test_mdat_table_unset, 0, 8 );
    tcase_add_test( tc_table, test_mdat_table_lockunlock );
    tcase_add_test( tc_table, test_mdat_table_overwrite );
+   tcase_add_test( tc_table, test_mdat_table_many );
 
    suite_add_tcase( s, tc_table );
 
@@ -336,9 +568,18 @@ Suite* mdat_suite( void ) {
    tcase_add_test( tc_strpool, test_mdat_strpool_dedupe );
    tcase_add_test( tc_strpool, test_mdat_strpool_extract );
    tcase_add_test( tc_strpool, test_mdat_strpool_remove );
+   tcase_add_loop_test( tc_strpool, test_mdat_strpool_intern, 0, 2 );
 
    suite_add_tcase( s, tc_strpool );
 
+   /* = */
+
+   tc_index = tcase_create( "Index" );
+
+   tcase_add_loop_test( tc_index, test_mdat_index_probe, 0, 2 );
+
+   suite_add_tcase( s, tc_index );
+
    return s;
 }
 
@@ -82,6 +82,29 @@ START_TEST( test_mfil_mem_cursor ) {
    mfile_close( &test_file );
 }
 
+START_TEST( test_mfil_mem_overflow ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   mfile_t test_file;
+   uint8_t test_buf[TEST_MEM_SZ + 1];
+
+   maug_mzero( test_buf, TEST_MEM_SZ + 1 );
+
+   retval = mfile_lock_buffer(
+      (MAUG_MHANDLE)NULL, test_buf, TEST_MEM_SZ, &test_file );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   /* Fixed buffers can't grow, so this should not touch the guard byte. */
+   test_file.seek( &test_file, _i );
+   retval = test_file.write_block( &test_file, g_test_mem, TEST_MEM_SZ );
+
+   ck_assert_uint_eq( retval, MERROR_OVERFLOW );
+   ck_assert_int_eq( test_buf[TEST_MEM_SZ], 0 );
+   ck_assert_int_eq( test_file.cursor( &test_file ), _i );
+
+   mfile_close( &test_file );
+}
+END_TEST
+
 START_TEST( test_mfil_file_cursor ) {
    MERROR_RETVAL retval = MERROR_OK;
    mfile_t test_file;
@@ -97,6 +120,302 @@ START_TEST( test_mfil_file_cursor ) {
 }
 END_TEST
 
+MERROR_RETVAL write_buf_temp( size_t sz, mfile_t* p_file ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   maug_path filename_path;
+   uint8_t c = 0;
+   size_t i = 0;
+
+   retval = open_temp( "chkbuf", p_file );
+   maug_cleanup_if_not_ok();
+
+   for( i = 0 ; sz > i ; i++ ) {
+      c = (i * 7) & 0xff;
+      retval = p_file->write_block( p_file, &c, 1 );
+      maug_cleanup_if_not_ok();
+   }
+
+   /* Reopen the file read-only, which should attach the read buffer. */
+   maug_mzero( filename_path, MAUG_PATH_SZ_MAX );
+   retval = mfile_assign_path( filename_path, p_file->filename, 0 );
+   maug_cleanup_if_not_ok();
+   mfile_close( p_file );
+
+   retval = mfile_open_read( filename_path, p_file );
+
+cleanup:
+
+   return retval;
+}
+
+START_TEST( test_mfil_file_buf_seek ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   mfile_t test_file;
+   uint8_t c = 0;
+
+   retval = write_buf_temp( TEST_MEM_SZ, &test_file );
+   ck_assert_uint_eq( retval, MERROR_OK );
+#ifdef MFILE_MMAP
+   ck_assert_uint_eq( MFILE_FLAG_MMAP & test_file.flags, MFILE_FLAG_MMAP );
+#else
+   ck_assert_uint_eq(
+      MFILE_FLAG_READ_BUFFERED & test_file.flags, MFILE_FLAG_READ_BUFFERED );
+#endif /* MFILE_MMAP */
+
+   /* Prime the buffer, then seek inside it. */
+   retval = mfile_getc( &test_file, &c );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   retval = test_file.seek( &test_file, _i );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   retval = mfile_getc( &test_file, &c );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   ck_assert_uint_eq( c, (_i * 7) & 0xff );
+   ck_assert_int_eq( test_file.cursor( &test_file ), _i + 1 );
+   ck_assert_int_eq( test_file.has_bytes( &test_file ), TEST_MEM_SZ - _i - 1 );
+
+   close_temp( &test_file );
+}
+END_TEST
+
+START_TEST( test_mfil_file_buf_chunk ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   mfile_t test_file;
+   uint8_t chunk[MFILE_CHUNK_SZ];
+   size_t chunk_sz = 0;
+   size_t file_sz = (MFILE_READ_BUFFER_SZ * 3) + 17;
+   size_t i = 0;
+   size_t j = 0;
+   uint8_t c = 0;
+   uint8_t* big_buf = NULL;
+
+   retval = write_buf_temp( file_sz, &test_file );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   /* Read straight through across several buffer fills. */
+   while( test_file.has_bytes( &test_file ) ) {
+      retval = mfile_read_chunk(
+         &test_file, chunk, MFILE_CHUNK_SZ, &chunk_sz );
+      ck_assert_uint_eq( retval, MERROR_OK );
+      for( j = 0 ; chunk_sz > j ; j++ ) {
+         ck_assert_uint_eq( chunk[j], (i * 7) & 0xff );
+         i++;
+      }
+   }
+   ck_assert_uint_eq( i, file_sz );
+
+   retval = mfile_getc( &test_file, &c );
+   ck_assert_uint_eq( retval, MERROR_FILE );
+
+   /* Seek back outside of the buffered window. */
+   retval = test_file.seek( &test_file, 5 );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   retval = mfile_getc( &test_file, &c );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   ck_assert_uint_eq( c, (5 * 7) & 0xff );
+
+   /* Read a block bigger than the buffer from a partially-read buffer. */
+   big_buf = calloc( MFILE_READ_BUFFER_SZ + 1, 1 );
+   ck_assert_ptr_ne( big_buf, NULL );
+   retval = test_file.read_block(
+      &test_file, big_buf, MFILE_READ_BUFFER_SZ + 1 );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   for( i = 0 ; MFILE_READ_BUFFER_SZ + 1 > i ; i++ ) {
+      ck_assert_uint_eq( big_buf[i], ((6 + i) * 7) & 0xff );
+   }
+   free( big_buf );
+
+   retval = mfile_getc( &test_file, &c );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   ck_assert_uint_eq( c, ((7 + MFILE_READ_BUFFER_SZ) * 7) & 0xff );
+   ck_assert_int_eq(
+      test_file.cursor( &test_file ), 8 + MFILE_READ_BUFFER_SZ );
+
+   close_temp( &test_file );
+}
+END_TEST
+
+#define TEST_PACK_ENTRIES_CT 3
+
+struct TEST_PACK_ENTRY {
+   const char* name;
+   const uint8_t* data;
+   uint32_t data_sz;
+   uint8_t comp;
+   const char* unpacked;
+};
+
+/* 40 'z' followed by "abc", as PackBits. */
+static const uint8_t gc_test_pack_rle[] = { 217, 'z', 2, 'a', 'b', 'c' };
+
+static const struct TEST_PACK_ENTRY gc_test_pack[TEST_PACK_ENTRIES_CT] = {
+   { "a.txt", (const uint8_t*)"hello", 5, MFILE_PACK_COMP_NONE, "hello" },
+   { "b.bin", gc_test_pack_rle, 6, MFILE_PACK_COMP_RLE,
+      "zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzabc" },
+   { "dir/c.txt", (const uint8_t*)"world!", 6, MFILE_PACK_COMP_NONE,
+      "world!" }
+};
+
+static void write_pack_u32( uint8_t* buf, uint32_t v ) {
+   buf[0] = v & 0xff;
+   buf[1] = (v >> 8) & 0xff;
+   buf[2] = (v >> 16) & 0xff;
+   buf[3] = (v >> 24) & 0xff;
+}
+
+/* Build a pack the same way tools/mpak.c does and open it. */
+MERROR_RETVAL open_pack_temp( maug_path pack_path ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   mfile_t pack_file;
+   uint8_t buf[MFILE_PACK_ENTRY_SZ];
+   size_t order[TEST_PACK_ENTRIES_CT];
+   uint32_t name_off = 0;
+   uint32_t data_off = 0;
+   size_t i = 0;
+   size_t j = 0;
+   size_t tmp = 0;
+   const struct TEST_PACK_ENTRY* e = NULL;
+
+   /* Sort entries by hash. */
+   for( i = 0 ; TEST_PACK_ENTRIES_CT > i ; i++ ) {
+      order[i] = i;
+   }
+   for( i = 0 ; TEST_PACK_ENTRIES_CT > i ; i++ ) {
+      for( j = i + 1 ; TEST_PACK_ENTRIES_CT > j ; j++ ) {
+         if(
+            mfile_pack_hash( gc_test_pack[order[j]].name,
+               strlen( gc_test_pack[order[j]].name ) ) <
+            mfile_pack_hash( gc_test_pack[order[i]].name,
+               strlen( gc_test_pack[order[i]].name ) )
+         ) {
+            tmp = order[i];
+            order[i] = order[j];
+            order[j] = tmp;
+         }
+      }
+   }
+
+   retval = open_temp( "chkpak", &pack_file );
+   maug_cleanup_if_not_ok();
+   maug_mzero( pack_path, MAUG_PATH_SZ_MAX );
+   retval = mfile_assign_path( pack_path, pack_file.filename, 0 );
+   maug_cleanup_if_not_ok();
+
+   maug_mzero( buf, MFILE_PACK_ENTRY_SZ );
+   memcpy( buf, MFILE_PACK_MAGIC, 4 );
+   buf[4] = MFILE_PACK_VERSION;
+   buf[6] = 1;
+   write_pack_u32( &(buf[8]), TEST_PACK_ENTRIES_CT );
+   write_pack_u32( &(buf[12]), MFILE_PACK_HDR_SZ );
+   retval = pack_file.write_block( &pack_file, buf, MFILE_PACK_HDR_SZ );
+   maug_cleanup_if_not_ok();
+
+   /* Names go after the directory, and data after the names. */
+   name_off = MFILE_PACK_HDR_SZ + (TEST_PACK_ENTRIES_CT * MFILE_PACK_ENTRY_SZ);
+   data_off = name_off;
+   for( i = 0 ; TEST_PACK_ENTRIES_CT > i ; i++ ) {
+      data_off += strlen( gc_test_pack[i].name ) + 1;
+   }
+
+   for( i = 0 ; TEST_PACK_ENTRIES_CT > i ; i++ ) {
+      e = &(gc_test_pack[order[i]]);
+      maug_mzero( buf, MFILE_PACK_ENTRY_SZ );
+      write_pack_u32( &(buf[0]), mfile_pack_hash( e->name, strlen( e->name ) ) );
+      write_pack_u32( &(buf[4]), data_off );
+      write_pack_u32( &(buf[8]), e->data_sz );
+      write_pack_u32( &(buf[12]), strlen( e->unpacked ) );
+      write_pack_u32( &(buf[16]), name_off );
+      buf[20] = strlen( e->name );
+      buf[22] = e->comp;
+      retval = pack_file.write_block( &pack_file, buf, MFILE_PACK_ENTRY_SZ );
+      maug_cleanup_if_not_ok();
+      name_off += strlen( e->name ) + 1;
+      data_off += e->data_sz;
+   }
+
+   for( i = 0 ; TEST_PACK_ENTRIES_CT > i ; i++ ) {
+      e = &(gc_test_pack[order[i]]);
+      retval = pack_file.write_block(
+         &pack_file, (const uint8_t*)e->name, strlen( e->name ) + 1 );
+      maug_cleanup_if_not_ok();
+   }
+
+   for( i = 0 ; TEST_PACK_ENTRIES_CT > i ; i++ ) {
+      e = &(gc_test_pack[order[i]]);
+      retval = pack_file.write_block( &pack_file, e->data, e->data_sz );
+      maug_cleanup_if_not_ok();
+   }
+
+   mfile_close( &pack_file );
+
+   retval = mfile_pack_open( pack_path );
+
+cleanup:
+
+   return retval;
+}
+
+START_TEST( test_mfil_pack_read ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   maug_path pack_path;
+   maug_path entry_path;
+   mfile_t test_file;
+   char buf[64];
+
+   retval = open_pack_temp( pack_path );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   maug_mzero( entry_path, MAUG_PATH_SZ_MAX );
+   maug_strncpy( entry_path, gc_test_pack[_i].name, MAUG_PATH_SZ_MAX - 1 );
+   retval = mfile_open_read( entry_path, &test_file );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   ck_assert_uint_eq( test_file.type, MFILE_CADDY_TYPE_MEM_BUFFER );
+   ck_assert_int_eq( test_file.sz, strlen( gc_test_pack[_i].unpacked ) );
+
+   maug_mzero( buf, 64 );
+   retval = test_file.read_block( &test_file, (uint8_t*)buf, test_file.sz );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   ck_assert_str_eq( buf, gc_test_pack[_i].unpacked );
+
+   mfile_close( &test_file );
+   mfile_pack_close();
+   remove( pack_path );
+}
+END_TEST
+
+START_TEST( test_mfil_pack_fallback ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   maug_path pack_path;
+   maug_path entry_path;
+   mfile_t test_file;
+
+   retval = open_pack_temp( pack_path );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   /* Not in the pack or on disk. */
+   maug_mzero( entry_path, MAUG_PATH_SZ_MAX );
+   maug_strncpy( entry_path, "dir/a.txt", MAUG_PATH_SZ_MAX - 1 );
+   retval = mfile_open_read( entry_path, &test_file );
+   ck_assert_uint_eq( retval, MERROR_FILE );
+
+   /* Not in the pack, but on disk. */
+   retval = mfile_open_read( pack_path, &test_file );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   ck_assert_uint_eq( test_file.flags & MFILE_FLAG_OWNS_HANDLE, 0 );
+   mfile_close( &test_file );
+
+   mfile_pack_close();
+   remove( pack_path );
+
+   /* No pack open at all. */
+   maug_mzero( entry_path, MAUG_PATH_SZ_MAX );
+   maug_strncpy( entry_path, gc_test_pack[0].name, MAUG_PATH_SZ_MAX - 1 );
+   retval = mfile_open_read( entry_path, &test_file );
+   ck_assert_uint_eq( retval, MERROR_FILE );
+}
+END_TEST
+
 Suite* mfil_suite( void ) {
    Suite* s;
    TCase* tc_mem;
@@ -110,12 +429,18 @@ Suite* mfil_suite( void ) {
    tcase_add_loop_test( tc_mem, test_mfil_mem_write, 0, TEST_MEM_SZ );
    tcase_add_loop_test( tc_mem, test_mfil_mem_insert, 1, TEST_MEM_SZ );
    tcase_add_loop_test( tc_mem, test_mfil_mem_cursor, 0, TEST_MEM_SZ );
+   tcase_add_loop_test( tc_mem, test_mfil_mem_overflow, 1, TEST_MEM_SZ );
 
    suite_add_tcase( s, tc_mem );
 
    tc_file = tcase_create( "File" );
 
    tcase_add_loop_test( tc_file, test_mfil_file_cursor, 0, TEST_MEM_SZ );
+   tcase_add_loop_test( tc_file, test_mfil_file_buf_seek, 0, TEST_MEM_SZ );
+   tcase_add_test( tc_file, test_mfil_file_buf_chunk );
+   tcase_add_loop_test(
+      tc_file, test_mfil_pack_read, 0, TEST_PACK_ENTRIES_CT );
+   tcase_add_test( tc_file, test_mfil_pack_fallback );
 
    suite_add_tcase( s, tc_file );
 
@@ -32,8 +32,14 @@ START_TEST( test_mfmt_decode_rle_4bit ) {
       ck_assert_uint_eq( check_rle_out[i], gc_check_rle_raw[i] );
    }
 
-   maug_munlock( check_rle_out_h, check_rle_out );
-   maug_mfree( check_rle_out_h );
+cleanup:
+
+   if( NULL != check_rle_out ) {
+      maug_munlock( check_rle_out_h, check_rle_out );
+   }
+   if( (MAUG_MHANDLE)NULL != check_rle_out_h ) {
+      maug_mfree( check_rle_out_h );
+   }
 
    ck_assert_uint_eq( retval, MERROR_OK );
 }
@@ -80,8 +86,14 @@ START_TEST( test_mfmt_bmp_px_4bit ) {
       ck_assert_uint_eq( check_8bit_out[i], gc_check_8bit[i] );
    }
 
-   maug_munlock( check_8bit_out_h, check_8bit_out );
-   maug_mfree( check_8bit_out_h );
+cleanup:
+
+   if( NULL != check_8bit_out ) {
+      maug_munlock( check_8bit_out_h, check_8bit_out );
+   }
+   if( (MAUG_MHANDLE)NULL != check_8bit_out_h ) {
+      maug_mfree( check_8bit_out_h );
+   }
 
    ck_assert_uint_eq( retval, MERROR_OK );
 }
@@ -2,7 +2,20 @@
 #include "maugchck.h"
 
 char g_script_simple[] = "(begin (define x 3) (define y (+ x 6)))";
+char g_script_redefine[] = "(begin (define x 3) (define y (+ x 6)) (define x 10) (define z (+ x 1)) (define w 1.5))";
 char g_script_lambda[] = "(begin (define y 1) (define cb1 (lambda (x) (begin (define y (+ x 6)) (define x (+ y 8))))) (cb1 3) (define q 3))";
+char g_script_tail[] = "(begin (define count (lambda (i) (if (< i 20) (count (+ i 1)) (gdefine n i)))) (count 0) (define loop (lambda (i) (begin (define j (+ i 1)) (if (< j 20) (loop j) (gdefine m j))))) (loop 0) (define tick (lambda () (gdefine t (+ t 1)))))";
+
+char g_script_preempt[] = "(begin (define r (slow 3 4)))";
+
+int g_slow_calls = 0;
+
+char* g_scripts[] = {
+   g_script_simple,
+   g_script_lambda,
+   g_script_redefine,
+   NULL
+};
 
 MERROR_RETVAL init_mlsp_script(
    struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec,
@@ -163,9 +176,332 @@ START_TEST( test_mlsp_exec_lambda ) {
    ck_assert_uint_eq( retval, MERROR_OK );
 }
 
+START_TEST( test_mlsp_exec_resolve ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   int8_t i = 0;
+   size_t j = 0;
+   struct MLISP_ENV_NODE* e = NULL;
+   struct MLISP_RESOLVE_NODE* r = NULL;
+   struct MLISP_PARSER parser;
+   struct MLISP_EXEC_STATE exec;
+   ssize_t baseline_env_ct = 0;
+   size_t literal_ct = 0;
+
+   /* Run the script to completion. */
+   retval = init_mlsp_script(
+      &parser, &exec, g_script_redefine, 1, &baseline_env_ct );
+   while( MERROR_OK == retval ) {
+      retval = mlisp_step( &parser, &exec );
+   }
+   ck_assert_uint_eq( retval, MERROR_EXEC );
+   retval = MERROR_OK;
+
+   /* Make sure cached symbols were dropped when x was redefined. */
+   for( i = exec.env_select ; 0 <= i ; i-- ) {
+      mdata_table_lock( &(exec.env[i]) );
+   }
+   e = mlisp_env_get( &exec, "y" );
+   ck_assert_ptr_ne( e, NULL );
+   ck_assert_int_eq( e->value.integer, 9 );
+   e = mlisp_env_get( &exec, "z" );
+   ck_assert_ptr_ne( e, NULL );
+   ck_assert_int_eq( e->value.integer, 11 );
+   e = mlisp_env_get( &exec, "w" );
+   ck_assert_ptr_ne( e, NULL );
+   ck_assert_int_eq( (int)(e->value.floating * 10), 15 );
+   for( i = exec.env_select ; 0 <= i ; i-- ) {
+      mdata_table_unlock( &(exec.env[i]) );
+   }
+
+   /* begin, 3, 6, 10, 1 and 1.5 should have been resolved up front. */
+   ck_assert_int_eq(
+      mdata_vector_ct( &(exec.per_node_resolve) ),
+      mdata_vector_ct( &(parser.ast) ) );
+   mdata_vector_lock( &(exec.per_node_resolve) );
+   for( j = 0 ; mdata_vector_ct( &(exec.per_node_resolve) ) > j ; j++ ) {
+      r = mdata_vector_get(
+         &(exec.per_node_resolve), j, struct MLISP_RESOLVE_NODE );
+      if(
+         MLISP_RESOLVE_FLAG_LITERAL == (MLISP_RESOLVE_FLAG_LITERAL & r->flags)
+      ) {
+         literal_ct++;
+      }
+   }
+   ck_assert_int_eq( literal_ct, 6 );
+
+cleanup:
+
+   if( mdata_vector_is_locked( &(exec.per_node_resolve) ) ) {
+      mdata_vector_unlock( &(exec.per_node_resolve) );
+   }
+
+   mlisp_parser_free( &parser );
+   mlisp_exec_free( &exec );
+
+   ck_assert_uint_eq( retval, MERROR_OK );
+}
+END_TEST
+
+MERROR_RETVAL init_mlsp_parser(
+   struct MLISP_PARSER* parser, const char* script
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t i = 0;
+
+   maug_mzero( parser, sizeof( struct MLISP_PARSER ) );
+
+   retval = mlisp_parser_init( parser );
+   maug_cleanup_if_not_ok();
+
+   for( i = 0 ; strlen( script ) > i ; i++ ) {
+      retval = mlisp_parse_c( parser, script[i] );
+      maug_cleanup_if_not_ok();
+   }
+
+cleanup:
+
+   return retval;
+}
+
+MERROR_RETVAL run_mlsp_script(
+   struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec, uint8_t flags,
+   size_t* p_steps
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+
+   maug_mzero( exec, sizeof( struct MLISP_EXEC_STATE ) );
+
+   retval = mlisp_exec_init( parser, exec, flags );
+   maug_cleanup_if_not_ok();
+
+   *p_steps = 0;
+   while( MERROR_OK == retval ) {
+      retval = mlisp_step( parser, exec );
+      (*p_steps)++;
+   }
+
+   if( MERROR_EXEC == retval ) {
+      /* Ran out of instructions. */
+      retval = MERROR_OK;
+   }
+
+cleanup:
+
+   return retval;
+}
+
+START_TEST( test_mlsp_bc_exec ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   int8_t i = 0;
+   size_t steps = 0;
+   struct MLISP_ENV_NODE* e = NULL;
+   struct MLISP_ENV_NODE e_tree;
+   struct MLISP_PARSER parser;
+   struct MLISP_EXEC_STATE exec;
+   struct MLISP_EXEC_STATE exec_bc;
+   const char* keys[] = { "x", "y", "z", "w", "q", NULL };
+   size_t k = 0;
+
+   retval = init_mlsp_parser( &parser, g_scripts[_i] );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   /* Both modes should end with the same env. */
+   retval = run_mlsp_script( &parser, &exec, 0, &steps );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   retval = run_mlsp_script(
+      &parser, &exec_bc, MLISP_EXEC_FLAG_BYTECODE, &steps );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   ck_assert_int_eq( exec_bc.env_select, exec.env_select );
+
+   for( i = exec.env_select ; 0 <= i ; i-- ) {
+      mdata_table_lock( &(exec.env[i]) );
+      mdata_table_lock( &(exec_bc.env[i]) );
+   }
+   for( k = 0 ; NULL != keys[k] ; k++ ) {
+      e = mlisp_env_get( &exec, keys[k] );
+      if( NULL == e ) {
+         ck_assert_ptr_eq( mlisp_env_get( &exec_bc, keys[k] ), NULL );
+         continue;
+      }
+      memcpy( &e_tree, e, sizeof( struct MLISP_ENV_NODE ) );
+      e = mlisp_env_get( &exec_bc, keys[k] );
+      ck_assert_ptr_ne( e, NULL );
+      ck_assert_int_eq( e->type, e_tree.type );
+      ck_assert_int_eq( e->value.integer, e_tree.value.integer );
+   }
+   for( i = exec.env_select ; 0 <= i ; i-- ) {
+      mdata_table_unlock( &(exec.env[i]) );
+      mdata_table_unlock( &(exec_bc.env[i]) );
+   }
+
+   mlisp_exec_free( &exec );
+   mlisp_exec_free( &exec_bc );
+   mlisp_parser_free( &parser );
+}
+END_TEST
+
+START_TEST( test_mlsp_bc_tail ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t steps = 0;
+   struct MLISP_ENV_NODE* e = NULL;
+   struct MLISP_PARSER parser;
+   struct MLISP_EXEC_STATE exec;
+   struct MDATA_TABLE global_env;
+   int16_t zero = 0;
+   int i = 0;
+
+   maug_mzero( &global_env, sizeof( struct MDATA_TABLE ) );
+
+   retval = init_mlsp_parser( &parser, g_script_tail );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   maug_mzero( &exec, sizeof( struct MLISP_EXEC_STATE ) );
+   retval = mlisp_exec_init( &parser, &exec, MLISP_EXEC_FLAG_BYTECODE );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   retval = mlisp_exec_set_global_env( &parser, &exec, &global_env );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   retval = mlisp_env_set( &exec, "t", 1, MLISP_TYPE_INT, &zero, 1, 0 );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   /* Recursing 20 deep would run out of env frames without tail calls, even
+    * out of the end of a begin.
+    */
+   while( MERROR_OK == retval ) {
+      retval = mlisp_step( &parser, &exec );
+      steps++;
+   }
+   ck_assert_uint_eq( retval, MERROR_EXEC );
+   ck_assert_int_eq( exec.env_select, 0 );
+
+   /* Call a lambda from outside a few times. */
+   for( i = 0 ; 3 > i ; i++ ) {
+      do {
+         retval = mlisp_step_lambda( &parser, &exec, "tick" );
+      } while( MERROR_PREEMPT == retval );
+      ck_assert_uint_eq( retval, MERROR_OK );
+   }
+   ck_assert_int_eq( exec.env_select, 0 );
+
+   mdata_table_lock( &global_env );
+   e = mdata_table_get( &global_env, "n", struct MLISP_ENV_NODE );
+   ck_assert_ptr_ne( e, NULL );
+   ck_assert_int_eq( e->value.integer, 20 );
+   e = mdata_table_get( &global_env, "m", struct MLISP_ENV_NODE );
+   ck_assert_ptr_ne( e, NULL );
+   ck_assert_int_eq( e->value.integer, 20 );
+   e = mdata_table_get( &global_env, "t", struct MLISP_ENV_NODE );
+   ck_assert_ptr_ne( e, NULL );
+   ck_assert_int_eq( e->value.integer, 3 );
+   mdata_table_unlock( &global_env );
+
+   mlisp_exec_free( &exec );
+   mlisp_parser_free( &parser );
+   mdata_table_free( &global_env );
+}
+END_TEST
+
+START_TEST( test_mlsp_bc_env_lock ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_PARSER parser;
+   struct MLISP_EXEC_STATE exec;
+   struct MDATA_TABLE global_env;
+
+   maug_mzero( &global_env, sizeof( struct MDATA_TABLE ) );
+
+   retval = init_mlsp_parser( &parser, g_script_simple );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   maug_mzero( &exec, sizeof( struct MLISP_EXEC_STATE ) );
+   retval = mlisp_exec_init( &parser, &exec, MLISP_EXEC_FLAG_BYTECODE );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   retval = mlisp_exec_set_global_env( &parser, &exec, &global_env );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   /* A lock held by the caller should still be held after each step. */
+   mdata_table_lock( &global_env );
+   while( MERROR_OK == retval ) {
+      retval = mlisp_step( &parser, &exec );
+      ck_assert_int_eq( mdata_table_is_locked( &global_env ), 1 );
+      ck_assert_int_eq( mdata_table_is_locked( &(exec.env[0]) ), 0 );
+   }
+   ck_assert_uint_eq( retval, MERROR_EXEC );
+   mdata_table_unlock( &global_env );
+
+   mlisp_exec_free( &exec );
+   mlisp_parser_free( &parser );
+   mdata_table_free( &global_env );
+}
+END_TEST
+
+static MERROR_RETVAL _mlsp_cb_slow(
+   struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec, size_t n_idx,
+   size_t args_c, uint8_t* cb_data, uint8_t flags
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_STACK_NODE a;
+   struct MLISP_STACK_NODE b;
+
+   retval = mlisp_stack_pop( exec, &b );
+   maug_cleanup_if_not_ok();
+   retval = mlisp_stack_pop( exec, &a );
+   maug_cleanup_if_not_ok();
+
+   /* Wait a couple of steps before finishing. */
+   g_slow_calls++;
+   if( 3 > g_slow_calls ) {
+      retval = MERROR_PREEMPT;
+      goto cleanup;
+   }
+
+   retval = _mlisp_stack_push_int16_t(
+      exec, (a.value.integer * 10) + b.value.integer );
+
+cleanup:
+
+   return retval;
+}
+
+START_TEST( test_mlsp_bc_preempt ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_ENV_NODE* e = NULL;
+   struct MLISP_PARSER parser;
+   struct MLISP_EXEC_STATE exec;
+
+   g_slow_calls = 0;
+
+   retval = init_mlsp_parser( &parser, g_script_preempt );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   maug_mzero( &exec, sizeof( struct MLISP_EXEC_STATE ) );
+   retval = mlisp_exec_init( &parser, &exec, MLISP_EXEC_FLAG_BYTECODE );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   retval = mlisp_env_set(
+      &exec, "slow", 4, MLISP_TYPE_CB, _mlsp_cb_slow, 0, 0 );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   /* The callback should get the same args every time it's called. */
+   while( MERROR_OK == retval ) {
+      retval = mlisp_step( &parser, &exec );
+   }
+   ck_assert_uint_eq( retval, MERROR_EXEC );
+   ck_assert_int_eq( g_slow_calls, 3 );
+
+   mdata_table_lock( &(exec.env[0]) );
+   e = mlisp_env_get( &exec, "r" );
+   ck_assert_ptr_ne( e, NULL );
+   ck_assert_int_eq( e->type, MLISP_TYPE_INT );
+   ck_assert_int_eq( e->value.integer, 34 );
+   mdata_table_unlock( &(exec.env[0]) );
+
+   mlisp_exec_free( &exec );
+   mlisp_parser_free( &parser );
+}
+END_TEST
+
 Suite* mlsp_suite( void ) {
    Suite* s;
    TCase* tc_exec;
+   TCase* tc_bc;
 
    s = suite_create( "mlsp" );
 
@@ -173,9 +509,19 @@ Suite* mlsp_suite( void ) {
 
    tcase_add_loop_test( tc_exec, test_mlsp_exec_step, 0, 9 );
    tcase_add_loop_test( tc_exec, test_mlsp_exec_lambda, 0, 24 );
+   tcase_add_test( tc_exec, test_mlsp_exec_resolve );
 
    suite_add_tcase( s, tc_exec );
 
+   tc_bc = tcase_create( "Bytecode" );
+
+   tcase_add_loop_test( tc_bc, test_mlsp_bc_exec, 0, 3 );
+   tcase_add_test( tc_bc, test_mlsp_bc_tail );
+   tcase_add_test( tc_bc, test_mlsp_bc_env_lock );
+   tcase_add_test( tc_bc, test_mlsp_bc_preempt );
+
+   suite_add_tcase( s, tc_bc );
+
    return s;
 }
 
@@ -3,6 +3,15 @@
 
 #define VEC_ARR_LOOPS 3
 
+#define VEC_RT_SZ 1024
+
+uint16_t g_test_vec_packed[] = { 0x0001, 0x1234, 0xffff };
+
+uint8_t g_test_vec_packed_ser[] = {
+   0x44, 0x0b, 0x02, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x34, 0x12, 0xff,
+   0xff
+};
+
 uint8_t g_test_vec_ser[] = {
    0x30, 0x25, 0x02, 0x01, 0x01, 0x02, 0x01, 0x02, 0x02, 0x01, 0x04, 0x02,
    0x01, 0x08, 0x02, 0x01, 0x10, 0x02, 0x01, 0x20, 0x02, 0x01, 0x40, 0x02,
@@ -283,6 +292,172 @@ START_TEST( test_mser_vector_write_arr ) {
 }
 END_TEST
 
+START_TEST( test_mser_vector_packed_read ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   mfile_t ser_mem;
+   struct MDATA_VECTOR vec_test;
+   uint16_t value_buf = 0;
+   ssize_t ser_sz = 0;
+   size_t i = 0;
+
+   maug_mzero( &vec_test, sizeof( struct MDATA_VECTOR ) );
+
+   retval = mfile_lock_buffer(
+      (MAUG_MHANDLE)NULL, g_test_vec_packed_ser,
+      sizeof( g_test_vec_packed_ser ), &ser_mem );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   retval = mdeserialize_vector(
+      &ser_mem, &vec_test, 1, (mdeserialize_cb_t)mdeserialize_uint16_t,
+      (uint8_t*)&value_buf, sizeof( uint16_t ), &ser_sz );
+   ck_assert_uint_eq( retval, MERROR_OK );
+   ck_assert_int_eq( ser_sz, sizeof( g_test_vec_packed_ser ) );
+
+   close_temp( &ser_mem );
+
+   ck_assert_uint_eq( mdata_vector_ct( &vec_test ), 3 );
+
+   mdata_vector_lock( &vec_test );
+   for( i = 0 ; mdata_vector_ct( &vec_test ) > i ; i++ ) {
+      ck_assert_uint_eq(
+         *(mdata_vector_get( &vec_test, i, uint16_t )), g_test_vec_packed[i] );
+   }
+   mdata_vector_unlock( &vec_test );
+
+cleanup:
+
+   mdata_vector_free( &vec_test );
+
+   ck_assert_uint_eq( retval, MERROR_OK );
+}
+END_TEST
+
+START_TEST( test_mser_vector_packed_write ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MDATA_VECTOR vec_test;
+   uint8_t buf_mem[sizeof( g_test_vec_packed_ser )];
+   mfile_t ser_mem;
+   size_t i = 0;
+
+   maug_mzero( &vec_test, sizeof( struct MDATA_VECTOR ) );
+   for( i = 0 ; 3 > i ; i++ ) {
+      mdata_vector_append(
+         &vec_test, &(g_test_vec_packed[i]), sizeof( uint16_t ) );
+   }
+
+   maug_mzero( buf_mem, sizeof( g_test_vec_packed_ser ) );
+
+   retval = open_temp( "chkvecpk", &ser_mem );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   retval = mserialize_vector( &ser_mem, &vec_test, 1,
+      (mserialize_cb_t)mserialize_uint16_t );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   ck_assert_uint_eq(
+      mfile_get_sz( &ser_mem ), sizeof( g_test_vec_packed_ser ) );
+
+   ser_mem.seek( &ser_mem, 0 );
+   ser_mem.read_block( &ser_mem, buf_mem, sizeof( g_test_vec_packed_ser ) );
+
+   ck_assert_mem_eq(
+      buf_mem, g_test_vec_packed_ser, sizeof( g_test_vec_packed_ser ) );
+
+   mdata_vector_free( &vec_test );
+
+   close_temp( &ser_mem );
+}
+END_TEST
+
+static MERROR_RETVAL vector_round_trip(
+   struct MDATA_VECTOR* vec_in, struct MDATA_VECTOR* vec_out,
+   mserialize_cb_t ser_cb, mdeserialize_cb_t deser_cb, size_t item_sz
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   mfile_t ser_mem;
+   uint8_t value_buf[sizeof( size_t )];
+   ssize_t ser_sz = 0;
+
+   maug_mzero( vec_out, sizeof( struct MDATA_VECTOR ) );
+
+   retval = open_temp( "chkvecrt", &ser_mem );
+   maug_cleanup_if_not_ok();
+
+   retval = mserialize_vector( &ser_mem, vec_in, 1, ser_cb );
+   maug_cleanup_if_not_ok();
+
+   ser_mem.seek( &ser_mem, 0 );
+
+   retval = mdeserialize_vector(
+      &ser_mem, vec_out, 1, deser_cb, value_buf, item_sz, &ser_sz );
+   maug_cleanup_if_not_ok();
+
+cleanup:
+
+   close_temp( &ser_mem );
+
+   return retval;
+}
+
+START_TEST( test_mser_vector_packed_round_trip ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MDATA_VECTOR vec_packed;
+   struct MDATA_VECTOR vec_seq;
+   struct MDATA_VECTOR vec_out;
+   size_t i = 0;
+   uint32_t value_packed = 0;
+   size_t value_seq = 0;
+
+   maug_mzero( &vec_packed, sizeof( struct MDATA_VECTOR ) );
+   maug_mzero( &vec_seq, sizeof( struct MDATA_VECTOR ) );
+   maug_mzero( &vec_out, sizeof( struct MDATA_VECTOR ) );
+
+   for( i = 0 ; VEC_RT_SZ > i ; i++ ) {
+      value_packed = i * 2654435761u;
+      mdata_vector_append( &vec_packed, &value_packed, sizeof( uint32_t ) );
+      value_seq = value_packed & 0x7fffffff;
+      mdata_vector_append( &vec_seq, &value_seq, sizeof( size_t ) );
+   }
+
+   /* A vector of uint32_t is written packed. */
+   retval = vector_round_trip( &vec_packed, &vec_out,
+      (mserialize_cb_t)mserialize_uint32_t,
+      (mdeserialize_cb_t)mdeserialize_uint32_t, sizeof( uint32_t ) );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   ck_assert_uint_eq( mdata_vector_ct( &vec_out ), VEC_RT_SZ );
+   mdata_vector_lock( &vec_out );
+   mdata_vector_lock( &vec_packed );
+   ck_assert_mem_eq( vec_out.data_bytes, vec_packed.data_bytes,
+      VEC_RT_SZ * sizeof( uint32_t ) );
+   mdata_vector_unlock( &vec_packed );
+   mdata_vector_unlock( &vec_out );
+   mdata_vector_free( &vec_out );
+
+   /* A vector of size_t is still written as a sequence. */
+   retval = vector_round_trip( &vec_seq, &vec_out,
+      (mserialize_cb_t)mserialize_size_t,
+      (mdeserialize_cb_t)mdeserialize_size_t, sizeof( size_t ) );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   ck_assert_uint_eq( mdata_vector_ct( &vec_out ), VEC_RT_SZ );
+   mdata_vector_lock( &vec_out );
+   mdata_vector_lock( &vec_seq );
+   ck_assert_mem_eq( vec_out.data_bytes, vec_seq.data_bytes,
+      VEC_RT_SZ * sizeof( size_t ) );
+   mdata_vector_unlock( &vec_seq );
+   mdata_vector_unlock( &vec_out );
+
+cleanup:
+
+   mdata_vector_free( &vec_out );
+   mdata_vector_free( &vec_seq );
+   mdata_vector_free( &vec_packed );
+
+   ck_assert_uint_eq( retval, MERROR_OK );
+}
+END_TEST
+
 void gen_test_tab( struct MDATA_TABLE* tab_test, size_t i_mult ) {
    size_t i = 0;
    size_t i_buf = 0;
@@ -467,11 +642,103 @@ START_TEST( test_mser_table_write_arr ) {
 }
 END_TEST
 
+START_TEST( test_mser_writer_vector_arr ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MDATA_VECTOR vec_test[VEC_ARR_LOOPS];
+   struct MSERIALIZE_WRITER writer;
+   uint8_t buf_mem[sizeof( g_test_vec_arr_ser )];
+   mfile_t ser_mem;
+   size_t i = 0;
+
+   for( i = 0 ; VEC_ARR_LOOPS > i ; i++ ) {
+      gen_test_vec( &(vec_test[i]), i + 1 );
+   }
+
+   maug_mzero( buf_mem, sizeof( g_test_vec_arr_ser ) );
+
+   /* Start small so the buffer has to grow. */
+   retval = mserialize_writer_init( &writer, 16 );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   retval = mserialize_vector( &(writer.buf), vec_test, VEC_ARR_LOOPS,
+      (mserialize_cb_t)mserialize_size_t );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   retval = open_temp( "chkwrvec", &ser_mem );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   retval = mserialize_writer_flush( &writer, &ser_mem );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   ck_assert_uint_eq( mfile_get_sz( &ser_mem ), sizeof( g_test_vec_arr_ser ) );
+
+   ser_mem.seek( &ser_mem, 0 );
+   ser_mem.read_block( &ser_mem, buf_mem, sizeof( g_test_vec_arr_ser ) );
+
+   ck_assert_mem_eq(
+      buf_mem, g_test_vec_arr_ser, sizeof( g_test_vec_arr_ser ) );
+
+   for( i = 0 ; VEC_ARR_LOOPS > i ; i++ ) {
+      mdata_vector_free( &(vec_test[i]) );
+   }
+
+   mserialize_writer_free( &writer );
+
+   close_temp( &ser_mem );
+}
+END_TEST
+
+START_TEST( test_mser_writer_table_arr ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MDATA_TABLE tab_test[VEC_ARR_LOOPS];
+   struct MSERIALIZE_WRITER writer;
+   uint8_t buf_mem[sizeof( g_test_tab_arr_ser )];
+   mfile_t ser_mem;
+   size_t i = 0;
+
+   for( i = 0 ; VEC_ARR_LOOPS > i ; i++ ) {
+      gen_test_tab( &(tab_test[i]), i + 1 );
+   }
+
+   maug_mzero( buf_mem, sizeof( g_test_tab_arr_ser ) );
+
+   retval = mserialize_writer_init( &writer, 0 );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   retval = mserialize_table( &(writer.buf), tab_test, VEC_ARR_LOOPS,
+      (mserialize_cb_t)mserialize_size_t );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   retval = open_temp( "chkwrtab", &ser_mem );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   retval = mserialize_writer_flush( &writer, &ser_mem );
+   ck_assert_uint_eq( retval, MERROR_OK );
+
+   ck_assert_uint_eq( mfile_get_sz( &ser_mem ), sizeof( g_test_tab_arr_ser ) );
+
+   ser_mem.seek( &ser_mem, 0 );
+   ser_mem.read_block( &ser_mem, buf_mem, sizeof( g_test_tab_arr_ser ) );
+
+   ck_assert_mem_eq(
+      buf_mem, g_test_tab_arr_ser, sizeof( g_test_tab_arr_ser ) );
+
+   for( i = 0 ; VEC_ARR_LOOPS > i ; i++ ) {
+      mdata_table_free( &tab_test[i] );
+   }
+
+   mserialize_writer_free( &writer );
+
+   close_temp( &ser_mem );
+}
+END_TEST
+
 Suite* mser_suite( void ) {
    Suite* s;
    TCase* tc_struct;
    TCase* tc_vector;
    TCase* tc_table;
+   TCase* tc_writer;
 
    s = suite_create( "mser" );
 
@@ -490,6 +757,9 @@ Suite* mser_suite( void ) {
    tcase_add_loop_test( tc_vector, test_mser_vector_read_arr, 0, 11 );
    tcase_add_test( tc_vector, test_mser_vector_write );
    tcase_add_test( tc_vector, test_mser_vector_write_arr );
+   tcase_add_test( tc_vector, test_mser_vector_packed_read );
+   tcase_add_test( tc_vector, test_mser_vector_packed_write );
+   tcase_add_test( tc_vector, test_mser_vector_packed_round_trip );
 
    suite_add_tcase( s, tc_vector );
    
@@ -504,6 +774,15 @@ Suite* mser_suite( void ) {
 
    suite_add_tcase( s, tc_table );
 
+   /* = */
+
+   tc_writer = tcase_create( "Writer" );
+
+   tcase_add_test( tc_writer, test_mser_writer_vector_arr );
+   tcase_add_test( tc_writer, test_mser_writer_table_arr );
+
+   suite_add_tcase( s, tc_writer );
+
    return s;
 }
 
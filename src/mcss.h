@@ -20,6 +20,18 @@
 #  define MCSS_CLASS_SZ_MAX 128
 #endif /* !MCSS_CLASS_SZ_MAX */
 
+#ifndef MCSS_TAG_SZ_MAX
+#  define MCSS_TAG_SZ_MAX 16
+#endif /* !MCSS_TAG_SZ_MAX */
+
+#ifndef MCSS_INDEX_SZ_MIN
+/**
+ * \brief Minimum number of slots in the MCSS_PARSER::index selector index.
+ *        Must be a power of 2.
+ */
+#  define MCSS_INDEX_SZ_MIN 16
+#endif /* !MCSS_INDEX_SZ_MIN */
+
 #ifndef MCSS_TRACE_LVL
 #  define MCSS_TRACE_LVL 0
 #endif /* !MCSS_TRACE_LVL */
@@ -53,6 +65,11 @@
  */
 #define MCSS_SELECT_CLASS         0x02
 
+/**
+ * \brief The select is selected by HTML element type (e.g. DIV).
+ */
+#define MCSS_SELECT_TAG           0x04
+
 /*! \} */
 
 #define MCSS_PARSER_PSTATE_TABLE( f ) \
@@ -61,7 +78,8 @@
    f( MCSS_PSTATE_RULE, 2 ) \
    f( MCSS_PSTATE_CLASS, 3 ) \
    f( MCSS_PSTATE_ID, 4 ) \
-   f( MCSS_PSTATE_BLOCK, 5 )
+   f( MCSS_PSTATE_BLOCK, 5 ) \
+   f( MCSS_PSTATE_TAG, 6 )
 
 /* TODO: Function names should be verb_noun! */
 
@@ -170,6 +188,9 @@ struct MCSS_STYLE {
    /* TODO: Use str_stable for class. */
    char class[MCSS_CLASS_SZ_MAX];
    size_t class_sz;
+   /*! \brief Uppercase HTML element name, if selected by element type. */
+   char tag[MCSS_TAG_SZ_MAX];
+   size_t tag_sz;
    MCSS_PROP_TABLE( MCSS_PROP_TABLE_PROPS )
 };
 
@@ -181,14 +202,43 @@ struct MCSS_PARSER {
    struct MDATA_VECTOR styles;
    struct MDATA_STRPOOL strpool;
    RETROFLAT_COLOR colors[16];
+   /*! \brief Index of style indexes, keyed by selector hash. */
+   struct MDATA_INDEX index;
+   /*! \brief Number of styles that have been considered for the index. */
+   size_t index_styles_ct;
 };
 
 MERROR_RETVAL mcss_push_style(
    struct MCSS_PARSER* parser, uint8_t select_by,
    const char* select, size_t select_sz );
 
+/**
+ * \brief Finish processing the current token. If this leaves the parser
+ *        outside of any block, the selector index is brought up to date with
+ *        mcss_parser_index().
+ */
 MERROR_RETVAL mcss_parser_flush( struct MCSS_PARSER* parser );
 
+/**
+ * \brief Add any styles pushed since the last call to the selector index
+ *        used by mcss_select().
+ */
+MERROR_RETVAL mcss_parser_index( struct MCSS_PARSER* parser );
+
+/**
+ * \brief Append the indexes of all styles whose selector matches the given
+ *        selector to a list, in stylesheet order.
+ * \param select_by Selector type (e.g. ::MCSS_SELECT_CLASS).
+ * \param matches Array to append matching style indexes to.
+ * \param p_matches_sz Pointer to the number of indexes already in matches.
+ *                     Incremented for each index appended.
+ * \param matches_sz_max Capacity of matches. Further matches are dropped.
+ */
+MERROR_RETVAL mcss_select(
+   struct MCSS_PARSER* parser, uint8_t select_by,
+   const char* select, size_t select_sz,
+   ssize_t* matches, size_t* p_matches_sz, size_t matches_sz_max );
+
 MERROR_RETVAL mcss_parse_c( struct MCSS_PARSER* parser, char c );
 
 MERROR_RETVAL mcss_style_init( struct MCSS_STYLE* style );
@@ -482,22 +532,35 @@ MERROR_RETVAL mcss_push_style(
    /* Create an empty new style. */
    maug_mzero( &style, sizeof( struct MCSS_STYLE ) );
 
-   /* Define the selector. */
+   /* Define the selector. Long selectors are truncated to fit, and their
+    * sizes with them, since the index hashes and compares by size. The style
+    * was zeroed above, so the copy is always terminated.
+    */
    /* TODO: Merge selector fields to save space; add select_by to struct. */
    switch( select_by ) {
    case MCSS_SELECT_CLASS:
-      maug_strncpy( style.class, select, MCSS_CLASS_SZ_MAX );
-      style.class_sz = select_sz;
+      style.class_sz =
+         MCSS_CLASS_SZ_MAX > select_sz ? select_sz : MCSS_CLASS_SZ_MAX - 1;
+      maug_mcpy( style.class, select, style.class_sz );
       debug_printf( MCSS_TRACE_LVL, "pushed style block " SSIZE_T_FMT ": .%s",
          style_idx, style.class );
       break;
 
    case MCSS_SELECT_ID:
-      maug_strncpy( style.id, select, MCSS_ID_SZ_MAX );
-      style.id_sz = select_sz;
+      style.id_sz =
+         MCSS_ID_SZ_MAX > select_sz ? select_sz : MCSS_ID_SZ_MAX - 1;
+      maug_mcpy( style.id, select, style.id_sz );
       debug_printf( MCSS_TRACE_LVL, "pushed style block " SSIZE_T_FMT ": #%s",
          style_idx, style.id );
       break;
+
+   case MCSS_SELECT_TAG:
+      style.tag_sz =
+         MCSS_TAG_SZ_MAX > select_sz ? select_sz : MCSS_TAG_SZ_MAX - 1;
+      maug_mcpy( style.tag, select, style.tag_sz );
+      debug_printf( MCSS_TRACE_LVL, "pushed style block " SSIZE_T_FMT ": %s",
+         style_idx, style.tag );
+      break;
    }
 
    style_idx = mdata_vector_append(
@@ -512,6 +575,217 @@ cleanup:
    return retval;
 }
 
+static uint8_t mcss_style_selector(
+   struct MCSS_STYLE* style, const char** p_select, size_t* p_select_sz
+) {
+   if( 0 < style->id_sz ) {
+      *p_select = style->id;
+      *p_select_sz = style->id_sz;
+      return MCSS_SELECT_ID;
+   } else if( 0 < style->class_sz ) {
+      *p_select = style->class;
+      *p_select_sz = style->class_sz;
+      return MCSS_SELECT_CLASS;
+   } else if( 0 < style->tag_sz ) {
+      *p_select = style->tag;
+      *p_select_sz = style->tag_sz;
+      return MCSS_SELECT_TAG;
+   }
+
+   /* Per-element styles are not indexed. */
+   return MCSS_SELECT_NONE;
+}
+
+/* === */
+
+#define mcss_select_hash( select_by, select, select_sz ) \
+   (mdata_hash( select, select_sz ) ^ (uint32_t)(select_by))
+
+/* === */
+
+/**
+ * \brief What mcss_select() is looking for in the stylesheet.
+ */
+struct MCSS_SELECT_KEY {
+   uint8_t select_by;
+   const char* select;
+   size_t select_sz;
+};
+
+/* === */
+
+static int mcss_index_hash( void* data, size_t style_idx, uint32_t* p_hash ) {
+   struct MCSS_PARSER* parser = (struct MCSS_PARSER*)data;
+   struct MCSS_STYLE* style = NULL;
+   const char* select = NULL;
+   size_t select_sz = 0;
+   uint8_t select_by = 0;
+
+   style = mdata_vector_get( &(parser->styles), style_idx, struct MCSS_STYLE );
+   assert( NULL != style );
+
+   select_by = mcss_style_selector( style, &select, &select_sz );
+   if( MCSS_SELECT_NONE == select_by ) {
+      return 0;
+   }
+
+   *p_hash = mcss_select_hash( select_by, select, select_sz );
+
+   return 1;
+}
+
+/* === */
+
+static int mcss_index_match(
+   void* data, size_t style_idx, const void* key
+) {
+   struct MCSS_PARSER* parser = (struct MCSS_PARSER*)data;
+   const struct MCSS_SELECT_KEY* k = (const struct MCSS_SELECT_KEY*)key;
+   struct MCSS_STYLE* style = NULL;
+   const char* select = NULL;
+   size_t select_sz = 0;
+
+   style = mdata_vector_get( &(parser->styles), style_idx, struct MCSS_STYLE );
+   assert( NULL != style );
+
+   return
+      k->select_by == mcss_style_selector( style, &select, &select_sz ) &&
+      k->select_sz == select_sz &&
+      0 == maug_strncmp( k->select, select, select_sz );
+}
+
+/* === */
+
+MERROR_RETVAL mcss_parser_index( struct MCSS_PARSER* parser ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t i = 0;
+   uint32_t hash = 0;
+   uint8_t autolock = 0;
+
+   if( mdata_vector_ct( &(parser->styles) ) == parser->index_styles_ct ) {
+      /* Nothing new to index. */
+      goto cleanup;
+   }
+
+   if( !mdata_vector_is_locked( &(parser->styles) ) ) {
+      mdata_vector_lock( &(parser->styles) );
+      autolock = 1;
+   }
+
+   if( mdata_vector_ct( &(parser->styles) ) * 2 > parser->index.slots_sz ) {
+      /* Rebuild the whole index with room to spare. */
+      debug_printf( MCSS_TRACE_LVL, "rebuilding style index..." );
+      retval = mdata_index_rebuild( &(parser->index),
+         mdata_vector_ct( &(parser->styles) ), MCSS_INDEX_SZ_MIN,
+         mcss_index_hash, parser );
+      maug_cleanup_if_not_ok();
+   } else {
+      /* Styles with the same selector stay in stylesheet order along the
+       * probe chain.
+       */
+      mdata_index_lock( &(parser->index) );
+      for(
+         i = parser->index_styles_ct ;
+         mdata_vector_ct( &(parser->styles) ) > i ;
+         i++
+      ) {
+         if( mcss_index_hash( parser, i, &hash ) ) {
+            mdata_index_insert( &(parser->index), hash, i );
+         }
+      }
+   }
+   parser->index_styles_ct = mdata_vector_ct( &(parser->styles) );
+
+cleanup:
+
+   mdata_index_unlock( &(parser->index) );
+
+   if( MERROR_OK != retval ) {
+      /* Without an index, mcss_select() falls back to a scan. */
+      mdata_index_free( &(parser->index) );
+      parser->index_styles_ct = 0;
+   }
+
+   if( autolock ) {
+      mdata_vector_unlock( &(parser->styles) );
+   }
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL mcss_select(
+   struct MCSS_PARSER* parser, uint8_t select_by,
+   const char* select, size_t select_sz,
+   ssize_t* matches, size_t* p_matches_sz, size_t matches_sz_max
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MCSS_SELECT_KEY key;
+   uint32_t hash = 0;
+   size_t probe = 0,
+      i = 0;
+   ssize_t style_idx = 0;
+   uint8_t autolock = 0;
+
+   if( 0 == select_sz || 0 == mdata_vector_ct( &(parser->styles) ) ) {
+      goto cleanup;
+   }
+
+   /* Styles may have been pushed outside of a stylesheet since last flush. */
+   mcss_parser_index( parser );
+
+   if( !mdata_vector_is_locked( &(parser->styles) ) ) {
+      mdata_vector_lock( &(parser->styles) );
+      autolock = 1;
+   }
+
+   key.select_by = select_by;
+   key.select = select;
+   key.select_sz = select_sz;
+
+   if( 0 < parser->index.slots_sz ) {
+      mdata_index_lock( &(parser->index) );
+      hash = mcss_select_hash( select_by, select, select_sz );
+   }
+
+   /* Walk the probe chain, or every style if there's no index. */
+   for( i = 0 ; ; i++ ) {
+      if( mdata_index_is_locked( &(parser->index) ) ) {
+         style_idx = mdata_index_probe( &(parser->index), hash, &probe,
+            mcss_index_match, parser, &key );
+         if( 0 > style_idx ) {
+            break;
+         }
+      } else if( mdata_vector_ct( &(parser->styles) ) > i ) {
+         if( !mcss_index_match( parser, i, &key ) ) {
+            continue;
+         }
+         style_idx = i;
+      } else {
+         break;
+      }
+
+      if( *p_matches_sz >= matches_sz_max ) {
+         error_printf( "too many styles match selector: %s", select );
+         break;
+      }
+      matches[(*p_matches_sz)++] = style_idx;
+   }
+
+cleanup:
+
+   mdata_index_unlock( &(parser->index) );
+
+   if( autolock ) {
+      mdata_vector_unlock( &(parser->styles) );
+   }
+
+   return retval;
+}
+
+/* === */
+
 MERROR_RETVAL mcss_parser_flush( struct MCSS_PARSER* parser ) {
    MERROR_RETVAL retval = MERROR_OK;
 
@@ -546,6 +820,13 @@ MERROR_RETVAL mcss_parser_flush( struct MCSS_PARSER* parser ) {
 
 cleanup:
 
+   if( MCSS_PSTATE_NONE == mcss_parser_pstate( parser ) ) {
+      /* Out of any block, so index what we have for lookups. An index failure
+       * isn't a parse error, since lookups can still scan.
+       */
+      mcss_parser_index( parser );
+   }
+
    return retval;
 }
 
@@ -638,6 +919,25 @@ MERROR_RETVAL mcss_parse_c( struct MCSS_PARSER* parser, char c ) {
             parser->base.token, parser->base.token_sz );
          mcss_parser_pstate_push( parser, MCSS_PSTATE_BLOCK );
          mcss_parser_reset_token( parser );
+
+      } else if(
+         MCSS_PSTATE_NONE == mcss_parser_pstate( parser ) &&
+         0 < parser->base.token_sz
+      ) {
+         /* Element type selector, e.g. "div {". */
+         while(
+            0 < parser->base.token_sz &&
+            ' ' == parser->base.token[parser->base.token_sz - 1]
+         ) {
+            parser->base.token_sz--;
+            parser->base.token[parser->base.token_sz] = '\0';
+         }
+         mparser_token_upper( &((parser)->base), i );
+         mcss_parser_pstate_push( parser, MCSS_PSTATE_TAG );
+         mcss_push_style( parser, MCSS_SELECT_TAG,
+            parser->base.token, parser->base.token_sz );
+         mcss_parser_pstate_push( parser, MCSS_PSTATE_BLOCK );
+         mcss_parser_reset_token( parser );
       }
       break;
 
@@ -646,8 +946,9 @@ MERROR_RETVAL mcss_parse_c( struct MCSS_PARSER* parser, char c ) {
          mcss_parser_pstate_pop( parser );
          mcss_parser_reset_token( parser );
          /* TODO: Handle multiple classes/IDs. */
-         mcss_parser_pstate_pop( parser ); /* Class or ID */
+         mcss_parser_pstate_pop( parser ); /* Class, ID, or tag */
       }
+      break;
 
    default:
       retval = mcss_parser_append_token( parser, c );
@@ -685,6 +986,9 @@ void mcss_parser_free( struct MCSS_PARSER* parser ) {
 
    mdata_vector_free( &(parser->styles) );
 
+   mdata_index_free( &(parser->index) );
+   parser->index_styles_ct = 0;
+
    mdata_strpool_free( &(parser->strpool ) );
 }
 
@@ -26,10 +26,32 @@
 #  define MDATA_TABLE_TRACE_LVL 0
 #endif /* !MDATA_TABLE_TRACE_LVL */
 
+#ifndef MDATA_INDEX_TRACE_LVL
+#  define MDATA_INDEX_TRACE_LVL 0
+#endif /* !MDATA_INDEX_TRACE_LVL */
+
 #ifndef MDATA_TABLE_KEY_SZ_MAX
 #  define MDATA_TABLE_KEY_SZ_MAX 8
 #endif /* !MDATA_TABLE_KEY_SZ_MAX */
 
+#ifndef MDATA_TABLE_IDX_SZ_MIN
+/**
+ * \relates MDATA_TABLE
+ * \brief Minimum number of slots in MDATA_TABLE::data_idx. Must be a power
+ *        of 2.
+ */
+#  define MDATA_TABLE_IDX_SZ_MIN 16
+#endif /* !MDATA_TABLE_IDX_SZ_MIN */
+
+#ifndef MDATA_STRPOOL_HASH_SZ_MIN
+/**
+ * \relates MDATA_STRPOOL
+ * \brief Minimum number of slots in a MDATA_STRPOOL hash index. Must be a
+ *        power of 2.
+ */
+#  define MDATA_STRPOOL_HASH_SZ_MIN 16
+#endif /* !MDATA_STRPOOL_HASH_SZ_MIN */
+
 /**
  * \addtogroup mdata_vector
  * \{
@@ -78,6 +100,10 @@ typedef size_t mdata_strpool_idx_t;
  * Append strings with mdata_strpool_append(), then reference them by the
  * returned character index. Find strings with mdata_strpool_find() later
  * and store that index.
+ *
+ * Unless MDATA_STRPOOL_NO_HASH is defined, an open-addressed index of string
+ * indexes keyed by mdata_hash() is kept alongside the pool, so that
+ * mdata_strpool_find() does not have to walk every string.
  */
 struct MDATA_STRPOOL {
    uint8_t flags;
@@ -86,6 +112,15 @@ struct MDATA_STRPOOL {
    size_t str_ct;
    size_t str_sz;
    size_t str_sz_max;
+#ifndef MDATA_STRPOOL_NO_HASH
+   /**
+    * \brief Handle for the hash index: an array of MDATA_STRPOOL::hash_sz
+    *        ::mdata_strpool_idx_t, with MDATA_STRPOOL_IDX_ERROR for empty.
+    */
+   MAUG_MHANDLE hash_h;
+   /*! \brief Number of slots in MDATA_STRPOOL::hash_h. Always a power of 2. */
+   size_t hash_sz;
+#endif /* !MDATA_STRPOOL_NO_HASH */
 };
 
 /*! \} */ /* mdata_strpool */
@@ -139,14 +174,93 @@ struct MDATA_TABLE_KEY {
    uint32_t hash;
 };
 
+/**
+ * \relates MDATA_TABLE
+ * \brief Value of a MDATA_TABLE::data_idx slot that has never been used.
+ */
+#define MDATA_TABLE_SLOT_EMPTY 0
+
+/**
+ * \relates MDATA_TABLE
+ * \brief Value of a MDATA_TABLE::data_idx slot whose key was unset. Probes
+ *        must continue past these.
+ */
+#define MDATA_TABLE_SLOT_TOMB ((size_t)-1)
+
+/**
+ * \brief A table of values indexed by short string keys.
+ *
+ * Keys and values are stored in insertion order in parallel vectors in
+ * MDATA_TABLE::data_cols, so mdata_table_iter() visits them in the order they
+ * were set. Lookups go through MDATA_TABLE::data_idx instead of walking the
+ * keys.
+ */
 struct MDATA_TABLE {
    volatile uint16_t flags;
    struct MDATA_VECTOR data_cols[2];
+   /**
+    * \brief Open-addressed index of size_t slots keyed by
+    *        MDATA_TABLE_KEY::hash. Each slot holds its key's position in
+    *        MDATA_TABLE::data_cols plus 1, MDATA_TABLE_SLOT_EMPTY, or
+    *        MDATA_TABLE_SLOT_TOMB. Locked and unlocked with the table.
+    */
+   struct MDATA_VECTOR data_idx;
+   /*! \brief Number of MDATA_TABLE_SLOT_TOMB slots in MDATA_TABLE::data_idx. */
+   size_t idx_tombs;
    size_t key_sz;
 };
 
 /*! \} */
 
+/**
+ * \addtogroup mdata_index Data Memory Hash Indexes
+ * \brief Open-addressed hash indexes of items kept in some other container.
+ *
+ * An index only holds the positions of items, so it must be rebuilt with
+ * mdata_index_rebuild() whenever items are removed or moved. Items with the
+ * same hash are probed in the order they were inserted.
+ *
+ * \{
+ */
+
+/**
+ * \brief Callback to get the hash of an item to index.
+ * \param data Data passed to mdata_index_rebuild().
+ * \param item_idx Position of the item in the container being indexed.
+ * \param p_hash Pointer to store the hash of the item in.
+ * \return Nonzero if the item should be indexed, or 0 to leave it out.
+ */
+typedef int (*mdata_index_hash_cb)(
+   void* data, size_t item_idx, uint32_t* p_hash );
+
+/**
+ * \brief Callback to check if an item found by mdata_index_probe() is the one
+ *        being looked for, as different keys may share a hash.
+ * \param data Data passed to mdata_index_probe().
+ * \param item_idx Position of the item in the container being indexed.
+ * \param key Key passed to mdata_index_probe().
+ * \return Nonzero if the item matches the key.
+ */
+typedef int (*mdata_index_match_cb)(
+   void* data, size_t item_idx, const void* key );
+
+struct MDATA_INDEX {
+   /**
+    * \brief Handle for an array of MDATA_INDEX::slots_sz item positions, or
+    *        -1 for empty slots.
+    */
+   MAUG_MHANDLE slots_h;
+   /*! \brief Locked pointer to MDATA_INDEX::slots_h, if locked. */
+   ssize_t* slots;
+   /**
+    * \brief Number of slots in MDATA_INDEX::slots_h. Always a power of 2, or
+    *        0 if there is no index and lookups must scan the container.
+    */
+   size_t slots_sz;
+};
+
+/*! \} */ /* mdata_index */
+
 /**
  * \addtogroup mdata_strpool
  * \{
@@ -184,6 +298,12 @@ MAUG_MHANDLE mdata_strpool_extract(
 mdata_strpool_idx_t mdata_strpool_append(
    struct MDATA_STRPOOL* sp, const char* str, size_t str_sz, uint8_t flags );
 
+/**
+ * \brief Remove the string at the given index from the strpool.
+ * \warning Indexes of all strings appended after the removed string will
+ *          change! This should only be used on strpools whose indexes are not
+ *          stored elsewhere.
+ */
 MERROR_RETVAL mdata_strpool_remove(
    struct MDATA_STRPOOL* sp, mdata_strpool_idx_t idx );
 
@@ -251,6 +371,49 @@ void mdata_vector_free( struct MDATA_VECTOR* v );
 
 uint32_t mdata_hash( const char* token, size_t token_sz );
 
+/**
+ * \addtogroup mdata_index
+ * \{
+ */
+
+/**
+ * \brief Resize an unlocked index to keep it at most half full and insert
+ *        every item in the container into it.
+ * \param items_ct Number of items in the container being indexed.
+ * \param slots_min Minimum number of slots. Must be a power of 2.
+ * \param hash_cb Callback to get the hash of each item.
+ * \warning If this fails, the index is freed.
+ */
+MERROR_RETVAL mdata_index_rebuild(
+   struct MDATA_INDEX* index, size_t items_ct, size_t slots_min,
+   mdata_index_hash_cb hash_cb, void* data );
+
+/**
+ * \brief Insert an item into a locked index after any items with the same
+ *        hash.
+ * \warning The index must have been sized by mdata_index_rebuild() to have
+ *          room for the item.
+ */
+void mdata_index_insert(
+   struct MDATA_INDEX* index, uint32_t hash, size_t item_idx );
+
+/**
+ * \brief Find the next item in a locked index with the given hash that
+ *        matches the given key.
+ * \param p_probe Pointer to the number of slots probed so far, which should
+ *                be 0 to start a new lookup. Call again with the same
+ *                pointer to find further matches.
+ * \return Position of the item in the container, or -1 if there are no more
+ *         matches.
+ */
+ssize_t mdata_index_probe(
+   struct MDATA_INDEX* index, uint32_t hash, size_t* p_probe,
+   mdata_index_match_cb match_cb, void* data, const void* key );
+
+void mdata_index_free( struct MDATA_INDEX* index );
+
+/*! \} */ /* mdata_index */
+
 /**
  * \addtogroup mdata_table
  * \{
@@ -280,6 +443,13 @@ void* mdata_table_get_void( const struct MDATA_TABLE* t, const char* key );
 void* mdata_table_hash_get_void(
    struct MDATA_TABLE* t, uint32_t key_hash, size_t key_sz );
 
+/**
+ * \brief Get the position of a key in the table's columns, for use with
+ *        mdata_table_get_by_idx() while the table stays the same shape.
+ * \return The position of the key, or -1 if the key was not found.
+ */
+ssize_t mdata_table_get_idx( const struct MDATA_TABLE* t, const char* key );
+
 void mdata_table_free( struct MDATA_TABLE* t );
 
 /*! \} */
@@ -495,6 +665,12 @@ void mdata_table_free( struct MDATA_TABLE* t );
 #define mdata_table_hash_get( t, hash, sz, type ) \
    ((type*)mdata_table_hash_get_void( t, hash, sz ))
 
+#define mdata_table_get_by_idx( t, idx, type ) \
+   mdata_vector_get( &((t)->data_cols[1]), idx, type )
+
+#define mdata_table_get_key_by_idx( t, idx ) \
+   mdata_vector_get( &((t)->data_cols[0]), idx, struct MDATA_TABLE_KEY )
+
 #define mdata_table_ct( t ) ((t)->data_cols[0].ct)
 
 #define mdata_table_sz( t ) \
@@ -503,6 +679,26 @@ void mdata_table_free( struct MDATA_TABLE* t );
 
 /*! \} */ /* mdata_table */
 
+/**
+ * \addtogroup mdata_index
+ * \{
+ */
+
+#define mdata_index_lock( index ) \
+   if( NULL == (index)->slots ) { \
+      maug_mlock( (index)->slots_h, (index)->slots ); \
+      maug_cleanup_if_null_lock( ssize_t*, (index)->slots ); \
+   }
+
+#define mdata_index_unlock( index ) \
+   if( NULL != (index)->slots ) { \
+      maug_munlock( (index)->slots_h, (index)->slots ); \
+   }
+
+#define mdata_index_is_locked( index ) (NULL != (index)->slots)
+
+/*! \} */ /* mdata_index */
+
 #define mdata_retval( idx ) (0 > idx ? ((idx) * -1) : MERROR_OK)
 
 #ifdef MDATA_C
@@ -586,8 +782,9 @@ MERROR_RETVAL mdata_strpool_check_idx(
       autolock = 1;
    }
 
-   for( i = 0 ; sp->str_sz > i ; i += (size_t)*(&(sp->str_p[i])) ) {
-      if( idx == i ) {
+   for( i = 0 ; sp->str_sz > i ; i += *((size_t*)&(sp->str_p[i])) ) {
+      /* Indexes point past the size_t at the start of each string. */
+      if( idx == i + sizeof( size_t ) ) {
          retval = MERROR_OK;
          goto cleanup;
       }
@@ -630,6 +827,82 @@ cleanup:
 
 /* === */
 
+#ifndef MDATA_STRPOOL_NO_HASH
+
+static void _mdata_strpool_hash_insert(
+   struct MDATA_STRPOOL* sp, mdata_strpool_idx_t* hash_p,
+   mdata_strpool_idx_t idx
+) {
+   size_t slot = 0;
+   const char* str = &(sp->str_p[idx]);
+
+   assert( NULL != sp->str_p );
+
+   slot = mdata_hash( str, maug_strlen( str ) ) & (sp->hash_sz - 1);
+
+   /* Linear probe to the next empty slot. */
+   while( MDATA_STRPOOL_IDX_ERROR != hash_p[slot] ) {
+      slot = (slot + 1) & (sp->hash_sz - 1);
+   }
+
+   hash_p[slot] = idx;
+}
+
+/* === */
+
+static MERROR_RETVAL _mdata_strpool_hash_rebuild(
+   struct MDATA_STRPOOL* sp, size_t hash_sz
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   mdata_strpool_idx_t* hash_p = NULL;
+   size_t i = 0;
+
+   assert( mdata_strpool_is_locked( sp ) );
+   assert( 0 == (hash_sz & (hash_sz - 1)) );
+
+   if( (MAUG_MHANDLE)NULL != sp->hash_h ) {
+      maug_mfree( sp->hash_h );
+      sp->hash_sz = 0;
+   }
+
+#if MDATA_STRPOOL_TRACE_LVL > 0
+   debug_printf( MDATA_STRPOOL_TRACE_LVL,
+      "rebuilding strpool hash index with " SIZE_T_FMT " slots...", hash_sz );
+#endif /* MDATA_STRPOOL_TRACE_LVL */
+
+   maug_malloc_test( sp->hash_h, hash_sz, sizeof( mdata_strpool_idx_t ) );
+   sp->hash_sz = hash_sz;
+
+   maug_mlock( sp->hash_h, hash_p );
+   maug_cleanup_if_null_lock( mdata_strpool_idx_t*, hash_p );
+   maug_mzero( hash_p, hash_sz * sizeof( mdata_strpool_idx_t ) );
+
+   /* Insert strings in pool order, so duplicates are probed in the same order
+    * a linear scan would find them.
+    */
+   for( i = 0 ; sp->str_sz > i ; i += *((size_t*)&(sp->str_p[i])) ) {
+      _mdata_strpool_hash_insert( sp, hash_p, i + sizeof( size_t ) );
+   }
+
+cleanup:
+
+   if( NULL != hash_p ) {
+      maug_munlock( sp->hash_h, hash_p );
+   }
+
+   if( MERROR_OK != retval && (MAUG_MHANDLE)NULL != sp->hash_h ) {
+      /* Without an index, mdata_strpool_find() falls back to a scan. */
+      maug_mfree( sp->hash_h );
+      sp->hash_sz = 0;
+   }
+
+   return retval;
+}
+
+#endif /* !MDATA_STRPOOL_NO_HASH */
+
+/* === */
+
 mdata_strpool_idx_t mdata_strpool_find(
    struct MDATA_STRPOOL* strpool, const char* str, size_t str_sz
 ) {
@@ -637,6 +910,11 @@ mdata_strpool_idx_t mdata_strpool_find(
    mdata_strpool_idx_t i = MDATA_STRPOOL_IDX_ERROR;
    size_t* p_str_iter_sz = NULL;
    uint8_t autolock = 0;
+#ifndef MDATA_STRPOOL_NO_HASH
+   mdata_strpool_idx_t* hash_p = NULL;
+   size_t slot = 0;
+   size_t str_len = 0;
+#endif /* !MDATA_STRPOOL_NO_HASH */
 
    if( (MAUG_MHANDLE)NULL == strpool->str_h ) {
       error_printf( "strpool not allocated!" );
@@ -649,6 +927,42 @@ mdata_strpool_idx_t mdata_strpool_find(
       autolock = 1;
    }
 
+#ifndef MDATA_STRPOOL_NO_HASH
+   if( (MAUG_MHANDLE)NULL != strpool->hash_h ) {
+      maug_mlock( strpool->hash_h, hash_p );
+      maug_cleanup_if_null_lock( mdata_strpool_idx_t*, hash_p );
+
+      /* Hash only up to any null, as _mdata_strpool_hash_insert() does with
+       * the stored copy.
+       */
+      while( str_sz > str_len && '\0' != str[str_len] ) {
+         str_len++;
+      }
+
+      slot = mdata_hash( str, str_len ) & (strpool->hash_sz - 1);
+      while( MDATA_STRPOOL_IDX_ERROR != hash_p[slot] ) {
+         if(
+            0 == maug_strncmp(
+               &(strpool->str_p[hash_p[slot]]), str, str_sz + 1 )
+         ) {
+            i = hash_p[slot];
+#if MDATA_STRPOOL_TRACE_LVL > 0
+            debug_printf( MDATA_STRPOOL_TRACE_LVL,
+               "found strpool_idx: " SIZE_T_FMT " in hash slot " SIZE_T_FMT
+               ": \"%s\" to match " SIZE_T_FMT "-byte token: %s",
+               i, slot, &(strpool->str_p[i]), str_sz, str );
+#endif /* MDATA_STRPOOL_TRACE_LVL */
+            goto cleanup;
+         }
+         slot = (slot + 1) & (strpool->hash_sz - 1);
+      }
+
+      /* String not found. */
+      i = MDATA_STRPOOL_IDX_ERROR;
+      goto cleanup;
+   }
+#endif /* !MDATA_STRPOOL_NO_HASH */
+
    while( i < strpool->str_sz ) {
       p_str_iter_sz = (size_t*)&(strpool->str_p[i]);
       if(
@@ -687,6 +1001,12 @@ cleanup:
       i = MDATA_STRPOOL_IDX_ERROR;
    }
 
+#ifndef MDATA_STRPOOL_NO_HASH
+   if( NULL != hash_p ) {
+      maug_munlock( strpool->hash_h, hash_p );
+   }
+#endif /* !MDATA_STRPOOL_NO_HASH */
+
    if( autolock ) {
       mdata_strpool_unlock( strpool );
    }
@@ -757,6 +1077,10 @@ mdata_strpool_idx_t mdata_strpool_append(
    MERROR_RETVAL retval = MERROR_OK;
    size_t* p_str_sz = NULL;
    size_t alloc_sz = 0;
+#ifndef MDATA_STRPOOL_NO_HASH
+   mdata_strpool_idx_t* hash_p = NULL;
+   size_t hash_sz_new = 0;
+#endif /* !MDATA_STRPOOL_NO_HASH */
 
    if( 0 == str_sz ) {
       error_printf( "attempted to add zero-length string!" );
@@ -765,9 +1089,9 @@ mdata_strpool_idx_t mdata_strpool_append(
    }
 
    if( mdata_strpool_is_locked( strpool ) ) {
+      /* Return directly, since the cleanup would unlock the caller's lock. */
       error_printf( "attempted to add string to locked strpool!" );
-      retval = MERROR_ALLOC;
-      goto cleanup;
+      return MDATA_STRPOOL_IDX_ERROR;
    }
 
    if(
@@ -834,12 +1158,35 @@ mdata_strpool_idx_t mdata_strpool_append(
 
    strpool->str_ct++;
 
+#ifndef MDATA_STRPOOL_NO_HASH
+   /* Keep the index at most half full so probe chains stay short. */
+   if( strpool->hash_sz < strpool->str_ct * 2 ) {
+      hash_sz_new = 0 < strpool->hash_sz ?
+         strpool->hash_sz * 2 : MDATA_STRPOOL_HASH_SZ_MIN;
+      while( hash_sz_new < strpool->str_ct * 2 ) {
+         hash_sz_new *= 2;
+      }
+      /* A failed rebuild just leaves find() to the linear scan. */
+      _mdata_strpool_hash_rebuild( strpool, hash_sz_new );
+   } else {
+      maug_mlock( strpool->hash_h, hash_p );
+      maug_cleanup_if_null_lock( mdata_strpool_idx_t*, hash_p );
+      _mdata_strpool_hash_insert( strpool, hash_p, idx_p_out );
+   }
+#endif /* !MDATA_STRPOOL_NO_HASH */
+
 cleanup:
 
    if( MERROR_OK != retval ) {
       idx_p_out = MDATA_STRPOOL_IDX_ERROR;
    }
 
+#ifndef MDATA_STRPOOL_NO_HASH
+   if( NULL != hash_p ) {
+      maug_munlock( strpool->hash_h, hash_p );
+   }
+#endif /* !MDATA_STRPOOL_NO_HASH */
+
    if( NULL != strpool->str_p ) {
       mdata_strpool_unlock( strpool );
    }
@@ -849,6 +1196,64 @@ cleanup:
 
 /* === */
 
+MERROR_RETVAL mdata_strpool_remove(
+   struct MDATA_STRPOOL* strpool, mdata_strpool_idx_t idx
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t str_alloc_sz = 0;
+   size_t str_start = 0;
+
+   if( mdata_strpool_is_locked( strpool ) ) {
+      /* Return directly, since the cleanup would unlock the caller's lock. */
+      error_printf( "attempted to remove string from locked strpool!" );
+      return MERROR_ALLOC;
+   }
+
+   retval = mdata_strpool_check_idx( strpool, idx );
+   if( MERROR_OK != retval ) {
+      error_printf( "invalid strpool index: " SIZE_T_FMT, idx );
+      goto cleanup;
+   }
+
+   mdata_strpool_lock( strpool );
+
+   str_start = idx - sizeof( size_t );
+   str_alloc_sz = *((size_t*)&(strpool->str_p[str_start]));
+
+#if MDATA_STRPOOL_TRACE_LVL > 0
+   debug_printf( MDATA_STRPOOL_TRACE_LVL,
+      "removing strpool_idx " SIZE_T_FMT " (" SIZE_T_FMT " bytes): \"%s\"",
+      idx, str_alloc_sz, &(strpool->str_p[idx]) );
+#endif /* MDATA_STRPOOL_TRACE_LVL */
+
+   /* Shift subsequent strings down over the removed string. */
+   memmove(
+      &(strpool->str_p[str_start]),
+      &(strpool->str_p[str_start + str_alloc_sz]),
+      strpool->str_sz - (str_start + str_alloc_sz) );
+   strpool->str_sz -= str_alloc_sz;
+   maug_mzero( &(strpool->str_p[strpool->str_sz]), str_alloc_sz );
+
+   strpool->str_ct--;
+
+#ifndef MDATA_STRPOOL_NO_HASH
+   /* Every index after the removed string moved, so start over. */
+   if( (MAUG_MHANDLE)NULL != strpool->hash_h ) {
+      _mdata_strpool_hash_rebuild( strpool, strpool->hash_sz );
+   }
+#endif /* !MDATA_STRPOOL_NO_HASH */
+
+cleanup:
+
+   if( NULL != strpool->str_p ) {
+      mdata_strpool_unlock( strpool );
+   }
+
+   return retval;
+}
+
+/* === */
+
 MERROR_RETVAL mdata_strpool_alloc(
    struct MDATA_STRPOOL* strpool, size_t alloc_sz
 ) {
@@ -890,6 +1295,12 @@ void mdata_strpool_free( struct MDATA_STRPOOL* strpool ) {
    if( 0 < strpool->str_sz_max && (MAUG_MHANDLE)NULL != strpool->str_h ) {
       maug_mfree( strpool->str_h );
    }
+#ifndef MDATA_STRPOOL_NO_HASH
+   if( (MAUG_MHANDLE)NULL != strpool->hash_h ) {
+      maug_mfree( strpool->hash_h );
+   }
+   strpool->hash_sz = 0;
+#endif /* !MDATA_STRPOOL_NO_HASH */
 }
 
 /* === */
@@ -1236,11 +1647,116 @@ uint32_t mdata_hash( const char* token, size_t token_sz ) {
 
 /* === */
 
+MERROR_RETVAL mdata_index_rebuild(
+   struct MDATA_INDEX* index, size_t items_ct, size_t slots_min,
+   mdata_index_hash_cb hash_cb, void* data
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t slots_sz = slots_min,
+      i = 0;
+   uint32_t hash = 0;
+
+   assert( 0 < slots_min && 0 == (slots_min & (slots_min - 1)) );
+   assert( !mdata_index_is_locked( index ) );
+
+   while( items_ct * 2 > slots_sz ) {
+      slots_sz *= 2;
+   }
+
+   if( slots_sz != index->slots_sz ) {
+#if MDATA_INDEX_TRACE_LVL > 0
+      debug_printf( MDATA_INDEX_TRACE_LVL,
+         "resizing index to " SIZE_T_FMT " slots...", slots_sz );
+#endif /* MDATA_INDEX_TRACE_LVL */
+      mdata_index_free( index );
+      maug_malloc_test( index->slots_h, slots_sz, sizeof( ssize_t ) );
+      index->slots_sz = slots_sz;
+   }
+
+   mdata_index_lock( index );
+
+   for( i = 0 ; slots_sz > i ; i++ ) {
+      index->slots[i] = -1;
+   }
+
+   for( i = 0 ; items_ct > i ; i++ ) {
+      if( hash_cb( data, i, &hash ) ) {
+         mdata_index_insert( index, hash, i );
+      }
+   }
+
+cleanup:
+
+   mdata_index_unlock( index );
+
+   if( MERROR_OK != retval ) {
+      mdata_index_free( index );
+   }
+
+   return retval;
+}
+
+/* === */
+
+void mdata_index_insert(
+   struct MDATA_INDEX* index, uint32_t hash, size_t item_idx
+) {
+   size_t slot = 0;
+
+   assert( mdata_index_is_locked( index ) );
+
+   /* Linear probe to the next empty slot. */
+   slot = hash & (index->slots_sz - 1);
+   while( 0 <= index->slots[slot] ) {
+      slot = (slot + 1) & (index->slots_sz - 1);
+   }
+
+   index->slots[slot] = item_idx;
+}
+
+/* === */
+
+ssize_t mdata_index_probe(
+   struct MDATA_INDEX* index, uint32_t hash, size_t* p_probe,
+   mdata_index_match_cb match_cb, void* data, const void* key
+) {
+   ssize_t item_idx = -1;
+
+   assert( mdata_index_is_locked( index ) );
+
+   /* The index is never full, so an empty slot always ends the chain. */
+   while( index->slots_sz > *p_probe ) {
+      item_idx = index->slots[(hash + *p_probe) & (index->slots_sz - 1)];
+      (*p_probe)++;
+      if( 0 > item_idx ) {
+         break;
+      } else if( match_cb( data, item_idx, key ) ) {
+         return item_idx;
+      }
+   }
+
+   return -1;
+}
+
+/* === */
+
+void mdata_index_free( struct MDATA_INDEX* index ) {
+   mdata_index_unlock( index );
+   if( (MAUG_MHANDLE)NULL != index->slots_h ) {
+      maug_mfree( index->slots_h );
+      index->slots_h = (MAUG_MHANDLE)NULL;
+   }
+   index->slots_sz = 0;
+}
+
+/* === */
+
 MERROR_RETVAL mdata_table_lock( struct MDATA_TABLE* t ) {
    MERROR_RETVAL retval = MERROR_OK;
 
    mdata_vector_lock( &(t->data_cols[0]) );
    mdata_vector_lock( &(t->data_cols[1]) );
+   mdata_vector_lock( &(t->data_idx) );
 
 cleanup:
 
@@ -1258,14 +1774,90 @@ cleanup:
 void mdata_table_unlock( struct MDATA_TABLE* t ) {
    mdata_vector_unlock( &(t->data_cols[0]) );
    mdata_vector_unlock( &(t->data_cols[1]) );
+   mdata_vector_unlock( &(t->data_idx) );
 }
 
 /* === */
 
-struct MDATA_TABLE_REPLACE_CADDY {
-   struct MDATA_TABLE_KEY* key;
-   void* data;
-};
+static void _mdata_table_idx_insert(
+   struct MDATA_TABLE* t, uint32_t key_hash, size_t col_idx
+) {
+   size_t slot_ct = mdata_vector_ct( &(t->data_idx) );
+   size_t slot_i = key_hash & (slot_ct - 1);
+   size_t* p_slot = NULL;
+
+   assert( mdata_vector_is_locked( &(t->data_idx) ) );
+
+   /* Take the first empty or tombstoned slot. The caller guarantees there is
+    * always at least one empty slot.
+    */
+   for(;;) {
+      p_slot = mdata_vector_get( &(t->data_idx), slot_i, size_t );
+      if( MDATA_TABLE_SLOT_EMPTY == *p_slot ) {
+         break;
+      } else if( MDATA_TABLE_SLOT_TOMB == *p_slot ) {
+         t->idx_tombs--;
+         break;
+      }
+      slot_i = (slot_i + 1) & (slot_ct - 1);
+   }
+
+   *p_slot = col_idx + 1;
+}
+
+/* === */
+
+/**
+ * \brief Reallocate the table index with room for at least slot_ct_min slots
+ *        and reinsert every key in MDATA_TABLE::data_cols.
+ * \warning The table must not be locked!
+ */
+static MERROR_RETVAL _mdata_table_idx_rebuild(
+   struct MDATA_TABLE* t, size_t slot_ct_min
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t slot_ct = MDATA_TABLE_IDX_SZ_MIN;
+   size_t i = 0;
+   struct MDATA_TABLE_KEY* p_key = NULL;
+
+   assert( !mdata_table_is_locked( t ) );
+
+   while( slot_ct < slot_ct_min ) {
+      slot_ct *= 2;
+   }
+
+#if MDATA_TABLE_TRACE_LVL > 0
+   debug_printf( MDATA_TABLE_TRACE_LVL,
+      "rebuilding table index with " SIZE_T_FMT " slots for " SIZE_T_FMT
+         " keys...", slot_ct, mdata_table_ct( t ) );
+#endif /* MDATA_TABLE_TRACE_LVL */
+
+   mdata_vector_free( &(t->data_idx) );
+   t->idx_tombs = 0;
+
+   /* Allocation zeroes the slots, which makes them all empty. */
+   mdata_vector_fill( &(t->data_idx), slot_ct, sizeof( size_t ) );
+
+   mdata_vector_lock( &(t->data_idx) );
+   mdata_vector_lock( &(t->data_cols[0]) );
+
+   for( i = 0 ; mdata_table_ct( t ) > i ; i++ ) {
+      p_key = mdata_vector_get( &(t->data_cols[0]), i, struct MDATA_TABLE_KEY );
+      _mdata_table_idx_insert( t, p_key->hash, i );
+   }
+
+cleanup:
+
+   mdata_vector_unlock( &(t->data_cols[0]) );
+   mdata_vector_unlock( &(t->data_idx) );
+
+   if( MERROR_OK != retval ) {
+      /* Lookups will fall back to walking the keys. */
+      mdata_vector_free( &(t->data_idx) );
+   }
+
+   return retval;
+}
 
 /* === */
 
@@ -1275,6 +1867,10 @@ ssize_t _mdata_table_hunt_index(
 ) {
    struct MDATA_TABLE_KEY* key_iter = NULL;
    ssize_t i = -1;
+   size_t slot_ct = 0;
+   size_t slot_i = 0;
+   size_t probes = 0;
+   size_t* p_slot = NULL;
 
    if( 0 == mdata_table_ct( t ) ) {
       goto cleanup;
@@ -1296,8 +1892,37 @@ ssize_t _mdata_table_hunt_index(
 #endif /* MDATA_TABLE_TRACE_LVL */
    }
 
-   /* Compare the key to what we have. */
-   /* TODO: Divide and conquer! */
+   if( 0 < mdata_vector_ct( &(t->data_idx) ) ) {
+      assert( mdata_vector_is_locked( &(t->data_idx) ) );
+
+      /* Probe the index from the key's home slot. */
+      slot_ct = mdata_vector_ct( &(t->data_idx) );
+      slot_i = key_hash & (slot_ct - 1);
+      for( probes = 0 ; slot_ct > probes ; probes++ ) {
+         p_slot = mdata_vector_get( &(t->data_idx), slot_i, size_t );
+         if( MDATA_TABLE_SLOT_EMPTY == *p_slot ) {
+            break;
+         } else if( MDATA_TABLE_SLOT_TOMB != *p_slot ) {
+            key_iter = mdata_vector_get(
+               &(t->data_cols[0]), *p_slot - 1, struct MDATA_TABLE_KEY );
+            assert( NULL != key_iter );
+            if(
+               key_iter->hash == key_hash &&
+               key_iter->string_sz == key_sz
+            ) {
+#if MDATA_TABLE_TRACE_LVL > 0
+               debug_printf( MDATA_TABLE_TRACE_LVL,
+                  "found value for key: %s", key );
+#endif /* MDATA_TABLE_TRACE_LVL */
+               return *p_slot - 1;
+            }
+         }
+         slot_i = (slot_i + 1) & (slot_ct - 1);
+      }
+      goto cleanup;
+   }
+
+   /* No index, so compare the key to what we have. */
    for( i = 0 ; mdata_vector_ct( &(t->data_cols[0]) ) > i ; i++ ) {
       key_iter = mdata_vector_get(
          &(t->data_cols[0]), i, struct MDATA_TABLE_KEY );
@@ -1320,30 +1945,6 @@ cleanup:
 
 /* === */
 
-static MERROR_RETVAL _mdata_table_replace(
-   const struct MDATA_TABLE_KEY* key, void* data, size_t data_sz,
-   void* cb_data, size_t cb_data_sz, size_t idx
-) {
-   MERROR_RETVAL retval = MERROR_OK;
-   struct MDATA_TABLE_REPLACE_CADDY* caddy =
-      (struct MDATA_TABLE_REPLACE_CADDY*)cb_data;
-
-   if(
-      key->hash == caddy->key->hash && key->string_sz == caddy->key->string_sz
-   ) {
-#if MDATA_TABLE_TRACE_LVL > 0
-      debug_printf( MDATA_TABLE_TRACE_LVL,
-         "replacing table data for key %s (%u)...", key->string, key->hash );
-#endif /* MDATA_TABLE_TRACE_LVL */
-      memcpy( data, caddy->data, data_sz );
-      retval = MERROR_FILE;
-   }
-
-   return retval;
-}
-
-/* === */
-
 MERROR_RETVAL mdata_table_iter(
    struct MDATA_TABLE* t,
    mdata_table_iter_t cb, void* cb_data, size_t cb_data_sz
@@ -1396,8 +1997,9 @@ MERROR_RETVAL mdata_table_set(
    MERROR_RETVAL retval = MERROR_OK;
    ssize_t idx_key = -1;
    ssize_t idx_val = -1;
+   ssize_t idx_old = -1;
    struct MDATA_TABLE_KEY key_tmp;
-   struct MDATA_TABLE_REPLACE_CADDY caddy;
+   int locked = 0;
 
    assert( 0 < maug_strlen( key ) );
 
@@ -1424,20 +2026,37 @@ MERROR_RETVAL mdata_table_set(
       key_tmp.string, key_tmp.hash, value_sz );
 #endif /* MDATA_TABLE_TRACE_LVL */
 
-   caddy.key = &key_tmp;
-   caddy.data = value;
+   /* Replace the value in place if the key is already present. */
+   if( 0 < mdata_table_ct( t ) ) {
+      retval = mdata_table_lock( t );
+      maug_cleanup_if_not_ok();
+      locked = 1;
 
-   /* Search for the hash. */
-   /* TODO: Use quicker search. */
-   retval = mdata_table_iter( t, _mdata_table_replace, &caddy,
-      sizeof( struct MDATA_TABLE_REPLACE_CADDY ) );
-   if( MERROR_FILE == retval ) {
-      /* _mdata_table_replace returned that it replaced an item, so quit. */
-      retval = MERROR_OK;
-      goto cleanup;
+      idx_old = _mdata_table_hunt_index( t, key_tmp.string, 0, 0 );
+      if( 0 <= idx_old ) {
+#if MDATA_TABLE_TRACE_LVL > 0
+         debug_printf( MDATA_TABLE_TRACE_LVL,
+            "replacing table data for key %s (%u)...",
+            key_tmp.string, key_tmp.hash );
+#endif /* MDATA_TABLE_TRACE_LVL */
+         memcpy(
+            mdata_vector_get_void( &(t->data_cols[1]), idx_old ),
+            value, t->data_cols[1].item_sz );
+         goto cleanup;
+      }
+
+      mdata_table_unlock( t );
+      locked = 0;
    }
 
-   /* TODO: Insert in hash order. */
+   /* Grow the index if this key would leave it more than half full. */
+   if(
+      mdata_vector_ct( &(t->data_idx) ) <
+      (mdata_table_ct( t ) + t->idx_tombs + 1) * 2
+   ) {
+      /* The new key is appended below and indexed on its own. */
+      _mdata_table_idx_rebuild( t, (mdata_table_ct( t ) + 1) * 4 );
+   }
 
    idx_key = mdata_vector_append(
       &(t->data_cols[0]), &key_tmp, sizeof( struct MDATA_TABLE_KEY ) );
@@ -1455,8 +2074,18 @@ MERROR_RETVAL mdata_table_set(
       retval = merror_sz_to_retval( idx_val );
    }
 
+   if( 0 <= idx_key && 0 < mdata_vector_ct( &(t->data_idx) ) ) {
+      mdata_vector_lock( &(t->data_idx) );
+      _mdata_table_idx_insert( t, key_tmp.hash, idx_key );
+      mdata_vector_unlock( &(t->data_idx) );
+   }
+
 cleanup:
 
+   if( locked ) {
+      mdata_table_unlock( t );
+   }
+
    /* TODO: Set retval! */
 
    return retval;
@@ -1470,6 +2099,8 @@ MERROR_RETVAL mdata_table_unset(
    MERROR_RETVAL retval = MERROR_OK;
    int autolock = 0;
    ssize_t idx = 0;
+   size_t i = 0;
+   size_t* p_slot = NULL;
 
 #if MDATA_TABLE_TRACE_LVL > 0
    debug_printf( MDATA_TABLE_TRACE_LVL, "unsetting table key: %s", key );
@@ -1493,6 +2124,23 @@ MERROR_RETVAL mdata_table_unset(
       goto cleanup;
    }
 
+   /* Tombstone the removed key's slot and point the slots of keys after it
+    * at their new positions, since removal shifts the columns up by 1.
+    */
+   for( i = 0 ; mdata_vector_ct( &(t->data_idx) ) > i ; i++ ) {
+      p_slot = mdata_vector_get( &(t->data_idx), i, size_t );
+      if(
+         MDATA_TABLE_SLOT_EMPTY == *p_slot || MDATA_TABLE_SLOT_TOMB == *p_slot
+      ) {
+         continue;
+      } else if( (size_t)idx + 1 == *p_slot ) {
+         *p_slot = MDATA_TABLE_SLOT_TOMB;
+         t->idx_tombs++;
+      } else if( (size_t)idx + 1 < *p_slot ) {
+         (*p_slot)--;
+      }
+   }
+
    /* Remove the item. */
    mdata_table_unlock( t );
    mdata_vector_remove( &(t->data_cols[0]), idx );
@@ -1570,9 +2218,18 @@ cleanup:
 
 /* === */
 
+ssize_t mdata_table_get_idx( const struct MDATA_TABLE* t, const char* key ) {
+   assert( mdata_table_is_locked( t ) );
+
+   return _mdata_table_hunt_index( t, key, 0, 0 );
+}
+
+/* === */
+
 void mdata_table_free( struct MDATA_TABLE* t ) {
    mdata_vector_free( &(t->data_cols[0]) );
    mdata_vector_free( &(t->data_cols[1]) );
+   mdata_vector_free( &(t->data_idx) );
    maug_mzero( t, sizeof( struct MDATA_TABLE ) );
 }
 
@@ -73,6 +73,53 @@ void retroflat_message(
  */
 #define MFILE_FLAG_HANDLE_LOCKED 0x02
 
+/**
+ * \relates MFILE_CADDY
+ * \brief Flag for MFILE_CADDY::flags indicating reads are served from the
+ *        read-ahead buffer set up by mfile_read_buffer_init().
+ */
+#define MFILE_FLAG_READ_BUFFERED 0x04
+
+/**
+ * \relates MFILE_CADDY
+ * \brief Flag for MFILE_CADDY::flags indicating this
+ *        ::MFILE_CADDY_TYPE_MEM_BUFFER is a read-only mapping of a file that
+ *        must be unmapped on close. Only set if ::MFILE_MMAP is defined.
+ */
+#define MFILE_FLAG_MMAP 0x08
+
+/**
+ * \relates MFILE_CADDY
+ * \brief Flag for MFILE_CADDY::flags indicating this
+ *        ::MFILE_CADDY_TYPE_MEM_BUFFER owns its handle and must free it on
+ *        close, e.g. a compressed entry unpacked from an \ref maug_mfile_pack.
+ */
+#define MFILE_FLAG_OWNS_HANDLE 0x10
+
+/**
+ * \relates MFILE_CADDY
+ * \brief Flag for MFILE_CADDY::flags indicating this
+ *        ::MFILE_CADDY_TYPE_MEM_BUFFER was created by mfile_alloc_buffer() and
+ *        grows its handle as it is written to.
+ */
+#define MFILE_FLAG_GROWABLE 0x20
+
+/**
+ * \relates MFILE_CADDY
+ * \brief Flag for MFILE_CADDY::flags indicating this file is the buffer of
+ *        an MSERIALIZE_WRITER, so mserialize_footer() should record sequence
+ *        sizes instead of seeking back to write them.
+ */
+#define MFILE_FLAG_SER_WRITER 0x40
+
+/**
+ * \relates MFILE_CADDY
+ * \brief Flag for MFILE_CADDY::flags indicating write_block() should replace
+ *        the bytes at the cursor rather than inserting before them, e.g. to
+ *        fill in a header once the rest of the file is written.
+ */
+#define MFILE_FLAG_OVERWRITE 0x80
+
 /**
  * \addtogroup maug_mfile_byte_order RetroFile Byte Order
  * \brief Flags controlling byte order for read operations.
@@ -115,10 +162,104 @@ void retroflat_message(
 #  define MFILE_SEEK_TRACE_LVL 0
 #endif /* !MFILE_SEEK_TRACE_LVL */
 
+#ifndef MFILE_READ_BUFFER_SZ
+/**
+ * \brief Size in bytes of the read-ahead buffer attached to files opened with
+ *        mfile_open_read(). Define as 0 to read directly from the platform.
+ */
+#  define MFILE_READ_BUFFER_SZ 1024
+#endif /* !MFILE_READ_BUFFER_SZ */
+
+#ifndef MFILE_ALLOC_BUFFER_SZ
+/**
+ * \brief Default initial size in bytes of buffers from mfile_alloc_buffer().
+ */
+#  define MFILE_ALLOC_BUFFER_SZ 1024
+#endif /* !MFILE_ALLOC_BUFFER_SZ */
+
+#ifndef MFILE_CHUNK_SZ
+/**
+ * \brief Size in bytes of the stack buffers parsers use to pull input through
+ *        mfile_read_chunk().
+ */
+#  define MFILE_CHUNK_SZ 64
+#endif /* !MFILE_CHUNK_SZ */
+
 #ifndef MFILE_CONTENTS_TRACE_LVL
 #  define MFILE_CONTENTS_TRACE_LVL 0
 #endif /* !MFILE_CONTENTS_TRACE_LVL */
 
+/**
+ * \addtogroup maug_mfile_pack RetroFile Asset Packs
+ * \brief Single-file archives of assets with a sorted, hashed directory.
+ *
+ * Packs are built from an assets directory with tools/mpak.c. Once a pack is
+ * opened with mfile_pack_open(), mfile_open_read() looks every filename up in
+ * the pack's directory first and only falls back to the platform file API if
+ * it is not found. Uncompressed entries are read directly from the pack's
+ * memory, so a pack that the platform can map (or that lives in MVFS) is
+ * never copied.
+ *
+ * All integers are stored least significant byte first.
+ *
+ * | Offset | Size | Header Field                                    |
+ * |--------|------|-------------------------------------------------|
+ * | 0      | 4    | ::MFILE_PACK_MAGIC                              |
+ * | 4      | 2    | ::MFILE_PACK_VERSION                            |
+ * | 6      | 2    | Alignment of entry data (power of 2)            |
+ * | 8      | 4    | Number of entries in the directory              |
+ * | 12     | 4    | Offset of the directory                         |
+ *
+ * The directory is an array of ::MFILE_PACK_ENTRY_SZ byte entries, sorted by
+ * hash and then by name:
+ *
+ * | Offset | Size | Entry Field                                     |
+ * |--------|------|-------------------------------------------------|
+ * | 0      | 4    | mfile_pack_hash() of the name                   |
+ * | 4      | 4    | Offset of the (aligned) entry data              |
+ * | 8      | 4    | Size of the entry data as stored                |
+ * | 12     | 4    | Size of the entry data once unpacked            |
+ * | 16     | 4    | Offset of the NULL-terminated name              |
+ * | 20     | 2    | Length of the name without the terminator       |
+ * | 22     | 1    | \ref maug_mfile_pack_comp used for the data     |
+ * | 23     | 1    | Reserved                                        |
+ *
+ * \{
+ */
+
+#define MFILE_PACK_MAGIC "MPAK"
+
+#define MFILE_PACK_VERSION 1
+
+/*! \brief Size of the pack header in bytes. */
+#define MFILE_PACK_HDR_SZ 16
+
+/*! \brief Size of each pack directory entry in bytes. */
+#define MFILE_PACK_ENTRY_SZ 24
+
+/**
+ * \addtogroup maug_mfile_pack_comp RetroFile Asset Pack Compression
+ * \{
+ */
+
+/*! \brief Entry data is stored as-is and can be read in place. */
+#define MFILE_PACK_COMP_NONE 0
+
+/**
+ * \brief Entry data is PackBits run-length encoded: a control byte n of 0-127
+ *        is followed by n + 1 literal bytes, and 129-255 is followed by one
+ *        byte to repeat 257 - n times.
+ */
+#define MFILE_PACK_COMP_RLE 1
+
+/*! \} */ /* maug_mfile_pack_comp */
+
+#ifndef MFILE_PACK_TRACE_LVL
+#  define MFILE_PACK_TRACE_LVL 0
+#endif /* !MFILE_PACK_TRACE_LVL */
+
+/*! \} */ /* maug_mfile_pack */
+
 /**
  * \addtogroup maug_retroflt_assets RetroFlat Assets API
  * \brief Functions and macros for handling graphical asset files.
@@ -210,6 +351,8 @@ struct MFILE_CADDY {
    off_t mem_cursor;
    /*! \brief Locked pointer for MFILE_HANDLE::mem. */
    uint8_t* mem_buffer;
+   /*! \brief Allocated size of MFILE_HANDLE::mem if ::MFILE_FLAG_GROWABLE. */
+   size_t mem_alloc_sz;
    uint8_t flags;
    /*! \brief Size of the current file/buffer in bytes. */
    off_t sz;
@@ -224,6 +367,22 @@ struct MFILE_CADDY {
    mfile_printf_t printf;
    mfile_vprintf_t vprintf;
    mfile_write_block_t write_block;
+   /*! \brief Handle for the read-ahead buffer, if ::MFILE_FLAG_READ_BUFFERED. */
+   MAUG_MHANDLE rbuf_h;
+   /*! \brief Locked pointer to MFILE_CADDY::rbuf_h, held until close. */
+   uint8_t* rbuf;
+   /*! \brief Allocated size of MFILE_CADDY::rbuf in bytes. */
+   size_t rbuf_sz;
+   /*! \brief Number of valid bytes currently in MFILE_CADDY::rbuf. */
+   size_t rbuf_len;
+   /*! \brief Index of the next unread byte in MFILE_CADDY::rbuf. */
+   size_t rbuf_pos;
+   /*! \brief Offset in the file of MFILE_CADDY::rbuf[0]. */
+   off_t rbuf_base;
+   /*! \brief Platform read_block replaced by the read-ahead buffer. */
+   mfile_read_block_t raw_read_block;
+   /*! \brief Platform seek replaced by the read-ahead buffer. */
+   mfile_seek_t raw_seek;
 };
 
 typedef struct MFILE_CADDY mfile_t;
@@ -268,12 +427,53 @@ MERROR_RETVAL mfile_file_vprintf(
 
 #define mfile_get_sz( p_file ) ((p_file)->sz)
 
+/**
+ * \brief Read a single byte from the given ::mfile_t into p_c.
+ *
+ * If the file has a read-ahead buffer with bytes left in it, this is a plain
+ * array read with no function call. Otherwise, it falls back to
+ * MFILE_CADDY::read_byte.
+ *
+ * \return ::MERROR_OK on success or the error from MFILE_CADDY::read_byte.
+ */
+#define mfile_getc( p_f, p_c ) \
+   ((p_f)->rbuf_pos < (p_f)->rbuf_len ? \
+      (*(p_c) = (p_f)->rbuf[(p_f)->rbuf_pos++], MERROR_OK) : \
+      (p_f)->read_byte( (p_f), (p_c) ))
+
+/**
+ * \brief Attach a read-ahead buffer to a read-only file so that small reads
+ *        are served from memory instead of the platform API.
+ *
+ * Seeks within the buffered window only move the buffer index, and the
+ * MFILE_CADDY::cursor and MFILE_CADDY::has_bytes callbacks report the logical
+ * position. This is called by mfile_open_read() for
+ * ::MFILE_CADDY_TYPE_FILE files when ::MFILE_READ_BUFFER_SZ is nonzero.
+ *
+ * \param buf_sz Size of the read-ahead buffer in bytes.
+ */
+MERROR_RETVAL mfile_read_buffer_init( mfile_t* p_file, size_t buf_sz );
+
+/**
+ * \brief Read as many bytes as are left in the file, up to buf_sz, into buf.
+ * \param p_read_sz Pointer to a size_t to hold the number of bytes read.
+ */
+MERROR_RETVAL mfile_read_chunk(
+   mfile_t* p_file, uint8_t* buf, size_t buf_sz, size_t* p_read_sz );
+
 /**
  * \brief Lock a buffer and assign it to an ::mfile_t to read/write.
  */
 MERROR_RETVAL mfile_lock_buffer(
    MAUG_MHANDLE, void* ptr, off_t, mfile_t* p_file );
 
+/**
+ * \brief Allocate an empty, writable ::MFILE_CADDY_TYPE_MEM_BUFFER that grows
+ *        as it is written to. Its handle is freed by mfile_close().
+ * \param sz_init Initial size of the buffer to allocate in bytes.
+ */
+MERROR_RETVAL mfile_alloc_buffer( size_t sz_init, mfile_t* p_file );
+
 /**
  * \brief Open a file and read it into memory or memory-map it.
  * \param filename NULL-terminated path to file to open.
@@ -289,6 +489,42 @@ MERROR_RETVAL mfile_open_write(
  */
 void mfile_close( mfile_t* p_file );
 
+/**
+ * \addtogroup maug_mfile_pack
+ * \{
+ */
+
+/**
+ * \brief Hash used to sort and look up \ref maug_mfile_pack directory entries.
+ *        This is 32-bit FNV-1a over the bytes of the name.
+ */
+uint32_t mfile_pack_hash( const char* name, size_t name_sz );
+
+/**
+ * \brief Open an asset pack so that subsequent mfile_open_read() calls look
+ *        in it before the platform file API. Only one pack may be open at a
+ *        time, so this closes any pack that was already open.
+ * \param filename Path to the pack, opened with the platform file API.
+ */
+MERROR_RETVAL mfile_pack_open( const maug_path filename );
+
+/**
+ * \brief Close the asset pack opened with mfile_pack_open(). Files opened from
+ *        the pack must be closed first.
+ */
+void mfile_pack_close( void );
+
+/**
+ * \brief Open an entry from the asset pack opened with mfile_pack_open() as a
+ *        read-only ::MFILE_CADDY_TYPE_MEM_BUFFER.
+ * \return ::MERROR_OK, or ::MERROR_FILE if no pack is open or it has no
+ *         entry by that name.
+ */
+MERROR_RETVAL mfile_pack_open_entry(
+   const maug_path filename, mfile_t* p_file );
+
+/*! \} */ /* maug_mfile_pack */
+
 #ifdef MFILE_C
 
 #include <mrapifil.h>
@@ -428,6 +664,42 @@ static void mfile_mem_release( struct MFILE_CADDY* p_f ) {
 
 /* === */
 
+static MERROR_RETVAL mfile_mem_grow( struct MFILE_CADDY* p_f, size_t sz_min ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   MAUG_MHANDLE h_new = (MAUG_MHANDLE)NULL;
+   size_t sz_new = p_f->mem_alloc_sz;
+
+   assert( MFILE_FLAG_GROWABLE == (MFILE_FLAG_GROWABLE & p_f->flags) );
+   assert(
+      MFILE_FLAG_HANDLE_LOCKED != (MFILE_FLAG_HANDLE_LOCKED & p_f->flags) );
+
+   if( sz_min <= sz_new ) {
+      goto cleanup;
+   }
+
+   /* Double so a long run of small writes only reallocates a few times. */
+   if( 0 == sz_new ) {
+      sz_new = MFILE_ALLOC_BUFFER_SZ;
+   }
+   while( sz_new < sz_min ) {
+      sz_new *= 2;
+   }
+
+#if MFILE_WRITE_TRACE_LVL > 0
+   debug_printf( MFILE_WRITE_TRACE_LVL,
+      "growing memory buffer to " SIZE_T_FMT " bytes...", sz_new );
+#endif /* MFILE_WRITE_TRACE_LVL */
+
+   maug_mrealloc_test( h_new, p_f->h.mem, sz_new, 1 );
+   p_f->mem_alloc_sz = sz_new;
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
 MERROR_RETVAL mfile_mem_read_byte( struct MFILE_CADDY* p_file, uint8_t* buf ) {
    return p_file->read_block( p_file, buf, 1 );
 }
@@ -439,16 +711,15 @@ MERROR_RETVAL mfile_mem_read_block(
 ) {
    MERROR_RETVAL retval = MERROR_OK;
 
-   if( p_file->mem_cursor >= p_file->sz ) {
+   if( p_file->mem_cursor + (off_t)buf_sz > p_file->sz ) {
       return MERROR_FILE;
    }
 
    retval = mfile_mem_lock( p_file );
    maug_cleanup_if_not_ok();
 
-   while( 0 < buf_sz-- ) {
-      *(buf++) = p_file->mem_buffer[p_file->mem_cursor++];
-   }
+   memcpy( buf, &(p_file->mem_buffer[p_file->mem_cursor]), buf_sz );
+   p_file->mem_cursor += buf_sz;
 
 cleanup:
 
@@ -555,6 +826,19 @@ MERROR_RETVAL mfile_mem_write_block(
       return MERROR_FILE;
    }
 
+   if( MFILE_FLAG_GROWABLE == (MFILE_FLAG_GROWABLE & p_f->flags) ) {
+      /* Make room for the new bytes, which are inserted at the cursor. */
+      retval = mfile_mem_grow( p_f, p_f->sz + buf_sz );
+      maug_cleanup_if_not_ok();
+      p_f->sz += buf_sz;
+   } else if( p_f->mem_cursor + buf_sz > p_f->sz ) {
+      /* Fixed buffers can't grow, so refuse to write past their end. */
+      error_printf( "write of " SIZE_T_FMT " bytes would overflow buffer!",
+         buf_sz );
+      retval = MERROR_OVERFLOW;
+      goto cleanup;
+   }
+
    retval = mfile_mem_lock( p_f );
    maug_cleanup_if_not_ok();
 
@@ -574,13 +858,256 @@ MERROR_RETVAL mfile_mem_write_block(
    memcpy( &(p_f->mem_buffer[p_f->mem_cursor]), buf, buf_sz );
    p_f->mem_cursor += buf_sz;
 
-   /* TODO: Expand buffer and reflect this in sz if writing beyond the end
-    *       of the buffer.
+cleanup:
+
+   mfile_mem_release( p_f );
+
+   return retval;
+}
+
+/* === */
+
+static off_t mfile_buf_cursor( struct MFILE_CADDY* p_f ) {
+   return p_f->rbuf_base + p_f->rbuf_pos;
+}
+
+/* === */
+
+static MERROR_RETVAL mfile_buf_fill( struct MFILE_CADDY* p_f ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   off_t raw_cursor = 0;
+   size_t fill_sz = 0;
+
+   /* The platform cursor always sits just past the buffered window. */
+   raw_cursor = p_f->rbuf_base + p_f->rbuf_len;
+   if( raw_cursor >= p_f->sz ) {
+      error_printf( "file %s out of bytes!", p_f->filename );
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   fill_sz = p_f->sz - raw_cursor;
+   if( fill_sz > p_f->rbuf_sz ) {
+      fill_sz = p_f->rbuf_sz;
+   }
+
+#if MFILE_READ_TRACE_LVL > 0
+   debug_printf( MFILE_READ_TRACE_LVL,
+      "filling read buffer with " SIZE_T_FMT " bytes from " OFF_T_FMT "...",
+      fill_sz, raw_cursor );
+#endif /* MFILE_READ_TRACE_LVL */
+
+   /* Invalidate the window first in case the read fails. */
+   p_f->rbuf_base = raw_cursor;
+   p_f->rbuf_len = 0;
+   p_f->rbuf_pos = 0;
+
+   retval = p_f->raw_read_block( p_f, p_f->rbuf, fill_sz );
+   maug_cleanup_if_not_ok();
+
+   p_f->rbuf_len = fill_sz;
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL mfile_buf_read_block(
+   struct MFILE_CADDY* p_f, uint8_t* buf, size_t buf_sz
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t copy_sz = 0;
+
+   while( 0 < buf_sz ) {
+      copy_sz = p_f->rbuf_len - p_f->rbuf_pos;
+      if( 0 < copy_sz ) {
+         /* Serve what we can from the buffer. */
+         if( copy_sz > buf_sz ) {
+            copy_sz = buf_sz;
+         }
+         memcpy( buf, &(p_f->rbuf[p_f->rbuf_pos]), copy_sz );
+         p_f->rbuf_pos += copy_sz;
+         buf += copy_sz;
+         buf_sz -= copy_sz;
+
+      } else if( buf_sz >= p_f->rbuf_sz ) {
+         /* Big reads would just be copied twice, so go straight to the
+          * platform and leave the buffer empty past them.
+          */
+         p_f->rbuf_base += p_f->rbuf_len;
+         p_f->rbuf_len = 0;
+         p_f->rbuf_pos = 0;
+         retval = p_f->raw_read_block( p_f, buf, buf_sz );
+         maug_cleanup_if_not_ok();
+         p_f->rbuf_base += buf_sz;
+         buf_sz = 0;
+
+      } else {
+         retval = mfile_buf_fill( p_f );
+         maug_cleanup_if_not_ok();
+      }
+   }
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL mfile_buf_read_byte(
+   struct MFILE_CADDY* p_f, uint8_t* buf
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+
+   if( p_f->rbuf_pos >= p_f->rbuf_len ) {
+      retval = mfile_buf_fill( p_f );
+      maug_cleanup_if_not_ok();
+   }
+
+   *buf = p_f->rbuf[p_f->rbuf_pos++];
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL mfile_buf_seek( struct MFILE_CADDY* p_f, off_t pos ) {
+   MERROR_RETVAL retval = MERROR_OK;
+
+   if( pos >= p_f->rbuf_base && pos <= p_f->rbuf_base + p_f->rbuf_len ) {
+      /* Seeking inside the buffered window is free. */
+      p_f->rbuf_pos = pos - p_f->rbuf_base;
+      goto cleanup;
+   }
+
+   retval = p_f->raw_seek( p_f, pos );
+   maug_cleanup_if_not_ok();
+
+   p_f->rbuf_base = pos;
+   p_f->rbuf_len = 0;
+   p_f->rbuf_pos = 0;
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL mfile_buf_read_line(
+   struct MFILE_CADDY* p_f, char* buffer, off_t buffer_sz, uint8_t flags
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   off_t i = 0;
+
+   if( !p_f->has_bytes( p_f ) ) {
+      error_printf( "file %s out of bytes!", p_f->filename );
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   /* Keep the newline like fgets() so callers see the same lines as they
+    * would unbuffered.
+    */
+   while( i < buffer_sz - 1 && p_f->has_bytes( p_f ) ) {
+      retval = mfile_getc( p_f, (uint8_t*)&(buffer[i]) );
+      maug_cleanup_if_not_ok();
+      if( '\n' == buffer[i++] ) {
+         break;
+      }
+   }
+
+   buffer[i] = '\0';
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL mfile_read_buffer_init( mfile_t* p_file, size_t buf_sz ) {
+   MERROR_RETVAL retval = MERROR_OK;
+
+   assert( MFILE_CADDY_TYPE_FILE == p_file->type );
+   assert( MFILE_FLAG_READ_ONLY == (MFILE_FLAG_READ_ONLY & p_file->flags) );
+   assert( 0 < buf_sz );
+
+   if( MFILE_FLAG_READ_BUFFERED == (MFILE_FLAG_READ_BUFFERED & p_file->flags) ) {
+      /* Already buffered. */
+      goto cleanup;
+   }
+
+   p_file->rbuf_h = (MAUG_MHANDLE)NULL;
+   p_file->rbuf = NULL;
+
+   maug_malloc_test( p_file->rbuf_h, buf_sz, 1 );
+   maug_mlock( p_file->rbuf_h, p_file->rbuf );
+   maug_cleanup_if_null_lock( uint8_t*, p_file->rbuf );
+
+   p_file->rbuf_sz = buf_sz;
+   p_file->rbuf_len = 0;
+   p_file->rbuf_pos = 0;
+   p_file->rbuf_base = p_file->cursor( p_file );
+
+   /* Swap in the buffered callbacks. Everything else (read_int, has_bytes)
+    * goes through these.
     */
+   p_file->raw_read_block = p_file->read_block;
+   p_file->raw_seek = p_file->seek;
+   p_file->cursor = mfile_buf_cursor;
+   p_file->read_byte = mfile_buf_read_byte;
+   p_file->read_block = mfile_buf_read_block;
+   p_file->seek = mfile_buf_seek;
+   p_file->read_line = mfile_buf_read_line;
+
+   p_file->flags |= MFILE_FLAG_READ_BUFFERED;
 
 cleanup:
 
-   mfile_mem_release( p_f );
+   if( MERROR_OK != retval ) {
+      if( NULL != p_file->rbuf ) {
+         maug_munlock( p_file->rbuf_h, p_file->rbuf );
+      }
+      if( (MAUG_MHANDLE)NULL != p_file->rbuf_h ) {
+         maug_mfree( p_file->rbuf_h );
+      }
+   }
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL mfile_read_chunk(
+   mfile_t* p_file, uint8_t* buf, size_t buf_sz, size_t* p_read_sz
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   off_t left = 0;
+
+   *p_read_sz = 0;
+
+   left = p_file->has_bytes( p_file );
+   if( 0 >= left ) {
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   if( (off_t)buf_sz > left ) {
+      buf_sz = left;
+   }
+
+   retval = p_file->read_block( p_file, buf, buf_sz );
+   maug_cleanup_if_not_ok();
+
+   *p_read_sz = buf_sz;
+
+cleanup:
 
    return retval;
 }
@@ -630,18 +1157,388 @@ cleanup:
 
 /* === */
 
+MERROR_RETVAL mfile_alloc_buffer( size_t sz_init, mfile_t* p_file ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   MAUG_MHANDLE buf_h = (MAUG_MHANDLE)NULL;
+
+   if( 0 == sz_init ) {
+      sz_init = MFILE_ALLOC_BUFFER_SZ;
+   }
+
+   maug_malloc_test( buf_h, sz_init, 1 );
+
+   retval = mfile_lock_buffer( buf_h, NULL, 0, p_file );
+   maug_cleanup_if_not_ok();
+
+   p_file->flags |= MFILE_FLAG_OWNS_HANDLE | MFILE_FLAG_GROWABLE;
+   p_file->mem_alloc_sz = sz_init;
+
+cleanup:
+
+   if( MERROR_OK != retval && (MAUG_MHANDLE)NULL != buf_h ) {
+      maug_mfree( buf_h );
+   }
+
+   return retval;
+}
+
+/* === */
+
+/* The pack the platform opened, if it's in memory already. */
+static mfile_t SEG_MGLOBAL gs_mfile_pack;
+/* A copy of the pack, if the platform could only open it as a file. */
+static MAUG_MHANDLE SEG_MGLOBAL gs_mfile_pack_h = (MAUG_MHANDLE)NULL;
+/* Locked pointer to the pack bytes, from either of the above. */
+static uint8_t* SEG_MGLOBAL gs_mfile_pack_bytes = NULL;
+static off_t SEG_MGLOBAL gs_mfile_pack_sz = 0;
+
+#define _mfile_pack_u16( p ) \
+   ((uint16_t)(p)[0] | ((uint16_t)(p)[1] << 8))
+
+#define _mfile_pack_u32( p ) \
+   ((uint32_t)(p)[0] | ((uint32_t)(p)[1] << 8) | \
+   ((uint32_t)(p)[2] << 16) | ((uint32_t)(p)[3] << 24))
+
+uint32_t mfile_pack_hash( const char* name, size_t name_sz ) {
+   uint32_t hash_out = 2166136261u;
+   size_t i = 0;
+
+   for( i = 0 ; name_sz > i ; i++ ) {
+      hash_out ^= (uint8_t)name[i];
+      hash_out *= 16777619u;
+   }
+
+   return hash_out;
+}
+
+/* === */
+
+MERROR_RETVAL mfile_pack_open( const maug_path filename ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   uint8_t* pack_bytes = NULL;
+
+   mfile_pack_close();
+
+   maug_mzero( &gs_mfile_pack, sizeof( mfile_t ) );
+   retval = mfile_plt_open_read( filename, &gs_mfile_pack );
+   maug_cleanup_if_not_ok();
+
+   gs_mfile_pack_sz = gs_mfile_pack.sz;
+
+   if( MFILE_CADDY_TYPE_MEM_BUFFER == gs_mfile_pack.type ) {
+      /* Mapped or built in, so just hold it open and read it in place. */
+      if( (MAUG_MHANDLE)NULL != gs_mfile_pack.h.mem ) {
+         retval = mfile_mem_lock( &gs_mfile_pack );
+         maug_cleanup_if_not_ok();
+      }
+      pack_bytes = gs_mfile_pack.mem_buffer;
+
+   } else {
+      /* Read the whole pack in once, rather than seeking around in it. */
+#if MFILE_PACK_TRACE_LVL > 0
+      debug_printf( MFILE_PACK_TRACE_LVL,
+         "copying pack %s (" OFF_T_FMT " bytes) into memory...",
+         filename, gs_mfile_pack_sz );
+#endif /* MFILE_PACK_TRACE_LVL */
+      maug_malloc_test( gs_mfile_pack_h, gs_mfile_pack_sz, 1 );
+      maug_mlock( gs_mfile_pack_h, pack_bytes );
+      maug_cleanup_if_null_lock( uint8_t*, pack_bytes );
+
+      retval = gs_mfile_pack.read_block(
+         &gs_mfile_pack, pack_bytes, gs_mfile_pack_sz );
+      mfile_close( &gs_mfile_pack );
+      maug_cleanup_if_not_ok();
+   }
+
+   if(
+      NULL == pack_bytes ||
+      MFILE_PACK_HDR_SZ > gs_mfile_pack_sz ||
+      0 != memcmp( pack_bytes, MFILE_PACK_MAGIC, 4 ) ||
+      MFILE_PACK_VERSION != _mfile_pack_u16( &(pack_bytes[4]) ) ||
+      /* Make sure the whole directory is inside of the pack. */
+      (uint32_t)gs_mfile_pack_sz < _mfile_pack_u32( &(pack_bytes[12]) ) ||
+      ((uint32_t)gs_mfile_pack_sz - _mfile_pack_u32( &(pack_bytes[12]) )) /
+         MFILE_PACK_ENTRY_SZ < _mfile_pack_u32( &(pack_bytes[8]) )
+   ) {
+      error_printf( "invalid asset pack: %s", filename );
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   gs_mfile_pack_bytes = pack_bytes;
+
+#if MFILE_PACK_TRACE_LVL > 0
+   debug_printf( MFILE_PACK_TRACE_LVL, "opened pack %s with " U32_FMT
+      " entries", filename, _mfile_pack_u32( &(pack_bytes[8]) ) );
+#endif /* MFILE_PACK_TRACE_LVL */
+
+cleanup:
+
+   if( MERROR_OK != retval ) {
+      if( (MAUG_MHANDLE)NULL != gs_mfile_pack_h ) {
+         if( NULL != pack_bytes ) {
+            maug_munlock( gs_mfile_pack_h, pack_bytes );
+         }
+         maug_mfree( gs_mfile_pack_h );
+         gs_mfile_pack_h = (MAUG_MHANDLE)NULL;
+      } else if( MFILE_CADDY_TYPE_MEM_BUFFER == gs_mfile_pack.type ) {
+         mfile_mem_release( &gs_mfile_pack );
+      }
+      /* The pack file is still open if copying it in failed partway.
+       * mfile_close() does nothing if it was already closed.
+       */
+      mfile_close( &gs_mfile_pack );
+   }
+
+   return retval;
+}
+
+/* === */
+
+void mfile_pack_close( void ) {
+   if( NULL == gs_mfile_pack_bytes ) {
+      return;
+   }
+
+   if( (MAUG_MHANDLE)NULL != gs_mfile_pack_h ) {
+      maug_munlock( gs_mfile_pack_h, gs_mfile_pack_bytes );
+      maug_mfree( gs_mfile_pack_h );
+      gs_mfile_pack_h = (MAUG_MHANDLE)NULL;
+   } else {
+      if( MFILE_CADDY_TYPE_MEM_BUFFER == gs_mfile_pack.type ) {
+         mfile_mem_release( &gs_mfile_pack );
+      }
+      mfile_close( &gs_mfile_pack );
+   }
+
+   gs_mfile_pack_bytes = NULL;
+   gs_mfile_pack_sz = 0;
+}
+
+/* === */
+
+static MERROR_RETVAL _mfile_pack_unrle(
+   const uint8_t* src, uint32_t src_sz, uint8_t* dest, uint32_t dest_sz
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   uint32_t i = 0;
+   uint32_t j = 0;
+   uint32_t run = 0;
+
+   while( src_sz > i ) {
+      if( 128 > src[i] ) {
+         /* Literal bytes. */
+         run = src[i++] + 1;
+         if( run > src_sz - i || run > dest_sz - j ) {
+            retval = MERROR_FILE;
+            goto cleanup;
+         }
+         memcpy( &(dest[j]), &(src[i]), run );
+         i += run;
+         j += run;
+
+      } else if( 128 < src[i] ) {
+         /* Repeated byte. */
+         run = 257 - src[i++];
+         if( src_sz <= i || run > dest_sz - j ) {
+            retval = MERROR_FILE;
+            goto cleanup;
+         }
+         memset( &(dest[j]), src[i++], run );
+         j += run;
+
+      } else {
+         i++;
+      }
+   }
+
+   if( j != dest_sz ) {
+      retval = MERROR_FILE;
+   }
+
+cleanup:
+
+   if( MERROR_OK != retval ) {
+      error_printf( "invalid RLE data in asset pack!" );
+   }
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL mfile_pack_open_entry(
+   const maug_path filename, mfile_t* p_file
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   uint32_t entries_ct = 0;
+   const uint8_t* dir = NULL;
+   const uint8_t* entry = NULL;
+   uint32_t hash = 0;
+   uint32_t lo = 0;
+   uint32_t hi = 0;
+   uint32_t mid = 0;
+   size_t name_sz = 0;
+   uint32_t name_off = 0;
+   uint32_t data_off = 0;
+   uint32_t data_sz = 0;
+   uint32_t unpacked_sz = 0;
+   MAUG_MHANDLE unpacked_h = (MAUG_MHANDLE)NULL;
+   uint8_t* unpacked = NULL;
+
+   if( NULL == gs_mfile_pack_bytes ) {
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   entries_ct = _mfile_pack_u32( &(gs_mfile_pack_bytes[8]) );
+   dir = &(gs_mfile_pack_bytes[_mfile_pack_u32( &(gs_mfile_pack_bytes[12]) )]);
+
+   name_sz = maug_strlen( filename );
+   hash = mfile_pack_hash( filename, name_sz );
+
+   /* Find the first entry with this hash. */
+   hi = entries_ct;
+   while( lo < hi ) {
+      mid = lo + ((hi - lo) >> 1);
+      if( _mfile_pack_u32( &(dir[mid * MFILE_PACK_ENTRY_SZ]) ) < hash ) {
+         lo = mid + 1;
+      } else {
+         hi = mid;
+      }
+   }
+
+   /* Check the names of every entry with this hash. */
+   for( ; entries_ct > lo ; lo++ ) {
+      entry = &(dir[lo * MFILE_PACK_ENTRY_SZ]);
+      if( _mfile_pack_u32( entry ) != hash ) {
+         break;
+      }
+      name_off = _mfile_pack_u32( &(entry[16]) );
+      if(
+         name_sz == _mfile_pack_u16( &(entry[20]) ) &&
+         name_off <= (uint32_t)gs_mfile_pack_sz &&
+         (uint32_t)gs_mfile_pack_sz - name_off >= name_sz &&
+         0 == memcmp( &(gs_mfile_pack_bytes[name_off]), filename, name_sz )
+      ) {
+         goto found;
+      }
+   }
+
+#if MFILE_PACK_TRACE_LVL > 0
+   debug_printf( MFILE_PACK_TRACE_LVL, "%s not found in pack", filename );
+#endif /* MFILE_PACK_TRACE_LVL */
+   retval = MERROR_FILE;
+   goto cleanup;
+
+found:
+
+   data_off = _mfile_pack_u32( &(entry[4]) );
+   data_sz = _mfile_pack_u32( &(entry[8]) );
+   unpacked_sz = _mfile_pack_u32( &(entry[12]) );
+   if(
+      (uint32_t)gs_mfile_pack_sz < data_off ||
+      (uint32_t)gs_mfile_pack_sz - data_off < data_sz
+   ) {
+      error_printf( "pack entry %s is out of bounds!", filename );
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+#if MFILE_PACK_TRACE_LVL > 0
+   debug_printf( MFILE_PACK_TRACE_LVL,
+      "found %s in pack at " U32_FMT " (" U32_FMT " bytes, compression %u)",
+      filename, data_off, data_sz, entry[22] );
+#endif /* MFILE_PACK_TRACE_LVL */
+
+   switch( entry[22] ) {
+   case MFILE_PACK_COMP_NONE:
+      /* Read the data in place. */
+      retval = mfile_lock_buffer( (MAUG_MHANDLE)NULL,
+         &(gs_mfile_pack_bytes[data_off]), data_sz, p_file );
+      maug_cleanup_if_not_ok();
+      break;
+
+   case MFILE_PACK_COMP_RLE:
+      if( 0 == unpacked_sz ) {
+         retval = mfile_lock_buffer( (MAUG_MHANDLE)NULL,
+            &(gs_mfile_pack_bytes[data_off]), 0, p_file );
+         maug_cleanup_if_not_ok();
+         break;
+      }
+
+      maug_malloc_test( unpacked_h, unpacked_sz, 1 );
+      maug_mlock( unpacked_h, unpacked );
+      maug_cleanup_if_null_lock( uint8_t*, unpacked );
+      retval = _mfile_pack_unrle(
+         &(gs_mfile_pack_bytes[data_off]), data_sz, unpacked, unpacked_sz );
+      maug_munlock( unpacked_h, unpacked );
+      maug_cleanup_if_not_ok();
+
+      retval = mfile_lock_buffer( unpacked_h, NULL, unpacked_sz, p_file );
+      maug_cleanup_if_not_ok();
+      p_file->flags |= MFILE_FLAG_OWNS_HANDLE;
+      unpacked_h = (MAUG_MHANDLE)NULL;
+      break;
+
+   default:
+      error_printf( "unknown compression in pack entry %s: %u",
+         filename, entry[22] );
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   p_file->flags |= MFILE_FLAG_READ_ONLY;
+
+cleanup:
+
+   if( NULL != unpacked ) {
+      maug_munlock( unpacked_h, unpacked );
+   }
+
+   if( (MAUG_MHANDLE)NULL != unpacked_h ) {
+      maug_mfree( unpacked_h );
+   }
+
+   return retval;
+}
+
+/* === */
+
 MERROR_RETVAL mfile_open_read(
    const maug_path filename, mfile_t* p_file
 ) {
    MERROR_RETVAL retval = MERROR_OK;
 
-   /* Call the platform-specific actual file opener from mrapifil.h. */
-   retval = mfile_plt_open_read( filename, p_file );
+   /* Start clean so mfile_getc() never sees a stale read buffer. */
+   maug_mzero( p_file, sizeof( struct MFILE_CADDY ) );
 
-   if( MERROR_OK == retval ) {
-      /* Store filename. */
-      retval = mfile_assign_path( p_file->filename, filename, 0 );
+   /* Try the asset pack first, if there is one. */
+   retval = mfile_pack_open_entry( filename, p_file );
+   if( MERROR_OK != retval ) {
+      /* Call the platform-specific actual file opener from mrapifil.h. */
+      maug_mzero( p_file, sizeof( struct MFILE_CADDY ) );
+      retval = mfile_plt_open_read( filename, p_file );
    }
+   maug_cleanup_if_not_ok();
+
+   /* Store filename. */
+   retval = mfile_assign_path( p_file->filename, filename, 0 );
+   maug_cleanup_if_not_ok();
+
+#if MFILE_READ_BUFFER_SZ > 0
+   if( MFILE_CADDY_TYPE_FILE == p_file->type ) {
+      retval = mfile_read_buffer_init( p_file, MFILE_READ_BUFFER_SZ );
+      if( MERROR_OK != retval ) {
+         /* Reading unbuffered is slower, but still works. */
+         error_printf( "could not buffer file %s; reading unbuffered!",
+            filename );
+         retval = MERROR_OK;
+      }
+   }
+#endif /* MFILE_READ_BUFFER_SZ */
+
+cleanup:
 
    return retval;
 }
@@ -653,6 +1550,8 @@ MERROR_RETVAL mfile_open_write(
 ) {
    MERROR_RETVAL retval = MERROR_OK;
 
+   maug_mzero( p_file, sizeof( struct MFILE_CADDY ) );
+
    retval = mfile_plt_open_write( filename, p_file );
 
    if( MERROR_OK == retval ) {
@@ -669,10 +1568,6 @@ void mfile_close( mfile_t* p_file ) {
 #  if MFILE_SEEK_TRACE_LVL > 0
    debug_printf( MFILE_SEEK_TRACE_LVL, "closing file..." );
 #  endif /* MFILE_SEEK_TRACE_LVL */
-#  ifdef MFILE_MMAP
-   munmap( bytes_ptr_h, bytes_sz );
-#  else
-   /* maug_mfree( bytes_ptr_h ); */
    switch( p_file->type ) {
    case 0:
       /* Do nothing silently. */
@@ -680,10 +1575,35 @@ void mfile_close( mfile_t* p_file ) {
 
    case MFILE_CADDY_TYPE_FILE:
       mfile_plt_close( p_file );
+      if(
+         MFILE_FLAG_READ_BUFFERED == (MFILE_FLAG_READ_BUFFERED & p_file->flags)
+      ) {
+         maug_munlock( p_file->rbuf_h, p_file->rbuf );
+         maug_mfree( p_file->rbuf_h );
+         p_file->flags &= ~MFILE_FLAG_READ_BUFFERED;
+      }
       p_file->type = 0;
       break;
 
    case MFILE_CADDY_TYPE_MEM_BUFFER:
+#  ifdef MFILE_MMAP
+      if( MFILE_FLAG_MMAP == (MFILE_FLAG_MMAP & p_file->flags) ) {
+         mfile_plt_unmap( p_file );
+         p_file->mem_buffer = NULL;
+         p_file->flags &= ~MFILE_FLAG_MMAP;
+         p_file->type = 0;
+         break;
+      }
+#  endif /* MFILE_MMAP */
+      if(
+         MFILE_FLAG_OWNS_HANDLE == (MFILE_FLAG_OWNS_HANDLE & p_file->flags)
+      ) {
+         maug_mfree( p_file->h.mem );
+         p_file->h.mem = (MAUG_MHANDLE)NULL;
+         p_file->flags &= ~MFILE_FLAG_OWNS_HANDLE;
+         p_file->type = 0;
+         break;
+      }
       if( NULL != p_file->mem_buffer ) {
          maug_munlock( p_file->h.mem, p_file->mem_buffer );
          debug_printf( MFILE_SEEK_TRACE_LVL,
@@ -697,7 +1617,6 @@ void mfile_close( mfile_t* p_file ) {
       error_printf( "unknown file type: %d", (p_file)->type );
       break;
    }
-#  endif /* MFILE_MMAP */
 }
 
 #endif /* MFILE_C */
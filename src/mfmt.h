@@ -802,7 +802,7 @@ MERROR_RETVAL mfmt_read_bmp_px_cb(
 
          /* Move on to a new byte. */
          /* TODO: Bad cursor? */
-         retval = p_file_bmp->read_byte( p_file_bmp, &byte_buffer );
+         retval = mfile_getc( p_file_bmp, &byte_buffer );
          maug_cleanup_if_not_ok();
          byte_in_idx++;
 
@@ -68,6 +68,15 @@
 #  define MLISP_STACK_TRACE_LVL 0
 #endif /* !MLISP_STACK_TRACE_LVL */
 
+/**
+ * \brief Maximum number of bytecode instructions to execute per call to
+ *        mlisp_step() or mlisp_step_lambda() for an exec with
+ *        ::MLISP_EXEC_FLAG_BYTECODE, before preempting.
+ */
+#ifndef MLISP_BC_STEP_OPS_MAX
+#  define MLISP_BC_STEP_OPS_MAX 32
+#endif /* !MLISP_BC_STEP_OPS_MAX */
+
 #define MLISP_ENV_FLAG_BUILTIN   0x02
 
 /*! \brief Flag for _mlisp_env_cb_cmp() specifying TRUE if A > B. */
@@ -185,6 +194,15 @@ ssize_t mlisp_count_builtins( struct MLISP_EXEC_STATE* exec );
 MERROR_RETVAL mlisp_check_state(
    struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec );
 
+/**
+ * \brief Fill in MLISP_EXEC_STATE::per_node_resolve with the literal values
+ *        of tokens in the AST, so they are not parsed on every visit.
+ *
+ * This is called by mlisp_step() the first time it runs on a new AST.
+ */
+MERROR_RETVAL mlisp_exec_resolve(
+   struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec );
+
 /**
  * \brief Iterate the current exec_state() starting from the next MLISP_AST_NODE
  *        to be executed according to the tree of
@@ -626,13 +644,20 @@ cleanup:
 
 /* === */
 
-struct MLISP_ENV_NODE* mlisp_env_get(
-   struct MLISP_EXEC_STATE* exec, const char* key
+/**
+ * \brief Find a key in the env the same way as mlisp_env_get(), and report
+ *        where it was found so it can be cached in a MLISP_RESOLVE_NODE.
+ * \param p_frame Frame the key was found in, or -1 for the global env.
+ * \param p_idx Position of the key in the table it was found in.
+ */
+static struct MLISP_ENV_NODE* _mlisp_env_get_idx(
+   struct MLISP_EXEC_STATE* exec, const char* key,
+   int8_t* p_frame, ssize_t* p_idx
 ) {
    struct MLISP_ENV_NODE* e = NULL;
    struct MDATA_TABLE* env = NULL;
-   MERROR_RETVAL retval = MERROR_OK;
    int8_t env_iter = exec->env_select;
+   ssize_t idx = -1;
 
    while( 0 <= env_iter ) {
       env = &(exec->env[env_iter]);
@@ -643,9 +668,10 @@ struct MLISP_ENV_NODE* mlisp_env_get(
        */
       assert( mdata_table_is_locked( env ) );
 
-      e = mdata_table_get( env, key, struct MLISP_ENV_NODE );
-      if( NULL != e ) {
+      idx = mdata_table_get_idx( env, key );
+      if( 0 <= idx ) {
          /* Found something, so short-circuit! */
+         e = mdata_table_get_by_idx( env, idx, struct MLISP_ENV_NODE );
          goto cleanup;
       }
 
@@ -658,20 +684,34 @@ struct MLISP_ENV_NODE* mlisp_env_get(
     */
    if( NULL != exec->global_env ) {
       assert( mdata_table_is_locked( exec->global_env ) );
-      e = mdata_table_get( exec->global_env, key, struct MLISP_ENV_NODE );
+      idx = mdata_table_get_idx( exec->global_env, key );
+      if( 0 <= idx ) {
+         e = mdata_table_get_by_idx(
+            exec->global_env, idx, struct MLISP_ENV_NODE );
+      }
    }
 
 cleanup:
 
-   if( MERROR_OK != retval ) {
-      e = NULL;
-   }
+   *p_frame = env_iter;
+   *p_idx = idx;
 
    return e;
 }
 
 /* === */
 
+struct MLISP_ENV_NODE* mlisp_env_get(
+   struct MLISP_EXEC_STATE* exec, const char* key
+) {
+   int8_t env_frame = 0;
+   ssize_t env_idx = 0;
+
+   return _mlisp_env_get_idx( exec, key, &env_frame, &env_idx );
+}
+
+/* === */
+
 MERROR_RETVAL mlisp_env_unset(
    struct MLISP_EXEC_STATE* exec, const char* token, size_t token_sz,
    uint8_t global
@@ -680,6 +720,7 @@ MERROR_RETVAL mlisp_env_unset(
    uint8_t autolock[MLISP_EXEC_ENV_FRAME_CT_MAX];
    int8_t env_iter = exec->env_select;
    struct MDATA_TABLE* env = NULL;
+   size_t env_ct = 0;
 
    /* TODO: Unset in global env if requested. */
 
@@ -699,7 +740,12 @@ MERROR_RETVAL mlisp_env_unset(
          autolock[env_iter] |= 0x02;
       }
 
+      env_ct = mdata_table_ct( env );
       retval = mdata_table_unset( env, token );
+      if( mdata_table_ct( env ) != env_ct ) {
+         /* Keys after this one moved, so cached symbol positions are stale. */
+         exec->env_gen++;
+      }
 
       env_iter--;
    }
@@ -725,6 +771,7 @@ MERROR_RETVAL mlisp_env_set(
    MERROR_RETVAL retval = MERROR_OK;
    struct MLISP_ENV_NODE e;
    struct MDATA_TABLE* env = NULL;
+   size_t env_ct = 0;
 
    /* Builtins can only be inserted into frame 0! */
    assert(
@@ -752,10 +799,6 @@ MERROR_RETVAL mlisp_env_set(
 
    assert( !mdata_table_is_locked( env ) );
 
-   /* Find previous env nodes with same token and change. */
-   /* Ignore the retval, since it doesn't really matter if this fails. */
-   mdata_table_unset( env, token );
-
 #if MLISP_ENV_TRACE_LVL > 0
 #  define _MLISP_TYPE_TABLE_ASGN( idx, ctype, name, const_name, fmt ) \
       case idx: \
@@ -832,7 +875,14 @@ MERROR_RETVAL mlisp_env_set(
       goto cleanup;
    }
 
+   /* An existing key is overwritten in place, so cached symbol positions only
+    * go stale if the env grew a new key.
+    */
+   env_ct = mdata_table_ct( env );
    retval = mdata_table_set( env, token, &e, sizeof( struct MLISP_ENV_NODE ) );
+   if( mdata_table_ct( env ) != env_ct ) {
+      exec->env_gen++;
+   }
 
 cleanup:
 
@@ -1618,6 +1668,7 @@ static MERROR_RETVAL _mlisp_reset_lambda(
    assert( 0 < exec->env_select );
    mdata_table_free( &(exec->env[exec->env_select]) );
    exec->env_select--;
+   exec->env_gen++;
 
    /* Reset per-node program counters. */
    retval = _mlisp_reset_child_pcs( parser, n_idx, exec );
@@ -1819,17 +1870,62 @@ cleanup:
 
 /* === */
 
+/**
+ * \brief Get the env node for a symbol cached in a MLISP_RESOLVE_NODE, if it
+ *        is still where it was found.
+ * \return The env node, or NULL if the cache is stale.
+ */
+static struct MLISP_ENV_NODE* _mlisp_resolve_get(
+   struct MLISP_EXEC_STATE* exec, struct MLISP_RESOLVE_NODE* r
+) {
+   struct MLISP_ENV_NODE* e = NULL;
+   struct MDATA_TABLE_KEY* key = NULL;
+
+   if( MLISP_RESOLVE_FLAG_GLOBAL == (MLISP_RESOLVE_FLAG_GLOBAL & r->flags) ) {
+      /* The global env may be shared with other execs that don't bump our
+       * env_gen, so make sure the key didn't move.
+       */
+      assert( NULL != exec->global_env );
+      key = mdata_table_get_key_by_idx( exec->global_env, r->env_idx );
+      if(
+         NULL == key || key->hash != r->key_hash || key->string_sz != r->key_sz
+      ) {
+         goto cleanup;
+      }
+      e = mdata_table_get_by_idx(
+         exec->global_env, r->env_idx, struct MLISP_ENV_NODE );
+
+   } else {
+      assert( r->env_frame <= exec->env_select );
+      e = mdata_table_get_by_idx(
+         &(exec->env[r->env_frame]), r->env_idx, struct MLISP_ENV_NODE );
+   }
+
+cleanup:
+
+   return e;
+}
+
+/* === */
+
 /**
  * \brief Like env_get, but fallback to numbers or literals if the token is
  *        not present in the env.
+ *
+ * Results are cached in MLISP_EXEC_STATE::per_node_resolve if it is locked.
  */
 static MERROR_RETVAL _mlisp_eval_token_strpool(
    struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec,
-   size_t token_idx, size_t token_sz, struct MLISP_ENV_NODE* e_out
+   size_t n_idx, size_t token_idx, size_t token_sz,
+   struct MLISP_ENV_NODE* e_out
 ) {
    MERROR_RETVAL retval = MERROR_OK;
    struct MLISP_ENV_NODE* p_e = NULL;
+   struct MLISP_RESOLVE_NODE* r = NULL;
+   struct MDATA_TABLE_KEY* key = NULL;
    char* strpool_token = NULL;
+   int8_t env_frame = 0;
+   ssize_t env_idx = 0;
 
    /* Make sure we're sharing env context with our caller! */
    /* assert(
@@ -1838,6 +1934,33 @@ static MERROR_RETVAL _mlisp_eval_token_strpool(
       NULL == exec->global_env ||
       mdata_table_is_locked( exec->global_env ) );
 
+   if( mdata_vector_is_locked( &(exec->per_node_resolve) ) ) {
+      r = mdata_vector_get(
+         &(exec->per_node_resolve), n_idx, struct MLISP_RESOLVE_NODE );
+   }
+
+   if( NULL != r ) {
+      /* Try to skip the string work below. */
+      if(
+         MLISP_RESOLVE_FLAG_LITERAL == (MLISP_RESOLVE_FLAG_LITERAL & r->flags)
+      ) {
+         memcpy( e_out, &(r->literal), sizeof( struct MLISP_ENV_NODE ) );
+         goto cleanup;
+
+      } else if(
+         MLISP_RESOLVE_FLAG_SYMBOL == (MLISP_RESOLVE_FLAG_SYMBOL & r->flags) &&
+         exec->env_gen == r->env_gen &&
+         NULL != (p_e = _mlisp_resolve_get( exec, r ))
+      ) {
+         memcpy( e_out, p_e, sizeof( struct MLISP_ENV_NODE ) );
+         p_e = NULL;
+         goto cleanup;
+      }
+
+      /* The cached symbol is stale, so look it up again below. */
+      r->flags &= ~(MLISP_RESOLVE_FLAG_SYMBOL | MLISP_RESOLVE_FLAG_GLOBAL);
+   }
+
    mdata_strpool_lock( &(parser->strpool) );
 
    /* TODO: Use exec_state strpool. */
@@ -1853,7 +1976,10 @@ static MERROR_RETVAL _mlisp_eval_token_strpool(
       /* Fake env node e to signal step_iter() to place/cleanup stack frame. */
       e_out->type = MLISP_TYPE_BEGIN;
 
-   } else if( NULL != (p_e = mlisp_env_get( exec, strpool_token ) ) ) {
+   } else if(
+      NULL != (p_e = _mlisp_env_get_idx(
+         exec, strpool_token, &env_frame, &env_idx ))
+   ) {
       /* A literal found in the environment. */
 #if MLISP_EXEC_TRACE_LVL > 0
       debug_printf( MLISP_EXEC_TRACE_LVL, "%u: found %s in env!",
@@ -1865,6 +1991,21 @@ static MERROR_RETVAL _mlisp_eval_token_strpool(
       memcpy( e_out, p_e, sizeof( struct MLISP_ENV_NODE ) );
       p_e = NULL;
 
+      if( NULL != r ) {
+         /* Remember where we found it until the env changes shape. */
+         r->flags |= MLISP_RESOLVE_FLAG_SYMBOL;
+         r->env_frame = env_frame;
+         r->env_idx = env_idx;
+         r->env_gen = exec->env_gen;
+         if( 0 > env_frame ) {
+            r->flags |= MLISP_RESOLVE_FLAG_GLOBAL;
+            key = mdata_table_get_key_by_idx( exec->global_env, env_idx );
+            assert( NULL != key );
+            r->key_hash = key->hash;
+            r->key_sz = key->string_sz;
+         }
+      }
+
    } else if( maug_is_num( strpool_token, token_sz, 10, 1 ) ) {
       /* Fake env node e from a numeric literal. */
 #if MLISP_EXEC_TRACE_LVL > 0
@@ -1999,7 +2140,7 @@ static MERROR_RETVAL _mlisp_step_iter(
 
    /* Grab the token for this node and figure out what it is. */
    retval = _mlisp_eval_token_strpool(
-      parser, exec, n->token_idx, n->token_sz, &e );
+      parser, exec, n_idx, n->token_idx, n->token_sz, &e );
    maug_cleanup_if_not_ok();
 
    /* Prepare to step. */
@@ -2134,6 +2275,568 @@ cleanup:
 
 /* === */
 
+/* Bytecode Functions */
+
+/* === */
+
+/**
+ * \brief Lock the env frames and the global env for the bytecode interpreter,
+ *        recording the ones that weren't already locked in autolock.
+ *
+ * Unlike _mlisp_autolock(), this locks an empty global env too, since token
+ * evaluation expects the global env to be locked if it is present.
+ */
+static void _mlisp_bc_env_lock(
+   struct MLISP_EXEC_STATE* exec, uint8_t autolock[MLISP_EXEC_ENV_FRAME_CT_MAX]
+) {
+   int8_t env_iter = 0;
+
+   maug_mzero( autolock, MLISP_EXEC_ENV_FRAME_CT_MAX );
+
+   for( env_iter = exec->env_select ; 0 <= env_iter ; env_iter-- ) {
+      if( !mdata_table_is_locked( &(exec->env[env_iter]) ) ) {
+         mdata_table_lock( &(exec->env[env_iter]) );
+         autolock[env_iter] |= MLISP_AUTOLOCK_EXEC_ENV;
+      }
+   }
+   if(
+      NULL != exec->global_env && !mdata_table_is_locked( exec->global_env )
+   ) {
+      mdata_table_lock( exec->global_env );
+      autolock[0] |= MLISP_AUTOLOCK_GLOBAL_ENV;
+   }
+}
+
+/* === */
+
+/**
+ * \brief Unlock only the tables locked by _mlisp_bc_env_lock(), leaving any
+ *        the caller had locked alone.
+ */
+static void _mlisp_bc_env_unlock(
+   struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec,
+   uint8_t autolock[MLISP_EXEC_ENV_FRAME_CT_MAX]
+) {
+   _mlisp_autounlock( parser, exec, autolock );
+
+   /* Don't unlock them again if this is called twice. */
+   maug_mzero( autolock, MLISP_EXEC_ENV_FRAME_CT_MAX );
+}
+
+/* === */
+
+/**
+ * \brief Enter a lambda, popping its args off the stack into a new env frame
+ *        and jumping to the start of its body.
+ * \param tail If nonzero, replace the env frame and call of the lambda being
+ *             left instead of returning to it.
+ * \warning The env must be unlocked before calling this!
+ */
+static MERROR_RETVAL _mlisp_bc_call(
+   struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec,
+   mlisp_lambda_t lambda_idx, size_t pc_ret, uint8_t flags, uint8_t tail
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_AST_NODE* n = NULL;
+   struct MLISP_BC_CALL call;
+   size_t* p_lambda_pc = NULL;
+   ssize_t append_retval = 0;
+
+   assert( mdata_vector_is_locked( &(parser->ast) ) );
+   assert( mdata_vector_is_locked( &(parser->bc_lambda_pc) ) );
+
+   n = mdata_vector_get( &(parser->ast), lambda_idx, struct MLISP_AST_NODE );
+   p_lambda_pc = mdata_vector_get(
+      &(parser->bc_lambda_pc), lambda_idx, size_t );
+   if(
+      NULL == n || NULL == p_lambda_pc ||
+      MLISP_AST_FLAG_LAMBDA != (MLISP_AST_FLAG_LAMBDA & n->flags)
+   ) {
+      error_printf( "%u: invalid node " SSIZE_T_FMT ": not a lambda!",
+         exec->uid, lambda_idx );
+      retval = MERROR_EXEC;
+      goto cleanup;
+   }
+
+   if( tail ) {
+      /* Nothing is left to do in the current lambda, so reuse its call. */
+#if MLISP_STEP_TRACE_LVL > 0
+      debug_printf( MLISP_STEP_TRACE_LVL, "%u: tail call to lambda "
+         SSIZE_T_FMT, exec->uid, lambda_idx );
+#endif /* MLISP_STEP_TRACE_LVL */
+      assert( 0 < exec->env_select );
+      mdata_table_free( &(exec->env[exec->env_select]) );
+      exec->env_select--;
+      exec->env_gen++;
+
+   } else {
+      maug_mzero( &call, sizeof( struct MLISP_BC_CALL ) );
+      call.pc_ret = pc_ret;
+      call.flags = flags;
+      append_retval = mdata_vector_append(
+         &(exec->bc_calls), &call, sizeof( struct MLISP_BC_CALL ) );
+      retval = mdata_retval( append_retval );
+      maug_cleanup_if_not_ok();
+   }
+
+   /* Pop stack into args in a new env frame. */
+   retval = _mlisp_step_lambda_args( parser, n->ast_idx_children[0], exec );
+   maug_cleanup_if_not_ok();
+
+   exec->bc_pc = *p_lambda_pc;
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+/**
+ * \brief Leave the current lambda and return to its caller.
+ * \param p_halt Set to nonzero if the call had ::MLISP_BC_CALL_FLAG_HALT.
+ * \warning The env must be unlocked before calling this!
+ */
+static MERROR_RETVAL _mlisp_bc_ret(
+   struct MLISP_EXEC_STATE* exec, uint8_t* p_halt
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_BC_CALL* p_call = NULL;
+   struct MLISP_BC_CALL call;
+
+   mdata_vector_lock( &(exec->bc_calls) );
+   p_call = mdata_vector_get_last( &(exec->bc_calls), struct MLISP_BC_CALL );
+   if( NULL == p_call ) {
+      error_printf( "%u: return without call!", exec->uid );
+      retval = MERROR_EXEC;
+      goto cleanup;
+   }
+   memcpy( &call, p_call, sizeof( struct MLISP_BC_CALL ) );
+   p_call = NULL;
+   mdata_vector_unlock( &(exec->bc_calls) );
+
+   retval = mdata_vector_remove_last( &(exec->bc_calls) );
+   maug_cleanup_if_not_ok();
+
+   /* Move up one env frame. */
+   assert( 0 < exec->env_select );
+   mdata_table_free( &(exec->env[exec->env_select]) );
+   exec->env_select--;
+   exec->env_gen++;
+
+   exec->bc_pc = call.pc_ret;
+   *p_halt = MLISP_BC_CALL_FLAG_HALT == (MLISP_BC_CALL_FLAG_HALT & call.flags);
+
+cleanup:
+
+   if( mdata_vector_is_locked( &(exec->bc_calls) ) ) {
+      mdata_vector_unlock( &(exec->bc_calls) );
+   }
+
+   return retval;
+}
+
+/* === */
+
+/**
+ * \brief Copy the top args_c nodes of the stack to
+ *        MLISP_EXEC_STATE::bc_cb_args before calling a callback, since the
+ *        callback pops its args itself.
+ */
+static MERROR_RETVAL _mlisp_bc_cb_args_save(
+   struct MLISP_EXEC_STATE* exec, size_t args_c
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t stack_ct = mdata_vector_ct( &(exec->stack) );
+
+   if( args_c > stack_ct ) {
+      /* The callback will find out about the underflow on its own. */
+      args_c = stack_ct;
+   }
+
+   /* The allocation is kept from call to call, so this rarely grows it. */
+   mdata_vector_fill(
+      &(exec->bc_cb_args), args_c, sizeof( struct MLISP_STACK_NODE ) );
+
+   if( 0 == args_c ) {
+      goto cleanup;
+   }
+
+   mdata_vector_lock( &(exec->stack) );
+   mdata_vector_lock( &(exec->bc_cb_args) );
+   memcpy(
+      mdata_vector_get_void( &(exec->bc_cb_args), 0 ),
+      mdata_vector_get_void( &(exec->stack), stack_ct - args_c ),
+      args_c * sizeof( struct MLISP_STACK_NODE ) );
+
+cleanup:
+
+   if( mdata_vector_is_locked( &(exec->bc_cb_args) ) ) {
+      mdata_vector_unlock( &(exec->bc_cb_args) );
+   }
+   if( mdata_vector_is_locked( &(exec->stack) ) ) {
+      mdata_vector_unlock( &(exec->stack) );
+   }
+
+   return retval;
+}
+
+/* === */
+
+/**
+ * \brief Rewind the stack to stack_base and push the args saved by
+ *        _mlisp_bc_cb_args_save() again, so a callback that preempted can be
+ *        called on the same args on the next step.
+ */
+static MERROR_RETVAL _mlisp_bc_cb_args_restore(
+   struct MLISP_EXEC_STATE* exec, size_t stack_base
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_STACK_NODE o;
+   ssize_t append_retval = 0;
+   size_t i = 0;
+
+   /* Get rid of anything the callback pushed before it preempted. */
+   while( mdata_vector_ct( &(exec->stack) ) > stack_base ) {
+      retval = mlisp_stack_pop( exec, &o );
+      maug_cleanup_if_not_ok();
+   }
+
+   if( 0 == mdata_vector_ct( &(exec->bc_cb_args) ) ) {
+      goto cleanup;
+   }
+
+   mdata_vector_lock( &(exec->bc_cb_args) );
+   for( i = 0 ; mdata_vector_ct( &(exec->bc_cb_args) ) > i ; i++ ) {
+      append_retval = mdata_vector_append( &(exec->stack),
+         mdata_vector_get_void( &(exec->bc_cb_args), i ),
+         sizeof( struct MLISP_STACK_NODE ) );
+      retval = mdata_retval( append_retval );
+      maug_cleanup_if_not_ok();
+   }
+
+cleanup:
+
+   if( mdata_vector_is_locked( &(exec->bc_cb_args) ) ) {
+      mdata_vector_unlock( &(exec->bc_cb_args) );
+   }
+
+   return retval;
+}
+
+/* === */
+
+/**
+ * \brief Make sure the parser has been compiled and the exec has resolved its
+ *        literals before running bytecode.
+ */
+static MERROR_RETVAL _mlisp_bc_prepare(
+   struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+
+   if( 0 == mdata_vector_ct( &(parser->bytecode) ) ) {
+      retval = mlisp_parser_compile( parser );
+      maug_cleanup_if_not_ok();
+   }
+
+   if(
+      mdata_vector_ct( &(exec->per_node_resolve) ) !=
+      mdata_vector_ct( &(parser->ast) )
+   ) {
+      retval = mlisp_exec_resolve( parser, exec );
+      maug_cleanup_if_not_ok();
+   }
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+/**
+ * \brief Determine if a call at pc is a tail call, because the instructions
+ *        after it lead straight to ::MLISP_OP_RET (maybe by way of jumping
+ *        out of an if or closing a begin).
+ */
+static uint8_t _mlisp_bc_is_tail(
+   struct MLISP_PARSER* parser, size_t pc
+) {
+   struct MLISP_BC_OP* op_next = NULL;
+
+   assert( mdata_vector_is_locked( &(parser->bytecode) ) );
+
+   pc++;
+   op_next = mdata_vector_get( &(parser->bytecode), pc, struct MLISP_BC_OP );
+   while(
+      NULL != op_next &&
+      (MLISP_OP_JMP == op_next->op || MLISP_OP_BEGIN_END == op_next->op)
+   ) {
+      if( MLISP_OP_JMP == op_next->op ) {
+         pc = op_next->arg;
+      } else {
+         pc++;
+      }
+      op_next = mdata_vector_get( &(parser->bytecode), pc, struct MLISP_BC_OP );
+   }
+
+   return NULL != op_next && MLISP_OP_RET == op_next->op;
+}
+
+/* === */
+
+/**
+ * \brief Rewind the stack for each begin closed between a tail call at pc and
+ *        the return it skips, since those ::MLISP_OP_BEGIN_END instructions
+ *        will never run.
+ *
+ * Unlike ::MLISP_OP_BEGIN_END, no replacement begin marker is pushed, so the
+ * tail call's result stands in for the begin's and the stack stays the same
+ * size no matter how many times a lambda tail calls itself.
+ *
+ * \warning The lambda's args must already have been popped!
+ */
+static MERROR_RETVAL _mlisp_bc_tail_cleanup(
+   struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec, size_t pc
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_BC_OP* op_next = NULL;
+
+   assert( mdata_vector_is_locked( &(parser->bytecode) ) );
+
+   pc++;
+   op_next = mdata_vector_get( &(parser->bytecode), pc, struct MLISP_BC_OP );
+   while( NULL != op_next && MLISP_OP_RET != op_next->op ) {
+      if( MLISP_OP_JMP == op_next->op ) {
+         pc = op_next->arg;
+      } else {
+         assert( MLISP_OP_BEGIN_END == op_next->op );
+         retval = _mlisp_stack_cleanup( parser, op_next->n_idx, exec );
+         maug_cleanup_if_not_ok();
+         pc++;
+      }
+      op_next = mdata_vector_get( &(parser->bytecode), pc, struct MLISP_BC_OP );
+   }
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+/**
+ * \brief Execute up to ::MLISP_BC_STEP_OPS_MAX instructions.
+ * \return MERROR_PREEMPT if there are more instructions to execute, or
+ *         MERROR_OK if execution reached ::MLISP_OP_END or returned from a
+ *         call with ::MLISP_BC_CALL_FLAG_HALT.
+ */
+static MERROR_RETVAL _mlisp_bc_run(
+   struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_BC_OP* op = NULL;
+   struct MLISP_AST_NODE* n = NULL;
+   struct MLISP_ENV_NODE e;
+   struct MLISP_STACK_NODE s;
+   uint8_t halt = 0;
+   uint8_t tail = 0;
+   uint8_t autolock[MLISP_EXEC_ENV_FRAME_CT_MAX];
+   size_t pc_call = 0;
+   size_t stack_base = 0;
+   size_t i = 0;
+
+   maug_mzero( autolock, MLISP_EXEC_ENV_FRAME_CT_MAX );
+
+   /* None of these are added to or removed from while running. */
+   assert( !mdata_vector_is_locked( &(parser->bytecode) ) );
+   assert( !mdata_vector_is_locked( &(parser->ast) ) );
+   mdata_vector_lock( &(parser->bytecode) );
+   mdata_vector_lock( &(parser->bc_lambda_pc) );
+   mdata_vector_lock( &(parser->ast) );
+   mdata_vector_lock( &(exec->per_node_resolve) );
+   /* Callbacks may expect these to be locked as they are for mlisp_step(). */
+   mdata_vector_lock( &(exec->per_node_child_idx) );
+   mdata_vector_lock( &(exec->per_node_visit_ct) );
+
+   _mlisp_bc_env_lock( exec, autolock );
+
+#  define _MLISP_TYPE_TABLE_BC_PUSH( idx, ctype, name, const_name, fmt ) \
+      case idx: \
+         retval = _mlisp_stack_push_ ## ctype( exec, op->value.name ); \
+         break;
+
+#  define _MLISP_TYPE_TABLE_BC_PUSH_E( idx, ctype, name, const_name, fmt ) \
+      case idx: \
+         retval = _mlisp_stack_push_ ## ctype( exec, e.value.name ); \
+         break;
+
+   for( i = 0 ; MLISP_BC_STEP_OPS_MAX > i ; i++ ) {
+      op = mdata_vector_get(
+         &(parser->bytecode), exec->bc_pc, struct MLISP_BC_OP );
+      if( NULL == op ) {
+         error_printf( "%u: invalid bytecode pc: " SIZE_T_FMT,
+            exec->uid, exec->bc_pc );
+         retval = MERROR_EXEC;
+         goto cleanup;
+      }
+
+#if MLISP_STEP_TRACE_LVL > 0
+      debug_printf( MLISP_STEP_TRACE_LVL,
+         "%u: pc " SIZE_T_FMT ": op %d (node " SIZE_T_FMT ")",
+         exec->uid, exec->bc_pc, op->op, op->n_idx );
+#endif /* MLISP_STEP_TRACE_LVL */
+
+      switch( op->op ) {
+      case MLISP_OP_END:
+         retval = MERROR_OK;
+         goto cleanup;
+
+      case MLISP_OP_PUSH:
+         switch( op->type ) {
+         MLISP_TYPE_TABLE( _MLISP_TYPE_TABLE_BC_PUSH )
+         default:
+            error_printf( "%u: invalid push type: %d", exec->uid, op->type );
+            retval = MERROR_EXEC;
+            break;
+         }
+         maug_cleanup_if_not_ok();
+         break;
+
+      case MLISP_OP_EVAL:
+         n = mdata_vector_get(
+            &(parser->ast), op->n_idx, struct MLISP_AST_NODE );
+         assert( NULL != n );
+         maug_mzero( &e, sizeof( struct MLISP_ENV_NODE ) );
+         retval = _mlisp_eval_token_strpool(
+            parser, exec, op->n_idx, n->token_idx, n->token_sz, &e );
+         maug_cleanup_if_not_ok();
+
+         if( MLISP_TYPE_CB == e.type ) {
+            retval = _mlisp_bc_cb_args_save( exec, op->arg );
+            maug_cleanup_if_not_ok();
+            stack_base = mdata_vector_ct( &(exec->stack) ) -
+               mdata_vector_ct( &(exec->bc_cb_args) );
+
+            /* Unlock the env so the callback can use it if needed. */
+            _mlisp_bc_env_unlock( parser, exec, autolock );
+            retval = e.value.cb(
+               parser, exec, op->n_idx, op->arg, NULL, e.flags );
+            _mlisp_bc_env_lock( exec, autolock );
+            if( MERROR_PREEMPT == retval ) {
+               /* The callback wants to be called again next step, on the
+                * args it already popped.
+                */
+               retval = _mlisp_bc_cb_args_restore( exec, stack_base );
+               maug_cleanup_if_not_ok();
+               retval = MERROR_PREEMPT;
+            }
+            maug_cleanup_if_not_ok();
+
+         } else if( MLISP_TYPE_LAMBDA == e.type ) {
+            pc_call = exec->bc_pc;
+            tail = _mlisp_bc_is_tail( parser, pc_call );
+            _mlisp_bc_env_unlock( parser, exec, autolock );
+            retval = _mlisp_bc_call( parser, exec, e.value.lambda,
+               pc_call + 1, 0, tail );
+            if( MERROR_OK == retval && tail ) {
+               retval = _mlisp_bc_tail_cleanup( parser, exec, pc_call );
+            }
+            _mlisp_bc_env_lock( exec, autolock );
+            maug_cleanup_if_not_ok();
+            /* The pc is now at the start of the lambda. */
+            continue;
+
+         } else {
+            switch( e.type ) {
+            MLISP_TYPE_TABLE( _MLISP_TYPE_TABLE_BC_PUSH_E )
+            default:
+               /* Not in the env, so it's a literal string. */
+               retval = _mlisp_stack_push_mdata_strpool_idx_t(
+                  exec, n->token_idx );
+               break;
+            }
+            maug_cleanup_if_not_ok();
+         }
+         break;
+
+      case MLISP_OP_BEGIN_END:
+         retval = _mlisp_stack_cleanup( parser, op->n_idx, exec );
+         maug_cleanup_if_not_ok();
+         retval = _mlisp_stack_push_mlisp_begin_t( exec, op->n_idx );
+         maug_cleanup_if_not_ok();
+         break;
+
+      case MLISP_OP_JMP:
+         exec->bc_pc = op->arg;
+         continue;
+
+      case MLISP_OP_JMP_FALSE:
+         retval = mlisp_stack_pop( exec, &s );
+         maug_cleanup_if_not_ok();
+         if( MLISP_TYPE_BOOLEAN != s.type ) {
+            error_printf( "(if) can only evaluate boolean type!" );
+            retval = MERROR_EXEC;
+            goto cleanup;
+         }
+         if( !s.value.boolean ) {
+            exec->bc_pc = op->arg;
+            continue;
+         }
+         break;
+
+      case MLISP_OP_RET:
+         _mlisp_bc_env_unlock( parser, exec, autolock );
+         retval = _mlisp_bc_ret( exec, &halt );
+         _mlisp_bc_env_lock( exec, autolock );
+         maug_cleanup_if_not_ok();
+         if( halt ) {
+            goto cleanup;
+         }
+         /* The pc is now after the call. */
+         continue;
+
+      default:
+         error_printf( "%u: invalid opcode: %d", exec->uid, op->op );
+         retval = MERROR_EXEC;
+         goto cleanup;
+      }
+
+      exec->bc_pc++;
+   }
+
+   /* Ran out of instructions for this step. */
+   retval = MERROR_PREEMPT;
+
+cleanup:
+
+   _mlisp_bc_env_unlock( parser, exec, autolock );
+
+   if( mdata_vector_is_locked( &(exec->per_node_visit_ct) ) ) {
+      mdata_vector_unlock( &(exec->per_node_visit_ct) );
+   }
+   if( mdata_vector_is_locked( &(exec->per_node_child_idx) ) ) {
+      mdata_vector_unlock( &(exec->per_node_child_idx) );
+   }
+   if( mdata_vector_is_locked( &(exec->per_node_resolve) ) ) {
+      mdata_vector_unlock( &(exec->per_node_resolve) );
+   }
+   if( mdata_vector_is_locked( &(parser->ast) ) ) {
+      mdata_vector_unlock( &(parser->ast) );
+   }
+   if( mdata_vector_is_locked( &(parser->bc_lambda_pc) ) ) {
+      mdata_vector_unlock( &(parser->bc_lambda_pc) );
+   }
+   if( mdata_vector_is_locked( &(parser->bytecode) ) ) {
+      mdata_vector_unlock( &(parser->bytecode) );
+   }
+
+   return retval;
+}
+
+/* === */
+
 static MERROR_RETVAL _mlisp_count_builtins_iter(
    const struct MDATA_TABLE_KEY* key, void* data, size_t data_sz,
    void* cb_data, size_t cb_data_sz, size_t idx
@@ -2208,6 +2911,83 @@ cleanup:
 
 /* === */
 
+MERROR_RETVAL mlisp_exec_resolve(
+   struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   uint8_t autolock[MLISP_EXEC_ENV_FRAME_CT_MAX];
+   struct MLISP_AST_NODE* n = NULL;
+   struct MLISP_RESOLVE_NODE* r = NULL;
+   char* strpool_token = NULL;
+   size_t i = 0;
+
+   maug_mzero( autolock, MLISP_EXEC_ENV_FRAME_CT_MAX );
+
+   retval = mlisp_check_state( parser, exec );
+   maug_cleanup_if_not_ok();
+
+   assert( !mdata_vector_is_locked( &(exec->per_node_resolve) ) );
+
+   mdata_vector_free( &(exec->per_node_resolve) );
+   mdata_vector_fill( &(exec->per_node_resolve),
+      mdata_vector_ct( &(parser->ast) ), sizeof( struct MLISP_RESOLVE_NODE ) );
+
+   retval = _mlisp_autolock( parser, exec, MLISP_AUTOLOCK_PARSER_AST, autolock );
+   maug_cleanup_if_not_ok();
+
+   mdata_vector_lock( &(exec->per_node_resolve) );
+   mdata_strpool_lock( &(parser->strpool) );
+
+   /* Tokens that are always literals can be parsed once, here. Symbols are
+    * found and cached on their first evaluation, since they may not be
+    * defined yet.
+    */
+   for( i = 0 ; mdata_vector_ct( &(parser->ast) ) > i ; i++ ) {
+      n = mdata_vector_get( &(parser->ast), i, struct MLISP_AST_NODE );
+      r = mdata_vector_get(
+         &(exec->per_node_resolve), i, struct MLISP_RESOLVE_NODE );
+      assert( NULL != n );
+      assert( NULL != r );
+
+      strpool_token = mdata_strpool_get( &(parser->strpool), n->token_idx );
+      if( NULL == strpool_token ) {
+         continue;
+      }
+
+      if( 0 == maug_strncmp( strpool_token, "begin", n->token_sz + 1 ) ) {
+         r->literal.type = MLISP_TYPE_BEGIN;
+         r->flags |= MLISP_RESOLVE_FLAG_LITERAL;
+
+      } else if( maug_is_num( strpool_token, n->token_sz, 10, 1 ) ) {
+         r->literal.value.integer =
+            maug_atos32( strpool_token, n->token_sz );
+         r->literal.type = MLISP_TYPE_INT;
+         r->flags |= MLISP_RESOLVE_FLAG_LITERAL;
+
+      } else if( maug_is_float( strpool_token, n->token_sz ) ) {
+         r->literal.value.floating = maug_atof( strpool_token, n->token_sz );
+         r->literal.type = MLISP_TYPE_FLOAT;
+         r->flags |= MLISP_RESOLVE_FLAG_LITERAL;
+      }
+   }
+
+cleanup:
+
+   if( mdata_strpool_is_locked( &(parser->strpool) ) ) {
+      mdata_strpool_unlock( &(parser->strpool) );
+   }
+
+   if( mdata_vector_is_locked( &(exec->per_node_resolve) ) ) {
+      mdata_vector_unlock( &(exec->per_node_resolve) );
+   }
+
+   _mlisp_autounlock( parser, exec, autolock );
+
+   return retval;
+}
+
+/* === */
+
 MERROR_RETVAL mlisp_step(
    struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec
 ) {
@@ -2225,14 +3005,41 @@ MERROR_RETVAL mlisp_step(
    debug_printf( MLISP_STEP_TRACE_LVL, "%u: heartbeat start", exec->uid );
 #endif /* MLISP_STEP_TRACE_LVL */
 
+   if(
+      mdata_vector_ct( &(exec->per_node_resolve) ) !=
+      mdata_vector_ct( &(parser->ast) )
+   ) {
+      /* Resolve literals before the first step. This is done here rather than
+       * in mlisp_exec_init() in case the AST was not finished then.
+       */
+      retval = mlisp_exec_resolve( parser, exec );
+      maug_cleanup_if_not_ok();
+   }
+
+   if( MLISP_EXEC_FLAG_BYTECODE == (MLISP_EXEC_FLAG_BYTECODE & exec->flags) ) {
+      retval = _mlisp_bc_prepare( parser, exec );
+      maug_cleanup_if_not_ok();
+      retval = _mlisp_bc_run( parser, exec );
+      if( MERROR_PREEMPT == retval ) {
+         /* There's still more to execute. */
+         retval = MERROR_OK;
+      } else if( MERROR_OK == retval ) {
+         /* Signal the caller: we're out of instructions! */
+         retval = MERROR_EXEC;
+      }
+      goto cleanup;
+   }
+
    /* These can remain locked for the whole step, as they're never added or
     * removed.
     */
    assert( !mdata_vector_is_locked( &(exec->per_node_child_idx) ) );
    assert( !mdata_vector_is_locked( &(exec->per_node_visit_ct) ) );
+   assert( !mdata_vector_is_locked( &(exec->per_node_resolve) ) );
    assert( !mdata_vector_is_locked( &(parser->ast) ) );
    mdata_vector_lock( &(exec->per_node_child_idx) );
    mdata_vector_lock( &(exec->per_node_visit_ct) );
+   mdata_vector_lock( &(exec->per_node_resolve) );
    mdata_vector_lock( &(parser->ast) );
 
    /* Disable transient flags. */
@@ -2284,10 +3091,79 @@ cleanup:
       "%u: heartbeat end: %x", exec->uid, retval );
 #endif /* MLISP_STEP_TRACE_LVL */
 
-   assert( mdata_vector_is_locked( &(parser->ast) ) );
-   mdata_vector_unlock( &(parser->ast) );
-   mdata_vector_unlock( &(exec->per_node_visit_ct) );
-   mdata_vector_unlock( &(exec->per_node_child_idx) );
+   if( mdata_vector_is_locked( &(parser->ast) ) ) {
+      mdata_vector_unlock( &(parser->ast) );
+   }
+   if( mdata_vector_is_locked( &(exec->per_node_resolve) ) ) {
+      mdata_vector_unlock( &(exec->per_node_resolve) );
+   }
+   if( mdata_vector_is_locked( &(exec->per_node_visit_ct) ) ) {
+      mdata_vector_unlock( &(exec->per_node_visit_ct) );
+   }
+   if( mdata_vector_is_locked( &(exec->per_node_child_idx) ) ) {
+      mdata_vector_unlock( &(exec->per_node_child_idx) );
+   }
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL _mlisp_bc_step_lambda(
+   struct MLISP_PARSER* parser, struct MLISP_EXEC_STATE* exec,
+   const char* lambda
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_ENV_NODE* e = NULL;
+   mlisp_lambda_t lambda_idx = 0;
+   uint8_t autolock[MLISP_EXEC_ENV_FRAME_CT_MAX];
+
+   maug_mzero( autolock, MLISP_EXEC_ENV_FRAME_CT_MAX );
+
+   retval = _mlisp_bc_prepare( parser, exec );
+   maug_cleanup_if_not_ok();
+
+   if( 0 == mdata_vector_ct( &(exec->bc_calls) ) ) {
+      /* Not in the middle of a lambda yet, so find the one to start. */
+      _mlisp_bc_env_lock( exec, autolock );
+      e = mlisp_env_get( exec, lambda );
+      if( NULL == e || MLISP_TYPE_LAMBDA != e->type ) {
+         error_printf( "lambda \"%s\" not found!", lambda );
+         retval = MERROR_OVERFLOW;
+         goto cleanup;
+      }
+      lambda_idx = e->value.lambda;
+      e = NULL;
+      _mlisp_bc_env_unlock( parser, exec, autolock );
+
+#if MLISP_STEP_TRACE_LVL > 0
+      debug_printf( MLISP_STEP_TRACE_LVL,
+         "%u: lambda \"%s\" is AST node idx " SSIZE_T_FMT,
+         exec->uid, lambda, lambda_idx );
+#endif /* MLISP_STEP_TRACE_LVL */
+
+      /* Stop when this call returns, and then resume where we were. */
+      mdata_vector_lock( &(parser->ast) );
+      mdata_vector_lock( &(parser->bc_lambda_pc) );
+      retval = _mlisp_bc_call( parser, exec, lambda_idx, exec->bc_pc,
+         MLISP_BC_CALL_FLAG_HALT, 0 );
+      mdata_vector_unlock( &(parser->bc_lambda_pc) );
+      mdata_vector_unlock( &(parser->ast) );
+      maug_cleanup_if_not_ok();
+   }
+
+   retval = _mlisp_bc_run( parser, exec );
+
+cleanup:
+
+   _mlisp_bc_env_unlock( parser, exec, autolock );
+
+   if( mdata_vector_is_locked( &(parser->bc_lambda_pc) ) ) {
+      mdata_vector_unlock( &(parser->bc_lambda_pc) );
+   }
+   if( mdata_vector_is_locked( &(parser->ast) ) ) {
+      mdata_vector_unlock( &(parser->ast) );
+   }
 
    return retval;
 }
@@ -2305,12 +3181,19 @@ MERROR_RETVAL mlisp_step_lambda(
    struct MLISP_AST_NODE* n = NULL;
    int8_t env_iter = 0;
 
+   maug_mzero( autolock, MLISP_EXEC_ENV_FRAME_CT_MAX );
+
    if( MERROR_OK != mlisp_check_state( parser, exec ) ) {
       error_printf( "mlisp not ready!" );
       retval = MERROR_EXEC;
       goto cleanup;
    }
 
+   if( MLISP_EXEC_FLAG_BYTECODE == (MLISP_EXEC_FLAG_BYTECODE & exec->flags) ) {
+      retval = _mlisp_bc_step_lambda( parser, exec, lambda );
+      goto cleanup;
+   }
+
    retval = _mlisp_autolock( parser, exec, 0xff, autolock );
    maug_cleanup_if_not_ok();
 
@@ -2573,6 +3456,9 @@ void mlisp_exec_free( struct MLISP_EXEC_STATE* exec ) {
 #endif /* MLISP_EXEC_TRACE_LVL */
    mdata_vector_free( &(exec->per_node_child_idx) );
    mdata_vector_free( &(exec->per_node_visit_ct) );
+   mdata_vector_free( &(exec->per_node_resolve) );
+   mdata_vector_free( &(exec->bc_calls) );
+   mdata_vector_free( &(exec->bc_cb_args) );
    mdata_vector_free( &(exec->stack) );
    for( env_iter = exec->env_select ; 0 <= env_iter ; env_iter-- ) {
       mdata_table_free( &(exec->env[env_iter]) );
@@ -100,6 +100,18 @@ MERROR_RETVAL mlisp_parse_file(
 
 MERROR_RETVAL mlisp_parser_init( struct MLISP_PARSER* parser );
 
+/**
+ * \brief Compile the AST into MLISP_PARSER::bytecode, for use by execs with
+ *        ::MLISP_EXEC_FLAG_BYTECODE.
+ *
+ * The main program is compiled from the root node and ends in ::MLISP_OP_END.
+ * Lambda bodies are compiled after it, each ending in ::MLISP_OP_RET.
+ *
+ * This is called automatically by mlisp_step() if needed, but it may be
+ * called once up front for a parser shared by many execs.
+ */
+MERROR_RETVAL mlisp_parser_compile( struct MLISP_PARSER* parser );
+
 void mlisp_parser_free( struct MLISP_PARSER* parser );
 
 /*! \} */ /* mlisp */
@@ -238,7 +250,10 @@ static MERROR_RETVAL _mlisp_ast_set_child_token(
          strpool_token, token_sz );
       n->flags |= MLISP_AST_FLAG_BEGIN;
 
-   } else if( 0 == maug_strncmp( strpool_token, "define", 7 ) ) {
+   } else if(
+      0 == maug_strncmp( strpool_token, "define", 7 ) ||
+      0 == maug_strncmp( strpool_token, "gdefine", 8 )
+   ) {
       /* Special node: define. */
       debug_printf( MLISP_PARSE_TRACE_LVL,
          "setting node \"%s\" (" SIZE_T_FMT ") flag: DEFINE",
@@ -618,6 +633,291 @@ cleanup:
 
 /* === */
 
+#define _mlisp_compile_emit_test( op, type, n_idx, arg, value ) \
+   emit_retval = _mlisp_compile_emit( parser, op, type, n_idx, arg, value ); \
+   if( 0 > emit_retval ) { \
+      retval = mdata_retval( emit_retval ); \
+      goto cleanup; \
+   }
+
+static ssize_t _mlisp_compile_emit(
+   struct MLISP_PARSER* parser, uint8_t op, uint8_t type, size_t n_idx,
+   size_t arg, const union MLISP_VAL* value
+) {
+   struct MLISP_BC_OP bc_op;
+
+   maug_mzero( &bc_op, sizeof( struct MLISP_BC_OP ) );
+   bc_op.op = op;
+   bc_op.type = type;
+   bc_op.n_idx = n_idx;
+   bc_op.arg = arg;
+   if( NULL != value ) {
+      memcpy( &(bc_op.value), value, sizeof( union MLISP_VAL ) );
+   }
+
+   return mdata_vector_append(
+      &(parser->bytecode), &bc_op, sizeof( struct MLISP_BC_OP ) );
+}
+
+/* === */
+
+/**
+ * \brief Point the jump instruction at pc to the next instruction emitted.
+ */
+static MERROR_RETVAL _mlisp_compile_patch(
+   struct MLISP_PARSER* parser, ssize_t pc
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_BC_OP* bc_op = NULL;
+
+   mdata_vector_lock( &(parser->bytecode) );
+   bc_op = mdata_vector_get( &(parser->bytecode), pc, struct MLISP_BC_OP );
+   assert( NULL != bc_op );
+   bc_op->arg = mdata_vector_ct( &(parser->bytecode) );
+
+cleanup:
+
+   if( mdata_vector_is_locked( &(parser->bytecode) ) ) {
+      mdata_vector_unlock( &(parser->bytecode) );
+   }
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL _mlisp_compile_node(
+   struct MLISP_PARSER* parser, size_t n_idx );
+
+static MERROR_RETVAL _mlisp_compile_children(
+   struct MLISP_PARSER* parser, size_t n_idx, size_t first
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_AST_NODE* n = NULL;
+   size_t i = 0;
+
+   /* The AST is locked through compilation, so this pointer stays good. */
+   n = mdata_vector_get( &(parser->ast), n_idx, struct MLISP_AST_NODE );
+   assert( NULL != n );
+
+   for( i = first ; n->ast_idx_children_sz > i ; i++ ) {
+      retval = _mlisp_compile_node( parser, n->ast_idx_children[i] );
+      maug_cleanup_if_not_ok();
+   }
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL _mlisp_compile_node(
+   struct MLISP_PARSER* parser, size_t n_idx
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_AST_NODE* n = NULL;
+   struct MLISP_AST_NODE* n_term = NULL;
+   ssize_t emit_retval = 0;
+   ssize_t pc_jf = 0;
+   ssize_t pc_jmp = 0;
+   char* strpool_token = NULL;
+   union MLISP_VAL value;
+
+   maug_mzero( &value, sizeof( union MLISP_VAL ) );
+
+   n = mdata_vector_get( &(parser->ast), n_idx, struct MLISP_AST_NODE );
+   assert( NULL != n );
+
+   if( MLISP_AST_FLAG_LAMBDA == (MLISP_AST_FLAG_LAMBDA & n->flags) ) {
+      /* Lambdas are lazily evaluated, so just push a reference. The body is
+       * compiled separately by mlisp_parser_compile().
+       */
+      value.lambda = n_idx;
+      _mlisp_compile_emit_test(
+         MLISP_OP_PUSH, MLISP_TYPE_LAMBDA, n_idx, 0, &value );
+
+   } else if( MLISP_AST_FLAG_IF == (MLISP_AST_FLAG_IF & n->flags) ) {
+      if( 2 > n->ast_idx_children_sz ) {
+         error_printf( "(if) node " SIZE_T_FMT " has too few children!",
+            n_idx );
+         retval = MERROR_PARSE;
+         goto cleanup;
+      }
+
+      /* Condition. */
+      retval = _mlisp_compile_node( parser, n->ast_idx_children[0] );
+      maug_cleanup_if_not_ok();
+      _mlisp_compile_emit_test( MLISP_OP_JMP_FALSE, 0, n_idx, 0, NULL );
+      pc_jf = emit_retval;
+
+      /* TRUE clause. */
+      retval = _mlisp_compile_node( parser, n->ast_idx_children[1] );
+      maug_cleanup_if_not_ok();
+
+      if( 2 < n->ast_idx_children_sz ) {
+         /* FALSE clause. */
+         _mlisp_compile_emit_test( MLISP_OP_JMP, 0, n_idx, 0, NULL );
+         pc_jmp = emit_retval;
+         retval = _mlisp_compile_patch( parser, pc_jf );
+         maug_cleanup_if_not_ok();
+         retval = _mlisp_compile_node( parser, n->ast_idx_children[2] );
+         maug_cleanup_if_not_ok();
+         retval = _mlisp_compile_patch( parser, pc_jmp );
+      } else {
+         retval = _mlisp_compile_patch( parser, pc_jf );
+      }
+
+   } else if( MLISP_AST_FLAG_BEGIN == (MLISP_AST_FLAG_BEGIN & n->flags) ) {
+      /* Push a stack frame marker to rewind to once the children are done. */
+      value.begin = n_idx;
+      _mlisp_compile_emit_test(
+         MLISP_OP_PUSH, MLISP_TYPE_BEGIN, n_idx, 0, &value );
+      retval = _mlisp_compile_children( parser, n_idx, 0 );
+      maug_cleanup_if_not_ok();
+      _mlisp_compile_emit_test( MLISP_OP_BEGIN_END, 0, n_idx, 0, NULL );
+
+   } else {
+      if(
+         MLISP_AST_FLAG_DEFINE == (MLISP_AST_FLAG_DEFINE & n->flags) &&
+         0 < n->ast_idx_children_sz
+      ) {
+         /* The first child is a term to be defined, so push it as a literal
+          * string rather than evaluating it.
+          */
+         retval = _mlisp_compile_children( parser, n->ast_idx_children[0], 0 );
+         maug_cleanup_if_not_ok();
+         n_term = mdata_vector_get(
+            &(parser->ast), n->ast_idx_children[0], struct MLISP_AST_NODE );
+         assert( NULL != n_term );
+         value.strpool_idx = n_term->token_idx;
+         _mlisp_compile_emit_test(
+            MLISP_OP_PUSH, MLISP_TYPE_STR, n->ast_idx_children[0], 0, &value );
+         value.strpool_idx = 0;
+
+         retval = _mlisp_compile_children( parser, n_idx, 1 );
+         maug_cleanup_if_not_ok();
+      } else {
+         retval = _mlisp_compile_children( parser, n_idx, 0 );
+         maug_cleanup_if_not_ok();
+      }
+
+      /* Numeric literals never change, so push them directly. Anything else
+       * has to be looked up in the env at runtime.
+       */
+      strpool_token = mdata_strpool_get( &(parser->strpool), n->token_idx );
+      if( NULL == strpool_token ) {
+         /* Nothing to evaluate (e.g. a list of lambda args). */
+
+      } else if( maug_is_num( strpool_token, n->token_sz, 10, 1 ) ) {
+         value.integer = maug_atos32( strpool_token, n->token_sz );
+         _mlisp_compile_emit_test(
+            MLISP_OP_PUSH, MLISP_TYPE_INT, n_idx, 0, &value );
+
+      } else if( maug_is_float( strpool_token, n->token_sz ) ) {
+         value.floating = maug_atof( strpool_token, n->token_sz );
+         _mlisp_compile_emit_test(
+            MLISP_OP_PUSH, MLISP_TYPE_FLOAT, n_idx, 0, &value );
+
+      } else {
+         _mlisp_compile_emit_test(
+            MLISP_OP_EVAL, 0, n_idx, n->ast_idx_children_sz, NULL );
+      }
+   }
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL mlisp_parser_compile( struct MLISP_PARSER* parser ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_AST_NODE* n = NULL;
+   size_t* p_lambda_pc = NULL;
+   ssize_t emit_retval = 0;
+   size_t i = 0;
+
+   if( !mlisp_check_ast( parser ) ) {
+      error_printf( "no valid AST present; could not compile!" );
+      retval = MERROR_EXEC;
+      goto cleanup;
+   }
+
+   mdata_vector_free( &(parser->bytecode) );
+   mdata_vector_free( &(parser->bc_lambda_pc) );
+
+   mdata_vector_fill( &(parser->bc_lambda_pc),
+      mdata_vector_ct( &(parser->ast) ), sizeof( size_t ) );
+
+   /* The strpool and AST aren't modified below, so they can stay locked. */
+   assert( !mdata_vector_is_locked( &(parser->ast) ) );
+   mdata_vector_lock( &(parser->ast) );
+   mdata_strpool_lock( &(parser->strpool) );
+
+   /* The main program starts at the root. */
+   retval = _mlisp_compile_node( parser, 0 );
+   maug_cleanup_if_not_ok();
+   _mlisp_compile_emit_test( MLISP_OP_END, 0, 0, 0, NULL );
+
+   /* Compile lambda bodies after the main program. */
+   for( i = 0 ; mdata_vector_ct( &(parser->ast) ) > i ; i++ ) {
+      n = mdata_vector_get( &(parser->ast), i, struct MLISP_AST_NODE );
+      if( MLISP_AST_FLAG_LAMBDA != (MLISP_AST_FLAG_LAMBDA & n->flags) ) {
+         continue;
+      }
+
+      /* There needs to be an arg node and an exec node. */
+      if( 1 >= n->ast_idx_children_sz ) {
+         error_printf( "invalid lambda node " SIZE_T_FMT ": too few children!",
+            i );
+         retval = MERROR_PARSE;
+         goto cleanup;
+      }
+
+      mdata_vector_lock( &(parser->bc_lambda_pc) );
+      p_lambda_pc = mdata_vector_get( &(parser->bc_lambda_pc), i, size_t );
+      assert( NULL != p_lambda_pc );
+      *p_lambda_pc = mdata_vector_ct( &(parser->bytecode) );
+      mdata_vector_unlock( &(parser->bc_lambda_pc) );
+
+      /* Skip the args node; the interpreter pops args when calling. */
+      retval = _mlisp_compile_children( parser, i, 1 );
+      maug_cleanup_if_not_ok();
+      _mlisp_compile_emit_test( MLISP_OP_RET, 0, i, 0, NULL );
+   }
+
+#if MLISP_PARSE_TRACE_LVL > 0
+   debug_printf( MLISP_PARSE_TRACE_LVL,
+      "compiled " SIZE_T_FMT " AST nodes to " SIZE_T_FMT " instructions",
+      mdata_vector_ct( &(parser->ast) ),
+      mdata_vector_ct( &(parser->bytecode) ) );
+#endif /* MLISP_PARSE_TRACE_LVL */
+
+cleanup:
+
+   if( mdata_strpool_is_locked( &(parser->strpool) ) ) {
+      mdata_strpool_unlock( &(parser->strpool) );
+   }
+
+   if( mdata_vector_is_locked( &(parser->bc_lambda_pc) ) ) {
+      mdata_vector_unlock( &(parser->bc_lambda_pc) );
+   }
+
+   if( mdata_vector_is_locked( &(parser->ast) ) ) {
+      mdata_vector_unlock( &(parser->ast) );
+   }
+
+   if( MERROR_OK != retval ) {
+      mdata_vector_free( &(parser->bytecode) );
+   }
+
+   return retval;
+}
+
+/* === */
+
 MERROR_RETVAL mlisp_parser_init( struct MLISP_PARSER* parser ) {
    MERROR_RETVAL retval = MERROR_OK;
    ssize_t append_retval = 0;
@@ -661,6 +961,8 @@ void mlisp_parser_free( struct MLISP_PARSER* parser ) {
          mdata_vector_ct( &(parser->ast) ) );
    mdata_strpool_free( &(parser->strpool) );
    mdata_vector_free( &(parser->ast) );
+   mdata_vector_free( &(parser->bytecode) );
+   mdata_vector_free( &(parser->bc_lambda_pc) );
    debug_printf( MLISP_PARSE_TRACE_LVL, "parser destroyed!" );
 }
 
@@ -42,6 +42,14 @@
 
 #define MLISP_EXEC_FLAG_INITIALIZED   0x08
 
+/**
+ * \relates MLISP_EXEC_STATE
+ * \brief Flag for MLISP_EXEC_STATE::flags indicating mlisp_step() and
+ *        mlisp_step_lambda() should run MLISP_PARSER::bytecode rather than
+ *        walking the AST.
+ */
+#define MLISP_EXEC_FLAG_BYTECODE   0x04
+
 /**
  * \addtogroup mlisp_types MLISP Types
  * \{
@@ -115,6 +123,111 @@ struct MLISP_STACK_NODE {
    union MLISP_VAL value;
 };
 
+/**
+ * \brief Flag for MLISP_RESOLVE_NODE::flags indicating the node's token is a
+ *        literal whose value is stored in MLISP_RESOLVE_NODE::literal.
+ */
+#define MLISP_RESOLVE_FLAG_LITERAL  0x01
+
+/**
+ * \brief Flag for MLISP_RESOLVE_NODE::flags indicating the node's token was
+ *        found in the env at MLISP_RESOLVE_NODE::env_idx.
+ */
+#define MLISP_RESOLVE_FLAG_SYMBOL   0x02
+
+/**
+ * \brief Flag for MLISP_RESOLVE_NODE::flags indicating the symbol was found in
+ *        MLISP_EXEC_STATE::global_env rather than a local frame.
+ */
+#define MLISP_RESOLVE_FLAG_GLOBAL   0x04
+
+/**
+ * \brief Cached result of evaluating the token of an MLISP_AST_NODE, so it
+ *        does not have to be looked up by string on every visit.
+ */
+struct MLISP_RESOLVE_NODE {
+   uint8_t flags;
+   /*! \brief Frame of MLISP_EXEC_STATE::env the symbol was found in. */
+   int8_t env_frame;
+   /*! \brief Position of the symbol in its env table. */
+   size_t env_idx;
+   /*! \brief MLISP_EXEC_STATE::env_gen when the symbol was found. */
+   size_t env_gen;
+   /**
+    * \brief Hash and size of the symbol, used to make sure a global env
+    *        shared with other execs has not moved it.
+    */
+   uint32_t key_hash;
+   size_t key_sz;
+   struct MLISP_ENV_NODE literal;
+};
+
+/**
+ * \addtogroup mlisp_bytecode MLISP Bytecode
+ * \{
+ */
+
+/*! \brief Stop execution. Only found at the end of the main program. */
+#define MLISP_OP_END          0
+
+/**
+ * \brief Push MLISP_BC_OP::value of MLISP_BC_OP::type to the stack. This is
+ *        used for numeric literals, define terms, lambdas, and begin markers.
+ */
+#define MLISP_OP_PUSH         1
+
+/**
+ * \brief Look up the token of the MLISP_BC_OP::n_idx node in the env and
+ *        push it, or call it with MLISP_BC_OP::arg args if it is callable.
+ */
+#define MLISP_OP_EVAL         2
+
+/**
+ * \brief Rewind the stack to the begin marker for MLISP_BC_OP::n_idx and
+ *        push a new one.
+ */
+#define MLISP_OP_BEGIN_END    3
+
+/*! \brief Jump to MLISP_BC_OP::arg. */
+#define MLISP_OP_JMP          4
+
+/*! \brief Pop a boolean and jump to MLISP_BC_OP::arg if it is false. */
+#define MLISP_OP_JMP_FALSE    5
+
+/*! \brief Leave the current lambda and return to its caller. */
+#define MLISP_OP_RET          6
+
+/**
+ * \brief Flag for MLISP_BC_CALL::flags indicating execution should stop when
+ *        this call returns, because it was started by mlisp_step_lambda().
+ */
+#define MLISP_BC_CALL_FLAG_HALT  0x01
+
+/**
+ * \brief A single instruction in MLISP_PARSER::bytecode.
+ */
+struct MLISP_BC_OP {
+   uint8_t op;
+   /*! \brief MLISP_TYPE_* of MLISP_BC_OP::value for ::MLISP_OP_PUSH. */
+   uint8_t type;
+   /*! \brief Index of the MLISP_AST_NODE this instruction was compiled from. */
+   size_t n_idx;
+   /*! \brief Jump target, or number of args for ::MLISP_OP_EVAL. */
+   size_t arg;
+   union MLISP_VAL value;
+};
+
+/**
+ * \brief Entry in MLISP_EXEC_STATE::bc_calls for a lambda being executed.
+ */
+struct MLISP_BC_CALL {
+   /*! \brief Instruction to resume at once the lambda returns. */
+   size_t pc_ret;
+   uint8_t flags;
+};
+
+/*! \} */ /* mlisp_bytecode */
+
 struct MLISP_AST_NODE {
    uint8_t flags;
    mdata_strpool_idx_t token_idx;
@@ -176,6 +289,30 @@ struct MLISP_EXEC_STATE {
    int8_t env_select;
    /*! \brief Dummy field; do not serialize fields after this! */
    int8_t no_serial;
+   /**
+    * \brief Cached token resolution for each node; see mlisp_exec_resolve().
+    */
+   /* vector_type struct MLISP_RESOLVE_NODE */
+   struct MDATA_VECTOR per_node_resolve;
+   /**
+    * \brief Incremented whenever a local env frame changes shape, to
+    *        invalidate symbols cached in MLISP_EXEC_STATE::per_node_resolve.
+    */
+   size_t env_gen;
+   /*! \brief Next instruction in MLISP_PARSER::bytecode to execute. */
+   size_t bc_pc;
+   /**
+    * \brief Lambdas entered by the bytecode interpreter that have not yet
+    *        returned.
+    */
+   /* vector_type struct MLISP_BC_CALL */
+   struct MDATA_VECTOR bc_calls;
+   /**
+    * \brief Args of the callback the bytecode interpreter is calling, to put
+    *        back on the stack if it preempts and has to be called again.
+    */
+   /* vector_type struct MLISP_STACK_NODE */
+   struct MDATA_VECTOR bc_cb_args;
    /**
     * \brief Path through any lambdas the execution has entered during *this*
     *        heartbeat cycle. Used to detect tail calls.
@@ -205,6 +342,18 @@ struct MLISP_PARSER {
     *        accompanying MLISP_EXEC_STATE::flags.
     */
    ssize_t ast_node_iter;
+   /**
+    * \brief The AST compiled by mlisp_parser_compile() for an exec with
+    *        ::MLISP_EXEC_FLAG_BYTECODE.
+    */
+   /* vector_type struct MLISP_BC_OP */
+   struct MDATA_VECTOR bytecode;
+   /**
+    * \brief First instruction in MLISP_PARSER::bytecode of the body of each
+    *        lambda, indexed by the AST index of the lambda.
+    */
+   /* vector_type size_t */
+   struct MDATA_VECTOR bc_lambda_pc;
 };
 
 /*! \} */ /* mlisp */
@@ -89,6 +89,61 @@ typedef MERROR_RETVAL (*mserialize_cb_t)(
 typedef MERROR_RETVAL (*mdeserialize_cb_t)(
    mfile_t* ser_out, void* p_ser_int, int array, ssize_t* p_ser_sz );
 
+/**
+ * \brief A sequence opened with mserialize_header() in an MSERIALIZE_WRITER,
+ *        whose size is filled in when mserialize_writer_flush() is called.
+ */
+struct MSERIALIZE_FIXUP {
+   /*! \brief Offset in MSERIALIZE_WRITER::buf where the size belongs. */
+   off_t pos;
+   /*! \brief MSERIALIZE_WRITER::fix_bytes when the header was written. */
+   size_t fix_bytes;
+   /*! \brief Size of the sequence, once mserialize_footer() is called. */
+   size_t sz;
+};
+
+/**
+ * \brief Serializes into a growable memory buffer and writes everything to
+ *        the destination at once with mserialize_writer_flush().
+ *
+ * Sequence sizes are kept on a stack of ::MSERIALIZE_FIXUP instead of being
+ * written by seeking back on every mserialize_footer(), so MSERIALIZE_WRITER::buf
+ * only ever grows at the end. Pass &(writer.buf) as ser_out to the mserialize_
+ * functions.
+ */
+struct MSERIALIZE_WRITER {
+   /**
+    * \brief Buffer serialized data without sizes is collected in.
+    *
+    * This must stay the first member: mserialize_header() and
+    * mserialize_footer() get the writer back from ser_out when
+    * ::MFILE_FLAG_SER_WRITER is set.
+    */
+   mfile_t buf;
+   /*! \brief ::MSERIALIZE_FIXUP for every sequence, in order of offset. */
+   struct MDATA_VECTOR fixups;
+   /*! \brief Indexes into MSERIALIZE_WRITER::fixups of open sequences. */
+   struct MDATA_VECTOR stack;
+   /*! \brief Total bytes taken by the sizes of closed sequences. */
+   size_t fix_bytes;
+};
+
+/**
+ * \brief Prepare an MSERIALIZE_WRITER to be serialized into.
+ * \param sz_init Initial size of the buffer, or 0 for the default.
+ */
+MERROR_RETVAL mserialize_writer_init(
+   struct MSERIALIZE_WRITER* writer, size_t sz_init );
+
+/**
+ * \brief Fill in the sizes of all sequences in an MSERIALIZE_WRITER and write
+ *        the result to ser_out with a single MFILE_CADDY::write_block call.
+ */
+MERROR_RETVAL mserialize_writer_flush(
+   struct MSERIALIZE_WRITER* writer, mfile_t* ser_out );
+
+void mserialize_writer_free( struct MSERIALIZE_WRITER* writer );
+
 MERROR_RETVAL mserialize_int(
    mfile_t* ser_out, const int32_t value, int array );
 
@@ -263,6 +318,34 @@ MERROR_RETVAL mdeserialize_struct_MDATA_TABLE_KEY(
 
 #ifdef MSERIAL_C
 
+MERROR_RETVAL mserialize_writer_init(
+   struct MSERIALIZE_WRITER* writer, size_t sz_init
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+
+   maug_mzero( writer, sizeof( struct MSERIALIZE_WRITER ) );
+
+   retval = mfile_alloc_buffer( sz_init, &(writer->buf) );
+   maug_cleanup_if_not_ok();
+
+   writer->buf.flags |= MFILE_FLAG_SER_WRITER;
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+void mserialize_writer_free( struct MSERIALIZE_WRITER* writer ) {
+   mfile_close( &(writer->buf) );
+   mdata_vector_free( &(writer->fixups) );
+   mdata_vector_free( &(writer->stack) );
+   writer->fix_bytes = 0;
+}
+
+/* === */
+
 MERROR_RETVAL mserialize_size_t(
    mfile_t* ser_out, const size_t* p_ser_int, int array 
 ) {
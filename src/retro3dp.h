@@ -686,7 +686,9 @@ MERROR_RETVAL retro3dp_parse_obj_file(
    maug_path filename_path;
    MERROR_RETVAL retval = MERROR_OK;
    mfile_t obj_file;
-   char c;
+   uint8_t chunk[MFILE_CHUNK_SZ];
+   size_t chunk_sz = 0;
+   size_t i = 0;
 
    if( NULL == parser ) {
       parser = calloc( 1, sizeof( struct RETRO3DP_PARSER ) );
@@ -706,12 +708,14 @@ MERROR_RETVAL retro3dp_parse_obj_file(
    retro3dp_parse_init( 
       parser, obj, (retro3dp_mtl_cb)retro3dp_parse_obj_file, obj );
 
-   /* Parse the obj, byte by byte. */
+   /* Parse the obj, byte by byte, a chunk at a time. */
    while( obj_file.has_bytes( &obj_file ) ) {
-      retval = obj_file.read_int( &obj_file, (uint8_t*)&c, 1, 0 );
-      maug_cleanup_if_not_ok();
-      retval = retro3dp_parse_obj_c( parser, c );
+      retval = mfile_read_chunk( &obj_file, chunk, MFILE_CHUNK_SZ, &chunk_sz );
       maug_cleanup_if_not_ok();
+      for( i = 0 ; chunk_sz > i ; i++ ) {
+         retval = retro3dp_parse_obj_c( parser, chunk[i] );
+         maug_cleanup_if_not_ok();
+      }
    }
 
    if( auto_parser ) {
@@ -145,6 +145,13 @@ struct RETROANI {
    uint16_t mspf;
    struct RETROANI_HOLE hole;
    RETROFLAT_COLOR colors[RETROANI_COLOR_CT_MAX];
+   /**
+    * \brief Pixels written by the last frame of this animation, to compare
+    *        what each type costs. Reset by retroani_frame() before drawing.
+    */
+   uint32_t cost_px;
+   /*! \brief Span and pixel calls made by the last frame of this animation. */
+   uint32_t cost_calls;
 };
 
 /*! \brief Callback to call on active animations for every frame. */
@@ -790,6 +797,8 @@ ssize_t retroani_create(
    ani_new.mspf = RETROANI_DEFAULT_MSPF;
    maug_mzero( ani_new.tile, RETROANI_TILE_SZ );
    maug_mzero( &(ani_new.hole), sizeof( struct RETROANI_HOLE ) );
+   ani_new.cost_px = 0;
+   ani_new.cost_calls = 0;
 
    if( RETROANI_TYPE_FIRE == type ) {
       ani_new.colors[0] = RETROFLAT_COLOR_RED;
@@ -815,28 +824,117 @@ ssize_t retroani_create(
 
 /* === */
 
+/**
+ * \brief A run of identically-colored pixels in one row of ::RETROANI::tile.
+ *
+ * retroani_tesselate() works these out once per frame, since every tile it
+ * draws is the same, and then repeats them across the animation's area.
+ */
+struct RETROANI_RUN {
+   /*! \brief Left edge of the run relative to the tile. */
+   int8_t x;
+   /*! \brief Width of the run in pixels. */
+   int8_t w;
+   RETROFLAT_COLOR color;
+   /*! \brief If nonzero, this run is a single snowflake with an outline. */
+   uint8_t outline;
+};
+
+/* === */
+
+static RETROFLAT_COLOR _retroani_tile_color( struct RETROANI* a, int8_t t ) {
+   if(
+      -1 == t &&
+      RETROANI_FLAG_CLEANUP == (RETROANI_FLAG_CLEANUP & a->flags)
+   ) {
+      return RETROFLAT_COLOR_BLACK;
+   } else if( 0 < t && RETROANI_TYPE_SNOW == a->type ) {
+      return a->colors[0];
+   } else if( 90 < t ) {
+      return a->colors[2];
+   } else if( 60 < t ) {
+      return a->colors[1];
+   } else if( 30 < t ) {
+      return a->colors[0];
+   }
+
+   return RETROFLAT_COLOR_NULL;
+}
+
+/* === */
+
+static void _retroani_span(
+   struct RETROANI* a, const RETROFLAT_COLOR color, int x, int y, int w
+) {
+   retroflat_blit_t* target = a->target;
+   int i = 0;
+
+#ifndef RETROFLAT_3D
+   if( NULL == target ) {
+      target = retroflat_screen_buffer();
+   }
+#endif /* !RETROFLAT_3D */
+
+   /* retroflat_2d_span() expects spans to already be clipped. */
+   if( 0 > y || retroflat_2d_bitmap_h( target ) <= y ) {
+      return;
+   }
+
+   if( 0 > x ) {
+      w += x;
+      x = 0;
+   }
+   if( x + w > retroflat_2d_bitmap_w( target ) ) {
+      w = retroflat_2d_bitmap_w( target ) - x;
+   }
+   if( 0 >= w ) {
+      return;
+   }
+
+   a->cost_px += w;
+   a->cost_calls++;
+
+   if( NULL != retroflat_2d_span ) {
+      retroflat_2d_span( target, color, x, y, w, 0 );
+   } else {
+      for( i = 0 ; w > i ; i++ ) {
+         retroflat_2d_px( target, color, x + i, y, 0 );
+      }
+   }
+}
+
+/* === */
+
 void retroani_tesselate( struct RETROANI* a, int16_t y_orig ) {
 #ifndef RETROANI_DISABLE
    int8_t
       /* Address of the current pixel rel to top-left corner of tile. */
       x = 0,
-      y = 0;
-   int16_t idx = 0;
+      y = 0,
+      t = 0;
+   RETROFLAT_COLOR color = RETROFLAT_COLOR_NULL;
+   struct RETROANI_RUN runs[RETROANI_TILE_SZ];
+   struct RETROANI_RUN* run = NULL;
+   /* Number of runs in each row of the tile, so empty rows can be skipped. */
+   uint8_t runs_ct[RETROFLAT_TILE_H];
+   size_t i = 0;
    retroflat_pxxy_t
       /* Address of the current tile's top-left corner rel to animation. */
       t_x = 0,
       t_y = 0,
-      /* Address of the current pixel rel to screen. */
+      /* Address of the current run rel to screen. */
       p_x = 0,
       p_y = 0,
+      p_r = 0,
       h_on = 0,
       h_l = 0,
       h_r = 0,
       h_t = 0,
-      h_b = 0;
-
-   /* Lock the target buffer for per-pixel manipulation. */
-   retroflat_px_lock( a->target );
+      h_b = 0,
+      /* Columns of the current row covered by the hole, if row_h_on. */
+      row_h_on = 0,
+      row_h_l = 0,
+      row_h_r = 0;
 
    /* Setup the animation "hole" if defined. */
    if( 0 < a->hole.w && 0 < a->hole.h ) {
@@ -847,56 +945,101 @@ void retroani_tesselate( struct RETROANI* a, int16_t y_orig ) {
       h_b = a->hole.y + a->hole.h;
    }
 
-   /* Iterate over every tile covered by the animation's screen area. */
-   for( t_y = y_orig ; a->h > t_y ; t_y += RETROFLAT_TILE_H ) {
-      for( t_x = 0 ; a->w > t_x ; t_x += RETROFLAT_TILE_W ) {
-         /* Iterate over every pixel of the animation grid. */
-         for( y = 0 ; RETROFLAT_TILE_H > y ; y++ ) {
-            for( x = 0 ; RETROFLAT_TILE_W > x ; x++ ) {
-               idx = (y * RETROFLAT_TILE_W) + x;
+   /* Every tile is the same, so resolve the tile into runs of colors once. */
+   for( y = 0 ; RETROFLAT_TILE_H > y ; y++ ) {
+      run = &(runs[y * RETROFLAT_TILE_W]);
+      runs_ct[y] = 0;
+      for( x = 0 ; RETROFLAT_TILE_W > x ; x++ ) {
+         t = a->tile[(y * RETROFLAT_TILE_W) + x];
+         color = _retroani_tile_color( a, t );
+         if( RETROFLAT_COLOR_NULL == color ) {
+            continue;
+         }
 
-               /* TODO: Try to trim animation to its area. */
+#ifndef NO_SNOW_OUTLINE
+         if( 0 < t && RETROANI_TYPE_SNOW == a->type ) {
+            /* Snowflakes are outlined, so they can't be merged into runs. */
+            run[runs_ct[y]].x = x;
+            run[runs_ct[y]].w = 1;
+            run[runs_ct[y]].color = color;
+            run[runs_ct[y]].outline = 1;
+            runs_ct[y]++;
+            continue;
+         }
+#endif /* !NO_SNOW_OUTLINE */
 
-               p_x = a->x + t_x + x;
-               p_y = a->y + t_y + y;
+         if(
+            0 < runs_ct[y] &&
+            !run[runs_ct[y] - 1].outline &&
+            color == run[runs_ct[y] - 1].color &&
+            x == run[runs_ct[y] - 1].x + run[runs_ct[y] - 1].w
+         ) {
+            run[runs_ct[y] - 1].w++;
+         } else {
+            run[runs_ct[y]].x = x;
+            run[runs_ct[y]].w = 1;
+            run[runs_ct[y]].color = color;
+            run[runs_ct[y]].outline = 0;
+            runs_ct[y]++;
+         }
+      }
+   }
 
-               if( h_on && p_x > h_l && p_x < h_r && p_y > h_t && p_y < h_b ) {
-                  /* We're inside an active animation "hole". */
-                  debug_printf(
-                     RETROANI_TRACE_LVL,
-                     "%u 0x%02x: " PXXY_FMT ", " PXXY_FMT " is inside hole at "
-                     "L" PXXY_FMT ", R" PXXY_FMT ", T" PXXY_FMT ", B" PXXY_FMT,
-                     a->type, h_on, p_x, p_y, h_l, h_r, h_t, h_b );
+   /* Lock the target buffer for per-pixel manipulation. */
+   retroflat_px_lock( a->target );
 
-                  continue;
-               }
+   /* Draw the tile row by row across every tile covered by the animation. The
+    * tile is not trimmed to the animation's area.
+    */
+   for( t_y = y_orig ; a->h > t_y ; t_y += RETROFLAT_TILE_H ) {
+      for( y = 0 ; RETROFLAT_TILE_H > y ; y++ ) {
+         if( 0 == runs_ct[y] ) {
+            /* Nothing in this row of the tile would be drawn. */
+            continue;
+         }
 
-               if(
-                  -1 == a->tile[idx] &&
-                  RETROANI_FLAG_CLEANUP == (RETROANI_FLAG_CLEANUP & a->flags)
-               ) {
-                  retroflat_2d_px(
-                     a->target, RETROFLAT_COLOR_BLACK, p_x, p_y, 0 );
+         p_y = a->y + t_y + y;
+         run = &(runs[y * RETROFLAT_TILE_W]);
 
-               } else if( 0 < a->tile[idx] && RETROANI_TYPE_SNOW == a->type ) {
-                  retroflat_2d_px( a->target, a->colors[0], p_x, p_y, 0 );
-#ifndef NO_SNOW_OUTLINE
-                  retroflat_2d_px(
-                     a->target, RETROFLAT_COLOR_BLACK, p_x - 1, p_y, 0 );
-                  retroflat_2d_px(
-                     a->target, RETROFLAT_COLOR_BLACK, p_x + 1, p_y, 0 );
-                  retroflat_2d_px(
-                     a->target, RETROFLAT_COLOR_BLACK, p_x, p_y - 1, 0 );
-                  retroflat_2d_px(
-                     a->target, RETROFLAT_COLOR_BLACK, p_x, p_y + 1, 0 );
-#endif /* !NO_SNOW_OUTLINE */
+         /* Figure out the columns inside the hole once for the whole row. */
+         row_h_on = 0;
+         if( h_on && p_y > h_t && p_y < h_b ) {
+            row_h_on = 1;
+            row_h_l = h_l + 1;
+            row_h_r = h_r - 1;
+         }
 
-               } else if( 90 < a->tile[idx] ) {
-                  retroflat_2d_px( a->target, a->colors[2], p_x, p_y, 0 );
-               } else if( 60 < a->tile[idx] ) {
-                  retroflat_2d_px( a->target, a->colors[1], p_x, p_y, 0 );
-               } else if( 30 < a->tile[idx] ) {
-                  retroflat_2d_px( a->target, a->colors[0], p_x, p_y, 0 );
+         for( t_x = 0 ; a->w > t_x ; t_x += RETROFLAT_TILE_W ) {
+            for( i = 0 ; runs_ct[y] > i ; i++ ) {
+               p_x = a->x + t_x + run[i].x;
+               p_r = p_x + run[i].w - 1;
+
+               if( run[i].outline ) {
+                  if( row_h_on && p_x >= row_h_l && p_x <= row_h_r ) {
+                     /* We're inside an active animation "hole". */
+                     continue;
+                  }
+                  _retroani_span( a, run[i].color, p_x, p_y, 1 );
+                  _retroani_span( a, RETROFLAT_COLOR_BLACK, p_x - 1, p_y, 1 );
+                  _retroani_span( a, RETROFLAT_COLOR_BLACK, p_x + 1, p_y, 1 );
+                  _retroani_span( a, RETROFLAT_COLOR_BLACK, p_x, p_y - 1, 1 );
+                  _retroani_span( a, RETROFLAT_COLOR_BLACK, p_x, p_y + 1, 1 );
+
+               } else if( !row_h_on || p_r < row_h_l || p_x > row_h_r ) {
+                  _retroani_span( a, run[i].color, p_x, p_y, run[i].w );
+
+               } else {
+                  /* Only draw the parts of the run on either side of the
+                   * hole.
+                   */
+                  if( p_x < row_h_l ) {
+                     _retroani_span(
+                        a, run[i].color, p_x, p_y, row_h_l - p_x );
+                  }
+                  if( p_r > row_h_r ) {
+                     _retroani_span(
+                        a, run[i].color, row_h_r + 1, p_y, p_r - row_h_r );
+                  }
                }
             }
          }
@@ -914,6 +1057,7 @@ MERROR_RETVAL retroani_frame( struct MDATA_VECTOR* ani_stack, uint16_t flags ) {
 #ifndef RETROANI_DISABLE
    ssize_t i = 0; /* So i can be -1 if we delete the first ani. */
    uint32_t now_ms = 0;
+   MERROR_RETVAL ani_retval = MERROR_OK;
    struct RETROANI* ani = NULL;
 
    if( 0 == mdata_vector_ct( ani_stack ) ) {
@@ -938,7 +1082,15 @@ MERROR_RETVAL retroani_frame( struct MDATA_VECTOR* ani_stack, uint16_t flags ) {
          "drawing animatione: " SSIZE_T_FMT ", type: %d", i, ani->type );
 
       ani->next_frame_ms = now_ms + ani->mspf;
-      if( MERROR_EXEC == gc_animate_draw[ani->type]( ani ) ) {
+      ani->cost_px = 0;
+      ani->cost_calls = 0;
+      ani_retval = gc_animate_draw[ani->type]( ani );
+
+      debug_printf( RETROANI_TRACE_LVL,
+         "animation " SSIZE_T_FMT " type %d cost: " U32_FMT " px in " U32_FMT
+         " calls", i, ani->type, ani->cost_px, ani->cost_calls );
+
+      if( MERROR_EXEC == ani_retval ) {
          mdata_vector_unlock( ani_stack );
          mdata_vector_remove( ani_stack, i );
          mdata_vector_lock( ani_stack );
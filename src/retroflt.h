@@ -200,6 +200,7 @@ typedef int16_t retrotile_coord_t;
  * | RETROFLAT_API_LIBNDS  | Nintendo DS        | Yes (Limited)   |
  * | RETROFLAT_API_PC_BIOS | MS-DOS w/ PC BIOS  | No              |
  * | RETROFLAT_API_GLUT    | GLUT (OpenGL-Only) | Yes             |
+ * | RETROFLAT_API_SOFT    | Headless (Memory)  | No              |
  *
  * ## Option Definitions
  *
@@ -726,6 +727,29 @@ typedef MERROR_RETVAL (*retroflat_proc_quit_t)( void* data );
 
 #define retroflat_fps_next() (1000 / RETROFLAT_FPS)
 
+#ifdef DOCUMENTATION
+/**
+ * \brief If defined, retroflat_loop_generic() will call retroflat_sleep_ms()
+ *        to yield the CPU between frames instead of busy spinning, waking
+ *        for the next frame, heartbeat, or timer deadline, whichever is
+ *        soonest.
+ *
+ * This only takes effect on platforms that provide retroflat_sleep_ms(), and
+ * only while no loop_iter is running between frames (or the
+ * ::RETROFLAT_STATE_FLAG_WAIT_FOR_FPS flag is set).
+ */
+#  define RETROFLAT_LOOP_SLEEP
+#endif /* DOCUMENTATION */
+
+#ifndef RETROFLAT_LOOP_SLEEP_SLOP
+/**
+ * \brief Milliseconds to wake up ahead of a deadline when
+ *        ::RETROFLAT_LOOP_SLEEP is defined, to absorb scheduler oversleep.
+ *        The remainder is spun as before.
+ */
+#  define RETROFLAT_LOOP_SLEEP_SLOP 1
+#endif /* !RETROFLAT_LOOP_SLEEP_SLOP */
+
 #ifndef RETROFLAT_WINDOW_CLASS
 /**
  * \brief Unique window class to use on some platforms (e.g. Win32).
@@ -1023,6 +1047,27 @@ struct RETROFLAT_3DTEX {
 #  define retroflat_system_task()
 #endif /* !retroflat_system_task */
 
+#if !defined( retroflat_sleep_ms ) && defined( RETROFLAT_LOOP_SLEEP )
+/**
+ * \brief Platform-specific call to yield the CPU for the given number of
+ *        milliseconds. Used by retroflat_loop_generic() when
+ *        ::RETROFLAT_LOOP_SLEEP is defined. May be defined in retapid.h.
+ */
+#  if defined( RETROFLAT_OS_UNIX )
+#     include <time.h>
+#     define retroflat_sleep_ms( ms ) { \
+         struct timespec sleep_ts; \
+         sleep_ts.tv_sec = (ms) / 1000; \
+         sleep_ts.tv_nsec = ((long)((ms) % 1000)) * 1000000L; \
+         nanosleep( &sleep_ts, NULL ); \
+      }
+#  elif defined( RETROFLAT_OS_WIN )
+#     define retroflat_sleep_ms( ms ) Sleep( ms )
+#  else
+#     pragma message( "warning: no retroflat_sleep_ms() for loop sleep" )
+#  endif /* RETROFLAT_OS_UNIX || RETROFLAT_OS_WIN */
+#endif /* !retroflat_sleep_ms && RETROFLAT_LOOP_SLEEP */
+
 typedef void (*retroflat_timer_cb_t)( retroflat_ms_t time, void* data );
 
 #include "retrom2d.h"
@@ -1121,6 +1166,36 @@ struct RETROFLAT_ARGS {
 
 #include <retrovi2.h>
 
+/**
+ * \brief Frame pacing measurements kept in RETROFLAT_STATE::frame_stats.
+ *
+ * Jitter is how late a frame started relative to its scheduled tick, so
+ * jitter_total / frames is the mean lateness. A mean or max near
+ * retroflat_fps_next() means frames are missing their budget.
+ */
+struct RETROFLAT_FRAME_STATS {
+   /*! \brief Lateness of the most recent frame in milliseconds. */
+   retroflat_ms_t jitter_last;
+   /*! \brief Worst lateness seen since the stats were last reset. */
+   retroflat_ms_t jitter_max;
+   /*! \brief Sum of lateness across all counted frames. */
+   uint32_t jitter_total;
+   /*! \brief Number of frames counted. */
+   uint32_t frames;
+   /*! \brief Number of times the loop slept instead of spinning. */
+   uint32_t sleeps;
+   /*! \brief Total milliseconds requested from retroflat_sleep_ms(). */
+   uint32_t slept_ms;
+};
+
+/**
+ * \relates RETROFLAT_STATE
+ * \brief Zero the RETROFLAT_STATE::frame_stats counters.
+ */
+#define retroflat_frame_stats_reset() \
+   maug_mzero( &(g_retroflat_state->frame_stats), \
+      sizeof( struct RETROFLAT_FRAME_STATS ) )
+
 /**
  * \brief Global singleton containing state for the current platform.
  * 
@@ -1269,6 +1344,11 @@ defined( RETROVDP_C )
    void* timers_data[RETROFLAT_TIMER_CT_MAX];
    size_t timers_ct;
 
+   /**
+    * \brief Frame pacing statistics gathered by retroflat_loop_generic().
+    */
+   struct RETROFLAT_FRAME_STATS frame_stats;
+
 #  ifndef RETROFLAT_NO_SOUND
    struct RETROFLAT_SOUND_STATE sound;
 #  endif /* !RETROFLAT_NO_SOUND */
@@ -1433,6 +1513,22 @@ void retroflat_px(
    struct RETROFLAT_BITMAP* target, const RETROFLAT_COLOR color,
    retroflat_pxxy_t x, retroflat_pxxy_t y, uint8_t flags );
 
+#if defined( RETROFLAT_NATIVE_SPAN ) || defined( DOCUMENTATION )
+
+/**
+ * \brief Fill a horizontal run of pixels on the target ::RETROFLAT_BITMAP.
+ *
+ * This is only provided by platforms that define RETROFLAT_NATIVE_SPAN, and
+ * is normally called through retroflat_2d_span() by \ref maug_retrosft.
+ *
+ * \warning The span must already be clipped to the target!
+ */
+void retroflat_span(
+   struct RETROFLAT_BITMAP* target, const RETROFLAT_COLOR color,
+   retroflat_pxxy_t x, retroflat_pxxy_t y, retroflat_pxxy_t w, uint8_t flags );
+
+#endif /* RETROFLAT_NATIVE_SPAN || DOCUMENTATION */
+
 #ifdef RETROFLAT_SOFT_SHAPES
 #  ifdef RETROFLAT_OPENGL
 /* Make sure we're not passing NULL to openGL texture drawers... they can't
@@ -1776,6 +1872,43 @@ MERROR_RETVAL retroflat_build_filename_path(
 
 #ifndef RETROFLAT_NO_GENERIC_LOOP
 
+#  if defined( RETROFLAT_LOOP_SLEEP ) && defined( retroflat_sleep_ms )
+
+static void retroflat_loop_sleep( retroflat_ms_t next ) {
+   retroflat_ms_t now = 0,
+      wake = next;
+   size_t i = 0;
+
+   now = retroflat_get_ms();
+
+   /* Wake for whichever deadline comes first. */
+   if(
+      g_retroflat_state->heartbeat_next > now &&
+      g_retroflat_state->heartbeat_next < wake
+   ) {
+      wake = g_retroflat_state->heartbeat_next;
+   }
+   for( i = 0 ; g_retroflat_state->timers_ct > i ; i++ ) {
+      if( g_retroflat_state->timers_at[i] < wake ) {
+         wake = g_retroflat_state->timers_at[i];
+      }
+   }
+
+   if( wake <= now + RETROFLAT_LOOP_SLEEP_SLOP ) {
+      /* Too close to bother; just spin the remainder. */
+      return;
+   }
+
+   g_retroflat_state->frame_stats.sleeps++;
+   g_retroflat_state->frame_stats.slept_ms +=
+      (wake - now) - RETROFLAT_LOOP_SLEEP_SLOP;
+   retroflat_sleep_ms( (wake - now) - RETROFLAT_LOOP_SLEEP_SLOP );
+}
+
+#  endif /* RETROFLAT_LOOP_SLEEP && retroflat_sleep_ms */
+
+/* === */
+
 MERROR_RETVAL retroflat_loop_generic(
    retroflat_loop_iter frame_iter, retroflat_loop_iter loop_iter, void* data
 ) {
@@ -1812,15 +1945,50 @@ MERROR_RETVAL retroflat_loop_generic(
          /* Run the loop iter as many times as possible. */
          g_retroflat_state->loop_iter( g_retroflat_state->loop_data );
       }
+      now = retroflat_get_ms();
       if(
          RETROFLAT_STATE_FLAG_UNLOCK_FPS !=
          (RETROFLAT_STATE_FLAG_UNLOCK_FPS & g_retroflat_state->retroflat_flags) &&
-         retroflat_get_ms() < next
+         now < next
       ) {
+#  if defined( RETROFLAT_LOOP_SLEEP ) && defined( retroflat_sleep_ms )
+         if(
+            RETROFLAT_STATE_FLAG_WAIT_FOR_FPS ==
+            (RETROFLAT_STATE_FLAG_WAIT_FOR_FPS &
+               g_retroflat_state->retroflat_flags) ||
+            NULL == g_retroflat_state->loop_iter
+         ) {
+            /* Nothing to do between frames, so yield the CPU. */
+            retroflat_loop_sleep( next );
+
+            /* We may have woken for a heartbeat or timer deadline. */
+            retroflat_heartbeat_update();
+            retroflat_timer_handle();
+         }
+#  endif /* RETROFLAT_LOOP_SLEEP && retroflat_sleep_ms */
          /* Sleep/low power for a bit. */
          continue;
       }
 
+      if(
+         RETROFLAT_STATE_FLAG_UNLOCK_FPS !=
+         (RETROFLAT_STATE_FLAG_UNLOCK_FPS & g_retroflat_state->retroflat_flags) &&
+         0 < next
+      ) {
+         /* Measure how late this frame is starting. */
+         g_retroflat_state->frame_stats.jitter_last = now - next;
+         if(
+            g_retroflat_state->frame_stats.jitter_last >
+            g_retroflat_state->frame_stats.jitter_max
+         ) {
+            g_retroflat_state->frame_stats.jitter_max =
+               g_retroflat_state->frame_stats.jitter_last;
+         }
+         g_retroflat_state->frame_stats.jitter_total +=
+            g_retroflat_state->frame_stats.jitter_last;
+         g_retroflat_state->frame_stats.frames++;
+      }
+
       retroflat_heartbeat_update();
 
       retroflat_timer_handle();
@@ -2160,6 +2328,7 @@ MERROR_RETVAL retroflat_init(
     */
 #     if defined( RETROFLAT_BMP_TEX )
    retroflat_2d_px = (retroflat_px_cb)retro3d_texture_px;
+   retroflat_2d_span = (retroflat_span_cb)retrosoft_span;
    retroflat_2d_line = (retroflat_line_cb)retrosoft_line;
    retroflat_2d_rect = (retroflat_rect_cb)retrosoft_rect;
    retroflat_2d_ellipse = (retroflat_ellipse_cb)retrosoft_ellipse;
@@ -2170,6 +2339,11 @@ MERROR_RETVAL retroflat_init(
       (retroflat_create_bitmap_cb)retro3d_texture_create;
 #     else
    retroflat_2d_px = (retroflat_px_cb)retroflat_px;
+#        ifdef RETROFLAT_NATIVE_SPAN
+   retroflat_2d_span = (retroflat_span_cb)retroflat_span;
+#        elif defined( RETROSOFT_PRESENT )
+   retroflat_2d_span = (retroflat_span_cb)retrosoft_span;
+#        endif /* RETROFLAT_NATIVE_SPAN */
 #        ifdef RETROFLAT_SOFT_SHAPES
    /* TODO: Work retrosoft routines to use retroflat_blit_t */
    retroflat_2d_line = (retroflat_line_cb)retrosoft_line;
@@ -2280,6 +2454,13 @@ MERROR_RETVAL retroflat_init(
    maug_cleanup_if_not_ok();
 #     endif /* !RETROFLAT_NO_CLI_SZ */
 
+#     ifdef RETROFLAT_API_SOFT
+   retval = maug_add_arg( MAUG_CLI_SIGIL "rfd", MAUG_CLI_SIGIL_SZ + 4,
+      "Dump the screen to a bitmap every N frames.", 0,
+      (maug_cli_cb)retroflat_cli_rfd, args );
+   maug_cleanup_if_not_ok();
+#     endif /* RETROFLAT_API_SOFT */
+
 #     ifdef RETROFLAT_VDP
    retval = maug_add_arg( MAUG_CLI_SIGIL "vdp", MAUG_CLI_SIGIL_SZ + 4,
       "Pass a string of args to the VDP.", 0,
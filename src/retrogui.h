@@ -237,6 +237,22 @@
 #  define RETROGUI_DEBOUNCE_MAX_DEFAULT 100
 #endif /* !RETROGUI_DEBOUNCE_MAX_DEFAULT */
 
+#ifndef RETROGUI_DAMAGE_RECTS_MAX
+/**
+ * \brief Number of separate damaged regions a ::RETROGUI tracks between
+ *        redraws before they are merged into one.
+ */
+#  define RETROGUI_DAMAGE_RECTS_MAX 8
+#endif /* !RETROGUI_DAMAGE_RECTS_MAX */
+
+#ifndef RETROGUI_IDC_INDEX_SZ_MIN
+/**
+ * \brief Minimum number of slots in the IDC index of a ::RETROGUI. Must be a
+ *        power of 2.
+ */
+#  define RETROGUI_IDC_INDEX_SZ_MIN 32
+#endif /* !RETROGUI_IDC_INDEX_SZ_MIN */
+
 #ifndef RETROGUI_LABEL_SHOW_TICKS_MAX
 /**
  * \brief The number of ticks (frames) to count down before incrementing the
@@ -269,6 +285,23 @@
  */
 #define RETROGUI_FLAGS_FONT_OWNED 0x02
 
+/**
+ * \relates RETROGUI
+ * \brief RETROGUI::flags indicating only some controls should be redrawn.
+ *
+ * Unlike ::RETROGUI_FLAGS_DIRTY, only controls marked with
+ * ::RETROGUI_CTL_FLAG_DIRTY and anything overlapping them or the regions in
+ * RETROGUI::damage will be redrawn by retrogui_redraw_ctls().
+ */
+#define RETROGUI_FLAGS_DAMAGED 0x04
+
+/**
+ * \relates RETROGUI_CTL
+ * \brief Flag for RETROGUI_CTL_BASE::flags indicating the control should be
+ *        redrawn even if the rest of the ::RETROGUI is clean.
+ */
+#define RETROGUI_CTL_FLAG_DIRTY 0x01
+
 /**
  * \relates RETROGUI_CTL
  * \brief Flag for flags field in RETROGUI_CTL LABEL type indicating that the
@@ -414,6 +447,8 @@ typedef int16_t retrogui_idc_t;
 /*! \brief Fields common to ALL ::RETROGUI_CTL types. */
 struct RETROGUI_CTL_BASE {
    uint8_t type;
+   /*! \brief Flags like ::RETROGUI_CTL_FLAG_DIRTY common to all types. */
+   uint8_t flags;
    retrogui_idc_t idc;
    retroflat_pxxy_t x;
    retroflat_pxxy_t y;
@@ -459,6 +494,17 @@ typedef void (*retrogui_xy_cb)(
 
 typedef char retrogui_list_t[RETROGUI_CTL_LISTBOX_STR_SZ_MAX + 1];
 
+/**
+ * \brief Region of a ::RETROGUI that must be redrawn, relative to RETROGUI::x
+ *        and RETROGUI::y.
+ */
+struct RETROGUI_RECT {
+   retroflat_pxxy_t x;
+   retroflat_pxxy_t y;
+   retroflat_pxxy_t w;
+   retroflat_pxxy_t h;
+};
+
 /*
  * \note It is possible to have multiple GUI controllers in a program. For
  *       example, a web browser might have a controller for its address bar and
@@ -487,8 +533,51 @@ struct RETROGUI {
     * then it will *not* be freed by retrogui_destroy().
     */
    union RETROGXC_CACHABLE font;
+   /**
+    * \brief Regions to clear and redraw on the next retrogui_redraw_ctls()
+    *        if only ::RETROGUI_FLAGS_DAMAGED is set.
+    *
+    * These are vacated areas (e.g. from moved or removed controls) and the
+    * areas of controls with ::RETROGUI_CTL_FLAG_DIRTY, as gathered by
+    * retrogui_collect_damage().
+    */
+   struct RETROGUI_RECT damage[RETROGUI_DAMAGE_RECTS_MAX];
+   /*! \brief Number of regions in use in RETROGUI::damage. */
+   size_t damage_ct;
+   /**
+    * \brief Index of slots in RETROGUI::ctls, keyed by IDC, maintained by
+    *        retrogui_push_ctl() and retrogui_remove_ctl().
+    */
+   struct MDATA_INDEX idc_index;
 };
 
+/**
+ * \brief A single change to apply to a control with retrogui_set_ctls().
+ */
+struct RETROGUI_CTL_SET {
+   /*! \brief Unique identifier of the control to change. */
+   retrogui_idc_t idc;
+   /*! \brief Text to set on the control, or NULL to leave it as is. */
+   const char* text;
+   /*! \brief Length of RETROGUI_CTL_SET::text, or 0 to use strlen(). */
+   size_t text_sz;
+   /**
+    * \brief Color to set on the control (e.g. ::RETROGUI_COLOR_BG), or 0 to
+    *        leave its colors as they are.
+    */
+   uint8_t color_key;
+   RETROFLAT_COLOR color_val;
+};
+
+/**
+ * \relates RETROGUI
+ * \brief Mark a single ::RETROGUI_CTL to be redrawn, without redrawing the
+ *        rest of the ::RETROGUI.
+ */
+#define retrogui_damage_ctl( gui, ctl ) \
+   (ctl)->base.flags |= RETROGUI_CTL_FLAG_DIRTY; \
+   (gui)->flags |= RETROGUI_FLAGS_DAMAGED;
+
 MERROR_RETVAL retrogui_push_listbox_item(
    struct RETROGUI* gui, retrogui_idc_t idc, const char* item, size_t item_sz );
 
@@ -504,8 +593,53 @@ retrogui_idc_t retrogui_poll_ctls(
    struct RETROGUI* gui, RETROFLAT_IN_KEY* p_input,
    struct RETROFLAT_INPUT* input_evt );
 
+/**
+ * \relates RETROGUI
+ * \brief Redraw the controls of a ::RETROGUI.
+ *
+ * If ::RETROGUI_FLAGS_DIRTY is set, the whole GUI is redrawn. Otherwise, if
+ * ::RETROGUI_FLAGS_DAMAGED is set, only the regions in RETROGUI::damage are
+ * cleared to RETROGUI::bg_color and only controls overlapping them are
+ * redrawn.
+ *
+ * \note As with a full redraw, damaged regions are not cleared if
+ *       RETROGUI::bg_color is ::RETROFLAT_COLOR_BLACK, so the caller may
+ *       clear them itself (see retrogui_collect_damage()).
+ */
 MERROR_RETVAL retrogui_redraw_ctls( struct RETROGUI* gui );
 
+/**
+ * \relates RETROGUI
+ * \brief Mark a region of a ::RETROGUI (e.g. one vacated by a control) to be
+ *        cleared and redrawn on the next retrogui_redraw_ctls().
+ *
+ * The region is merged with an overlapping one if possible. If
+ * ::RETROGUI_DAMAGE_RECTS_MAX regions are already in use, they are all merged
+ * into one.
+ */
+void retrogui_damage( struct RETROGUI* gui,
+   retroflat_pxxy_t x, retroflat_pxxy_t y,
+   retroflat_pxxy_t w, retroflat_pxxy_t h );
+
+/**
+ * \relates RETROGUI
+ * \brief Add the areas of all controls marked with ::RETROGUI_CTL_FLAG_DIRTY
+ *        to RETROGUI::damage, so that the full list of regions to be redrawn
+ *        may be inspected before retrogui_redraw_ctls() is called.
+ */
+MERROR_RETVAL retrogui_collect_damage( struct RETROGUI* gui );
+
+/**
+ * \relates RETROGUI
+ * \brief Get a single rectangle enclosing everything that will be redrawn by
+ *        the next retrogui_redraw_ctls(), relative to RETROGUI::x and
+ *        RETROGUI::y.
+ * \param p_rect Pointer to a rect to fill. Its w and h will be 0 if nothing
+ *               will be redrawn.
+ */
+MERROR_RETVAL retrogui_get_damage(
+   struct RETROGUI* gui, struct RETROGUI_RECT* p_rect );
+
 MERROR_RETVAL retrogui_sz_ctl(
    struct RETROGUI* gui, retrogui_idc_t idc,
    retroflat_pxxy_t* p_w, retroflat_pxxy_t* p_h,
@@ -546,6 +680,19 @@ MERROR_RETVAL retrogui_set_ctl_text(
    struct RETROGUI* gui, retrogui_idc_t idc, size_t buffer_sz,
    const char* fmt, ... );
 
+/**
+ * \relates RETROGUI
+ * \brief Apply many text and color changes to controls under a single lock
+ *        of RETROGUI::ctls, e.g. to update a screen full of labels each frame.
+ * \param sets Array of changes to apply, in order.
+ * \param sets_ct Number of changes in sets.
+ * \return One of the \ref maug_error_retvals indicating operation result. If
+ *         a control is missing, the rest of the changes are still applied and
+ *         ::MERROR_GUI is returned.
+ */
+MERROR_RETVAL retrogui_set_ctls(
+   struct RETROGUI* gui, struct RETROGUI_CTL_SET* sets, size_t sets_ct );
+
 /**
  * \brief Set the image displayed by an IMAGE-type RETROGUI_CTL.
  * \param idc Unique identifier index of the control to adjust.
@@ -797,7 +944,7 @@ static retrogui_idc_t retrogui_key_LISTBOX(
       }
 
       /* Redraw and preempt further processing of input. */
-      gui->flags |= RETROGUI_FLAGS_DIRTY;
+      retrogui_damage_ctl( gui, ctl );
       *p_input = 0;
       break;
 
@@ -809,7 +956,7 @@ static retrogui_idc_t retrogui_key_LISTBOX(
       }
 
       /* Redraw and preempt further processing of input. */
-      gui->flags |= RETROGUI_FLAGS_DIRTY;
+      retrogui_damage_ctl( gui, ctl );
       *p_input = 0;
       break;
    }
@@ -976,7 +1123,7 @@ MERROR_RETVAL retrogui_push_listbox_item(
 
 #endif
 
-   gui->flags |= RETROGUI_FLAGS_DIRTY;
+   retrogui_damage_ctl( gui, ctl );
 
 cleanup:
 
@@ -1158,7 +1305,8 @@ static void retrogui_redraw_BUTTON(
          gui->x + ctl->base.x + 1, gui->y + ctl->base.y + 2,
          gui->x + ctl->base.x + 1, gui->y + ctl->base.y + ctl->base.h - 3, 0 );
 
-      gui->flags |= RETROGUI_FLAGS_DIRTY; /* Mark dirty for push animation. */
+      /* Mark dirty for push animation. */
+      retrogui_damage_ctl( gui, ctl );
       ctl->BUTTON.push_frames--;
       text_offset = 1;
    } else {
@@ -1546,7 +1694,8 @@ static void retrogui_redraw_TEXTBOX(
       maug_munlock( ctl->TEXTBOX.text_h, ctl->TEXTBOX.text );
    }
 
-   gui->flags |= RETROGUI_FLAGS_DIRTY; /* Mark dirty for blink animation. */
+   /* Mark dirty for blink animation. */
+   retrogui_damage_ctl( gui, ctl );
 
 cleanup:
 
@@ -1692,7 +1841,7 @@ static void retrogui_redraw_LABEL(
          ctl->LABEL.show_ticks--;
          show_sz = ctl->LABEL.shown_sz;
          if( ctl->LABEL.shown_sz < ctl->LABEL.label_sz ) {
-            gui->flags |= RETROGUI_FLAGS_DIRTY;
+            retrogui_damage_ctl( gui, ctl );
          }
 
       } else {
@@ -1710,7 +1859,7 @@ static void retrogui_redraw_LABEL(
             show_sz = ctl->LABEL.label_sz;
          } else {
             /* Not done showing yet! */
-            gui->flags |= RETROGUI_FLAGS_DIRTY;
+            retrogui_damage_ctl( gui, ctl );
          }
 
          /* Finalize whatever decision we came to above. */
@@ -2082,14 +2231,124 @@ static MERROR_RETVAL retrogui_init_FILLBAR( union RETROGUI_CTL* ctl ) {
 
 /* === Static Internal Functions === */
 
-static union RETROGUI_CTL* _retrogui_get_ctl_by_idc(
+/* IDCs are usually handed out in sequence, so they spread evenly across the
+ * index without any further hashing.
+ */
+#define _retrogui_idc_hash( idc ) ((uint32_t)(uint16_t)(idc))
+
+static int _retrogui_index_hash( void* data, size_t idx, uint32_t* p_hash ) {
+   struct RETROGUI* gui = (struct RETROGUI*)data;
+   union RETROGUI_CTL* ctl = NULL;
+
+   ctl = mdata_vector_get( &(gui->ctls), idx, union RETROGUI_CTL );
+   assert( NULL != ctl );
+   *p_hash = _retrogui_idc_hash( ctl->base.idc );
+
+   return 1;
+}
+
+/* === */
+
+static int _retrogui_index_match( void* data, size_t idx, const void* key ) {
+   struct RETROGUI* gui = (struct RETROGUI*)data;
+   union RETROGUI_CTL* ctl = NULL;
+
+   ctl = mdata_vector_get( &(gui->ctls), idx, union RETROGUI_CTL );
+   assert( NULL != ctl );
+
+   return *((const retrogui_idc_t*)key) == ctl->base.idc;
+}
+
+/* === */
+
+/**
+ * \brief Rebuild the IDC index of a ::RETROGUI from its locked
+ *        RETROGUI::ctls, keeping it at most half full.
+ *
+ * If this fails, lookups fall back to scanning RETROGUI::ctls.
+ */
+static MERROR_RETVAL _retrogui_index_rebuild( struct RETROGUI* gui ) {
+   assert( mdata_vector_is_locked( &((gui)->ctls) ) );
+
+#if RETROGUI_TRACE_LVL > 0
+   debug_printf( RETROGUI_TRACE_LVL, "rebuilding IDC index..." );
+#endif /* RETROGUI_TRACE_LVL */
+
+   return mdata_index_rebuild( &(gui->idc_index),
+      mdata_vector_ct( &(gui->ctls) ), RETROGUI_IDC_INDEX_SZ_MIN,
+      _retrogui_index_hash, gui );
+}
+
+/* === */
+
+/**
+ * \brief Add the last control in the locked RETROGUI::ctls to the IDC index,
+ *        growing the index if it would become more than half full.
+ */
+static MERROR_RETVAL _retrogui_index_add( struct RETROGUI* gui ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   union RETROGUI_CTL* ctl = NULL;
+
+   assert( mdata_vector_is_locked( &((gui)->ctls) ) );
+
+   if( mdata_vector_ct( &(gui->ctls) ) * 2 > gui->idc_index.slots_sz ) {
+      retval = _retrogui_index_rebuild( gui );
+      goto cleanup;
+   }
+
+   ctl = mdata_vector_get_last( &(gui->ctls), union RETROGUI_CTL );
+   assert( NULL != ctl );
+   mdata_index_lock( &(gui->idc_index) );
+   mdata_index_insert( &(gui->idc_index),
+      _retrogui_idc_hash( ctl->base.idc ), mdata_vector_ct( &(gui->ctls) ) - 1 );
+   mdata_index_unlock( &(gui->idc_index) );
+
+cleanup:
+
+   if( MERROR_OK != retval ) {
+      mdata_index_free( &(gui->idc_index) );
+   }
+
+   return retval;
+}
+
+/* === */
+
+/**
+ * \brief Find a control in the locked RETROGUI::ctls by IDC without
+ *        complaining if it is missing.
+ */
+static union RETROGUI_CTL* _retrogui_find_ctl(
    struct RETROGUI* gui, retrogui_idc_t idc
 ) {
-   size_t i = 0;
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t i = 0,
+      probe = 0;
+   ssize_t idx = -1;
    union RETROGUI_CTL* ctl = NULL;
+   int autolock = 0;
 
    assert( mdata_vector_is_locked( &((gui)->ctls) ) );
 
+   if(
+      0 < gui->idc_index.slots_sz &&
+      !mdata_index_is_locked( &(gui->idc_index) )
+   ) {
+      mdata_index_lock( &(gui->idc_index) );
+      autolock = 1;
+   }
+
+   if( mdata_index_is_locked( &(gui->idc_index) ) ) {
+      /* Probe the index. */
+      idx = mdata_index_probe( &(gui->idc_index), _retrogui_idc_hash( idc ),
+         &probe, _retrogui_index_match, gui, &idc );
+      if( 0 <= idx ) {
+         ctl = mdata_vector_get( &(gui->ctls), idx, union RETROGUI_CTL );
+      }
+      goto cleanup;
+   }
+
+   /* No index, so fall back to a scan. */
    for( i = 0 ; mdata_vector_ct( &(gui->ctls) ) > i ; i++ ) {
       ctl = mdata_vector_get( &(gui->ctls), i, union RETROGUI_CTL );
       if( idc == ctl->base.idc ) {
@@ -2098,6 +2357,27 @@ static union RETROGUI_CTL* _retrogui_get_ctl_by_idc(
       ctl = NULL;
    }
 
+cleanup:
+
+   if( autolock ) {
+      mdata_index_unlock( &(gui->idc_index) );
+   }
+
+   if( MERROR_OK != retval ) {
+      ctl = NULL;
+   }
+
+   return ctl;
+}
+
+/* === */
+
+static union RETROGUI_CTL* _retrogui_get_ctl_by_idc(
+   struct RETROGUI* gui, retrogui_idc_t idc
+) {
+   union RETROGUI_CTL* ctl = NULL;
+
+   ctl = _retrogui_find_ctl( gui, idc );
    if( NULL == ctl ) {
       error_printf( "could not find GUI item IDC " RETROGUI_IDC_FMT, idc );
    }
@@ -2152,6 +2432,177 @@ cleanup:
    return retval;
 }
 
+/* === */
+
+#define _retrogui_rects_overlap( a, b ) \
+   ((a)->x < (b)->x + (b)->w && (b)->x < (a)->x + (a)->w && \
+   (a)->y < (b)->y + (b)->h && (b)->y < (a)->y + (a)->h)
+
+static void _retrogui_rect_union(
+   struct RETROGUI_RECT* dest, const struct RETROGUI_RECT* src
+) {
+   retroflat_pxxy_t x2 = 0;
+   retroflat_pxxy_t y2 = 0;
+
+   if( 0 == dest->w || 0 == dest->h ) {
+      maug_mcpy( dest, src, sizeof( struct RETROGUI_RECT ) );
+      return;
+   }
+
+   x2 = dest->x + dest->w > src->x + src->w ?
+      dest->x + dest->w : src->x + src->w;
+   y2 = dest->y + dest->h > src->y + src->h ?
+      dest->y + dest->h : src->y + src->h;
+   if( src->x < dest->x ) {
+      dest->x = src->x;
+   }
+   if( src->y < dest->y ) {
+      dest->y = src->y;
+   }
+   dest->w = x2 - dest->x;
+   dest->h = y2 - dest->y;
+}
+
+/* === */
+
+void retrogui_damage( struct RETROGUI* gui,
+   retroflat_pxxy_t x, retroflat_pxxy_t y,
+   retroflat_pxxy_t w, retroflat_pxxy_t h
+) {
+   struct RETROGUI_RECT rect;
+   size_t i = 0;
+
+   if( 0 == w || 0 == h ) {
+      return;
+   }
+
+   rect.x = x;
+   rect.y = y;
+   rect.w = w;
+   rect.h = h;
+
+   gui->flags |= RETROGUI_FLAGS_DAMAGED;
+
+   /* Grow an overlapping region to cover the new one if we can. */
+   for( i = 0 ; gui->damage_ct > i ; i++ ) {
+      if( _retrogui_rects_overlap( &(gui->damage[i]), &rect ) ) {
+         _retrogui_rect_union( &(gui->damage[i]), &rect );
+         return;
+      }
+   }
+
+   if( RETROGUI_DAMAGE_RECTS_MAX <= gui->damage_ct ) {
+      /* Out of regions, so merge them all into the first. */
+#if RETROGUI_TRACE_LVL > 0
+      debug_printf( RETROGUI_TRACE_LVL,
+         "out of damage regions; merging " SIZE_T_FMT "...", gui->damage_ct );
+#endif /* RETROGUI_TRACE_LVL */
+      for( i = 1 ; gui->damage_ct > i ; i++ ) {
+         _retrogui_rect_union( &(gui->damage[0]), &(gui->damage[i]) );
+      }
+      _retrogui_rect_union( &(gui->damage[0]), &rect );
+      gui->damage_ct = 1;
+      return;
+   }
+
+   maug_mcpy(
+      &(gui->damage[gui->damage_ct]), &rect, sizeof( struct RETROGUI_RECT ) );
+   gui->damage_ct++;
+}
+
+/* === */
+
+MERROR_RETVAL retrogui_collect_damage( struct RETROGUI* gui ) {
+   size_t i = 0;
+   union RETROGUI_CTL* ctl = NULL;
+   MERROR_RETVAL retval = MERROR_OK;
+   int autolock = 0;
+
+   if( 0 == mdata_vector_ct( &(gui->ctls) ) ) {
+      goto cleanup;
+   }
+
+   if( !mdata_vector_is_locked( &((gui)->ctls) ) ) {
+      mdata_vector_lock( &(gui->ctls) );
+      autolock = 1;
+   }
+
+   for( i = 0 ; mdata_vector_ct( &(gui->ctls) ) > i ; i++ ) {
+      ctl = mdata_vector_get( &(gui->ctls), i, union RETROGUI_CTL );
+      if(
+         RETROGUI_CTL_FLAG_DIRTY == (RETROGUI_CTL_FLAG_DIRTY & ctl->base.flags)
+      ) {
+         retrogui_damage(
+            gui, ctl->base.x, ctl->base.y, ctl->base.w, ctl->base.h );
+      }
+   }
+
+cleanup:
+
+   if( autolock ) {
+      mdata_vector_unlock( &(gui->ctls) );
+   }
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL retrogui_get_damage(
+   struct RETROGUI* gui, struct RETROGUI_RECT* p_rect
+) {
+   size_t i = 0;
+   MERROR_RETVAL retval = MERROR_OK;
+
+   maug_mzero( p_rect, sizeof( struct RETROGUI_RECT ) );
+
+   if( RETROGUI_FLAGS_DIRTY == (RETROGUI_FLAGS_DIRTY & gui->flags) ) {
+      /* Everything will be redrawn. */
+      p_rect->w = gui->w;
+      p_rect->h = gui->h;
+      goto cleanup;
+   }
+
+   if( RETROGUI_FLAGS_DAMAGED != (RETROGUI_FLAGS_DAMAGED & gui->flags) ) {
+      goto cleanup;
+   }
+
+   retval = retrogui_collect_damage( gui );
+   maug_cleanup_if_not_ok();
+
+   for( i = 0 ; gui->damage_ct > i ; i++ ) {
+      _retrogui_rect_union( p_rect, &(gui->damage[i]) );
+   }
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL _retrogui_damage_idc(
+   struct RETROGUI* gui, retrogui_idc_t idc
+) {
+   union RETROGUI_CTL* ctl = NULL;
+
+   assert( mdata_vector_is_locked( &((gui)->ctls) ) );
+
+   if( RETROGUI_IDC_NONE == idc ) {
+      return MERROR_OK;
+   }
+
+   /* A missing control is fine here. */
+   ctl = _retrogui_find_ctl( gui, idc );
+   if( NULL != ctl ) {
+      retrogui_damage_ctl( gui, ctl );
+   }
+
+   return MERROR_OK;
+}
+
+/* === */
+
 /* === Generic Functions === */
 
 retrogui_idc_t retrogui_poll_ctls( 
@@ -2164,6 +2615,7 @@ retrogui_idc_t retrogui_poll_ctls(
    retrogui_idc_t idc_out = RETROGUI_IDC_NONE;
    union RETROGUI_CTL* ctl = NULL;
    MERROR_RETVAL retval = MERROR_OK;
+   retrogui_idc_t focus_prev = RETROGUI_IDC_NONE;
 
    if( 0 == mdata_vector_ct( &(gui->ctls) ) ) {
       return RETROGUI_IDC_NONE;
@@ -2172,6 +2624,8 @@ retrogui_idc_t retrogui_poll_ctls(
    assert( !mdata_vector_is_locked( &((gui)->ctls) ) );
    mdata_vector_lock( &(gui->ctls) );
 
+   focus_prev = gui->focus_idc;
+
 #  if defined( RETROGUI_NATIVE_WIN )
 
    if( 0 == g_retroflat_state->last_idc ) {
@@ -2207,12 +2661,12 @@ retrogui_idc_t retrogui_poll_ctls(
 
 #     define RETROGUI_CTL_TABLE_CLICK( idx, c_name, c_fields ) \
          } else if( RETROGUI_CTL_TYPE_ ## c_name == ctl->base.type ) { \
-            gui->flags |= RETROGUI_FLAGS_DIRTY; \
+            retrogui_damage_ctl( gui, ctl ); \
             idc_out = retrogui_click_ ## c_name( gui, ctl, p_input, input_evt );
 
 #     define RETROGUI_CTL_TABLE_KEY( idx, c_name, c_fields ) \
          } else if( RETROGUI_CTL_TYPE_ ## c_name == ctl->base.type ) { \
-            gui->flags |= RETROGUI_FLAGS_DIRTY; \
+            retrogui_damage_ctl( gui, ctl ); \
             idc_out = retrogui_key_ ## c_name( gui, ctl, p_input, input_evt );
 
    if( 0 != *p_input ) {
@@ -2250,7 +2704,7 @@ retrogui_idc_t retrogui_poll_ctls(
 #endif /* RETROGUI_TRACE_LVL */
          idc_out = gui->focus_idc;
          /* gui->focus_idc = -1; */
-         gui->flags |= RETROGUI_FLAGS_DIRTY;
+         _retrogui_damage_idc( gui, gui->focus_idc );
       }
 
    } else if(
@@ -2360,6 +2814,15 @@ retrogui_idc_t retrogui_poll_ctls(
 
 cleanup:
 
+   if(
+      mdata_vector_is_locked( &((gui)->ctls) ) &&
+      focus_prev != gui->focus_idc
+   ) {
+      /* Redraw the controls focus left and landed on. */
+      _retrogui_damage_idc( gui, focus_prev );
+      _retrogui_damage_idc( gui, gui->focus_idc );
+   }
+
    if( MERROR_OK != retval ) {
       idc_out = merror_retval_to_sz( retval );
    }
@@ -2373,19 +2836,31 @@ cleanup:
 
 MERROR_RETVAL retrogui_redraw_ctls( struct RETROGUI* gui ) {
    size_t i = 0;
+   size_t j = 0;
    union RETROGUI_CTL* ctl = NULL;
    MERROR_RETVAL retval = MERROR_OK;
    int autolock = 0;
+   int full = 1;
+   struct RETROGUI_RECT damage[RETROGUI_DAMAGE_RECTS_MAX];
+   size_t damage_ct = 0;
 
 #if RETROGUI_TRACE_LVL > 0
    debug_printf( RETROGUI_TRACE_LVL, "redrawing controls..." );
 #endif /* RETROGUI_TRACE_LVL */
 
+   /* With RETROWIN_NO_BITMAP, controls are drawn straight to a screen that is
+    * cleared every frame, so they must always all be redrawn.
+    */
 #ifndef RETROWIN_NO_BITMAP
-   if( RETROGUI_FLAGS_DIRTY != (RETROGUI_FLAGS_DIRTY & gui->flags) ) {
+   if(
+      RETROGUI_FLAGS_DIRTY != (RETROGUI_FLAGS_DIRTY & gui->flags) &&
+      RETROGUI_FLAGS_DAMAGED != (RETROGUI_FLAGS_DAMAGED & gui->flags)
+   ) {
       /* Shortcut! */
       return MERROR_OK;
    }
+
+   full = RETROGUI_FLAGS_DIRTY == (RETROGUI_FLAGS_DIRTY & gui->flags);
 #endif /* !RETROWIN_NO_BITMAP */
 
    if( 0 == mdata_vector_ct( &(gui->ctls) ) ) {
@@ -2402,24 +2877,60 @@ MERROR_RETVAL retrogui_redraw_ctls( struct RETROGUI* gui ) {
       autolock = 1;
    }
 
-   if(
-      RETROFLAT_COLOR_BLACK != gui->bg_color &&
-      0 < gui->w && 0 < gui->h
-   ) {
-      retroflat_2d_rect( gui->draw_bmp,
-         gui->bg_color, gui->x, gui->y, gui->w, gui->h, RETROFLAT_DRAW_FLAG_FILL );
+   if( full ) {
+      if(
+         RETROFLAT_COLOR_BLACK != gui->bg_color &&
+         0 < gui->w && 0 < gui->h
+      ) {
+         retroflat_2d_rect( gui->draw_bmp, gui->bg_color,
+            gui->x, gui->y, gui->w, gui->h, RETROFLAT_DRAW_FLAG_FILL );
+      }
+   } else {
+      retval = retrogui_collect_damage( gui );
+      maug_cleanup_if_not_ok();
+
+      /* Take the regions, as redraws below may damage controls again. */
+      damage_ct = gui->damage_ct;
+      maug_mcpy( damage, gui->damage,
+         sizeof( struct RETROGUI_RECT ) * damage_ct );
+
+#if RETROGUI_TRACE_LVL > 0
+      debug_printf( RETROGUI_TRACE_LVL,
+         "redrawing " SIZE_T_FMT " damaged regions...", damage_ct );
+#endif /* RETROGUI_TRACE_LVL */
+
+      if( RETROFLAT_COLOR_BLACK != gui->bg_color ) {
+         for( j = 0 ; damage_ct > j ; j++ ) {
+            retroflat_2d_rect( gui->draw_bmp, gui->bg_color,
+               gui->x + damage[j].x, gui->y + damage[j].y,
+               damage[j].w, damage[j].h, RETROFLAT_DRAW_FLAG_FILL );
+         }
+      }
    }
 
    /* Mark the GUI dirty first so redraw can unmark it for animation! */
-   gui->flags &= ~RETROGUI_FLAGS_DIRTY;
+   gui->flags &= ~(RETROGUI_FLAGS_DIRTY | RETROGUI_FLAGS_DAMAGED);
+   gui->damage_ct = 0;
 
    #define RETROGUI_CTL_TABLE_REDRAW( idx, c_name, c_fields ) \
       } else if( RETROGUI_CTL_TYPE_ ## c_name == ctl->base.type ) { \
          retrogui_redraw_ ## c_name( gui, ctl );
 
-   /* Iterate and redraw all controls. */
+   /* Iterate and redraw all controls (or only those in damaged regions). */
    for( i = 0 ; mdata_vector_ct( &(gui->ctls) ) > i ; i++ ) {
       ctl = mdata_vector_get( &(gui->ctls), i, union RETROGUI_CTL );
+      if( !full ) {
+         /* Skip controls that don't overlap a damaged region. */
+         for( j = 0 ; damage_ct > j ; j++ ) {
+            if( _retrogui_rects_overlap( &(ctl->base), &(damage[j]) ) ) {
+               break;
+            }
+         }
+         if( damage_ct == j ) {
+            continue;
+         }
+      }
+      ctl->base.flags &= ~RETROGUI_CTL_FLAG_DIRTY;
       if( 0 ) {
       RETROGUI_CTL_TABLE( RETROGUI_CTL_TABLE_REDRAW )
       }
@@ -2469,6 +2980,9 @@ MERROR_RETVAL retrogui_pos_ctl(
       goto cleanup;
    }
 
+   /* Clear the area the control is leaving. */
+   retrogui_damage( gui, ctl->base.x, ctl->base.y, ctl->base.w, ctl->base.h );
+
    #define RETROGUI_CTL_TABLE_POS( idx, c_name, c_fields ) \
       } else if( RETROGUI_CTL_TYPE_ ## c_name == ctl->base.type ) { \
          /* Mark dirty first so redraw can unmark it for animation! */ \
@@ -2488,7 +3002,7 @@ MERROR_RETVAL retrogui_pos_ctl(
 #endif /* RETROGUI_TRACE_LVL */
 
    /* New position! Redraw! */
-   gui->flags |= RETROGUI_FLAGS_DIRTY;
+   retrogui_damage_ctl( gui, ctl );
 
 cleanup:
 
@@ -2570,6 +3084,9 @@ MERROR_RETVAL retrogui_push_ctl(
       union RETROGUI_CTL );
    assert( NULL != ctl );
 
+   /* A failed index just means slower lookups, so keep going. */
+   _retrogui_index_add( gui );
+
 #if RETROGUI_TRACE_LVL > 0
 #  define RETROGUI_CTL_TABLE_PUSH( idx, c_name, c_fields ) \
       } else if( RETROGUI_CTL_TYPE_ ## c_name == ctl->base.type ) { \
@@ -2648,6 +3165,10 @@ MERROR_RETVAL retrogui_remove_ctl( struct RETROGUI* gui, retrogui_idc_t idc ) {
          continue;
       }
 
+      /* Clear the area the control is leaving. */
+      retrogui_damage(
+         gui, ctl->base.x, ctl->base.y, ctl->base.w, ctl->base.h );
+
       /* Free the control data. */
       if( 0 ) {
       RETROGUI_CTL_TABLE( RETROGUI_CTL_TABLE_FREE_CTL )
@@ -2657,6 +3178,9 @@ MERROR_RETVAL retrogui_remove_ctl( struct RETROGUI* gui, retrogui_idc_t idc ) {
       mdata_vector_unlock( &(gui->ctls) );
       mdata_vector_remove( &(gui->ctls), i );
       mdata_vector_lock( &(gui->ctls) );
+
+      /* Controls after this one have moved down a slot. */
+      _retrogui_index_rebuild( gui );
       break;
    }
 
@@ -2749,7 +3273,10 @@ MERROR_RETVAL retrogui_get_ctl_text(
 
 cleanup:
 
-   if( RETROGUI_CTL_TYPE_TEXTBOX == ctl->base.type ) {
+   if( NULL == ctl ) {
+      /* Nothing was locked. */
+
+   } else if( RETROGUI_CTL_TYPE_TEXTBOX == ctl->base.type ) {
       if( NULL != ctl->TEXTBOX.text ) {
          maug_munlock( ctl->TEXTBOX.text_h, ctl->TEXTBOX.text );
       }
@@ -2813,6 +3340,108 @@ cleanup:
 
 /* === */
 
+/**
+ * \brief Copy an already-formatted string into a control in the locked
+ *        RETROGUI::ctls and mark it for redraw.
+ */
+static MERROR_RETVAL _retrogui_set_ctl_text_buf(
+   struct RETROGUI* gui, union RETROGUI_CTL* ctl, const char* buffer,
+   size_t buffer_sz
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   char* label_tmp = NULL;
+
+   assert( mdata_vector_is_locked( &((gui)->ctls) ) );
+
+   if( RETROGUI_CTL_TYPE_BUTTON == ctl->base.type ) {
+      assert( NULL == ctl->BUTTON.label );
+      _retrogui_copy_str( label, buffer, ctl->BUTTON, label_tmp, buffer_sz );
+   } else if( RETROGUI_CTL_TYPE_LABEL == ctl->base.type ) {
+      assert( NULL == ctl->LABEL.label );
+      _retrogui_copy_str(
+         label, buffer, ctl->LABEL, label_tmp, buffer_sz );
+      ctl->LABEL.shown_sz = 1;
+      ctl->LABEL.show_ticks =
+         RETROGUI_LABEL_FLAG_SHOWINC_SLOW ==
+         (RETROGUI_LABEL_FLAG_SHOWINC_SLOW & ctl->LABEL.flags) ?
+            RETROGUI_LABEL_SHOW_TICKS_MAX * 2 :
+            RETROGUI_LABEL_SHOW_TICKS_MAX;
+
+#ifndef RETROGUI_NO_TEXTBOX
+   } else if( RETROGUI_CTL_TYPE_TEXTBOX == ctl->base.type ) {
+      /* This is slightly different from _retrogui_copy_str, as it handles
+       * the sz_max and sz_ fields independently for the TEXTBOX and allocates
+       * an extra byte for NULL at the end for safety.
+       */
+      if( buffer_sz > ctl->TEXTBOX.text_sz_max ) {
+#if RETROGUI_TRACE_LVL > 0
+         debug_printf( RETROGUI_TRACE_LVL,
+            "string size different; creating new buffer..." );
+#endif /* RETROGUI_TRACE_LVL */
+         if( (MAUG_MHANDLE)NULL != ctl->TEXTBOX.text_h ) {
+            /* Free the existing string. */
+            maug_mfree( ctl->TEXTBOX.text_h );
+         }
+
+         /* Allocate new string space. */
+         maug_malloc_test( ctl->TEXTBOX.text_h, buffer_sz + 1, 1 );
+
+         ctl->TEXTBOX.text_sz_max = buffer_sz;
+      }
+      ctl->TEXTBOX.text_sz = buffer_sz;
+      ctl->TEXTBOX.text_cur = 0;
+      maug_mlock( ctl->TEXTBOX.text_h, label_tmp );
+      maug_cleanup_if_null_lock( char*, label_tmp );
+
+      /* Copy the string over. */
+      maug_mzero( label_tmp, buffer_sz + 1 );
+#if RETROGUI_TRACE_LVL > 0
+      debug_printf( RETROGUI_TRACE_LVL,
+         "zeroed str sz for \"%s\": " SIZE_T_FMT, buffer, buffer_sz + 1 );
+#endif /* RETROGUI_TRACE_LVL */
+      maug_strncpy( label_tmp, buffer, buffer_sz );
+#if RETROGUI_TRACE_LVL > 0
+      debug_printf( RETROGUI_TRACE_LVL, "copied str as: \"%s\"", label_tmp );
+#endif /* RETROGUI_TRACE_LVL */
+      maug_munlock( ctl->TEXTBOX.text_h, label_tmp );
+
+#endif /* !RETROGUI_NO_TEXTBOX */
+   } else {
+      error_printf( "invalid control type! no label!" );
+      goto cleanup;
+   }
+
+   /* New text! Redraw! */
+   retrogui_damage_ctl( gui, ctl );
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static void _retrogui_set_ctl_color(
+   struct RETROGUI* gui, union RETROGUI_CTL* ctl, uint8_t color_key,
+   RETROFLAT_COLOR color_val
+) {
+   switch( color_key ) {
+   case RETROGUI_COLOR_BG: ctl->base.bg_color = color_val; break;
+   case RETROGUI_COLOR_FG: ctl->base.fg_color = color_val; break;
+   case RETROGUI_COLOR_SEL_BG: ctl->base.sel_bg = color_val; break;
+   case RETROGUI_COLOR_SEL_FG: ctl->base.sel_fg = color_val; break;
+
+   default:
+      error_printf( "invalid color key specified: %u", color_key );
+      return;
+   }
+
+   /* New color! Redraw! */
+   retrogui_damage_ctl( gui, ctl );
+}
+
+/* === */
+
 MERROR_RETVAL retrogui_set_ctl_color(
    struct RETROGUI* gui, retrogui_idc_t idc, uint8_t color_key,
    RETROFLAT_COLOR color_val
@@ -2838,16 +3467,7 @@ MERROR_RETVAL retrogui_set_ctl_color(
       goto cleanup;
    }
 
-   switch( color_key ) {
-   case RETROGUI_COLOR_BG: ctl->base.bg_color = color_val; break;
-   case RETROGUI_COLOR_FG: ctl->base.fg_color = color_val; break;
-   case RETROGUI_COLOR_SEL_BG: ctl->base.sel_bg = color_val; break;
-   case RETROGUI_COLOR_SEL_FG: ctl->base.sel_fg = color_val; break;
-
-   default:
-      error_printf( "invalid color key specified: %u", color_key );
-      break;
-   }
+   _retrogui_set_ctl_color( gui, ctl, color_key, color_val );
 
 cleanup:
 
@@ -2863,7 +3483,6 @@ MERROR_RETVAL retrogui_set_ctl_text(
    const char* fmt, ...
 ) {
    MERROR_RETVAL retval = MERROR_OK;
-   char* label_tmp = NULL;
    char* buffer = NULL;
    union RETROGUI_CTL* ctl = NULL;
    MAUG_MHANDLE buffer_h = (MAUG_MHANDLE)NULL;
@@ -2905,80 +3524,84 @@ MERROR_RETVAL retrogui_set_ctl_text(
       va_end( args );
    }
 
-   /* Perform the actual update. */
-   if( RETROGUI_CTL_TYPE_BUTTON == ctl->base.type ) {
-      assert( NULL == ctl->BUTTON.label );
-      _retrogui_copy_str( label, buffer, ctl->BUTTON, label_tmp, buffer_sz );
-   } else if( RETROGUI_CTL_TYPE_LABEL == ctl->base.type ) {
-      assert( NULL == ctl->LABEL.label );
-      _retrogui_copy_str(
-         label, buffer, ctl->LABEL, label_tmp, buffer_sz );
-      ctl->LABEL.shown_sz = 1;
-      ctl->LABEL.show_ticks =
-         RETROGUI_LABEL_FLAG_SHOWINC_SLOW ==
-         (RETROGUI_LABEL_FLAG_SHOWINC_SLOW & ctl->LABEL.flags) ?
-            RETROGUI_LABEL_SHOW_TICKS_MAX * 2 :
-            RETROGUI_LABEL_SHOW_TICKS_MAX;
+   retval = _retrogui_set_ctl_text_buf( gui, ctl, buffer, buffer_sz );
 
-#ifndef RETROGUI_NO_TEXTBOX
-   } else if( RETROGUI_CTL_TYPE_TEXTBOX == ctl->base.type ) {
-      /* This is slightly different from _retrogui_copy_str, as it handles
-       * the sz_max and sz_ fields independently for the TEXTBOX and allocates
-       * an extra byte for NULL at the end for safety.
-       */
-      if( buffer_sz > ctl->TEXTBOX.text_sz_max ) {
-#if RETROGUI_TRACE_LVL > 0
-         debug_printf( RETROGUI_TRACE_LVL,
-            "string size different; creating new buffer..." );
-#endif /* RETROGUI_TRACE_LVL */
-         if( (MAUG_MHANDLE)NULL != ctl->TEXTBOX.text_h ) {
-            /* Free the existing string. */
-            maug_mfree( ctl->TEXTBOX.text_h );
-         }
+cleanup:
 
-         /* Allocate new string space. */
-         maug_malloc_test( ctl->TEXTBOX.text_h, buffer_sz + 1, 1 );
+   if( NULL != buffer ) {
+      maug_munlock( buffer_h, buffer );
+   }
 
-         ctl->TEXTBOX.text_sz_max = buffer_sz;
-      }
-      ctl->TEXTBOX.text_sz = buffer_sz;
-      ctl->TEXTBOX.text_cur = 0;
-      maug_mlock( ctl->TEXTBOX.text_h, label_tmp );
-      maug_cleanup_if_null_lock( char*, label_tmp );
+   if( (MAUG_MHANDLE)NULL != buffer_h ) {
+      maug_mfree( buffer_h );
+   }
+
+   mdata_vector_unlock( &(gui->ctls) );
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL retrogui_set_ctls(
+   struct RETROGUI* gui, struct RETROGUI_CTL_SET* sets, size_t sets_ct
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   MERROR_RETVAL set_retval = MERROR_OK;
+   union RETROGUI_CTL* ctl = NULL;
+   size_t i = 0;
+   size_t text_sz = 0;
+   int autolock = 0;
+
+   if( !mdata_vector_is_locked( &((gui)->ctls) ) ) {
+      mdata_vector_lock( &(gui->ctls) );
+      autolock = 1;
+   }
+
+   /* Hold the index for the whole batch rather than once per lookup. */
+   if( 0 < gui->idc_index.slots_sz ) {
+      mdata_index_lock( &(gui->idc_index) );
+   }
 
-      /* Copy the string over. */
-      maug_mzero( label_tmp, buffer_sz + 1 );
-#if RETROGUI_TRACE_LVL > 0
-      debug_printf( RETROGUI_TRACE_LVL,
-         "zeroed str sz for \"%s\": " SIZE_T_FMT, buffer, buffer_sz + 1 );
-#endif /* RETROGUI_TRACE_LVL */
-      maug_strncpy( label_tmp, buffer, buffer_sz );
 #if RETROGUI_TRACE_LVL > 0
-      debug_printf( RETROGUI_TRACE_LVL, "copied str as: \"%s\"", label_tmp );
+   debug_printf( RETROGUI_TRACE_LVL,
+      "applying " SIZE_T_FMT " control changes...", sets_ct );
 #endif /* RETROGUI_TRACE_LVL */
-      maug_munlock( ctl->TEXTBOX.text_h, label_tmp );
 
-#endif /* !RETROGUI_NO_TEXTBOX */
-   } else {
-      error_printf( "invalid control type! no label!" );
-      goto cleanup;
-   }
+   for( i = 0 ; sets_ct > i ; i++ ) {
+      ctl = _retrogui_get_ctl_by_idc( gui, sets[i].idc );
+      if( NULL == ctl ) {
+         /* Note the error, but still apply the rest of the batch. */
+         retval = MERROR_GUI;
+         continue;
+      }
 
-   /* New text! Redraw! */
-   gui->flags |= RETROGUI_FLAGS_DIRTY;
+      if( NULL != sets[i].text ) {
+         text_sz = sets[i].text_sz;
+         if( 0 == text_sz ) {
+            text_sz = maug_strlen( sets[i].text );
+         }
+         set_retval = _retrogui_set_ctl_text_buf(
+            gui, ctl, sets[i].text, text_sz );
+         if( MERROR_OK != set_retval ) {
+            retval = set_retval;
+         }
+      }
+
+      if( 0 != sets[i].color_key ) {
+         _retrogui_set_ctl_color(
+            gui, ctl, sets[i].color_key, sets[i].color_val );
+      }
+   }
 
 cleanup:
 
-   if( NULL != buffer ) {
-      maug_munlock( buffer_h, buffer );
-   }
+   mdata_index_unlock( &(gui->idc_index) );
 
-   if( (MAUG_MHANDLE)NULL != buffer_h ) {
-      maug_mfree( buffer_h );
+   if( autolock ) {
+      mdata_vector_unlock( &(gui->ctls) );
    }
 
-   mdata_vector_unlock( &(gui->ctls) );
-
    return retval;
 }
 
@@ -3034,7 +3657,7 @@ MERROR_RETVAL retrogui_set_ctl_image(
    }
 
    /* New text! Redraw! */
-   gui->flags |= RETROGUI_FLAGS_DIRTY;
+   retrogui_damage_ctl( gui, ctl );
 
 cleanup:
 
@@ -3130,7 +3753,7 @@ MERROR_RETVAL retrogui_set_ctl_image_blit(
    }
 
    /* New text! Redraw! */
-   gui->flags |= RETROGUI_FLAGS_DIRTY;
+   retrogui_damage_ctl( gui, ctl );
 
 cleanup:
 
@@ -3182,7 +3805,7 @@ MERROR_RETVAL retrogui_set_ctl_level(
    }
 
    /* New level! Redraw! */
-   gui->flags |= RETROGUI_FLAGS_DIRTY;
+   retrogui_damage_ctl( gui, ctl );
 
 cleanup:
 
@@ -3281,6 +3904,8 @@ cleanup:
 
    mdata_vector_free( &(gui->ctls) );
 
+   mdata_index_free( &(gui->idc_index) );
+
    return retval;
 }
 
@@ -3295,6 +3920,7 @@ retrogui_idc_t retrogui_focus_iter(
    retrogui_idc_t i = 0;
    ssize_t i_before = -1; /* Index of the current selected IDC. */
    int autolock = 0;
+   retrogui_idc_t focus_prev = gui->focus_idc;
 
    if( 0 == mdata_vector_ct( &(gui->ctls) ) ) {
       goto cleanup;
@@ -3383,8 +4009,14 @@ retrogui_idc_t retrogui_focus_iter(
 
 cleanup:
 
-   /* New focus! Dirty! */
-   gui->flags |= RETROGUI_FLAGS_DIRTY;
+   /* New focus! Redraw the controls it left and landed on. */
+   if(
+      mdata_vector_is_locked( &((gui)->ctls) ) &&
+      focus_prev != gui->focus_idc
+   ) {
+      _retrogui_damage_idc( gui, focus_prev );
+      _retrogui_damage_idc( gui, gui->focus_idc );
+   }
 
    if( MERROR_OK != retval ) {
       idc_out = merror_retval_to_sz( retval );
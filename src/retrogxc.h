@@ -39,12 +39,68 @@
 #  define RETROGXC_TRACE_LVL 0
 #endif /* !RETROGXC_TRACE_LVL */
 
+#ifndef RETROGXC_INDEX_SZ_MIN
+/**
+ * \brief Minimum number of slots in the cache path index. Must be a power
+ *        of 2.
+ */
+#  define RETROGXC_INDEX_SZ_MIN 32
+#endif /* !RETROGXC_INDEX_SZ_MIN */
+
+#ifndef RETROGXC_BUDGET_DEFAULT
+/**
+ * \brief Default byte budget for resident cached assets. 0 means unlimited,
+ *        which never evicts. May be changed with retrogxc_set_budget().
+ */
+#  define RETROGXC_BUDGET_DEFAULT 0
+#endif /* !RETROGXC_BUDGET_DEFAULT */
+
+#ifndef RETROGXC_BITMAP_PX_SZ
+/**
+ * \brief Bytes per pixel used to estimate the size of a cached bitmap for
+ *        budget purposes.
+ */
+#  define RETROGXC_BITMAP_PX_SZ 4
+#endif /* !RETROGXC_BITMAP_PX_SZ */
+
+#ifndef RETROGXC_FONT_GLYPH_SZ
+/**
+ * \brief Bytes per glyph used to estimate the size of a cached font for
+ *        budget purposes.
+ */
+#  define RETROGXC_FONT_GLYPH_SZ 32
+#endif /* !RETROGXC_FONT_GLYPH_SZ */
+
+#if defined( RETROFONT_PRESENT ) && defined( RETROFONT_ATLAS_SLOTS ) && \
+   !defined( RETROFONT_NO_ATLAS )
+/* The font backend keeps glyph atlas bitmaps alongside each font. */
+#  define RETROGXC_FONT_ATLASES
+#endif /* RETROFONT_PRESENT && RETROFONT_ATLAS_SLOTS && !RETROFONT_NO_ATLAS */
+
 #define RETROGXC_ERROR_CACHE_MISS (-1)
 
 #define RETROGXC_ASSET_TYPE_NONE    0
 #define RETROGXC_ASSET_TYPE_BITMAP  1
 #define RETROGXC_ASSET_TYPE_FONT    2
 
+/**
+ * \brief RETROFLAT_CACHE_ASSET::flags indicating the asset has been used since
+ *        the eviction clock hand last passed it.
+ */
+#define RETROGXC_ASSET_FLAG_REF        0x01
+
+/**
+ * \brief RETROFLAT_CACHE_ASSET::flags indicating the asset payload has been
+ *        evicted and will be reloaded on next use.
+ */
+#define RETROGXC_ASSET_FLAG_EVICTED    0x02
+
+/**
+ * \brief RETROFLAT_CACHE_ASSET::flags indicating the asset cannot be reloaded
+ *        (e.g. its loader data was not retained), so it is never evicted.
+ */
+#define RETROGXC_ASSET_FLAG_NO_EVICT   0x04
+
 #define retrogxc_load_bitmap( res_p, flags ) \
    retrogxc_load_asset( res_p, retrogxc_loader_bitmap, NULL, flags )
 
@@ -54,16 +110,54 @@ typedef retrogxc_asset_type_t (*retrogxc_loader)(
    const maug_path res_p, MAUG_MHANDLE* handle_p,
    void* data, uint8_t flags );
 
+struct RETROGXC_FONT_PARMS {
+   uint8_t glyph_h;
+   uint16_t first_glyph;
+   uint16_t glyphs_count;
+};
+
+/**
+ * \brief A cache slot. Slots are never removed or reused until
+ *        retrogxc_clear_cache(), so indexes handed out by
+ *        retrogxc_load_asset() stay valid even if the payload is evicted.
+ */
 struct RETROFLAT_CACHE_ASSET {
    uint8_t type;
+   /*! \brief Bitfield of e.g. ::RETROGXC_ASSET_FLAG_REF. */
+   uint8_t flags;
+   /*! \brief Flags passed to the loader, kept for reloading. */
+   uint8_t load_flags;
+   /*! \brief Number of outstanding retrogxc_pin_asset() calls. */
+   uint8_t pins;
    MAUG_MHANDLE handle;
+   /*! \brief Estimated resident size in bytes, counted against the budget. */
+   size_t sz;
+   /*! \brief Hash of RETROFLAT_CACHE_ASSET::id for the path index. */
+   uint32_t hash;
+   retrogxc_loader loader;
+   /*! \brief Font parameters, if loaded with retrogxc_loader_font(). */
+   struct RETROGXC_FONT_PARMS parms;
    maug_path id;
 };
 
-struct RETROGXC_FONT_PARMS {
-   uint8_t glyph_h;
-   uint16_t first_glyph;
-   uint16_t glyphs_count;
+/**
+ * \brief Counters describing cache behavior, from retrogxc_get_stats().
+ */
+struct RETROGXC_STATS {
+   /*! \brief retrogxc_load_asset() calls satisfied from the index. */
+   uint32_t hits;
+   /*! \brief retrogxc_load_asset() calls that had to invoke a loader. */
+   uint32_t misses;
+   /*! \brief Asset payloads dropped to stay within the budget. */
+   uint32_t evictions;
+   /*! \brief Evicted assets brought back in on use. */
+   uint32_t reloads;
+   /*! \brief Estimated bytes of resident asset payloads. */
+   size_t bytes;
+   /*! \brief Current byte budget; 0 is unlimited. */
+   size_t budget;
+   /*! \brief Number of cache slots (resident or evicted). */
+   size_t assets;
 };
 
 MERROR_RETVAL retrogxc_init( void );
@@ -99,12 +193,32 @@ int16_t retrogxc_load_asset(
 /**
  * \brief Retrive an asset for which we have a prior cached index.
  *
- * This should be quicker than retrogxc_load_asset(), which has to compare
- * paths for prior loaded assets by looping.
+ * This skips the path lookup done by retrogxc_load_asset(). If the asset was
+ * evicted, it is reloaded first.
+ *
+ * \warning Unless the asset is pinned with retrogxc_pin_asset(), the handle
+ *          returned may be evicted by the next call that loads an asset.
  */
 MAUG_MHANDLE retrogxc_get_asset(
    size_t asset_idx, retrogxc_asset_type_t asset_type );
 
+/**
+ * \brief Prevent an asset from being evicted until a matching
+ *        retrogxc_unpin_asset(). Reloads the asset if it was evicted.
+ */
+MERROR_RETVAL retrogxc_pin_asset( size_t asset_idx );
+
+MERROR_RETVAL retrogxc_unpin_asset( size_t asset_idx );
+
+/**
+ * \brief Set the byte budget for resident assets, evicting unpinned assets
+ *        that have not been used recently if the cache is over it.
+ * \param budget Budget in (estimated) bytes, or 0 for unlimited.
+ */
+void retrogxc_set_budget( size_t budget );
+
+void retrogxc_get_stats( struct RETROGXC_STATS* p_stats );
+
 MERROR_RETVAL retrogxc_blit_bitmap(
    retroflat_blit_t* target, size_t bitmap_idx,
    retroflat_pxxy_t s_x, retroflat_pxxy_t s_y,
@@ -118,6 +232,14 @@ MERROR_RETVAL retrogxc_bitmap_wh(
 
 static struct MDATA_VECTOR SEG_MGLOBAL gs_retrogxc_bitmaps;
 
+/*! \brief Index of asset slots, keyed by path hash. */
+static struct MDATA_INDEX SEG_MGLOBAL gs_retrogxc_index;
+
+/*! \brief Position of the CLOCK eviction hand in gs_retrogxc_bitmaps. */
+static size_t SEG_MGLOBAL gs_retrogxc_clock = 0;
+
+static struct RETROGXC_STATS SEG_MGLOBAL gs_retrogxc_stats;
+
 /* === */
 
 MERROR_RETVAL retrogxc_init( void ) {
@@ -130,6 +252,9 @@ MERROR_RETVAL retrogxc_init( void ) {
       sizeof( struct RETROFLAT_CACHE_ASSET ) * gs_retrogxc_sz );
    */
 
+   maug_mzero( &gs_retrogxc_stats, sizeof( struct RETROGXC_STATS ) );
+   gs_retrogxc_stats.budget = RETROGXC_BUDGET_DEFAULT;
+
    g_retroflat_state->retroflat_flags |= RETROFLAT_STATE_FLAG_USE_GXC;
 
    return retval;
@@ -137,12 +262,47 @@ MERROR_RETVAL retrogxc_init( void ) {
 
 /* === */
 
+static void retrogxc_asset_free( struct RETROFLAT_CACHE_ASSET* asset ) {
+   retroflat_blit_t* bitmap = NULL;
+
+   if( (MAUG_MHANDLE)NULL == asset->handle ) {
+      return;
+   }
+
+   /* Asset-type-specific cleanup. */
+   switch( asset->type ) {
+   case RETROGXC_ASSET_TYPE_BITMAP:
+      maug_mlock( asset->handle, bitmap );
+      if( NULL != bitmap ) {
+         retroflat_2d_destroy_bitmap( bitmap );
+      }
+      maug_munlock( asset->handle, bitmap );
+      maug_mfree( asset->handle );
+      break;
+
+#ifdef RETROFONT_PRESENT
+   case RETROGXC_ASSET_TYPE_FONT:
+      /* Fonts are just a blob of data after a struct, so just free it! */
+      retrofont_free( &(asset->handle) );
+      break;
+#endif /* RETROFONT_PRESENT */
+   }
+
+   asset->handle = (MAUG_MHANDLE)NULL;
+}
+
+/* === */
+
 void retrogxc_clear_cache( void ) {
    size_t dropped_count = 0;
    struct RETROFLAT_CACHE_ASSET* asset = NULL;
-   retroflat_blit_t* bitmap = NULL;
    MERROR_RETVAL retval = MERROR_OK;
 
+   mdata_index_free( &gs_retrogxc_index );
+   gs_retrogxc_clock = 0;
+   gs_retrogxc_stats.bytes = 0;
+   gs_retrogxc_stats.assets = 0;
+
    if( 0 == mdata_vector_ct( &gs_retrogxc_bitmaps ) ) {
       /* Nothing to do! */
       return;
@@ -155,22 +315,8 @@ void retrogxc_clear_cache( void ) {
          &gs_retrogxc_bitmaps, 0, struct RETROFLAT_CACHE_ASSET );
       assert( NULL != asset );
 
-      /* Asset-type-specific cleanup. */
-      switch( asset->type ) {
-      case RETROGXC_ASSET_TYPE_BITMAP:
-         maug_mlock( asset->handle, bitmap );
-         if( NULL != bitmap ) {
-            retroflat_2d_destroy_bitmap( bitmap );
-         }
-         maug_munlock( asset->handle, bitmap );
-         maug_mfree( asset->handle );
-         dropped_count++;
-
-      case RETROGXC_ASSET_TYPE_FONT:
-         /* Fonts are just a blob of data after a struct, so just free it! */
-         retrofont_free( &(asset->handle) );
-         dropped_count++;
-      }
+      retrogxc_asset_free( asset );
+      dropped_count++;
 
       mdata_vector_unlock( &gs_retrogxc_bitmaps );
       mdata_vector_remove( &gs_retrogxc_bitmaps, 0 );
@@ -270,12 +416,281 @@ cleanup:
 
 /* === */
 
+static size_t retrogxc_asset_sz( struct RETROFLAT_CACHE_ASSET* asset ) {
+   size_t sz_out = 0;
+   retroflat_blit_t* bitmap = NULL;
+#ifdef RETROGXC_FONT_ATLASES
+   struct RETROFONT* font = NULL;
+#endif /* RETROGXC_FONT_ATLASES */
+
+   switch( asset->type ) {
+   case RETROGXC_ASSET_TYPE_BITMAP:
+      maug_mlock( asset->handle, bitmap );
+      if( NULL != bitmap ) {
+         sz_out = (size_t)retroflat_2d_bitmap_w( bitmap ) *
+            (size_t)retroflat_2d_bitmap_h( bitmap ) * RETROGXC_BITMAP_PX_SZ;
+         maug_munlock( asset->handle, bitmap );
+      }
+      break;
+
+   case RETROGXC_ASSET_TYPE_FONT:
+      sz_out = (size_t)asset->parms.glyphs_count * RETROGXC_FONT_GLYPH_SZ;
+#ifdef RETROGXC_FONT_ATLASES
+      /* Atlases are created as the font is drawn, so count every slot up
+       * front rather than let the font outgrow its budget later.
+       */
+      maug_mlock( asset->handle, font );
+      if( NULL != font ) {
+         sz_out += RETROFONT_ATLAS_SLOTS *
+            retrofont_atlas_px( font->glyph_w, font->glyph_h ) *
+            RETROGXC_BITMAP_PX_SZ;
+         maug_munlock( asset->handle, font );
+      }
+#endif /* RETROGXC_FONT_ATLASES */
+      break;
+   }
+
+   return sz_out;
+}
+
+/* === */
+
+static void retrogxc_evict_to_budget( void ) {
+   size_t steps = 0;
+   struct RETROFLAT_CACHE_ASSET* asset = NULL;
+
+   assert( mdata_vector_is_locked( &gs_retrogxc_bitmaps ) );
+
+   if( 0 == gs_retrogxc_stats.budget ) {
+      return;
+   }
+
+   /* Two sweeps are enough to clear every reference bit and evict behind it;
+    * anything left over is pinned or not evictable.
+    */
+   while(
+      gs_retrogxc_stats.bytes > gs_retrogxc_stats.budget &&
+      steps < 2 * mdata_vector_ct( &gs_retrogxc_bitmaps )
+   ) {
+      if( gs_retrogxc_clock >= mdata_vector_ct( &gs_retrogxc_bitmaps ) ) {
+         gs_retrogxc_clock = 0;
+      }
+      asset = mdata_vector_get(
+         &gs_retrogxc_bitmaps, gs_retrogxc_clock,
+         struct RETROFLAT_CACHE_ASSET );
+      assert( NULL != asset );
+      gs_retrogxc_clock++;
+      steps++;
+
+      if(
+         0 < asset->pins ||
+         RETROGXC_ASSET_FLAG_EVICTED ==
+            (RETROGXC_ASSET_FLAG_EVICTED & asset->flags) ||
+         RETROGXC_ASSET_FLAG_NO_EVICT ==
+            (RETROGXC_ASSET_FLAG_NO_EVICT & asset->flags)
+      ) {
+         continue;
+      }
+
+      if( RETROGXC_ASSET_FLAG_REF == (RETROGXC_ASSET_FLAG_REF & asset->flags) ) {
+         /* Used recently; give it another lap. */
+         asset->flags &= ~RETROGXC_ASSET_FLAG_REF;
+         continue;
+      }
+
+      debug_printf( RETROGXC_TRACE_LVL,
+         "evicting asset \"%s\" (" SIZE_T_FMT " bytes)", asset->id, asset->sz );
+
+      retrogxc_asset_free( asset );
+      asset->flags |= RETROGXC_ASSET_FLAG_EVICTED;
+      gs_retrogxc_stats.bytes -= asset->sz;
+      gs_retrogxc_stats.evictions++;
+   }
+}
+
+/* === */
+
+/**
+ * \brief Make sure the given locked asset is resident and mark it used.
+ */
+static MERROR_RETVAL retrogxc_asset_touch(
+   struct RETROFLAT_CACHE_ASSET* asset
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   retrogxc_asset_type_t asset_type = RETROGXC_ASSET_TYPE_NONE;
+   void* data = NULL;
+
+   asset->flags |= RETROGXC_ASSET_FLAG_REF;
+
+   if(
+      RETROGXC_ASSET_FLAG_EVICTED !=
+      (RETROGXC_ASSET_FLAG_EVICTED & asset->flags)
+   ) {
+      goto cleanup;
+   }
+
+   debug_printf( RETROGXC_TRACE_LVL,
+      "reloading evicted asset \"%s\"...", asset->id );
+
+   if( RETROGXC_ASSET_TYPE_FONT == asset->type ) {
+      data = &(asset->parms);
+   }
+   asset_type = asset->loader(
+      asset->id, &(asset->handle), data, asset->load_flags );
+   if( asset_type != asset->type ) {
+      error_printf( "unable to reload asset \"%s\"!", asset->id );
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   asset->flags &= ~RETROGXC_ASSET_FLAG_EVICTED;
+   gs_retrogxc_stats.bytes += asset->sz;
+   gs_retrogxc_stats.reloads++;
+
+   /* Don't evict the asset we just brought back before the caller uses it. */
+   asset->pins++;
+   retrogxc_evict_to_budget();
+   asset->pins--;
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+/**
+ * \brief What retrogxc_index_find() is looking for in the cache.
+ */
+struct RETROGXC_INDEX_KEY {
+   const char* res_p;
+   uint32_t hash;
+   retrogxc_loader loader;
+   struct RETROGXC_FONT_PARMS* parms;
+};
+
+/* === */
+
+static int retrogxc_index_hash( void* data, size_t idx, uint32_t* p_hash ) {
+   struct RETROFLAT_CACHE_ASSET* asset = NULL;
+
+   asset = mdata_vector_get(
+      &gs_retrogxc_bitmaps, idx, struct RETROFLAT_CACHE_ASSET );
+   assert( NULL != asset );
+   *p_hash = asset->hash;
+
+   return 1;
+}
+
+/* === */
+
+static int retrogxc_index_match( void* data, size_t idx, const void* key ) {
+   const struct RETROGXC_INDEX_KEY* k = (const struct RETROGXC_INDEX_KEY*)key;
+   struct RETROFLAT_CACHE_ASSET* asset = NULL;
+
+   asset = mdata_vector_get(
+      &gs_retrogxc_bitmaps, idx, struct RETROFLAT_CACHE_ASSET );
+   assert( NULL != asset );
+   debug_printf( RETROGXC_TRACE_LVL, "\"%s\" vs \"%s\"",
+     asset->id, k->res_p );
+
+   return
+      asset->hash == k->hash &&
+      asset->loader == k->loader &&
+      asset->parms.glyph_h == k->parms->glyph_h &&
+      asset->parms.first_glyph == k->parms->first_glyph &&
+      asset->parms.glyphs_count == k->parms->glyphs_count &&
+      0 == mfile_cmp_path( asset->id, k->res_p );
+}
+
+/* === */
+
+/**
+ * \brief Add the last asset in the locked cache to the path index, growing
+ *        the index to keep it at most half full.
+ */
+static MERROR_RETVAL retrogxc_index_add( void ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROFLAT_CACHE_ASSET* asset = NULL;
+   size_t idx = 0;
+
+   assert( mdata_vector_is_locked( &gs_retrogxc_bitmaps ) );
+
+   if(
+      mdata_vector_ct( &gs_retrogxc_bitmaps ) * 2 >
+      gs_retrogxc_index.slots_sz
+   ) {
+#if RETROGXC_TRACE_LVL > 0
+      debug_printf( RETROGXC_TRACE_LVL, "rebuilding cache index..." );
+#endif /* RETROGXC_TRACE_LVL */
+      retval = mdata_index_rebuild( &gs_retrogxc_index,
+         mdata_vector_ct( &gs_retrogxc_bitmaps ), RETROGXC_INDEX_SZ_MIN,
+         retrogxc_index_hash, NULL );
+      goto cleanup;
+   }
+
+   /* Just insert the new asset. */
+   idx = mdata_vector_ct( &gs_retrogxc_bitmaps ) - 1;
+   asset = mdata_vector_get(
+      &gs_retrogxc_bitmaps, idx, struct RETROFLAT_CACHE_ASSET );
+   assert( NULL != asset );
+   mdata_index_lock( &gs_retrogxc_index );
+   mdata_index_insert( &gs_retrogxc_index, asset->hash, idx );
+
+cleanup:
+
+   mdata_index_unlock( &gs_retrogxc_index );
+
+   return retval;
+}
+
+/* === */
+
+/**
+ * \brief Find the slot for the given path and loader in the locked cache.
+ * \return Cache index or ::RETROGXC_ERROR_CACHE_MISS.
+ */
+static int16_t retrogxc_index_find(
+   const maug_path res_p, uint32_t hash, retrogxc_loader l,
+   struct RETROGXC_FONT_PARMS* parms
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   int16_t idx = RETROGXC_ERROR_CACHE_MISS;
+   struct RETROGXC_INDEX_KEY key;
+   size_t probe = 0;
+
+   if( 0 == gs_retrogxc_index.slots_sz ) {
+      goto cleanup;
+   }
+
+   key.res_p = res_p;
+   key.hash = hash;
+   key.loader = l;
+   key.parms = parms;
+
+   mdata_index_lock( &gs_retrogxc_index );
+   idx = (int16_t)mdata_index_probe( &gs_retrogxc_index, hash, &probe,
+      retrogxc_index_match, NULL, &key );
+
+cleanup:
+
+   mdata_index_unlock( &gs_retrogxc_index );
+
+   if( MERROR_OK != retval ) {
+      /* Treat it as a miss; the caller will just load a new copy. */
+      idx = RETROGXC_ERROR_CACHE_MISS;
+   }
+
+   return idx;
+}
+
+/* === */
+
 int16_t retrogxc_load_asset(
    const maug_path res_p, retrogxc_loader l, void* data,
    uint8_t flags
 ) {
-   int16_t idx = RETROGXC_ERROR_CACHE_MISS,
-      i = 0;
+   int16_t idx = RETROGXC_ERROR_CACHE_MISS;
    struct RETROFLAT_CACHE_ASSET asset_new;
    struct RETROFLAT_CACHE_ASSET* asset_iter = NULL;
    retrogxc_asset_type_t asset_type = RETROGXC_ASSET_TYPE_NONE;
@@ -283,26 +698,39 @@ int16_t retrogxc_load_asset(
 
    maug_mzero( &asset_new, sizeof( struct RETROFLAT_CACHE_ASSET ) );
 
+   asset_new.hash = mdata_hash( res_p, maug_strlen( res_p ) );
+   asset_new.loader = l;
+   asset_new.load_flags = flags;
+#ifdef RETROFONT_PRESENT
+   if( retrogxc_loader_font == l ) {
+      /* Keep the font parameters so the font can be reloaded if evicted. */
+      maug_mcpy( &(asset_new.parms), data,
+         sizeof( struct RETROGXC_FONT_PARMS ) );
+   } else
+#endif /* RETROFONT_PRESENT */
+   if( NULL != data ) {
+      /* We don't know how to keep this loader's data for later. */
+      asset_new.flags |= RETROGXC_ASSET_FLAG_NO_EVICT;
+   }
+
    if( 0 == mdata_vector_ct( &gs_retrogxc_bitmaps ) ) {
       goto just_load_asset;
    }
 
-   /* Try to find the bitmap already in the cache. */
+   /* Try to find the asset already in the cache. */
    mdata_vector_lock( &gs_retrogxc_bitmaps );
-   for( i = 0 ; mdata_vector_ct( &gs_retrogxc_bitmaps ) > (size_t)i ; i++ ) {
+   idx = retrogxc_index_find( res_p, asset_new.hash, l, &(asset_new.parms) );
+   if( 0 <= idx ) {
       asset_iter = mdata_vector_get(
-         &gs_retrogxc_bitmaps, i, struct RETROFLAT_CACHE_ASSET );
+         &gs_retrogxc_bitmaps, idx, struct RETROFLAT_CACHE_ASSET );
       assert( NULL != asset_iter );
-      debug_printf( RETROGXC_TRACE_LVL, "\"%s\" vs \"%s\"",
-        asset_iter->id, res_p );
-      if( 0 == mfile_cmp_path( asset_iter->id, res_p ) ) {
-         debug_printf( RETROGXC_TRACE_LVL,
-            "found asset \"%s\" at index %d with type %d!",
-            res_p, i, asset_iter->type );
-         idx = i;
-         mdata_vector_unlock( &gs_retrogxc_bitmaps );
-         goto cleanup;
-      }
+      debug_printf( RETROGXC_TRACE_LVL,
+         "found asset \"%s\" at index %d with type %d!",
+         res_p, idx, asset_iter->type );
+      gs_retrogxc_stats.hits++;
+      retval = retrogxc_asset_touch( asset_iter );
+      mdata_vector_unlock( &gs_retrogxc_bitmaps );
+      goto cleanup;
    }
    mdata_vector_unlock( &gs_retrogxc_bitmaps );
 
@@ -312,17 +740,47 @@ just_load_asset:
    debug_printf( RETROGXC_TRACE_LVL,
       "asset %s not found in cache; loading...", res_p );
 
+   gs_retrogxc_stats.misses++;
+
    /* Call the format-specific loader. */
    asset_type = l( res_p, &asset_new.handle, data, flags );
    if( RETROGXC_ASSET_TYPE_NONE != asset_type ) {
       asset_new.type = asset_type;
+      asset_new.flags |= RETROGXC_ASSET_FLAG_REF;
+      asset_new.sz = retrogxc_asset_sz( &asset_new );
       mfile_assign_path( asset_new.id, res_p, 0 );
       idx = mdata_vector_append(
          &gs_retrogxc_bitmaps, &asset_new,
          sizeof( struct RETROFLAT_CACHE_ASSET ) );
       if( 0 > idx ) {
+         retrogxc_asset_free( &asset_new );
+         goto cleanup;
+      }
+      gs_retrogxc_stats.bytes += asset_new.sz;
+      gs_retrogxc_stats.assets = mdata_vector_ct( &gs_retrogxc_bitmaps );
+
+      mdata_vector_lock( &gs_retrogxc_bitmaps );
+      retval = retrogxc_index_add();
+      if( MERROR_OK == retval ) {
+         asset_iter = mdata_vector_get(
+            &gs_retrogxc_bitmaps, idx, struct RETROFLAT_CACHE_ASSET );
+         assert( NULL != asset_iter );
+         asset_iter->pins++;
+         retrogxc_evict_to_budget();
+         asset_iter->pins--;
+      }
+      mdata_vector_unlock( &gs_retrogxc_bitmaps );
+
+      if( MERROR_OK != retval ) {
+         /* The index can't find the new asset, so don't keep it. */
+         error_printf( "could not index asset \"%s\"!", res_p );
+         retrogxc_asset_free( &asset_new );
+         mdata_vector_remove_last( &gs_retrogxc_bitmaps );
+         gs_retrogxc_stats.bytes -= asset_new.sz;
+         gs_retrogxc_stats.assets = mdata_vector_ct( &gs_retrogxc_bitmaps );
          goto cleanup;
       }
+
       debug_printf( RETROGXC_TRACE_LVL,
          "asset type %d, \"%s\" assigned cache ID: %d",
          asset_type, res_p, idx );
@@ -370,6 +828,9 @@ MAUG_MHANDLE retrogxc_get_asset(
       goto cleanup;
    }
 
+   retval = retrogxc_asset_touch( asset );
+   maug_cleanup_if_not_ok();
+
    handle_out = asset->handle;
 
 cleanup:
@@ -385,6 +846,83 @@ cleanup:
 
 /* === */
 
+static MERROR_RETVAL retrogxc_pin_adjust( size_t asset_idx, int pin ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROFLAT_CACHE_ASSET* asset = NULL;
+
+   mdata_vector_lock( &gs_retrogxc_bitmaps );
+
+   if( mdata_vector_ct( &gs_retrogxc_bitmaps ) <= asset_idx ) {
+      error_printf( "invalid asset index: " SIZE_T_FMT, asset_idx );
+      retval = MERROR_OVERFLOW;
+      goto cleanup;
+   }
+
+   asset = mdata_vector_get(
+      &gs_retrogxc_bitmaps, asset_idx, struct RETROFLAT_CACHE_ASSET );
+
+   if( pin ) {
+      if( 255 == asset->pins ) {
+         error_printf( "asset " SIZE_T_FMT " pinned too many times!",
+            asset_idx );
+         retval = MERROR_OVERFLOW;
+         goto cleanup;
+      }
+      retval = retrogxc_asset_touch( asset );
+      maug_cleanup_if_not_ok();
+      asset->pins++;
+   } else if( 0 < asset->pins ) {
+      asset->pins--;
+   }
+
+cleanup:
+
+   mdata_vector_unlock( &gs_retrogxc_bitmaps );
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL retrogxc_pin_asset( size_t asset_idx ) {
+   return retrogxc_pin_adjust( asset_idx, 1 );
+}
+
+/* === */
+
+MERROR_RETVAL retrogxc_unpin_asset( size_t asset_idx ) {
+   return retrogxc_pin_adjust( asset_idx, 0 );
+}
+
+/* === */
+
+void retrogxc_set_budget( size_t budget ) {
+   MERROR_RETVAL retval = MERROR_OK;
+
+   gs_retrogxc_stats.budget = budget;
+
+   if( 0 == mdata_vector_ct( &gs_retrogxc_bitmaps ) ) {
+      return;
+   }
+
+   mdata_vector_lock( &gs_retrogxc_bitmaps );
+   retrogxc_evict_to_budget();
+
+cleanup:
+
+   if( MERROR_OK == retval ) {
+      mdata_vector_unlock( &gs_retrogxc_bitmaps );
+   }
+}
+
+/* === */
+
+void retrogxc_get_stats( struct RETROGXC_STATS* p_stats ) {
+   maug_mcpy( p_stats, &gs_retrogxc_stats, sizeof( struct RETROGXC_STATS ) );
+}
+
+/* === */
+
 MERROR_RETVAL retrogxc_blit_bitmap(
    retroflat_blit_t* target, size_t bitmap_idx,
    retroflat_pxxy_t s_x, retroflat_pxxy_t s_y,
@@ -416,6 +954,9 @@ MERROR_RETVAL retrogxc_blit_bitmap(
       goto cleanup;
    }
 
+   retval = retrogxc_asset_touch( asset );
+   maug_cleanup_if_not_ok();
+
    maug_mlock( asset->handle, bitmap );
 
    retval = retroflat_2d_blit_bitmap(
@@ -460,6 +1001,9 @@ MERROR_RETVAL retrogxc_bitmap_wh(
       goto cleanup;
    }
 
+   retval = retrogxc_asset_touch( asset );
+   maug_cleanup_if_not_ok();
+
    maug_mlock( asset->handle, bitmap );
 
    if( NULL != p_w ) {
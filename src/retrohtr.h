@@ -10,7 +10,56 @@
 
 #define RETROHTR_TREE_FLAG_GUI_ACTIVE 1
 
-#define RETROHTR_NODE_FLAG_DIRTY 2
+/**
+ * \brief Flag for RETROHTR_RENDER_NODE::flags indicating the node must be
+ *        repainted by retrohtr_tree_draw().
+ */
+#define RETROHTR_NODE_FLAG_DIRTY 0x02
+
+/**
+ * \brief Alias for ::RETROHTR_NODE_FLAG_DIRTY, for symmetry with the other
+ *        dirty flags.
+ */
+#define RETROHTR_NODE_FLAG_DIRTY_PAINT RETROHTR_NODE_FLAG_DIRTY
+
+/**
+ * \brief Flag for RETROHTR_RENDER_NODE::flags indicating the node's style may
+ *        have changed, so everything below must be redone.
+ */
+#define RETROHTR_NODE_FLAG_DIRTY_STYLE 0x04
+
+/**
+ * \brief Flag for RETROHTR_RENDER_NODE::flags indicating the node must be
+ *        resized by retrohtr_tree_size().
+ */
+#define RETROHTR_NODE_FLAG_DIRTY_SIZE 0x08
+
+/**
+ * \brief Flag for RETROHTR_RENDER_NODE::flags indicating the node must be
+ *        repositioned by retrohtr_tree_pos().
+ */
+#define RETROHTR_NODE_FLAG_DIRTY_POS 0x10
+
+/**
+ * \brief Flag for RETROHTR_RENDER_NODE::flags indicating a descendant of the
+ *        node must be repositioned, even if the node itself is clean.
+ */
+#define RETROHTR_NODE_FLAG_CHILD_POS 0x20
+
+/**
+ * \brief Flag for RETROHTR_RENDER_NODE::flags indicating a descendant of the
+ *        node must be repainted, even if the node itself is clean.
+ */
+#define RETROHTR_NODE_FLAG_CHILD_PAINT 0x40
+
+/**
+ * \brief All of the dirty flags a freshly created node starts with.
+ */
+#define RETROHTR_NODE_FLAG_DIRTY_ALL ( \
+   RETROHTR_NODE_FLAG_DIRTY_STYLE | \
+   RETROHTR_NODE_FLAG_DIRTY_SIZE | \
+   RETROHTR_NODE_FLAG_DIRTY_POS | \
+   RETROHTR_NODE_FLAG_DIRTY_PAINT)
 
 #ifndef RETROHTR_RENDER_NODES_INIT_SZ
 #  define RETROHTR_RENDER_NODES_INIT_SZ 10
@@ -20,6 +69,28 @@
 #  define RETROHTR_TRACE_LVL 0
 #endif /* !RETROHTR_TRACE_LVL */
 
+#ifndef RETROHTR_STYLE_CACHE_SZ
+/**
+ * \brief Number of computed styles retrohtr_apply_styles() keeps per tree,
+ *        so that sibling tags with the same type and classes under the same
+ *        inherited style are only resolved once. Must be a power of 2, or 0
+ *        to disable the cache.
+ */
+#  define RETROHTR_STYLE_CACHE_SZ 16
+#endif /* !RETROHTR_STYLE_CACHE_SZ */
+
+#ifndef RETROHTR_STYLE_MATCHES_MAX
+/**
+ * \brief Maximum number of stylesheet rules that may apply to a single tag's
+ *        classes in retrohtr_apply_styles().
+ */
+#  define RETROHTR_STYLE_MATCHES_MAX 32
+#endif /* !RETROHTR_STYLE_MATCHES_MAX */
+
+#define RETROHTR_STYLE_CACHE_FLAG_ACTIVE     0x01
+
+#define RETROHTR_STYLE_CACHE_FLAG_NO_PARENT  0x02
+
 #define RETROHTR_EDGE_UNKNOWN 0
 #define RETROHTR_EDGE_LEFT    1
 #define RETROHTR_EDGE_TOP     2
@@ -52,6 +123,21 @@ struct RETROHTR_RENDER_NODE {
    struct RETROFLAT_BITMAP bitmap;
 };
 
+/**
+ * \brief Computed style kept by retrohtr_apply_styles(), keyed by tag type,
+ *        class attribute, and the heritable properties of the parent style.
+ */
+struct RETROHTR_STYLE_CACHE {
+   uint8_t flags;
+   uint32_t hash;
+   size_t tag_type;
+   char classes[MCSS_CLASS_SZ_MAX + 1];
+   size_t classes_sz;
+   /*! \brief Only heritable properties of the parent are kept here. */
+   struct MCSS_STYLE parent;
+   struct MCSS_STYLE style;
+};
+
 struct RETROHTR_RENDER_TREE {
    uint8_t flags;
    MAUG_MHANDLE nodes_h;
@@ -62,6 +148,25 @@ struct RETROHTR_RENDER_TREE {
    /*! \brief Current alloc'd number of nodes in RETROHTR_RENDER_NODE::nodes_h. */
    size_t nodes_sz_max;
    struct RETROGUI gui;
+#if 0 < RETROHTR_STYLE_CACHE_SZ
+   /*! \brief Array of ::RETROHTR_STYLE_CACHE_SZ RETROHTR_STYLE_CACHE. */
+   MAUG_MHANDLE styles_cache_h;
+   /*! \brief Number of parsed styles when RETROHTR_RENDER_TREE::styles_cache_h
+    *         was filled. The cache is dropped if this changes. */
+   size_t styles_cache_styles_ct;
+#endif /* RETROHTR_STYLE_CACHE_SZ */
+   /*! \brief Root node area given to retrohtr_tree_create(), so repeated
+    *         passes don't pile padding and margins onto the root. */
+   retroflat_pxxy_t root_x;
+   retroflat_pxxy_t root_y;
+   retroflat_pxxy_t root_w;
+   retroflat_pxxy_t root_h;
+   /*! \brief Nodes resized by the last retrohtr_tree_size() pass. */
+   size_t nodes_sized;
+   /*! \brief Nodes repositioned by the last retrohtr_tree_pos() pass. */
+   size_t nodes_posed;
+   /*! \brief Nodes repainted by the last retrohtr_tree_draw() pass. */
+   size_t nodes_drawn;
 };
 
 /* TODO: Function names should be verb_noun! */
@@ -131,6 +236,34 @@ MERROR_RETVAL retrohtr_apply_styles(
    struct MCSS_STYLE* parent_style, struct MCSS_STYLE* effect_style,
    ssize_t tag_idx );
 
+/**
+ * \brief Mark a render node as needing to be redone by the passes following
+ *        a change to its tag (e.g. new text or classes).
+ *
+ * Dirtiness is propagated so that retrohtr_tree_size(), retrohtr_tree_pos()
+ * and retrohtr_tree_draw() can skip subtrees that are still clean:
+ * ::RETROHTR_NODE_FLAG_DIRTY_STYLE dirties the whole subtree below the node,
+ * ::RETROHTR_NODE_FLAG_DIRTY_SIZE dirties the size of every ancestor, and
+ * ::RETROHTR_NODE_FLAG_DIRTY_PAINT repaints from the nearest ancestor with a
+ * background so that whatever was drawn there before is covered.
+ *
+ * \param flags Bitfield of RETROHTR_NODE_FLAG_DIRTY_* flags.
+ * \warning The tree must be locked with retrohtr_tree_lock().
+ */
+void retrohtr_tree_set_dirty(
+   struct RETROHTR_RENDER_TREE* tree, ssize_t node_idx, uint8_t flags );
+
+/**
+ * \brief Get the number of nodes resized, repositioned and repainted by the
+ *        last retrohtr_tree_size(), retrohtr_tree_pos() and
+ *        retrohtr_tree_draw() passes, respectively.
+ */
+#define retrohtr_tree_touched( tree, p_sized, p_posed, p_drawn ) { \
+      *(p_sized) = (tree)->nodes_sized; \
+      *(p_posed) = (tree)->nodes_posed; \
+      *(p_drawn) = (tree)->nodes_drawn; \
+   }
+
 MERROR_RETVAL retrohtr_tree_size(
    struct MHTML_PARSER* parser, struct RETROHTR_RENDER_TREE* tree,
    struct MCSS_STYLE* prev_sibling_style,
@@ -373,6 +506,112 @@ cleanup:
 
 /* === */
 
+static void retrohtr_tree_set_dirty_subtree(
+   struct RETROHTR_RENDER_TREE* tree, ssize_t node_idx, uint8_t flags
+) {
+   ssize_t child_iter_idx = -1;
+
+   retrohtr_node( tree, node_idx )->flags |= flags;
+
+   child_iter_idx = retrohtr_node( tree, node_idx )->first_child;
+   while( 0 <= child_iter_idx ) {
+      retrohtr_tree_set_dirty_subtree( tree, child_iter_idx, flags );
+      child_iter_idx = retrohtr_node( tree, child_iter_idx )->next_sibling;
+   }
+}
+
+/* === */
+
+void retrohtr_tree_set_dirty(
+   struct RETROHTR_RENDER_TREE* tree, ssize_t node_idx, uint8_t flags
+) {
+   ssize_t iter_idx = -1;
+
+   assert( retrohtr_tree_is_locked( tree ) );
+
+   if( NULL == retrohtr_node( tree, node_idx ) ) {
+      return;
+   }
+
+#if RETROHTR_TRACE_LVL > 0
+   debug_printf( RETROHTR_TRACE_LVL,
+      "setting node " SSIZE_T_FMT " dirty: 0x%02x", node_idx, flags );
+#endif /* RETROHTR_TRACE_LVL */
+
+   if(
+      RETROHTR_NODE_FLAG_DIRTY_STYLE ==
+         (RETROHTR_NODE_FLAG_DIRTY_STYLE & flags)
+   ) {
+      /* Anything below may inherit from the new style. */
+      retrohtr_tree_set_dirty_subtree(
+         tree, node_idx, RETROHTR_NODE_FLAG_DIRTY_ALL );
+      flags |= RETROHTR_NODE_FLAG_DIRTY_ALL;
+#if 0 < RETROHTR_STYLE_CACHE_SZ
+      /* The stylesheet may have been edited in place, so drop the cache. */
+      tree->styles_cache_styles_ct = 0;
+#endif /* RETROHTR_STYLE_CACHE_SZ */
+   }
+
+   retrohtr_node( tree, node_idx )->flags |=
+      (flags & ~RETROHTR_NODE_FLAG_DIRTY_PAINT);
+
+   if(
+      RETROHTR_NODE_FLAG_DIRTY_SIZE == (RETROHTR_NODE_FLAG_DIRTY_SIZE & flags)
+   ) {
+      /* Containers are sized from their children. */
+      iter_idx = retrohtr_node( tree, node_idx )->parent;
+      while( 0 <= iter_idx ) {
+         retrohtr_node( tree, iter_idx )->flags |=
+            RETROHTR_NODE_FLAG_DIRTY_SIZE;
+         iter_idx = retrohtr_node( tree, iter_idx )->parent;
+      }
+   }
+
+   if(
+      RETROHTR_NODE_FLAG_DIRTY_POS == (RETROHTR_NODE_FLAG_DIRTY_POS & flags)
+   ) {
+      /* Leave a trail for retrohtr_tree_pos() to follow down to this node. */
+      iter_idx = retrohtr_node( tree, node_idx )->parent;
+      while( 0 <= iter_idx ) {
+         retrohtr_node( tree, iter_idx )->flags |=
+            RETROHTR_NODE_FLAG_CHILD_POS;
+         iter_idx = retrohtr_node( tree, iter_idx )->parent;
+      }
+   }
+
+   if(
+      RETROHTR_NODE_FLAG_DIRTY_PAINT ==
+         (RETROHTR_NODE_FLAG_DIRTY_PAINT & flags)
+   ) {
+      /* Text and images don't clear what was under them, so repaint from the
+       * nearest container with a background. Painting a node repaints all of
+       * its children in retrohtr_tree_draw().
+       */
+      iter_idx = retrohtr_node( tree, node_idx )->parent;
+      while(
+         0 <= iter_idx &&
+         0 <= retrohtr_node( tree, iter_idx )->parent &&
+         RETROFLAT_COLOR_NULL == retrohtr_node( tree, iter_idx )->bg
+      ) {
+         iter_idx = retrohtr_node( tree, iter_idx )->parent;
+      }
+      if( 0 > iter_idx ) {
+         iter_idx = node_idx;
+      }
+      retrohtr_node( tree, iter_idx )->flags |= RETROHTR_NODE_FLAG_DIRTY_PAINT;
+
+      /* Leave a trail for retrohtr_tree_draw() to follow down to it. */
+      iter_idx = retrohtr_node( tree, iter_idx )->parent;
+      while( 0 <= iter_idx ) {
+         retrohtr_node( tree, iter_idx )->flags |=
+            RETROHTR_NODE_FLAG_CHILD_PAINT;
+         iter_idx = retrohtr_node( tree, iter_idx )->parent;
+      }
+   }
+}
+
+/* === */
+
 ssize_t retrohtr_add_node_child(
    struct RETROHTR_RENDER_TREE* tree, ssize_t node_parent_idx
 ) {
@@ -390,6 +629,7 @@ ssize_t retrohtr_add_node_child(
    retrohtr_node( tree, node_new_idx )->parent = node_parent_idx;
    retrohtr_node( tree, node_new_idx )->first_child = -1;
    retrohtr_node( tree, node_new_idx )->next_sibling = -1;
+   retrohtr_node( tree, node_new_idx )->flags = RETROHTR_NODE_FLAG_DIRTY_ALL;
 
    if( 0 > node_parent_idx ) {
       debug_printf(
@@ -419,6 +659,10 @@ ssize_t retrohtr_add_node_child(
       retrohtr_node( tree, node_sibling_idx )->next_sibling = node_new_idx;
    }
 
+   /* Make sure passes on an existing tree find their way to the new node. */
+   retrohtr_tree_set_dirty(
+      tree, node_new_idx, RETROHTR_NODE_FLAG_DIRTY_ALL );
+
 cleanup:
    
    return node_new_idx;
@@ -475,6 +719,11 @@ MERROR_RETVAL retrohtr_tree_create(
       retrohtr_node( tree, node_idx )->y = y;
       retrohtr_node( tree, node_idx )->w = w;
       retrohtr_node( tree, node_idx )->h = h;
+
+      tree->root_x = x;
+      tree->root_y = y;
+      tree->root_w = w;
+      tree->root_h = h;
    }
 
    tag_iter_idx = p_tag_iter->base.first_child;
@@ -538,6 +787,124 @@ cleanup:
 
 /* === */
 
+#if 0 < RETROHTR_STYLE_CACHE_SZ
+
+static uint32_t retrohtr_style_cache_hash(
+   union MHTML_TAG* p_tag, struct MCSS_STYLE* parent_style
+) {
+   uint32_t hash_out = 0;
+
+   hash_out = mdata_hash( p_tag->base.classes, p_tag->base.classes_sz );
+   hash_out = (hash_out * 31) + p_tag->base.type;
+
+   if( NULL != parent_style ) {
+      #define RETROHTR_PROP_TABLE_HASH( p_id, prop_n, prop_t, prop_p, def ) \
+         if( mcss_prop_is_heritable( p_id ) ) { \
+            hash_out = (hash_out * 31) + (uint32_t)(parent_style->prop_n); \
+            hash_out = (hash_out * 31) + parent_style->prop_n ## _flags; \
+         }
+
+      MCSS_PROP_TABLE( RETROHTR_PROP_TABLE_HASH )
+   }
+
+   return hash_out;
+}
+
+/* === */
+
+static int retrohtr_style_cache_match(
+   struct RETROHTR_STYLE_CACHE* entry, uint32_t hash,
+   union MHTML_TAG* p_tag, struct MCSS_STYLE* parent_style
+) {
+   if(
+      RETROHTR_STYLE_CACHE_FLAG_ACTIVE !=
+         (RETROHTR_STYLE_CACHE_FLAG_ACTIVE & entry->flags) ||
+      entry->hash != hash ||
+      entry->tag_type != p_tag->base.type ||
+      entry->classes_sz != p_tag->base.classes_sz ||
+      0 != maug_strncmp(
+         entry->classes, p_tag->base.classes, p_tag->base.classes_sz ) ||
+      (NULL == parent_style) !=
+         (RETROHTR_STYLE_CACHE_FLAG_NO_PARENT ==
+            (RETROHTR_STYLE_CACHE_FLAG_NO_PARENT & entry->flags))
+   ) {
+      return 0;
+   }
+
+   if( NULL != parent_style ) {
+      #define RETROHTR_PROP_TABLE_CMP( p_id, prop_n, prop_t, prop_p, def ) \
+         if( mcss_prop_is_heritable( p_id ) && ( \
+            entry->parent.prop_n != parent_style->prop_n || \
+            entry->parent.prop_n ## _flags != parent_style->prop_n ## _flags \
+         ) ) { \
+            return 0; \
+         }
+
+      MCSS_PROP_TABLE( RETROHTR_PROP_TABLE_CMP )
+   }
+
+   return 1;
+}
+
+/* === */
+
+static void retrohtr_style_cache_store(
+   struct RETROHTR_STYLE_CACHE* entry, uint32_t hash,
+   union MHTML_TAG* p_tag, struct MCSS_STYLE* parent_style,
+   struct MCSS_STYLE* effect_style
+) {
+   maug_mzero( entry, sizeof( struct RETROHTR_STYLE_CACHE ) );
+
+   entry->flags = RETROHTR_STYLE_CACHE_FLAG_ACTIVE;
+   entry->hash = hash;
+   entry->tag_type = p_tag->base.type;
+   maug_strncpy( entry->classes, p_tag->base.classes, MCSS_CLASS_SZ_MAX );
+   entry->classes_sz = p_tag->base.classes_sz;
+
+   if( NULL != parent_style ) {
+      #define RETROHTR_PROP_TABLE_KEEP( p_id, prop_n, prop_t, prop_p, def ) \
+         if( mcss_prop_is_heritable( p_id ) ) { \
+            entry->parent.prop_n = parent_style->prop_n; \
+            entry->parent.prop_n ## _flags = parent_style->prop_n ## _flags; \
+         }
+
+      MCSS_PROP_TABLE( RETROHTR_PROP_TABLE_KEEP )
+   } else {
+      entry->flags |= RETROHTR_STYLE_CACHE_FLAG_NO_PARENT;
+   }
+
+   maug_mcpy( &(entry->style), effect_style, sizeof( struct MCSS_STYLE ) );
+}
+
+#endif /* RETROHTR_STYLE_CACHE_SZ */
+
+/* === */
+
+static void retrohtr_merge_matches(
+   struct MHTML_PARSER* parser,
+   struct MCSS_STYLE* effect_style, struct MCSS_STYLE* parent_style,
+   size_t tag_type, ssize_t* matches, size_t matches_sz
+) {
+   size_t i = 0;
+   struct MCSS_STYLE* style = NULL;
+
+   for( i = 0 ; matches_sz > i ; i++ ) {
+      style = mdata_vector_get(
+         &(parser->styler.styles), matches[i], struct MCSS_STYLE );
+      assert( NULL != style );
+
+#if RETROHTR_TRACE_LVL > 0
+      debug_printf( RETROHTR_TRACE_LVL,
+         "found style " SSIZE_T_FMT " for tag: %s%s%s",
+         matches[i], style->tag, style->class, style->id );
+#endif /* RETROHTR_TRACE_LVL */
+
+      retrohtr_merge_styles( effect_style, parent_style, style, tag_type );
+   }
+}
+
+/* === */
+
 MERROR_RETVAL retrohtr_apply_styles(
    struct MHTML_PARSER* parser, struct RETROHTR_RENDER_TREE* tree,
    struct MCSS_STYLE* parent_style, struct MCSS_STYLE* effect_style,
@@ -546,9 +913,19 @@ MERROR_RETVAL retrohtr_apply_styles(
    MERROR_RETVAL retval = MERROR_OK;
    ssize_t tag_style_idx = -1;
    size_t tag_type = 0,
-      i = 0;
+      i = 0,
+      j = 0,
+      class_start = 0;
    struct MCSS_STYLE* style = NULL;
    union MHTML_TAG* p_tag_iter = NULL;
+   ssize_t matches[RETROHTR_STYLE_MATCHES_MAX];
+   size_t matches_sz = 0;
+   ssize_t match_swap = 0;
+#if 0 < RETROHTR_STYLE_CACHE_SZ
+   struct RETROHTR_STYLE_CACHE* cache = NULL;
+   uint32_t cache_hash = 0;
+   uint8_t cachable = 0;
+#endif /* RETROHTR_STYLE_CACHE_SZ */
 
 #if RETROHTR_TRACE_LVL > 0
    debug_printf( RETROHTR_TRACE_LVL,
@@ -571,61 +948,99 @@ MERROR_RETVAL retrohtr_apply_styles(
 
    tag_type = p_tag_iter->base.type;
 
-   /* Merge style based on HTML element class. */
-   if( 0 < p_tag_iter->base.classes_sz ) {
-      for( i = 0 ; mdata_vector_ct( &(parser->styler.styles) ) > i ; i++ ) {
-         style = mdata_vector_get(
-            &(parser->styler.styles), i, struct MCSS_STYLE );
-
-         if(
-            NULL != style &&
-            0 == maug_strncmp(
-               p_tag_iter->base.classes,
-               style->class,
-               p_tag_iter->base.classes_sz
-            )
-         ) {
-#if RETROHTR_TRACE_LVL > 0
-            debug_printf( RETROHTR_TRACE_LVL, "found style for tag class: %s",
-               style->class );
-#endif /* RETROHTR_TRACE_LVL */
+#if 0 < RETROHTR_STYLE_CACHE_SZ
+   /* Tags with an ID or their own style are unique, so don't cache them. */
+   if( 0 == p_tag_iter->base.id_sz && 0 > p_tag_iter->base.style ) {
+      if( (MAUG_MHANDLE)NULL == tree->styles_cache_h ) {
+         maug_malloc_test( tree->styles_cache_h,
+            RETROHTR_STYLE_CACHE_SZ, sizeof( struct RETROHTR_STYLE_CACHE ) );
+         tree->styles_cache_styles_ct = 0;
+      }
+      maug_mlock( tree->styles_cache_h, cache );
+      maug_cleanup_if_null_lock( struct RETROHTR_STYLE_CACHE*, cache );
 
-            retrohtr_merge_styles(
-               effect_style, parent_style, style, tag_type );
-         }
+      if(
+         0 == tree->styles_cache_styles_ct ||
+         mdata_vector_ct( &(parser->styler.styles) ) !=
+            tree->styles_cache_styles_ct
+      ) {
+         /* The stylesheet changed (or this is a new cache), so start over. */
+         maug_mzero( cache,
+            RETROHTR_STYLE_CACHE_SZ * sizeof( struct RETROHTR_STYLE_CACHE ) );
+         tree->styles_cache_styles_ct =
+            mdata_vector_ct( &(parser->styler.styles) );
+      }
+
+      cache_hash = retrohtr_style_cache_hash( p_tag_iter, parent_style );
+      if( retrohtr_style_cache_match(
+         &(cache[cache_hash & (RETROHTR_STYLE_CACHE_SZ - 1)]),
+         cache_hash, p_tag_iter, parent_style
+      ) ) {
+         maug_mcpy( effect_style,
+            &(cache[cache_hash & (RETROHTR_STYLE_CACHE_SZ - 1)].style),
+            sizeof( struct MCSS_STYLE ) );
+         goto cleanup;
       }
+      cachable = 1;
    }
+#endif /* RETROHTR_STYLE_CACHE_SZ */
 
-   /* Merge style based on HTML element ID. */
-   if( 0 < p_tag_iter->base.id_sz ) {
-      for( i = 0 ; mdata_vector_ct( &(parser->styler.styles) ) > i ; i++ ) {
-         style = mdata_vector_get(
-            &(parser->styler.styles), i, struct MCSS_STYLE );
-
-         if(
-            NULL != style &&
-            0 == maug_strncmp(
-               p_tag_iter->base.id,
-               style->id,
-               p_tag_iter->base.id_sz
-            )
-         ) {
-#if RETROHTR_TRACE_LVL > 0
-            debug_printf( RETROHTR_TRACE_LVL, "found style for tag ID: %s",
-               style->id );
-#endif /* RETROHTR_TRACE_LVL */
+   /* Merge style based on HTML element type. */
+   matches_sz = 0;
+   retval = mcss_select( &(parser->styler), MCSS_SELECT_TAG,
+      gc_mhtml_tag_names[tag_type], maug_strlen( gc_mhtml_tag_names[tag_type] ),
+      matches, &matches_sz, RETROHTR_STYLE_MATCHES_MAX );
+   maug_cleanup_if_not_ok();
+   retrohtr_merge_matches(
+      parser, effect_style, parent_style, tag_type, matches, matches_sz );
 
-            retrohtr_merge_styles(
-               effect_style, parent_style, style, tag_type );
-         }
+   /* Merge style based on each of the space-separated HTML element classes. */
+   matches_sz = 0;
+   for( i = 0 ; p_tag_iter->base.classes_sz >= i ; i++ ) {
+      if(
+         p_tag_iter->base.classes_sz != i &&
+         ' ' != p_tag_iter->base.classes[i]
+      ) {
+         continue;
+      }
+      if( i > class_start ) {
+         retval = mcss_select( &(parser->styler), MCSS_SELECT_CLASS,
+            &(p_tag_iter->base.classes[class_start]), i - class_start,
+            matches, &matches_sz, RETROHTR_STYLE_MATCHES_MAX );
+         maug_cleanup_if_not_ok();
+      }
+      class_start = i + 1;
+   }
+
+   /* Apply class styles in stylesheet order, as a scan would have. */
+   for( i = 1 ; matches_sz > i ; i++ ) {
+      match_swap = matches[i];
+      for( j = i ; 0 < j && matches[j - 1] > match_swap ; j-- ) {
+         matches[j] = matches[j - 1];
       }
+      matches[j] = match_swap;
    }
+   retrohtr_merge_matches(
+      parser, effect_style, parent_style, tag_type, matches, matches_sz );
+
+   /* Merge style based on HTML element ID. */
+   matches_sz = 0;
+   retval = mcss_select( &(parser->styler), MCSS_SELECT_ID,
+      p_tag_iter->base.id, p_tag_iter->base.id_sz,
+      matches, &matches_sz, RETROHTR_STYLE_MATCHES_MAX );
+   maug_cleanup_if_not_ok();
+   retrohtr_merge_matches(
+      parser, effect_style, parent_style, tag_type, matches, matches_sz );
 
    /* Grab element-specific style last. */
    tag_style_idx = p_tag_iter->base.style;
 
 cleanup:
 
+#if 0 < RETROHTR_STYLE_CACHE_SZ
+   if( cachable || NULL == cache ) {
+#endif /* RETROHTR_STYLE_CACHE_SZ */
+
    /* TODO: Separate this out of cleanup phase. */
 
    /* This might be NULL! */
@@ -635,6 +1050,19 @@ cleanup:
    /* Make sure we have a root style. */
    retrohtr_merge_styles( effect_style, parent_style, style, tag_type );
 
+#if 0 < RETROHTR_STYLE_CACHE_SZ
+   }
+
+   if( NULL != cache ) {
+      if( cachable && MERROR_OK == retval ) {
+         retrohtr_style_cache_store(
+            &(cache[cache_hash & (RETROHTR_STYLE_CACHE_SZ - 1)]),
+            cache_hash, p_tag_iter, parent_style, effect_style );
+      }
+      maug_munlock( tree->styles_cache_h, cache );
+   }
+#endif /* RETROHTR_STYLE_CACHE_SZ */
+
    mdata_vector_unlock( &(parser->tags) );
    mdata_vector_unlock( &(parser->styler.styles) );
 
@@ -759,6 +1187,12 @@ MERROR_RETVAL retrohtr_tree_size(
    union MHTML_TAG* p_tag_iter = NULL;
    union MHTML_TAG* p_tag_node = NULL;
    MAUG_MHANDLE font_h = (MAUG_MHANDLE)NULL;
+   retroflat_pxxy_t old_w = 0;
+   retroflat_pxxy_t old_h = 0;
+
+   if( 0 == d ) {
+      tree->nodes_sized = 0;
+   }
 
    if( NULL == retrohtr_node( tree, node_idx ) ) {
       goto cleanup;
@@ -770,6 +1204,27 @@ MERROR_RETVAL retrohtr_tree_size(
       parser, tree, parent_style, &effect_style, tag_idx );
    maug_cleanup_if_not_ok();
 
+   if(
+      RETROHTR_NODE_FLAG_DIRTY_SIZE !=
+         (RETROHTR_NODE_FLAG_DIRTY_SIZE & retrohtr_node( tree, node_idx )->flags)
+   ) {
+      /* Nothing in this subtree changed, so the last size still stands. */
+      goto cleanup;
+   }
+
+   tree->nodes_sized++;
+
+   /* Start over from scratch, or padding would pile up on every pass. */
+   old_w = retrohtr_node( tree, node_idx )->w;
+   old_h = retrohtr_node( tree, node_idx )->h;
+   if( 0 <= retrohtr_node( tree, node_idx )->parent ) {
+      retrohtr_node( tree, node_idx )->w = 0;
+      retrohtr_node( tree, node_idx )->h = 0;
+   } else {
+      retrohtr_node( tree, node_idx )->w = tree->root_w;
+      retrohtr_node( tree, node_idx )->h = tree->root_h;
+   }
+
    assert( !mdata_vector_is_locked( &(parser->tags) ) );
    mdata_vector_lock( &(parser->tags) );
 
@@ -810,12 +1265,18 @@ MERROR_RETVAL retrohtr_tree_size(
    
    /* Figure out how big the contents of this node are. */
 
-   /* Font is heritable, so load it for all nodes even if we don't use it. */
-   retval = retrohtr_load_font(
-      &(parser->styler),
-      &(retrohtr_node( tree, node_idx )->font),
-      &effect_style );
-   maug_cleanup_if_not_ok();
+   /* Font is heritable, so load it for all nodes even if we don't use it.
+    * (It may still be loaded from a previous pass.)
+    */
+   if(
+      !retrogxc_cachable_is_loaded( &(retrohtr_node( tree, node_idx )->font) )
+   ) {
+      retval = retrohtr_load_font(
+         &(parser->styler),
+         &(retrohtr_node( tree, node_idx )->font),
+         &effect_style );
+      maug_cleanup_if_not_ok();
+   }
 
    if( 0 <= tag_idx && MHTML_TAG_TYPE_TEXT == p_tag_iter->base.type ) {
       /* Get text size to use in calculations below. */
@@ -856,6 +1317,9 @@ MERROR_RETVAL retrohtr_tree_size(
 
       retval = retrohtr_tree_gui( tree, &(parser->styler), &effect_style );
 
+      /* Drop the control from the last pass, if any, before replacing it. */
+      retrogui_remove_ctl( &(tree->gui), node_idx );
+
       if(
          /* Use the same ID for the node and control it creates. */
          MERROR_OK != retrogui_init_ctl(
@@ -1040,11 +1504,25 @@ MERROR_RETVAL retrohtr_tree_size(
       retrohtr_node( tree, node_idx )->h += effect_style.PADDING;
    }
 
-#if RETROHTR_TRACE_LVL > 0
-   debug_printf( RETROHTR_TRACE_LVL,
-      "setting node " SIZE_T_FMT " dirty...", node_idx );
-#endif /* RETROHTR_TRACE_LVL */
-   retrohtr_node( tree, node_idx )->flags |= RETROHTR_NODE_FLAG_DIRTY;
+   retrohtr_node( tree, node_idx )->flags &=
+      ~(RETROHTR_NODE_FLAG_DIRTY_STYLE | RETROHTR_NODE_FLAG_DIRTY_SIZE);
+
+   if(
+      old_w != retrohtr_node( tree, node_idx )->w ||
+      old_h != retrohtr_node( tree, node_idx )->h
+   ) {
+      /* Siblings have to be moved to make room for the new size. */
+      retrohtr_tree_set_dirty( tree,
+         0 <= retrohtr_node( tree, node_idx )->parent ?
+            retrohtr_node( tree, node_idx )->parent : node_idx,
+         RETROHTR_NODE_FLAG_DIRTY_POS );
+
+      /* Ancestors of a changed node are resized to the same size often, so
+       * only repaint when it changed. New styles are repainted when placed.
+       */
+      retrohtr_tree_set_dirty(
+         tree, node_idx, RETROHTR_NODE_FLAG_DIRTY_PAINT );
+   }
 
 cleanup:
 
@@ -1203,6 +1681,13 @@ MERROR_RETVAL retrohtr_tree_pos(
    ssize_t prev_sibling_idx = -1;
    MERROR_RETVAL retval = MERROR_OK;
    union MHTML_TAG* p_tag_iter = NULL;
+   retroflat_pxxy_t old_x = 0;
+   retroflat_pxxy_t old_y = 0;
+   int moved = 0;
+
+   if( 0 == d ) {
+      tree->nodes_posed = 0;
+   }
 
    if( NULL == retrohtr_node( tree, node_idx ) ) {
       goto cleanup;
@@ -1213,6 +1698,31 @@ MERROR_RETVAL retrohtr_tree_pos(
    retrohtr_apply_styles(
       parser, tree, parent_style, &effect_style, tag_idx );
 
+   if(
+      RETROHTR_NODE_FLAG_DIRTY_POS !=
+         (RETROHTR_NODE_FLAG_DIRTY_POS & retrohtr_node( tree, node_idx )->flags)
+   ) {
+      if(
+         RETROHTR_NODE_FLAG_CHILD_POS ==
+            (RETROHTR_NODE_FLAG_CHILD_POS &
+               retrohtr_node( tree, node_idx )->flags)
+      ) {
+         /* This node stays put, but something below it is moving. */
+         goto pos_children;
+      }
+      goto cleanup;
+   }
+
+   tree->nodes_posed++;
+
+   old_x = retrohtr_node( tree, node_idx )->x;
+   old_y = retrohtr_node( tree, node_idx )->y;
+   if( 0 > retrohtr_node( tree, node_idx )->parent ) {
+      /* Start the root over, or its margins would pile up on every pass. */
+      retrohtr_node( tree, node_idx )->x = tree->root_x;
+      retrohtr_node( tree, node_idx )->y = tree->root_y;
+   }
+
    prev_sibling_idx =
       retrohtr_find_prev_sibling_in_box_model( tree, node_idx );
 
@@ -1401,6 +1911,32 @@ MERROR_RETVAL retrohtr_tree_pos(
       retrohtr_node( tree, node_idx )->bg = effect_style.BACKGROUND_COLOR;
    }
 
+   retrohtr_node( tree, node_idx )->flags &= ~RETROHTR_NODE_FLAG_DIRTY_POS;
+
+   moved =
+      old_x != retrohtr_node( tree, node_idx )->x ||
+      old_y != retrohtr_node( tree, node_idx )->y;
+
+   if( moved ) {
+      /* Inline neighbors are placed relative to this node. */
+      retrohtr_tree_set_dirty( tree,
+         retrohtr_node( tree, node_idx )->next_sibling,
+         RETROHTR_NODE_FLAG_DIRTY_POS );
+   }
+
+   /* Repaint even if we didn't move, as our size may have changed. */
+   retrohtr_tree_set_dirty( tree, node_idx, RETROHTR_NODE_FLAG_DIRTY_PAINT );
+
+   /* Children are placed relative to this node and its size. */
+   node_iter_idx = retrohtr_node( tree, node_idx )->first_child;
+   while( 0 <= node_iter_idx ) {
+      retrohtr_node( tree, node_iter_idx )->flags |=
+         RETROHTR_NODE_FLAG_DIRTY_POS;
+      node_iter_idx = retrohtr_node( tree, node_iter_idx )->next_sibling;
+   }
+
+pos_children:
+
    /* Figure out child positions. */
 
    retrohtr_mark_edge_child_nodes( parser, tree, node_idx );
@@ -1418,6 +1954,8 @@ MERROR_RETVAL retrohtr_tree_pos(
       node_iter_idx = retrohtr_node( tree, node_iter_idx )->next_sibling;
    }
 
+   retrohtr_node( tree, node_idx )->flags &= ~RETROHTR_NODE_FLAG_CHILD_POS;
+
    assert( !mdata_vector_is_locked( &(parser->tags) ) );
    mdata_vector_lock( &(parser->tags) );
    p_tag_iter = mdata_vector_get( &(parser->tags), tag_idx, union MHTML_TAG );
@@ -1432,12 +1970,6 @@ MERROR_RETVAL retrohtr_tree_pos(
          retrohtr_node( tree, node_idx )->h );
       maug_cleanup_if_not_ok();
    }
-
-#if RETROHTR_TRACE_LVL > 0
-   debug_printf( RETROHTR_TRACE_LVL,
-      "setting node " SIZE_T_FMT " dirty...", node_idx );
-#endif /* RETROHTR_TRACE_LVL */
-   retrohtr_node( tree, node_idx )->flags |= RETROHTR_NODE_FLAG_DIRTY;
  
 cleanup:
 
@@ -1467,6 +1999,8 @@ MERROR_RETVAL retrohtr_tree_draw(
    struct RETROHTR_RENDER_NODE* node = NULL;
    MERROR_RETVAL retval = MERROR_OK;
    MAUG_MHANDLE font_h = (MAUG_MHANDLE)NULL;
+   ssize_t child_iter_idx = -1;
+   int painted = 0;
 
    node = retrohtr_node( tree, node_idx );
 
@@ -1474,6 +2008,13 @@ MERROR_RETVAL retrohtr_tree_draw(
       return MERROR_OK;
    }
 
+   /* Only reset on a real node, as the walk over the root's siblings below
+    * also comes back through here at depth 0.
+    */
+   if( 0 == d ) {
+      tree->nodes_drawn = 0;
+   }
+
    /* TODO: Multi-pass, draw absolute pos afterwards. */
 
    if( 0 > node->tag ) {
@@ -1484,6 +2025,13 @@ MERROR_RETVAL retrohtr_tree_draw(
       goto cleanup;
    }
 
+   /* Even if there's nothing to draw, consider this node painted so its
+    * children are painted over it below.
+    */
+   painted = 1;
+   tree->nodes_drawn++;
+   node->flags &= ~RETROHTR_NODE_FLAG_DIRTY;
+
    assert( !mdata_vector_is_locked( &(parser->tags) ) );
    mdata_vector_lock( &(parser->tags) );
 
@@ -1592,8 +2140,6 @@ MERROR_RETVAL retrohtr_tree_draw(
          RETROFLAT_DRAW_FLAG_FILL );
    }
 
-   node->flags &= ~RETROHTR_NODE_FLAG_DIRTY;
-
 cleanup:
 
    if( mdata_vector_is_locked( &(parser->tags) ) ) {
@@ -1606,7 +2152,24 @@ cleanup:
 
    /* Keep trying to render children, tho. */  
 
-   retrohtr_tree_draw( parser, tree, node->first_child, d + 1 );
+   if( painted ) {
+      /* Anything under this node has just been painted over. */
+      child_iter_idx = node->first_child;
+      while( 0 <= child_iter_idx ) {
+         retrohtr_node( tree, child_iter_idx )->flags |=
+            RETROHTR_NODE_FLAG_DIRTY;
+         child_iter_idx = retrohtr_node( tree, child_iter_idx )->next_sibling;
+      }
+   }
+
+   if(
+      painted ||
+      RETROHTR_NODE_FLAG_CHILD_PAINT ==
+         (RETROHTR_NODE_FLAG_CHILD_PAINT & node->flags)
+   ) {
+      node->flags &= ~RETROHTR_NODE_FLAG_CHILD_PAINT;
+      retrohtr_tree_draw( parser, tree, node->first_child, d + 1 );
+   }
 
    retrohtr_tree_draw( parser, tree, node->next_sibling, d );
 
@@ -1649,7 +2212,7 @@ retrogui_idc_t retrohtr_tree_poll_ctls(
       debug_printf(
          RETROHTR_TRACE_LVL, "setting node " SIZE_T_FMT " dirty...", idc );
 #endif /* RETROHTR_TRACE_LVL */
-      retrohtr_node( tree, idc )->flags |= RETROHTR_NODE_FLAG_DIRTY;
+      retrohtr_tree_set_dirty( tree, idc, RETROHTR_NODE_FLAG_DIRTY_PAINT );
    }
 
    if( MERROR_OK != retval ) {
@@ -1741,6 +2304,12 @@ void retrohtr_tree_free( struct RETROHTR_RENDER_TREE* tree ) {
       retrogui_destroy( &(tree->gui) );
    }
 
+#if 0 < RETROHTR_STYLE_CACHE_SZ
+   if( (MAUG_MHANDLE)NULL != tree->styles_cache_h ) {
+      maug_mfree( tree->styles_cache_h );
+   }
+#endif /* RETROHTR_STYLE_CACHE_SZ */
+
    /* Unlock nodes before trying to free them. */
    retrohtr_tree_unlock( tree );
 
@@ -44,6 +44,17 @@ typedef void (*retroflat_px_cb)(
    retroflat_blit_t* target, const RETROFLAT_COLOR color_idx,
    size_t x, size_t y, uint8_t flags );
 
+/**
+ * \brief Type of callback function used to fill a horizontal run of w pixels
+ *        starting at x, y on a surface.
+ *
+ * Callers must clip the span to the surface first, so implementations can
+ * write the whole run without checking each pixel.
+ */
+typedef void (*retroflat_span_cb)(
+   retroflat_blit_t* target, const RETROFLAT_COLOR color_idx,
+   size_t x, size_t y, size_t w, uint8_t flags );
+
 typedef void (*retroflat_line_cb)(
    retroflat_blit_t* target, const RETROFLAT_COLOR color,
    int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t flags );
@@ -76,6 +87,15 @@ typedef MERROR_RETVAL (*retroflat_create_bitmap_cb)(
 RETROFLT_CB_EXTERN
 retroflat_px_cb SEG_MGLOBAL retroflat_2d_px RETROFLT_CB_INIT;
 
+/**
+ * \brief Directly addressable callback to fill horizontal spans on a surface.
+ *
+ * This is retroflat_span() on platforms that define RETROFLAT_NATIVE_SPAN,
+ * or retrosoft_span() (one retroflat_2d_px() per pixel) otherwise.
+ */
+RETROFLT_CB_EXTERN
+retroflat_span_cb SEG_MGLOBAL retroflat_2d_span RETROFLT_CB_INIT;
+
 RETROFLT_CB_EXTERN
 retroflat_line_cb SEG_MGLOBAL retroflat_2d_line RETROFLT_CB_INIT;
 
@@ -19,19 +19,98 @@
 #  define RETROTILE_PATH_LIST_MAX 20
 #endif /* !RETROTILE_PATH_LIST_MAX */
 
+#ifdef RETROTILE_PATH_COST_16
+/*! \brief Path cost type. Define RETROTILE_PATH_COST_16 to save memory. */
+typedef uint16_t retrotile_path_cost_t;
+#  define RETROTILE_PATH_COST_MAX 0xffff
+#else
+typedef uint32_t retrotile_path_cost_t;
+#  define RETROTILE_PATH_COST_MAX 0xffffffffUL
+#endif /* RETROTILE_PATH_COST_16 */
+
+/**
+ * \brief Cost of an orthogonal step for retrotile_path_find().
+ *
+ * Diagonal steps cost ::RETROTILE_PATH_COST_DIAG, so these are scaled up to
+ * keep the ratio near sqrt(2) in integer math.
+ */
+#define RETROTILE_PATH_COST_ORTHO 10
+
+/*! \brief Cost of a diagonal step for retrotile_path_find(). */
+#define RETROTILE_PATH_COST_DIAG 14
+
+/**
+ * \brief Flag for retrotile_path_find() allowing diagonal movement using
+ *        ::gc_retroflat_offsets8_x and ::gc_retroflat_offsets8_y.
+ *
+ * Diagonal steps are only taken if both orthogonal steps that make them up
+ * are not blocked, so paths don't cut corners.
+ */
+#define RETROTILE_PATH_FLAG_8DIR 0x01
+
+/*! \brief Value of RETROTILE_PATH_POOL_NODE::parent for the start tile. */
+#define RETROTILE_PATH_NO_PARENT 0xffffffffUL
+
 struct RETROTILE_PATH_NODE {
    uint16_t x;
    uint16_t y;
    /*! \brief Total node cost. */
-   uint8_t f;
+   retrotile_path_cost_t f;
    /*! \brief Distance from node to pathfinding start. */
-   uint8_t g; 
+   retrotile_path_cost_t g; 
    /*! \brief Estimated distance from node to pathfinding target. */
-   uint8_t h;
+   retrotile_path_cost_t h;
    /*! \brief Direction of this node from its parent. */
    int8_t dir;
 };
 
+/**
+ * \brief Per-tile search state used by retrotile_path_find().
+ */
+struct RETROTILE_PATH_POOL_NODE {
+   /*! \brief Distance from node to pathfinding start. */
+   retrotile_path_cost_t g;
+   /*! \brief Total node cost. */
+   retrotile_path_cost_t f;
+   /*! \brief Tile index (y * w + x) this node was reached from. */
+   uint32_t parent;
+   /*! \brief Index of this node in RETROTILE_PATH_POOL::heap while open. */
+   uint32_t heap_idx;
+   /*! \brief Direction (\ref retroflat_dir8_t) of this node from its parent. */
+   int8_t dir;
+};
+
+/**
+ * \brief Reusable memory for retrotile_path_find(), sized to a tilemap.
+ *
+ * This should be zeroed before the first call to retrotile_path_pool_init()
+ * and can then be kept around and reused for as many searches as needed, so
+ * pathfinding doesn't allocate.
+ */
+struct RETROTILE_PATH_POOL {
+   /*! \brief Number of tiles the buffers below are allocated for. */
+   size_t tiles_sz_max;
+   size_t tiles_w;
+   size_t tiles_h;
+   /*! \brief One ::RETROTILE_PATH_POOL_NODE per tile. */
+   MAUG_MHANDLE nodes_h;
+   struct RETROTILE_PATH_POOL_NODE* nodes;
+   /*! \brief Binary min-heap of open tile indexes, ordered by cost. */
+   MAUG_MHANDLE heap_h;
+   uint32_t* heap;
+   size_t heap_sz;
+   /**
+    * \brief Two bitmaps, each with one bit per tile: tiles that have been
+    *        seen by the current search, then tiles that have been closed.
+    */
+   MAUG_MHANDLE bits_h;
+   uint8_t* bits;
+   /*! \brief Size of each bitmap in RETROTILE_PATH_POOL::bits_h in bytes. */
+   size_t bits_sz;
+   /*! \brief Number of tiles expanded by the last search (for profiling). */
+   size_t last_expanded;
+};
+
 typedef int8_t RETROTILE_RETVAL;
 
 typedef RETROTILE_RETVAL (*retrotile_blocked_cb)(
@@ -54,6 +133,162 @@ MERROR_RETVAL retrotile_path_start(
    struct RETROTILE* t, uint8_t flags,
    retrotile_blocked_cb blocked_cb, void* blocked_cb_data );
 
+/**
+ * \brief Size a ::RETROTILE_PATH_POOL for a tilemap of the given dimensions.
+ *
+ * If the pool is already big enough, it is reused as-is.
+ */
+MERROR_RETVAL retrotile_path_pool_init(
+   struct RETROTILE_PATH_POOL* pool, size_t tiles_w, size_t tiles_h );
+
+void retrotile_path_pool_free( struct RETROTILE_PATH_POOL* pool );
+
+/**
+ * \brief Find a path across the given tilemap with A* that scales to the
+ *        whole map.
+ *
+ * Unlike retrotile_path_start(), this keeps its state in a
+ * ::RETROTILE_PATH_POOL with a binary heap for the open set and a bitmap for
+ * the closed set, so paths are only limited by the map size.
+ *
+ * \param pool Pool initialized with retrotile_path_pool_init() for this map.
+ * \param path Array to hold the path, in order, starting from the first step
+ *             after the start tile and ending on the target. If the path is
+ *             longer than path_sz_max, only the first path_sz_max steps are
+ *             returned.
+ * \param flags Bitwise combination of ::RETROTILE_PATH_FLAG_8DIR, etc.
+ * \param blocked_cb Callback called with the tile being moved from and the
+ *                   \ref retroflat_dir8_t being moved in, even when moving in
+ *                   4 directions.
+ * \return ::MERROR_OK if a path was found, or ::RETROTILE_RETVAL_BLOCKED if
+ *         the target could not be reached.
+ */
+MERROR_RETVAL retrotile_path_find(
+   struct RETROTILE_PATH_POOL* pool,
+   uint16_t start_x, uint16_t start_y,
+   uint16_t tgt_x, uint16_t tgt_y,
+   struct RETROTILE_PATH_NODE* path,
+   size_t* p_path_sz, size_t path_sz_max,
+   struct RETROTILE* t, uint8_t flags,
+   retrotile_blocked_cb blocked_cb, void* blocked_cb_data );
+
+/**
+ * \addtogroup dsekai_pathfind_flow Flow Fields
+ * \brief Shared distance fields for routing many agents to the same targets.
+ *
+ * A ::RETROTILE_FLOW holds the distance from every tile to the nearest of a
+ * set of targets, along with the direction to step in to get closer. It is
+ * built once with retrotile_flow_update() and can then be queried by any
+ * number of agents with retrotile_flow_dir(), which is a single lookup.
+ *
+ * A tile is considered impassible if its ::RETROTILE_TILE_DEF in the
+ * flow's tile defs has ::RETROTILE_TILE_FLAG_BLOCK set (tile values are
+ * converted to tile def indexes by subtracting RETROTILE::tileset_fgid) or
+ * if the optional ::retrotile_blocked_cb says so. Targets are always
+ * reachable, even if their tile blocks (e.g. doors).
+ * \{
+ */
+
+#ifndef RETROTILE_FLOW_TARGETS_MAX
+/*! \brief Maximum number of targets a single ::RETROTILE_FLOW can track. */
+#  define RETROTILE_FLOW_TARGETS_MAX 8
+#endif /* !RETROTILE_FLOW_TARGETS_MAX */
+
+/*! \brief Distance for tiles that cannot reach any target in a flow field. */
+#define RETROTILE_FLOW_DIST_NONE 0xffff
+
+/**
+ * \brief Flag for RETROTILE_FLOW::flags indicating the field must be rebuilt
+ *        by the next call to retrotile_flow_update(). Should only be set
+ *        internally!
+ */
+#define RETROTILE_FLOW_FLAG_DIRTY 0x80
+
+struct RETROTILE_FLOW {
+   /*! \brief ::RETROTILE_PATH_FLAG_8DIR and ::RETROTILE_FLOW_FLAG_DIRTY. */
+   uint8_t flags;
+   size_t tiles_w;
+   size_t tiles_h;
+   /*! \brief Index of the layer whose tiles decide what is passable. */
+   size_t layer_idx;
+   /*! \brief Tile defs for the tilemap, or NULL to ignore tile flags. */
+   struct MDATA_VECTOR* p_tile_defs;
+   retrotile_blocked_cb blocked_cb;
+   void* blocked_cb_data;
+   struct RETROTILE_COORDS targets[RETROTILE_FLOW_TARGETS_MAX];
+   size_t targets_sz;
+   /*! \brief Steps from each tile to the nearest target. */
+   MAUG_MHANDLE dist_h;
+   /*! \brief \ref retroflat_dir8_t to step in from each tile. */
+   MAUG_MHANDLE dir_h;
+   /*! \brief Scratch queue of tile indexes for building the field. */
+   MAUG_MHANDLE queue_h;
+   /*! \brief Number of full rebuilds performed (for profiling). */
+   size_t rebuilds;
+   /*! \brief Number of tile changes handled without a rebuild. */
+   size_t patches;
+};
+
+/**
+ * \brief Allocate a flow field for the given tilemap.
+ * \param flow Zeroed ::RETROTILE_FLOW to initialize.
+ * \param flags ::RETROTILE_PATH_FLAG_8DIR to allow diagonal steps.
+ */
+MERROR_RETVAL retrotile_flow_init(
+   struct RETROTILE_FLOW* flow, struct RETROTILE* t, size_t layer_idx,
+   struct MDATA_VECTOR* p_tile_defs, uint8_t flags,
+   retrotile_blocked_cb blocked_cb, void* blocked_cb_data );
+
+void retrotile_flow_free( struct RETROTILE_FLOW* flow );
+
+/**
+ * \brief Add a target to the flow field. The field will be rebuilt on the
+ *        next call to retrotile_flow_update().
+ */
+MERROR_RETVAL retrotile_flow_add_target(
+   struct RETROTILE_FLOW* flow, retrotile_coord_t x, retrotile_coord_t y );
+
+void retrotile_flow_clear_targets( struct RETROTILE_FLOW* flow );
+
+/**
+ * \brief Rebuild the flow field if targets or blocking tiles have changed
+ *        since it was last built. This is cheap to call every tick.
+ * \param t Locked tilemap the flow field was initialized for.
+ */
+MERROR_RETVAL retrotile_flow_update(
+   struct RETROTILE_FLOW* flow, struct RETROTILE* t );
+
+/**
+ * \brief Set a tile on the given layer, patching the flow field in place
+ *        where possible rather than rebuilding it.
+ *
+ * Changes that don't alter whether the tile blocks are ignored. Tiles that
+ * open up are flooded out from locally. Tiles that close are only rebuilt
+ * if other tiles were routed through them.
+ */
+MERROR_RETVAL retrotile_flow_set_tile(
+   struct RETROTILE_FLOW* flow, struct RETROTILE* t,
+   struct RETROTILE_LAYER* layer, retrotile_coord_t x, retrotile_coord_t y,
+   retroflat_tile_t new_val );
+
+/**
+ * \brief Get the direction to step from the given tile to get closer to the
+ *        nearest target.
+ * \return A \ref retroflat_dir8_t, or ::RETROFLAT_DIR8_NONE if the tile is a
+ *         target or cannot reach one.
+ */
+retroflat_dir8_t retrotile_flow_dir(
+   struct RETROTILE_FLOW* flow, retrotile_coord_t x, retrotile_coord_t y );
+
+/**
+ * \brief Get the number of steps from the given tile to the nearest target.
+ * \return The distance, or ::RETROTILE_FLOW_DIST_NONE if unreachable.
+ */
+uint16_t retrotile_flow_dist(
+   struct RETROTILE_FLOW* flow, retrotile_coord_t x, retrotile_coord_t y );
+
+/*! \} */ /* dsekai_pathfind_flow */
+
 /*! \} */ /* dsekai_pathfind */
 
 #ifdef RETROTIL_C
@@ -338,6 +573,987 @@ cleanup:
    return retval;
 }
 
+/* === */
+
+MERROR_RETVAL retrotile_path_pool_init(
+   struct RETROTILE_PATH_POOL* pool, size_t tiles_w, size_t tiles_h
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t tiles_sz = tiles_w * tiles_h;
+
+   if( 0 == tiles_sz || RETROTILE_PATH_NO_PARENT <= tiles_sz ) {
+      error_printf( "invalid pathfinding pool size: " SIZE_T_FMT " x "
+         SIZE_T_FMT, tiles_w, tiles_h );
+      retval = MERROR_OVERFLOW;
+      goto cleanup;
+   }
+
+   if( tiles_sz <= pool->tiles_sz_max ) {
+      /* Pool is already big enough. */
+      goto cleanup;
+   }
+
+   retrotile_path_pool_free( pool );
+
+   debug_printf( RETROTILE_PATH_TRACE_LVL,
+      "allocating pathfinding pool for " SIZE_T_FMT " tiles...", tiles_sz );
+
+   maug_malloc_test(
+      pool->nodes_h, tiles_sz, sizeof( struct RETROTILE_PATH_POOL_NODE ) );
+   maug_malloc_test( pool->heap_h, tiles_sz, sizeof( uint32_t ) );
+   pool->bits_sz = (tiles_sz + 7) / 8;
+   maug_malloc_test( pool->bits_h, 2, pool->bits_sz );
+
+   pool->tiles_sz_max = tiles_sz;
+
+cleanup:
+
+   if( MERROR_OK == retval ) {
+      pool->tiles_w = tiles_w;
+      pool->tiles_h = tiles_h;
+   } else {
+      retrotile_path_pool_free( pool );
+   }
+
+   return retval;
+}
+
+/* === */
+
+void retrotile_path_pool_free( struct RETROTILE_PATH_POOL* pool ) {
+   if( (MAUG_MHANDLE)NULL != pool->nodes_h ) {
+      maug_mfree( pool->nodes_h );
+   }
+   if( (MAUG_MHANDLE)NULL != pool->heap_h ) {
+      maug_mfree( pool->heap_h );
+   }
+   if( (MAUG_MHANDLE)NULL != pool->bits_h ) {
+      maug_mfree( pool->bits_h );
+   }
+   maug_mzero( pool, sizeof( struct RETROTILE_PATH_POOL ) );
+}
+
+/* === */
+
+#define retrotile_path_bit_test( bits, idx ) \
+   (0 != ((bits)[(idx) >> 3] & (1 << ((idx) & 0x07))))
+
+#define retrotile_path_bit_set( bits, idx ) \
+   (bits)[(idx) >> 3] |= (1 << ((idx) & 0x07))
+
+/* Open nodes with lower f come first. On ties, prefer nodes closer to the
+ * target (higher g), which keeps the search from fanning out.
+ */
+#define retrotile_path_heap_lt( pool, a, b ) \
+   ((pool)->nodes[a].f < (pool)->nodes[b].f || \
+   ((pool)->nodes[a].f == (pool)->nodes[b].f && \
+      (pool)->nodes[a].g > (pool)->nodes[b].g))
+
+static void retrotile_path_heap_place(
+   struct RETROTILE_PATH_POOL* pool, size_t heap_idx, uint32_t tile_idx
+) {
+   pool->heap[heap_idx] = tile_idx;
+   pool->nodes[tile_idx].heap_idx = heap_idx;
+}
+
+/* === */
+
+static void retrotile_path_heap_up(
+   struct RETROTILE_PATH_POOL* pool, size_t heap_idx
+) {
+   uint32_t tile_idx = pool->heap[heap_idx];
+   size_t parent_idx = 0;
+
+   while( 0 < heap_idx ) {
+      parent_idx = (heap_idx - 1) / 2;
+      if( !retrotile_path_heap_lt( pool, tile_idx, pool->heap[parent_idx] ) ) {
+         break;
+      }
+      retrotile_path_heap_place( pool, heap_idx, pool->heap[parent_idx] );
+      heap_idx = parent_idx;
+   }
+
+   retrotile_path_heap_place( pool, heap_idx, tile_idx );
+}
+
+/* === */
+
+static uint32_t retrotile_path_heap_pop( struct RETROTILE_PATH_POOL* pool ) {
+   uint32_t top_idx = pool->heap[0];
+   uint32_t tile_idx = 0;
+   size_t heap_idx = 0;
+   size_t child_idx = 0;
+
+   assert( 0 < pool->heap_sz );
+
+   pool->heap_sz--;
+   if( 0 == pool->heap_sz ) {
+      goto cleanup;
+   }
+
+   /* Sift the last node down from the top. */
+   tile_idx = pool->heap[pool->heap_sz];
+   for( ;; ) {
+      child_idx = (heap_idx * 2) + 1;
+      if( child_idx >= pool->heap_sz ) {
+         break;
+      }
+      if(
+         child_idx + 1 < pool->heap_sz &&
+         retrotile_path_heap_lt(
+            pool, pool->heap[child_idx + 1], pool->heap[child_idx] )
+      ) {
+         child_idx++;
+      }
+      if( !retrotile_path_heap_lt( pool, pool->heap[child_idx], tile_idx ) ) {
+         break;
+      }
+      retrotile_path_heap_place( pool, heap_idx, pool->heap[child_idx] );
+      heap_idx = child_idx;
+   }
+   retrotile_path_heap_place( pool, heap_idx, tile_idx );
+
+cleanup:
+
+   return top_idx;
+}
+
+/* === */
+
+static retrotile_path_cost_t retrotile_path_heuristic(
+   uint16_t x, uint16_t y, uint16_t tgt_x, uint16_t tgt_y, uint8_t flags
+) {
+   retrotile_path_cost_t dx = 0;
+   retrotile_path_cost_t dy = 0;
+
+   dx = x > tgt_x ? x - tgt_x : tgt_x - x;
+   dy = y > tgt_y ? y - tgt_y : tgt_y - y;
+
+   if( RETROTILE_PATH_FLAG_8DIR == (RETROTILE_PATH_FLAG_8DIR & flags) ) {
+      /* Octile distance: diagonal as far as possible, then straight. */
+      if( dx < dy ) {
+         return (RETROTILE_PATH_COST_DIAG * dx) +
+            (RETROTILE_PATH_COST_ORTHO * (dy - dx));
+      } else {
+         return (RETROTILE_PATH_COST_DIAG * dy) +
+            (RETROTILE_PATH_COST_ORTHO * (dx - dy));
+      }
+   }
+
+   /* Manhattan distance, since we can only move in 4 dirs. */
+   return RETROTILE_PATH_COST_ORTHO * (dx + dy);
+}
+
+/* === */
+
+MERROR_RETVAL retrotile_path_find(
+   struct RETROTILE_PATH_POOL* pool,
+   uint16_t start_x, uint16_t start_y,
+   uint16_t tgt_x, uint16_t tgt_y,
+   struct RETROTILE_PATH_NODE* path,
+   size_t* p_path_sz, size_t path_sz_max,
+   struct RETROTILE* t, uint8_t flags,
+   retrotile_blocked_cb blocked_cb, void* blocked_cb_data
+) {
+   MERROR_RETVAL retval = RETROTILE_RETVAL_BLOCKED;
+   uint32_t iter_idx = 0;
+   uint32_t adj_idx = 0;
+   uint32_t tgt_idx = 0;
+   uint16_t iter_x = 0;
+   uint16_t iter_y = 0;
+   int32_t adj_x = 0;
+   int32_t adj_y = 0;
+   uint8_t blocked_dirs = 0;
+   uint8_t dir_step = 2;
+   uint8_t* closed = NULL;
+   retrotile_path_cost_t adj_g = 0;
+   retrotile_path_cost_t adj_h = 0;
+   retrotile_path_cost_t step_cost = 0;
+   size_t path_len = 0;
+   size_t i = 0;
+   int8_t dir = 0;
+
+   *p_path_sz = 0;
+
+   assert( pool->tiles_w == t->tiles_w );
+   assert( pool->tiles_h == t->tiles_h );
+
+   if(
+      start_x >= t->tiles_w || start_y >= t->tiles_h ||
+      tgt_x >= t->tiles_w || tgt_y >= t->tiles_h
+   ) {
+      error_printf( "pathfinding coordinates outside of tilemap!" );
+      retval = MERROR_OVERFLOW;
+      goto cleanup;
+   }
+
+   maug_mlock( pool->nodes_h, pool->nodes );
+   maug_cleanup_if_null_lock( struct RETROTILE_PATH_POOL_NODE*, pool->nodes );
+   maug_mlock( pool->heap_h, pool->heap );
+   maug_cleanup_if_null_lock( uint32_t*, pool->heap );
+   maug_mlock( pool->bits_h, pool->bits );
+   maug_cleanup_if_null_lock( uint8_t*, pool->bits );
+
+   /* Only the bitmaps need clearing. Nodes are set up when first seen. */
+   maug_mzero( pool->bits, pool->bits_sz * 2 );
+   closed = &(pool->bits[pool->bits_sz]);
+   pool->heap_sz = 0;
+   pool->last_expanded = 0;
+
+   if( RETROTILE_PATH_FLAG_8DIR == (RETROTILE_PATH_FLAG_8DIR & flags) ) {
+      dir_step = 1;
+   }
+
+   debug_printf( RETROTILE_PATH_TRACE_LVL, "---BEGIN PATHFIND---" );
+   debug_printf( RETROTILE_PATH_TRACE_LVL,
+      "pathfinding from %d, %d to %d, %d...", start_x, start_y, tgt_x, tgt_y );
+
+   /* Add the start node to the open list. */
+   iter_idx = (start_y * t->tiles_w) + start_x;
+   tgt_idx = (tgt_y * t->tiles_w) + tgt_x;
+   pool->nodes[iter_idx].g = 0;
+   pool->nodes[iter_idx].f = retrotile_path_heuristic(
+      start_x, start_y, tgt_x, tgt_y, flags );
+   pool->nodes[iter_idx].parent = RETROTILE_PATH_NO_PARENT;
+   pool->nodes[iter_idx].dir = RETROFLAT_DIR8_NONE;
+   retrotile_path_bit_set( pool->bits, iter_idx );
+   retrotile_path_heap_place( pool, 0, iter_idx );
+   pool->heap_sz = 1;
+
+   while( 0 < pool->heap_sz ) {
+      iter_idx = retrotile_path_heap_pop( pool );
+      retrotile_path_bit_set( closed, iter_idx );
+      pool->last_expanded++;
+
+      if( iter_idx == tgt_idx ) {
+         debug_printf( RETROTILE_PATH_TRACE_LVL, "> target reached!" );
+         retval = MERROR_OK;
+         break;
+      }
+
+      iter_x = iter_idx % t->tiles_w;
+      iter_y = iter_idx / t->tiles_w;
+      blocked_dirs = 0;
+
+      /* Test orthogonal directions first so diagonals can check them. */
+      for( i = 0 ; 8 > i ; i += dir_step ) {
+         if( 2 == dir_step ) {
+            dir = i;
+         } else {
+            /* Visit 0, 2, 4, 6, then 1, 3, 5, 7. */
+            dir = (i < 4 ? i * 2 : ((i - 4) * 2) + 1);
+         }
+
+         adj_x = iter_x + gc_retroflat_offsets8_x[dir];
+         adj_y = iter_y + gc_retroflat_offsets8_y[dir];
+
+         /* Don't wander off the map! */
+         if(
+            0 > adj_x || 0 > adj_y ||
+            t->tiles_w <= (size_t)adj_x || t->tiles_h <= (size_t)adj_y
+         ) {
+            blocked_dirs |= (1 << dir);
+            continue;
+         }
+
+         adj_idx = (adj_y * t->tiles_w) + adj_x;
+         if( retrotile_path_bit_test( closed, adj_idx ) ) {
+            continue;
+         }
+
+         if( 0x01 == (dir & 0x01) ) {
+            /* Don't cut corners around blocked orthogonal tiles. */
+            if(
+               (blocked_dirs & (1 << ((dir + 7) & 0x07))) ||
+               (blocked_dirs & (1 << ((dir + 1) & 0x07)))
+            ) {
+               continue;
+            }
+            step_cost = RETROTILE_PATH_COST_DIAG;
+         } else {
+            step_cost = RETROTILE_PATH_COST_ORTHO;
+         }
+
+         if(
+            NULL != blocked_cb &&
+            RETROTILE_RETVAL_BLOCKED == blocked_cb(
+               iter_x, iter_y, dir, t, blocked_cb_data )
+         ) {
+            blocked_dirs |= (1 << dir);
+            continue;
+         }
+
+         if( RETROTILE_PATH_COST_MAX - step_cost < pool->nodes[iter_idx].g ) {
+            error_printf( "path cost overflow!" );
+            retval = MERROR_OVERFLOW;
+            goto cleanup;
+         }
+         adj_g = pool->nodes[iter_idx].g + step_cost;
+
+         if( !retrotile_path_bit_test( pool->bits, adj_idx ) ) {
+            /* First time seeing this tile, so open it. */
+            retrotile_path_bit_set( pool->bits, adj_idx );
+            adj_h = retrotile_path_heuristic(
+               adj_x, adj_y, tgt_x, tgt_y, flags );
+            pool->nodes[adj_idx].g = adj_g;
+            if( RETROTILE_PATH_COST_MAX - adj_h < adj_g ) {
+               pool->nodes[adj_idx].f = RETROTILE_PATH_COST_MAX;
+            } else {
+               pool->nodes[adj_idx].f = adj_g + adj_h;
+            }
+            pool->nodes[adj_idx].parent = iter_idx;
+            pool->nodes[adj_idx].dir = dir;
+            retrotile_path_heap_place( pool, pool->heap_sz, adj_idx );
+            pool->heap_sz++;
+            retrotile_path_heap_up( pool, pool->heap_sz - 1 );
+
+         } else if( adj_g < pool->nodes[adj_idx].g ) {
+            /* Found a cheaper way to an open tile. */
+            pool->nodes[adj_idx].f -= pool->nodes[adj_idx].g - adj_g;
+            pool->nodes[adj_idx].g = adj_g;
+            pool->nodes[adj_idx].parent = iter_idx;
+            pool->nodes[adj_idx].dir = dir;
+            retrotile_path_heap_up( pool, pool->nodes[adj_idx].heap_idx );
+         }
+      }
+   }
+
+   if( MERROR_OK != retval ) {
+      debug_printf( RETROTILE_PATH_TRACE_LVL,
+         "> blocked! (expanded " SIZE_T_FMT " tiles)", pool->last_expanded );
+      goto cleanup;
+   }
+
+   /* Count the steps back to the start. */
+   for(
+      iter_idx = tgt_idx ;
+      RETROTILE_PATH_NO_PARENT != pool->nodes[iter_idx].parent ;
+      iter_idx = pool->nodes[iter_idx].parent
+   ) {
+      path_len++;
+   }
+
+   /* Walk back again, writing out the steps that fit in order. */
+   i = path_len;
+   for(
+      iter_idx = tgt_idx ;
+      RETROTILE_PATH_NO_PARENT != pool->nodes[iter_idx].parent ;
+      iter_idx = pool->nodes[iter_idx].parent
+   ) {
+      i--;
+      if( i >= path_sz_max ) {
+         continue;
+      }
+      path[i].x = iter_idx % t->tiles_w;
+      path[i].y = iter_idx / t->tiles_w;
+      path[i].g = pool->nodes[iter_idx].g;
+      path[i].f = pool->nodes[iter_idx].f;
+      path[i].h = pool->nodes[iter_idx].f - pool->nodes[iter_idx].g;
+      path[i].dir = pool->nodes[iter_idx].dir;
+   }
+
+   *p_path_sz = path_len < path_sz_max ? path_len : path_sz_max;
+
+   debug_printf( RETROTILE_PATH_TRACE_LVL,
+      "> path is " SIZE_T_FMT " steps (expanded " SIZE_T_FMT " tiles)",
+      path_len, pool->last_expanded );
+
+cleanup:
+
+   if( NULL != pool->bits ) {
+      maug_munlock( pool->bits_h, pool->bits );
+   }
+
+   if( NULL != pool->heap ) {
+      maug_munlock( pool->heap_h, pool->heap );
+   }
+
+   if( NULL != pool->nodes ) {
+      maug_munlock( pool->nodes_h, pool->nodes );
+   }
+
+   debug_printf( RETROTILE_PATH_TRACE_LVL, "---END PATHFIND---" );
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL retrotile_flow_init(
+   struct RETROTILE_FLOW* flow, struct RETROTILE* t, size_t layer_idx,
+   struct MDATA_VECTOR* p_tile_defs, uint8_t flags,
+   retrotile_blocked_cb blocked_cb, void* blocked_cb_data
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t tiles_sz = t->tiles_w * t->tiles_h;
+
+   assert( (MAUG_MHANDLE)NULL == flow->dist_h );
+
+   if( layer_idx >= t->layers_count ) {
+      error_printf( "invalid flow field layer: " SIZE_T_FMT, layer_idx );
+      retval = MERROR_OVERFLOW;
+      goto cleanup;
+   }
+
+   flow->flags =
+      (flags & RETROTILE_PATH_FLAG_8DIR) | RETROTILE_FLOW_FLAG_DIRTY;
+   flow->tiles_w = t->tiles_w;
+   flow->tiles_h = t->tiles_h;
+   flow->layer_idx = layer_idx;
+   flow->p_tile_defs = p_tile_defs;
+   flow->blocked_cb = blocked_cb;
+   flow->blocked_cb_data = blocked_cb_data;
+
+   maug_malloc_test( flow->dist_h, tiles_sz, sizeof( uint16_t ) );
+   maug_malloc_test( flow->dir_h, tiles_sz, sizeof( retroflat_dir8_t ) );
+   maug_malloc_test( flow->queue_h, tiles_sz, sizeof( uint32_t ) );
+
+cleanup:
+
+   if( MERROR_OK != retval ) {
+      retrotile_flow_free( flow );
+   }
+
+   return retval;
+}
+
+/* === */
+
+void retrotile_flow_free( struct RETROTILE_FLOW* flow ) {
+   if( (MAUG_MHANDLE)NULL != flow->dist_h ) {
+      maug_mfree( flow->dist_h );
+   }
+   if( (MAUG_MHANDLE)NULL != flow->dir_h ) {
+      maug_mfree( flow->dir_h );
+   }
+   if( (MAUG_MHANDLE)NULL != flow->queue_h ) {
+      maug_mfree( flow->queue_h );
+   }
+   maug_mzero( flow, sizeof( struct RETROTILE_FLOW ) );
+}
+
+/* === */
+
+MERROR_RETVAL retrotile_flow_add_target(
+   struct RETROTILE_FLOW* flow, retrotile_coord_t x, retrotile_coord_t y
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+
+   if( RETROTILE_FLOW_TARGETS_MAX <= flow->targets_sz ) {
+      error_printf( "too many flow field targets!" );
+      retval = MERROR_OVERFLOW;
+      goto cleanup;
+   }
+
+   if(
+      0 > x || 0 > y ||
+      flow->tiles_w <= (size_t)x || flow->tiles_h <= (size_t)y
+   ) {
+      error_printf( "flow field target outside of tilemap!" );
+      retval = MERROR_OVERFLOW;
+      goto cleanup;
+   }
+
+   flow->targets[flow->targets_sz].x = x;
+   flow->targets[flow->targets_sz].y = y;
+   flow->targets_sz++;
+   flow->flags |= RETROTILE_FLOW_FLAG_DIRTY;
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+void retrotile_flow_clear_targets( struct RETROTILE_FLOW* flow ) {
+   flow->targets_sz = 0;
+   flow->flags |= RETROTILE_FLOW_FLAG_DIRTY;
+}
+
+/* === */
+
+static int retrotile_flow_is_target(
+   struct RETROTILE_FLOW* flow, int32_t x, int32_t y
+) {
+   size_t i = 0;
+
+   for( i = 0 ; flow->targets_sz > i ; i++ ) {
+      if( flow->targets[i].x == x && flow->targets[i].y == y ) {
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+/* === */
+
+/**
+ * \return 1 if the given tile value's tile def doesn't block movement.
+ */
+static int retrotile_flow_tile_passable(
+   struct RETROTILE_FLOW* flow, struct RETROTILE* t, retroflat_tile_t tile
+) {
+   struct RETROTILE_TILE_DEF* tile_def = NULL;
+
+   if(
+      NULL == flow->p_tile_defs || 0 > tile ||
+      (size_t)tile < t->tileset_fgid
+   ) {
+      /* No tile defs or empty tile. */
+      return 1;
+   }
+
+   assert( mdata_vector_is_locked( flow->p_tile_defs ) );
+
+   tile_def = mdata_vector_get(
+      flow->p_tile_defs, tile - t->tileset_fgid, struct RETROTILE_TILE_DEF );
+   if( NULL == tile_def ) {
+      return 1;
+   }
+
+   return
+      RETROTILE_TILE_FLAG_BLOCK != (RETROTILE_TILE_FLAG_BLOCK & tile_def->flags);
+}
+
+/* === */
+
+#define retrotile_flow_passable( flow, t, layer, x, y ) \
+   retrotile_flow_tile_passable( \
+      flow, t, retrotile_get_tile( t, layer, x, y ) )
+
+/**
+ * \return 1 if an agent on x, y can step in dir8 dir without leaving the map,
+ *         hitting a blocking tile, or cutting a blocked corner.
+ */
+static int retrotile_flow_can_move(
+   struct RETROTILE_FLOW* flow, struct RETROTILE* t,
+   struct RETROTILE_LAYER* layer, int32_t x, int32_t y, int8_t dir
+) {
+   int32_t dest_x = x + gc_retroflat_offsets8_x[dir];
+   int32_t dest_y = y + gc_retroflat_offsets8_y[dir];
+
+   if(
+      0 > dest_x || 0 > dest_y ||
+      t->tiles_w <= (size_t)dest_x || t->tiles_h <= (size_t)dest_y
+   ) {
+      return 0;
+   }
+
+   if(
+      !retrotile_flow_passable( flow, t, layer, dest_x, dest_y ) &&
+      !retrotile_flow_is_target( flow, dest_x, dest_y )
+   ) {
+      return 0;
+   }
+
+   if(
+      0x01 == (dir & 0x01) && (
+         !retrotile_flow_passable( flow, t, layer, dest_x, y ) ||
+         !retrotile_flow_passable( flow, t, layer, x, dest_y ))
+   ) {
+      /* Don't cut corners. */
+      return 0;
+   }
+
+   if(
+      NULL != flow->blocked_cb &&
+      RETROTILE_RETVAL_BLOCKED == flow->blocked_cb(
+         x, y, dir, t, flow->blocked_cb_data )
+   ) {
+      return 0;
+   }
+
+   return 1;
+}
+
+/* === */
+
+/**
+ * \brief Flood outwards from the tiles already in the queue, lowering the
+ *        distance of any tile that can step into a queued tile.
+ *
+ * Since every step costs the same, this gives correct distances as long as
+ * the queue starts out sorted by distance.
+ */
+static void retrotile_flow_flood(
+   struct RETROTILE_FLOW* flow, struct RETROTILE* t,
+   struct RETROTILE_LAYER* layer, uint16_t* dist, retroflat_dir8_t* dirs,
+   uint32_t* queue, size_t queue_start, size_t queue_end
+) {
+   uint32_t tile_idx = 0;
+   int32_t x = 0;
+   int32_t y = 0;
+   int32_t src_x = 0;
+   int32_t src_y = 0;
+   uint32_t src_idx = 0;
+   int8_t dir = 0;
+   uint8_t dir_step = 2;
+
+   if(
+      RETROTILE_PATH_FLAG_8DIR == (RETROTILE_PATH_FLAG_8DIR & flow->flags)
+   ) {
+      dir_step = 1;
+   }
+
+   while( queue_start < queue_end ) {
+      tile_idx = queue[queue_start++];
+      x = tile_idx % t->tiles_w;
+      y = tile_idx / t->tiles_w;
+
+      if(
+         !retrotile_flow_passable( flow, t, layer, x, y ) &&
+         !retrotile_flow_is_target( flow, x, y )
+      ) {
+         /* Agents can step off of blocked tiles but not through them. */
+         continue;
+      }
+
+      for( dir = 0 ; 8 > dir ; dir += dir_step ) {
+         /* Find the tile that would step into this one in dir. */
+         src_x = x - gc_retroflat_offsets8_x[dir];
+         src_y = y - gc_retroflat_offsets8_y[dir];
+         if(
+            0 > src_x || 0 > src_y ||
+            t->tiles_w <= (size_t)src_x || t->tiles_h <= (size_t)src_y
+         ) {
+            continue;
+         }
+
+         src_idx = (src_y * t->tiles_w) + src_x;
+         if(
+            dist[src_idx] <= dist[tile_idx] + 1 ||
+            !retrotile_flow_can_move( flow, t, layer, src_x, src_y, dir )
+         ) {
+            continue;
+         }
+
+         dist[src_idx] = dist[tile_idx] + 1;
+         dirs[src_idx] = dir;
+         assert( queue_end < t->tiles_w * t->tiles_h );
+         queue[queue_end++] = src_idx;
+      }
+   }
+}
+
+/* === */
+
+MERROR_RETVAL retrotile_flow_update(
+   struct RETROTILE_FLOW* flow, struct RETROTILE* t
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROTILE_LAYER* layer = NULL;
+   uint16_t* dist = NULL;
+   retroflat_dir8_t* dirs = NULL;
+   uint32_t* queue = NULL;
+   size_t queue_end = 0;
+   uint32_t tile_idx = 0;
+   size_t i = 0;
+   int autolock = 0;
+
+   if(
+      RETROTILE_FLOW_FLAG_DIRTY != (RETROTILE_FLOW_FLAG_DIRTY & flow->flags)
+   ) {
+      /* Nothing has changed. */
+      goto cleanup;
+   }
+
+   assert( flow->tiles_w == t->tiles_w );
+   assert( flow->tiles_h == t->tiles_h );
+
+   layer = retrotile_get_layer_p( t, flow->layer_idx );
+   assert( NULL != layer );
+
+   if(
+      NULL != flow->p_tile_defs && !mdata_vector_is_locked( flow->p_tile_defs )
+   ) {
+      mdata_vector_lock( flow->p_tile_defs );
+      autolock = 1;
+   }
+
+   maug_mlock( flow->dist_h, dist );
+   maug_cleanup_if_null_lock( uint16_t*, dist );
+   maug_mlock( flow->dir_h, dirs );
+   maug_cleanup_if_null_lock( retroflat_dir8_t*, dirs );
+   maug_mlock( flow->queue_h, queue );
+   maug_cleanup_if_null_lock( uint32_t*, queue );
+
+   for( i = 0 ; t->tiles_w * t->tiles_h > i ; i++ ) {
+      dist[i] = RETROTILE_FLOW_DIST_NONE;
+      dirs[i] = RETROFLAT_DIR8_NONE;
+   }
+
+   /* Seed the queue with all targets at once, so each tile ends up pointed
+    * at whichever is nearest.
+    */
+   for( i = 0 ; flow->targets_sz > i ; i++ ) {
+      tile_idx = (flow->targets[i].y * t->tiles_w) + flow->targets[i].x;
+      if( 0 == dist[tile_idx] ) {
+         continue;
+      }
+      dist[tile_idx] = 0;
+      queue[queue_end++] = tile_idx;
+   }
+
+   retrotile_flow_flood( flow, t, layer, dist, dirs, queue, 0, queue_end );
+
+   flow->flags &= ~RETROTILE_FLOW_FLAG_DIRTY;
+   flow->rebuilds++;
+
+#if RETROTILE_PATH_TRACE_LVL > 0
+   debug_printf( RETROTILE_PATH_TRACE_LVL,
+      "rebuilt flow field for " SIZE_T_FMT " targets (" SIZE_T_FMT
+         " rebuilds, " SIZE_T_FMT " patches)",
+      flow->targets_sz, flow->rebuilds, flow->patches );
+#endif /* RETROTILE_PATH_TRACE_LVL */
+
+cleanup:
+
+   if( NULL != queue ) {
+      maug_munlock( flow->queue_h, queue );
+   }
+
+   if( NULL != dirs ) {
+      maug_munlock( flow->dir_h, dirs );
+   }
+
+   if( NULL != dist ) {
+      maug_munlock( flow->dist_h, dist );
+   }
+
+   if( autolock ) {
+      mdata_vector_unlock( flow->p_tile_defs );
+   }
+
+   return retval;
+}
+
+/* === */
+
+MERROR_RETVAL retrotile_flow_set_tile(
+   struct RETROTILE_FLOW* flow, struct RETROTILE* t,
+   struct RETROTILE_LAYER* layer, retrotile_coord_t x, retrotile_coord_t y,
+   retroflat_tile_t new_val
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   uint16_t* dist = NULL;
+   retroflat_dir8_t* dirs = NULL;
+   uint32_t* queue = NULL;
+   uint32_t tile_idx = 0;
+   uint32_t nbr_idx = 0;
+   int32_t nbr_x = 0;
+   int32_t nbr_y = 0;
+   int was_passable = 0;
+   int8_t dir = 0;
+   uint8_t dir_step = 2;
+   int autolock = 0;
+
+   assert( flow->tiles_w == t->tiles_w );
+   assert( flow->tiles_h == t->tiles_h );
+
+   if(
+      0 > x || 0 > y ||
+      t->tiles_w <= (size_t)x || t->tiles_h <= (size_t)y
+   ) {
+      error_printf( "flow field tile outside of tilemap!" );
+      retval = MERROR_OVERFLOW;
+      goto cleanup;
+   }
+
+   retrotile_set_tile( t, layer, x, y, new_val );
+
+   if(
+      layer != retrotile_get_layer_p( t, flow->layer_idx ) ||
+      RETROTILE_FLOW_FLAG_DIRTY == (RETROTILE_FLOW_FLAG_DIRTY & flow->flags) ||
+      retrotile_flow_is_target( flow, x, y )
+   ) {
+      /* This can't change the field, or it's being rebuilt anyway. Targets
+       * are always reachable, so they don't change either.
+       */
+      goto cleanup;
+   }
+
+   if(
+      NULL != flow->p_tile_defs && !mdata_vector_is_locked( flow->p_tile_defs )
+   ) {
+      mdata_vector_lock( flow->p_tile_defs );
+      autolock = 1;
+   }
+
+   maug_mlock( flow->dist_h, dist );
+   maug_cleanup_if_null_lock( uint16_t*, dist );
+   maug_mlock( flow->dir_h, dirs );
+   maug_cleanup_if_null_lock( retroflat_dir8_t*, dirs );
+   maug_mlock( flow->queue_h, queue );
+   maug_cleanup_if_null_lock( uint32_t*, queue );
+
+   if(
+      RETROTILE_PATH_FLAG_8DIR == (RETROTILE_PATH_FLAG_8DIR & flow->flags)
+   ) {
+      dir_step = 1;
+   }
+
+   tile_idx = (y * t->tiles_w) + x;
+
+   /* Blocked tiles only get a distance if they have a neighbor that isn't
+    * blocked, and they never pass it on, so a tile that has a distance but no
+    * neighbor routed through it was blocked.
+    */
+   was_passable = 0;
+   for( dir = 0 ; 8 > dir ; dir += dir_step ) {
+      nbr_x = x - gc_retroflat_offsets8_x[dir];
+      nbr_y = y - gc_retroflat_offsets8_y[dir];
+      if(
+         0 > nbr_x || 0 > nbr_y ||
+         t->tiles_w <= (size_t)nbr_x || t->tiles_h <= (size_t)nbr_y
+      ) {
+         continue;
+      }
+      nbr_idx = (nbr_y * t->tiles_w) + nbr_x;
+      if( dirs[nbr_idx] == dir ) {
+         /* The neighbor steps into this tile to get to a target. */
+         was_passable = 1;
+         break;
+      }
+      if(
+         0x00 == (dir & 0x01) && RETROFLAT_DIR8_NONE != dirs[nbr_idx] &&
+         0x01 == (dirs[nbr_idx] & 0x01) && (
+            (nbr_x + gc_retroflat_offsets8_x[dirs[nbr_idx]] == x &&
+               nbr_y == y) ||
+            (nbr_y + gc_retroflat_offsets8_y[dirs[nbr_idx]] == y &&
+               nbr_x == x))
+      ) {
+         /* The neighbor steps diagonally around this tile's corner. */
+         was_passable = 1;
+         break;
+      }
+   }
+
+   if( retrotile_flow_tile_passable( flow, t, new_val ) ) {
+      /* The tile may have just opened up. Pick the best neighbor to step
+       * into, then flood out from here.
+       */
+      for( dir = 0 ; 8 > dir ; dir += dir_step ) {
+         nbr_x = x + gc_retroflat_offsets8_x[dir];
+         nbr_y = y + gc_retroflat_offsets8_y[dir];
+         if( !retrotile_flow_can_move( flow, t, layer, x, y, dir ) ) {
+            continue;
+         }
+         nbr_idx = (nbr_y * t->tiles_w) + nbr_x;
+         if(
+            RETROTILE_FLOW_DIST_NONE != dist[nbr_idx] &&
+            dist[nbr_idx] + 1 < dist[tile_idx]
+         ) {
+            dist[tile_idx] = dist[nbr_idx] + 1;
+            dirs[tile_idx] = dir;
+         }
+      }
+
+      if( RETROTILE_FLOW_DIST_NONE != dist[tile_idx] ) {
+         queue[0] = tile_idx;
+         retrotile_flow_flood( flow, t, layer, dist, dirs, queue, 0, 1 );
+      }
+
+      /* An open corner may also let orthogonal neighbors step diagonally
+       * into each other, so flood out from each of them, too. Flooding from
+       * one tile at a time keeps each flood in distance order.
+       */
+      for( dir = 0 ; 1 == dir_step && 8 > dir ; dir += 2 ) {
+         nbr_x = x + gc_retroflat_offsets8_x[dir];
+         nbr_y = y + gc_retroflat_offsets8_y[dir];
+         if(
+            0 > nbr_x || 0 > nbr_y ||
+            t->tiles_w <= (size_t)nbr_x || t->tiles_h <= (size_t)nbr_y
+         ) {
+            continue;
+         }
+         nbr_idx = (nbr_y * t->tiles_w) + nbr_x;
+         if( RETROTILE_FLOW_DIST_NONE != dist[nbr_idx] ) {
+            queue[0] = nbr_idx;
+            retrotile_flow_flood( flow, t, layer, dist, dirs, queue, 0, 1 );
+         }
+      }
+      flow->patches++;
+
+   } else if( was_passable ) {
+      /* Other tiles were routed through here, so they need new routes. */
+      flow->flags |= RETROTILE_FLOW_FLAG_DIRTY;
+
+   } else {
+      /* Nothing was routed through here, so the rest of the field stands. */
+      flow->patches++;
+   }
+
+cleanup:
+
+   if( NULL != queue ) {
+      maug_munlock( flow->queue_h, queue );
+   }
+
+   if( NULL != dirs ) {
+      maug_munlock( flow->dir_h, dirs );
+   }
+
+   if( NULL != dist ) {
+      maug_munlock( flow->dist_h, dist );
+   }
+
+   if( autolock ) {
+      mdata_vector_unlock( flow->p_tile_defs );
+   }
+
+   return retval;
+}
+
+/* === */
+
+retroflat_dir8_t retrotile_flow_dir(
+   struct RETROTILE_FLOW* flow, retrotile_coord_t x, retrotile_coord_t y
+) {
+   retroflat_dir8_t* dirs = NULL;
+   retroflat_dir8_t dir = RETROFLAT_DIR8_NONE;
+
+   if(
+      0 > x || 0 > y ||
+      flow->tiles_w <= (size_t)x || flow->tiles_h <= (size_t)y
+   ) {
+      return RETROFLAT_DIR8_NONE;
+   }
+
+   maug_mlock( flow->dir_h, dirs );
+   if( NULL != dirs ) {
+      dir = dirs[(y * flow->tiles_w) + x];
+      maug_munlock( flow->dir_h, dirs );
+   }
+
+   return dir;
+}
+
+/* === */
+
+uint16_t retrotile_flow_dist(
+   struct RETROTILE_FLOW* flow, retrotile_coord_t x, retrotile_coord_t y
+) {
+   uint16_t* dist = NULL;
+   uint16_t dist_out = RETROTILE_FLOW_DIST_NONE;
+
+   if(
+      0 > x || 0 > y ||
+      flow->tiles_w <= (size_t)x || flow->tiles_h <= (size_t)y
+   ) {
+      return RETROTILE_FLOW_DIST_NONE;
+   }
+
+   maug_mlock( flow->dist_h, dist );
+   if( NULL != dist ) {
+      dist_out = dist[(y * flow->tiles_w) + x];
+      maug_munlock( flow->dist_h, dist );
+   }
+
+   return dist_out;
+}
+
 #endif /* RETROTIL_C */
 
 #endif /* !RETROPTH_H */
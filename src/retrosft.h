@@ -13,6 +13,11 @@
  * This library is also used in conjunction with retro3D, in order to
  * manipulate texture bitmaps.
  *
+ * Filled shapes and shallow lines are broken into horizontal spans, which are
+ * clipped to the target and then drawn with retroflat_2d_span(). Platforms
+ * that can fill a run of pixels faster than one at a time should define
+ * RETROFLAT_NATIVE_SPAN and provide retroflat_span().
+ *
  * \{
  */
 
@@ -28,6 +33,15 @@
 #  define RETROSOFT_TRACE_LVL 0
 #endif /* RETROSOFT_TRACE_LVL */
 
+/**
+ * \brief Fill a horizontal run of w pixels one retroflat_2d_px() at a time.
+ *        Used as retroflat_2d_span() where the platform has nothing faster.
+ * \warning The span must already be clipped to the target!
+ */
+void retrosoft_span(
+   retroflat_blit_t* target, const RETROFLAT_COLOR color_idx,
+   size_t x, size_t y, size_t w, uint8_t flags );
+
 /**
  * \brief Draw a line from x1, y1 to x2, y2.
  * \warning This function does not check if supplied bitmaps are read-only!
@@ -48,8 +62,10 @@ void retrosoft_rect(
 
 /**
  * \brief Draw an ellipsoid at the given coordinates, with the given dimensions.
- * \todo Right now this uses integer polar coordinates; it needs to be redone
- *       to use the Midpoint circle algorithm or similar.
+ *
+ * This uses the midpoint ellipse algorithm with 32-bit error terms, which
+ * grow with r_x * r_x * r_y, so radii should stay under about 800 pixels.
+ *
  * \warning This function does not check if supplied bitmaps are read-only!
  *          Such checks should be performed by wrapper functions calling it!
  */
@@ -63,6 +79,52 @@ void retrosoft_ellipse(
 
 /* === */
 
+void retrosoft_span(
+   retroflat_blit_t* target, const RETROFLAT_COLOR color_idx,
+   size_t x, size_t y, size_t w, uint8_t flags
+) {
+   size_t x_iter = 0;
+
+   for( x_iter = x ; x + w > x_iter ; x_iter++ ) {
+      retroflat_2d_px( target, color_idx, x_iter, y, flags );
+   }
+}
+
+/* === */
+
+/**
+ * \brief Clip a horizontal span to the target and draw whatever is left.
+ */
+static void _retrosoft_span_clip(
+   retroflat_blit_t* target, const RETROFLAT_COLOR color_idx,
+   int x, int y, int w, uint8_t flags
+) {
+   /* Some platforms report bitmap sizes as size_t, so compare against
+    * signed copies or negative coordinates would wrap around.
+    */
+   int bmp_w = (int)retroflat_2d_bitmap_w( target ),
+      bmp_h = (int)retroflat_2d_bitmap_h( target );
+
+   if( 0 > y || bmp_h <= y ) {
+      return;
+   }
+
+   if( 0 > x ) {
+      w += x;
+      x = 0;
+   }
+   if( x + w > bmp_w ) {
+      w = bmp_w - x;
+   }
+   if( 0 >= w ) {
+      return;
+   }
+
+   retroflat_2d_span( target, color_idx, x, y, w, flags );
+}
+
+/* === */
+
 void retrosoft_line_strategy(
    int x1, int y1, int x2, int y2,
    uint8_t* p_for_axis, uint8_t* p_off_axis, int16_t dist[2],
@@ -136,7 +198,8 @@ void retrosoft_line(
       end[2],
       iter[2],
       inc = 1,
-      delta = 0;
+      delta = 0,
+      run_start = 0;
 
    /* TODO: Handle thickness. */
 
@@ -147,31 +210,48 @@ void retrosoft_line(
    }
 #endif /* !RETROFLAT_3D */
 
+   /* Skip lines that are entirely off one side of the target. */
+   if(
+      (0 > x1 && 0 > x2) || (0 > y1 && 0 > y2) ||
+      ((int)retroflat_2d_bitmap_w( target ) <= x1 &&
+         (int)retroflat_2d_bitmap_w( target ) <= x2) ||
+      ((int)retroflat_2d_bitmap_h( target ) <= y1 &&
+         (int)retroflat_2d_bitmap_h( target ) <= y2)
+   ) {
+      return;
+   }
+
    retroflat_px_lock( target );
 
    retrosoft_line_strategy(
       x1, y1, x2, y2,
       &for_axis, &off_axis, dist, start, end, iter, &inc, &delta );
 
+   /* Shallow lines are runs of pixels along a row, so those are drawn as
+    * spans that end wherever the line steps to the next row.
+    */
+   run_start = start[RETROFLAT_LINE_X];
+
    for(
       iter[for_axis] = start[for_axis] ;
       end[for_axis] > iter[for_axis] ;
       iter[for_axis]++
    ) {
 
-      /*
-      if(
-         (size_t)iter[RETROFLAT_LINE_X] < (size_t)retroflat_screen_w() &&
-         (size_t)iter[RETROFLAT_LINE_Y] < (size_t)retroflat_screen_h()
-      ) {
-      */
-      retroflat_2d_px(
-         target, color,
-         iter[RETROFLAT_LINE_X], iter[RETROFLAT_LINE_Y], flags );
-      /* } */
+      if( RETROFLAT_LINE_Y == for_axis ) {
+         retroflat_2d_px(
+            target, color,
+            iter[RETROFLAT_LINE_X], iter[RETROFLAT_LINE_Y], flags );
+      }
 
       /* Increment off-axis based on for-axis. */
       if( 0 < delta ) {
+         if( RETROFLAT_LINE_X == for_axis ) {
+            _retrosoft_span_clip( target, color,
+               run_start, iter[RETROFLAT_LINE_Y],
+               iter[RETROFLAT_LINE_X] - run_start + 1, flags );
+            run_start = iter[RETROFLAT_LINE_X] + 1;
+         }
          iter[off_axis] += inc;
          delta += (2 * (dist[off_axis] - dist[for_axis]));
       } else {
@@ -179,6 +259,13 @@ void retrosoft_line(
       }
    }
 
+   if( RETROFLAT_LINE_X == for_axis && end[RETROFLAT_LINE_X] > run_start ) {
+      /* Finish the last run. */
+      _retrosoft_span_clip( target, color,
+         run_start, iter[RETROFLAT_LINE_Y],
+         end[RETROFLAT_LINE_X] - run_start, flags );
+   }
+
    retroflat_px_release( target );
 }
 
@@ -190,12 +277,7 @@ void retrosoft_rect(
    retroflat_blit_t* target, const RETROFLAT_COLOR color_idx,
    int x, int y, int w, int h, uint8_t flags
 ) {
-   int x_iter = 0,
-      y_iter = 0;
-
-   /* Don't trim or constrain, as those should be left to the platform-specific
-    * px routine.
-    */
+   int y_iter = 0;
 
 #ifndef RETROFLAT_3D
    /* Under 3D mode, we should never be drawing directly to the screen! */
@@ -208,11 +290,26 @@ void retrosoft_rect(
 
    if( RETROFLAT_DRAW_FLAG_FILL == (RETROFLAT_DRAW_FLAG_FILL & flags) ) {
 
-      for( y_iter = y ; y_iter < y + h ; y_iter++ ) {
-         for( x_iter = x ; x_iter < x + w ; x_iter++ ) {
-            /* TODO: Optimize filling 4-byte sequences! */
-            retroflat_2d_px( target, color_idx, x_iter, y_iter, flags );
-         }
+      /* Clip up front, so rows and columns off the target are never visited
+       * and each remaining row can be drawn as one span.
+       */
+      if( 0 > x ) {
+         w += x;
+         x = 0;
+      }
+      if( 0 > y ) {
+         h += y;
+         y = 0;
+      }
+      if( x + w > (int)retroflat_2d_bitmap_w( target ) ) {
+         w = (int)retroflat_2d_bitmap_w( target ) - x;
+      }
+      if( y + h > (int)retroflat_2d_bitmap_h( target ) ) {
+         h = (int)retroflat_2d_bitmap_h( target ) - y;
+      }
+
+      for( y_iter = y ; 0 < w && y_iter < y + h ; y_iter++ ) {
+         retroflat_2d_span( target, color_idx, x, y_iter, w, flags );
       }
 
    } else {
@@ -236,20 +333,49 @@ void retrosoft_rect(
 
 /* === */
 
-void retrosoft_ellipse(
+/**
+ * \brief Draw the points or rows of an ellipse that are mirrored from a
+ *        single point of its lower-right quadrant.
+ */
+static void _retrosoft_ellipse_quad(
    retroflat_blit_t* target, RETROFLAT_COLOR color,
-   int x, int y, int w, int h, uint8_t flags
+   int c_x, int c_y, int d_x, int d_y, uint8_t flags
 ) {
-   int32_t i = 0,
-      i_prev = 0;
-   uint16_t px_x1 = 0,
-      px_y1 = 0,
-      px_x2 = 0,
-      px_y2 = 0;
+   int i = 0;
+   int y_quad[2];
+
+   y_quad[0] = c_y + d_y;
+   y_quad[1] = c_y - d_y;
 
-   /* TODO: Switch to Bresenham algorithm. */
+   /* The middle row is only one row! */
+   for( i = 0 ; (0 == d_y ? 1 : 2) > i ; i++ ) {
+      if( RETROFLAT_DRAW_FLAG_FILL == (RETROFLAT_DRAW_FLAG_FILL & flags) ) {
+         _retrosoft_span_clip(
+            target, color, c_x - d_x, y_quad[i], (2 * d_x) + 1, flags );
+      } else {
+         _retrosoft_span_clip( target, color, c_x - d_x, y_quad[i], 1, flags );
+         _retrosoft_span_clip( target, color, c_x + d_x, y_quad[i], 1, flags );
+      }
+   }
+}
 
-   /* TODO: Filled ellipse. */
+/* === */
+
+void retrosoft_ellipse(
+   retroflat_blit_t* target, RETROFLAT_COLOR color,
+   int x, int y, int w, int h, uint8_t flags
+) {
+   int c_x = 0,
+      c_y = 0,
+      d_x = 0,
+      d_y = 0;
+   int32_t r_x = 0,
+      r_y = 0,
+      r_x2 = 0,
+      r_y2 = 0,
+      p_x = 0,
+      p_y = 0,
+      p = 0;
 
 #ifndef RETROFLAT_3D
    /* Under 3D mode, we should never be drawing directly to the screen! */
@@ -258,64 +384,85 @@ void retrosoft_ellipse(
    }
 #endif /* !RETROFLAT_3D */
 
+   /* Skip ellipses that are entirely off the target. */
+   if(
+      0 > x + w || 0 > y + h ||
+      (int)retroflat_2d_bitmap_w( target ) <= x ||
+      (int)retroflat_2d_bitmap_h( target ) <= y
+   ) {
+      return;
+   }
+
    retroflat_px_lock( target );
 
-   do {
-      /* For the soft_lut, input numbers are * 1000... so 0.1 becomes 100. */
-      for( i = 100 ; 2 * MFIX_PI + 100 > i ; i += 100 ) {
-         i_prev = i - 100;
-
-         px_x1 =
-            /* Offset circle center by X. */
-            x + (w / 2) + 
-            /* Get Cartesian coord by multiplying polar coord by radius. */
-            /* (Note that we convert to i *after* multiplication so the number
-             * is big enough that the precision no longer matters! */
-            mfix_to_i( mfix_cos( i_prev ) * w / 2 );
-
-         px_y1 = y + (h / 2) + mfix_to_i( mfix_sin( i_prev ) * (h / 2) );
-         px_x2 = x + (w / 2) + mfix_to_i( mfix_cos( i ) * (w / 2) );
-         px_y2 = y + (h / 2) + mfix_to_i( mfix_sin( i ) * (h / 2) );
-
-         /* We don't do bounds checks since the low-level API should handle
-          * those! Performance!
-          */
-
-#ifdef RETROSOFT_HARD_LINES
-         retroflat_line( target, color, px_x1, px_y1, px_x2, px_y2, flags );  
-#else
-         retrosoft_line( target, color, px_x1, px_y1, px_x2, px_y2, flags );  
-#endif /* RETROSOFT_HARD_LINES */
+   r_x = w / 2;
+   r_y = h / 2;
+   c_x = x + r_x;
+   c_y = y + r_y;
+
+   if( 0 == r_x || 0 == r_y ) {
+      /* Too flat to have a curve, so just draw the straight line. */
+      for( d_y = -r_y ; r_y >= d_y ; d_y++ ) {
+         _retrosoft_span_clip(
+            target, color, c_x - r_x, c_y + d_y, (2 * r_x) + 1, flags );
       }
+      goto cleanup;
+   }
 
-      /* Keep shrinking and filling if required. */
-      if( w > h ) {
-         x++;
-         w--;
-         if( 0 < h ) {
-            y++;
-            h--;
-         }
-      } else if( h > w ) {
-         y++;
-         h--;
-         if( 0 < w ) {
-            x++;
-            w--;
+   r_x2 = r_x * r_x;
+   r_y2 = r_y * r_y;
+
+   /* Start at the bottom and walk around to the right side, mirroring each
+    * point into the other quadrants.
+    */
+   d_x = 0;
+   d_y = r_y;
+   p_x = 0;
+   p_y = 2 * r_x2 * d_y;
+
+   /* Region 1: The slope is shallow, so step along X. */
+   p = r_y2 - (r_x2 * r_y) + (r_x2 / 4);
+   while( p_x < p_y ) {
+      if( 0 > p ) {
+         if( RETROFLAT_DRAW_FLAG_FILL != (RETROFLAT_DRAW_FLAG_FILL & flags) ) {
+            _retrosoft_ellipse_quad( target, color, c_x, c_y, d_x, d_y, flags );
          }
+         d_x++;
+         p_x += 2 * r_y2;
+         p += r_y2 + p_x;
       } else {
-         x++;
-         w--;
-         y++;
-         h--;
+         /* Leaving this row, so d_x is as wide as it gets here. */
+         _retrosoft_ellipse_quad( target, color, c_x, c_y, d_x, d_y, flags );
+         d_x++;
+         d_y--;
+         p_x += 2 * r_y2;
+         p_y -= 2 * r_x2;
+         p += r_y2 + p_x - p_y;
       }
-      assert( 0 <= w );
-      assert( 0 <= h );
-      /* debug_printf( 1, "ELLIPSE %d, %d", w, h ); */
-   } while(
-      (RETROFLAT_DRAW_FLAG_FILL == (RETROFLAT_DRAW_FLAG_FILL & flags)) &&
-      (0 < w || 0 < h)
-   );
+   }
+
+   /* Region 2: The slope is steep, so step along Y. Derive the new decision
+    * term from the region 1 term rather than evaluating the ellipse equation
+    * outright, since that multiplies r_x2 by r_y2 and overflows 32 bits for
+    * even screen-sized ellipses. The remainders keep the result identical to
+    * the truncated quarters in the textbook form.
+    */
+   p = p - (r_y2 * d_x) - (r_x2 * d_y) +
+      (3 * (r_x2 / 4)) + (r_x2 % 4) - (3 * (r_y2 / 4)) - (r_y2 % 4);
+   while( 0 <= d_y ) {
+      _retrosoft_ellipse_quad( target, color, c_x, c_y, d_x, d_y, flags );
+      d_y--;
+      p_y -= 2 * r_x2;
+      if( 0 < p ) {
+         p += r_x2 - p_y;
+      } else {
+         d_x++;
+         p_x += 2 * r_y2;
+         p += r_x2 - p_y + p_x;
+      }
+   }
+
+cleanup:
 
    retroflat_px_release( target );
 }
@@ -30,10 +30,23 @@
  * And the MPU-401 interface for being so darn simple!
  */
 
+/**
+ * \brief Number of channels mixed by the software synthesizer.
+ *
+ * Channels past ::RETROSND_TUNE_CHANNEL_CT are not driven by tunes and are
+ * free for sound effects (e.g. with retrosnd_note_on_deadline()).
+ */
 #ifndef RETROSND_CHANNEL_CT_MAX
-#  define RETROSND_CHANNEL_CT_MAX 4
+#  define RETROSND_CHANNEL_CT_MAX 8
 #endif /* !RETROSND_CHANNEL_CT_MAX */
 
+/**
+ * \brief Number of channels stored per note in a RETROSND_TUNE.
+ */
+#ifndef RETROSND_TUNE_CHANNEL_CT
+#  define RETROSND_TUNE_CHANNEL_CT 4
+#endif /* !RETROSND_TUNE_CHANNEL_CT */
+
 #ifndef RETROSND_TRACE_LVL
 #  define RETROSND_TRACE_LVL 0
 #endif /* !RETROSND_TRACE_LVL */
@@ -46,6 +59,14 @@
 #  define RETROSND_SAMPLES_CT 2048
 #endif /* !RETROSND_SAMPLES_CT */
 
+/**
+ * \brief Number of samples mixed at a time on the stack by
+ *        _retrosnd_render_block(). Larger requests are mixed in pieces.
+ */
+#ifndef RETROSND_MIX_BLOCK_SZ
+#  define RETROSND_MIX_BLOCK_SZ 512
+#endif /* !RETROSND_MIX_BLOCK_SZ */
+
 #ifdef RETROSND_SAMPLE_22050
 #  define RETROSND_SAMPLE_RATE 22050
 #elif defined( RETROSND_SAMPLE_44100 )
@@ -92,7 +113,7 @@ struct RETROSND_TUNE {
    int8_t current_note_idx;
    int16_t ms_per_note;
    retroflat_ms_t next_note_at;
-   uint8_t notes[][RETROSND_CHANNEL_CT_MAX];
+   uint8_t notes[][RETROSND_TUNE_CHANNEL_CT];
 };
 
 /**
@@ -182,12 +203,18 @@ MERROR_RETVAL retrosnd_tune_set_note(
    ((tune)->notes[idx][channel])
 
 /**
- * \brief Increment synthesizer phase based on its instrument and system
- *        settings.
+ * \brief Render and mix a block of samples from all synthesizer channels.
+ * \param channels Array of ::RETROSND_CHANNEL_CT_MAX channels to mix.
+ * \param now Time at the start of the block, used to cut off channels with a
+ *            RETROSND_CHANNEL::deadline at the sample it falls on.
+ * \param out Buffer to place the mixed and clipped samples in.
+ * \param out_ct Number of samples to render into out.
  * \note This should only be called by the API-specific implementation, and not
  *       a client program.
  */
-int16_t _retrosnd_generate_note( struct RETROSND_CHANNEL* channels );
+void _retrosnd_render_block(
+   struct RETROSND_CHANNEL* channels, retroflat_ms_t now,
+   int16_t* out, size_t out_ct );
 
 /**
  * \brief Set controls for the software synthesizer.
@@ -197,6 +224,22 @@ int16_t _retrosnd_generate_note( struct RETROSND_CHANNEL* channels );
 MERROR_RETVAL _retrosnd_set_control(
    struct RETROSND_CHANNEL* channel, uint8_t key, uint8_t val );
 
+/*! \brief Size in bytes of the header written by _retrosnd_write_wav_hdr(). */
+#define RETROSND_WAV_HDR_SZ 44
+
+/**
+ * \brief Convert samples to the signed 16-bit little-endian PCM stored in
+ *        WAV files.
+ * \param out Buffer of at least buf_ct * sizeof( int16_t ) bytes.
+ */
+void _retrosnd_pcm_lsbf( const int16_t* buf, size_t buf_ct, uint8_t* out );
+
+/**
+ * \brief Write a ::RETROSND_WAV_HDR_SZ byte mono 16-bit PCM WAV header for
+ *        samples_ct samples at ::RETROSND_SAMPLE_RATE to p_out.
+ */
+MERROR_RETVAL _retrosnd_write_wav_hdr( mfile_t* p_out, uint32_t samples_ct );
+
 #define RETROSND_TUNE_NOTE_DISABLED (255)
 
 #define RETROSND_NOTES_START (36)
@@ -542,20 +585,20 @@ MERROR_RETVAL retrosnd_tune_init(
    MERROR_RETVAL retval = MERROR_OK;
 
    maug_malloc_test( *p_tune_h, 1,
-      sizeof( struct RETROSND_TUNE ) + (notes_ct * RETROSND_CHANNEL_CT_MAX ) );
+      sizeof( struct RETROSND_TUNE ) + (notes_ct * RETROSND_TUNE_CHANNEL_CT ) );
    maug_mlock( *p_tune_h, tune );
    maug_cleanup_if_null_lock( struct RETROSND_TUNE*, tune );
 
    maug_mzero( tune,
-      sizeof( struct RETROSND_TUNE ) + (notes_ct * RETROSND_CHANNEL_CT_MAX ) );
+      sizeof( struct RETROSND_TUNE ) + (notes_ct * RETROSND_TUNE_CHANNEL_CT ) );
 
    memset( tune->notes, RETROSND_TUNE_NOTE_DISABLED,
-      RETROSND_CHANNEL_CT_MAX * notes_ct );
+      RETROSND_TUNE_CHANNEL_CT * notes_ct );
 
    tune->sz = sizeof( struct RETROSND_TUNE );
    tune->notes_ct = notes_ct;
    tune->total_sz = sizeof( struct RETROSND_TUNE ) +
-      (RETROSND_CHANNEL_CT_MAX * tune->notes_ct);
+      (RETROSND_TUNE_CHANNEL_CT * tune->notes_ct);
    tune->ms_per_note = ms_per_note;
 
 cleanup:
@@ -588,7 +631,7 @@ MERROR_RETVAL retrosnd_tune_update( struct RETROSND_TUNE* tune ) {
 #endif /* RETROSND_TUNE_TRACE_LVL */
 
       /* Ensure playing blocks are playing and stopped are stopped. */
-      for( i = 0 ; RETROSND_CHANNEL_CT_MAX > i ; i++ ) {
+      for( i = 0 ; RETROSND_TUNE_CHANNEL_CT > i ; i++ ) {
          if( 0 <= prev_note ) {
             retrosnd_note_off( i, tune->notes[prev_note][i], 0 );
          }
@@ -606,7 +649,7 @@ MERROR_RETVAL retrosnd_tune_update( struct RETROSND_TUNE* tune ) {
 void retrosnd_tune_seek( struct RETROSND_TUNE* tune, int8_t idx ) {
    int i = 0;
    if( 0 <= tune->current_note_idx ) {
-      for( i = 0 ; RETROSND_CHANNEL_CT_MAX > i ; i++ ) {
+      for( i = 0 ; RETROSND_TUNE_CHANNEL_CT > i ; i++ ) {
          retrosnd_note_off( i, tune->notes[tune->current_note_idx][i], 0 );
       }
    }
@@ -627,7 +670,7 @@ MERROR_RETVAL retrosnd_tune_set_note(
       goto cleanup;
    }
 
-   if( channel >= RETROSND_CHANNEL_CT_MAX ) {
+   if( channel >= RETROSND_TUNE_CHANNEL_CT ) {
       error_printf( "invalid channel specified: %d", channel );
       retval = MERROR_OVERFLOW;
       goto cleanup;
@@ -672,27 +715,111 @@ MERROR_RETVAL _retrosnd_channels_init( struct RETROSND_CHANNEL* channels ) {
    retrosnd_set_voice( 2, 1 );
    retrosnd_set_voice( 3, 2 );
 
-   retrosnd_set_control( 0, RETROSND_CONTROL_VOL, 128 );
-   retrosnd_set_control( 1, RETROSND_CONTROL_VOL, 128 );
-   retrosnd_set_control( 2, RETROSND_CONTROL_VOL, 128 );
-   retrosnd_set_control( 3, RETROSND_CONTROL_VOL, 128 );
+   /* Extra effect channels default to the triangle wave. */
+   for( i = 4 ; RETROSND_CHANNEL_CT_MAX > i ; i++ ) {
+      retrosnd_set_voice( i, 0 );
+   }
+
+   for( i = 0 ; RETROSND_CHANNEL_CT_MAX > i ; i++ ) {
+      retrosnd_set_control( i, RETROSND_CONTROL_VOL, 128 );
+   }
 
    return retval;
 }
 
-int16_t _retrosnd_generate_note( struct RETROSND_CHANNEL* channels ) {
-   int32_t mix = 0;
+/* === */
+
+/**
+ * \brief Render a run of samples from a single channel, adding them to mix.
+ *
+ * Each voice gets its own tight loop so the per-sample work is free of the
+ * voice switch and deadline checks.
+ */
+static void _retrosnd_mix_channel(
+   struct RETROSND_CHANNEL* channel, int32_t* mix, size_t mix_ct
+) {
+   size_t i = 0;
+   uint32_t phase = channel->phase;
+   uint32_t phase_inc = gc_phase_inc[channel->note];
+   int32_t vol = channel->vol;
+   int32_t sq_hi = 0,
+      sq_lo = 0;
+
+   switch( channel->voice ) {
+   case 0:
+      /* Triangle wave. */
+      for( i = 0 ; mix_ct > i ; i++ ) {
+         phase += phase_inc;
+         if( 32768 > phase ) {
+            mix[i] += (int32_t)(phase - 16384) * 2;
+         } else {
+            mix[i] += ((uint16_t)((((65536 - phase)
+               - 16384) * 2)) * vol) >> 8;
+         }
+      }
+      break;
+
+   case 1:
+      /* Square wave. */
+      sq_hi = (30000 * vol) >> 8;
+      sq_lo = (-30000 * vol) >> 8;
+      for( i = 0 ; mix_ct > i ; i++ ) {
+         phase += phase_inc;
+         mix[i] += INT16_MAX >= (uint16_t)phase ? sq_hi : sq_lo;
+      }
+      break;
+
+   case 2:
+      /* Noise. */
+      for( i = 0 ; mix_ct > i ; i++ ) {
+         if( 0 < channel->noise_time ) {
+            channel->noise_time--;
+         } else {
+            channel->noise_last = retroflat_get_rand() % INT16_MAX;
+            channel->noise_time = channel->note / 2;
+         }
+         mix[i] += channel->noise_last;
+      }
+      phase += phase_inc * mix_ct;
+      break;
+
+   default:
+      phase += phase_inc * mix_ct;
+      break;
+   }
+
+   channel->phase = phase;
+}
+
+/* === */
+
+void _retrosnd_render_block(
+   struct RETROSND_CHANNEL* channels, retroflat_ms_t now,
+   int16_t* out, size_t out_ct
+) {
+   int32_t mix[RETROSND_MIX_BLOCK_SZ];
+   size_t ch_end[RETROSND_CHANNEL_CT_MAX];
+   size_t block_start = 0,
+      block_ct = 0,
+      ch_ct = 0,
+      j = 0;
+   retroflat_ms_t remain_ms = 0;
    int i = 0;
 
-   /* Mix each of the channels into a single sample. */
+   /* Check deadlines once for the whole block, turning each one into the
+    * sample its channel should stop at.
+    */
    for( i = 0 ; RETROSND_CHANNEL_CT_MAX > i ; i++ ) {
-      if( RETROSND_TUNE_NOTE_DISABLED == channels[i].note ) {
-         continue;
-      }
+      ch_end[i] = out_ct;
 
       if(
-         channels[i].deadline > 0 && channels[i].deadline < retroflat_get_ms()
+         RETROSND_TUNE_NOTE_DISABLED == channels[i].note ||
+         0 == channels[i].deadline
       ) {
+         continue;
+      }
+
+      if( channels[i].deadline < now ) {
 #if RETROSND_TRACE_LVL > 0
          debug_printf( RETROSND_TRACE_LVL, "note %d disabled after deadline!",
             i );
@@ -702,44 +829,63 @@ int16_t _retrosnd_generate_note( struct RETROSND_CHANNEL* channels ) {
          continue;
       }
 
-      channels[i].phase += gc_phase_inc[channels[i].note];
+      remain_ms = channels[i].deadline - now;
+      if( remain_ms < (out_ct * 1000) / RETROSND_SAMPLE_RATE ) {
+         ch_end[i] =
+            ((uint32_t)remain_ms * RETROSND_SAMPLE_RATE) / 1000;
+      }
+   }
 
-      switch( channels[i].voice ) {
-      case 0:
-         /* Triangle wave. */
-         if( 32768 > channels[i].phase ) {
-            mix += (channels[i].phase - 16384) * 2;
-         } else {
-            mix += ((uint16_t)((((65536 - channels[i].phase)
-               - 16384) * 2)) * channels[i].vol) >> 8;
+   for( block_start = 0 ; out_ct > block_start ; block_start += block_ct ) {
+      block_ct = out_ct - block_start;
+      if( RETROSND_MIX_BLOCK_SZ < block_ct ) {
+         block_ct = RETROSND_MIX_BLOCK_SZ;
+      }
+
+      maug_mzero( mix, block_ct * sizeof( int32_t ) );
+
+      /* Mix each of the channels into the block. */
+      for( i = 0 ; RETROSND_CHANNEL_CT_MAX > i ; i++ ) {
+         if(
+            RETROSND_TUNE_NOTE_DISABLED == channels[i].note ||
+            ch_end[i] <= block_start
+         ) {
+            continue;
          }
-         break;
 
-      case 1:
-         /* Square wave. */
-         mix += ((INT16_MAX >= (uint16_t)(channels[i].phase) ? 30000 : -30000)
-               * channels[i].vol) >> 8;
-         break;
+         ch_ct = ch_end[i] - block_start;
+         if( block_ct < ch_ct ) {
+            ch_ct = block_ct;
+         }
+
+         _retrosnd_mix_channel( &(channels[i]), mix, ch_ct );
+      }
 
-      case 2:
-         if( 0 < channels[i].noise_time ) {
-            channels[i].noise_time--;
+      /* Clip the samples and assign them. */
+      for( j = 0 ; block_ct > j ; j++ ) {
+         if( INT16_MAX <= mix[j] ) {
+            out[block_start + j] = INT16_MAX;
+         } else if( INT16_MIN > mix[j] ) {
+            out[block_start + j] = INT16_MIN;
          } else {
-            channels[i].noise_last = retroflat_get_rand() % INT16_MAX;
-            channels[i].noise_time = channels[i].note / 2;
+            out[block_start + j] = mix[j];
          }
-         mix += channels[i].noise_last;
-         break;
       }
    }
 
-   /* Clip the sample and assign it. */
-   if( INT16_MAX <= mix ) {
-      return INT16_MAX;
-   } else if( INT16_MIN > mix ) {
-      return INT16_MIN;
-   } else {
-      return mix;
+   /* Silence any channels that hit their deadline during this block. */
+   for( i = 0 ; RETROSND_CHANNEL_CT_MAX > i ; i++ ) {
+      if(
+         RETROSND_TUNE_NOTE_DISABLED != channels[i].note &&
+         ch_end[i] < out_ct
+      ) {
+#if RETROSND_TRACE_LVL > 0
+         debug_printf( RETROSND_TRACE_LVL,
+            "note %d disabled at sample " SIZE_T_FMT "!", i, ch_end[i] );
+#endif /* RETROSND_TRACE_LVL */
+         channels[i].note = RETROSND_TUNE_NOTE_DISABLED;
+         channels[i].deadline = 0;
+      }
    }
 }
 
@@ -764,6 +910,48 @@ MERROR_RETVAL _retrosnd_set_control(
    return retval;
 }
 
+/* === */
+
+static void _retrosnd_lsbf( uint8_t* bytes, uint32_t val, size_t sz ) {
+   size_t i = 0;
+
+   for( i = 0 ; sz > i ; i++ ) {
+      bytes[i] = (val >> (8 * i)) & 0xff;
+   }
+}
+
+/* === */
+
+void _retrosnd_pcm_lsbf( const int16_t* buf, size_t buf_ct, uint8_t* out ) {
+   size_t i = 0;
+
+   for( i = 0 ; buf_ct > i ; i++ ) {
+      _retrosnd_lsbf( &(out[i * 2]), (uint16_t)(buf[i]), 2 );
+   }
+}
+
+/* === */
+
+MERROR_RETVAL _retrosnd_write_wav_hdr( mfile_t* p_out, uint32_t samples_ct ) {
+   uint8_t hdr[RETROSND_WAV_HDR_SZ];
+   uint32_t data_sz = samples_ct * sizeof( int16_t );
+
+   maug_mcpy( &(hdr[0]), "RIFF", 4 );
+   _retrosnd_lsbf( &(hdr[4]), RETROSND_WAV_HDR_SZ - 8 + data_sz, 4 );
+   maug_mcpy( &(hdr[8]), "WAVEfmt ", 8 );
+   _retrosnd_lsbf( &(hdr[16]), 16, 4 );
+   _retrosnd_lsbf( &(hdr[20]), 1, 2 ); /* PCM */
+   _retrosnd_lsbf( &(hdr[22]), 1, 2 ); /* Mono */
+   _retrosnd_lsbf( &(hdr[24]), RETROSND_SAMPLE_RATE, 4 );
+   _retrosnd_lsbf( &(hdr[28]), RETROSND_SAMPLE_RATE * sizeof( int16_t ), 4 );
+   _retrosnd_lsbf( &(hdr[32]), sizeof( int16_t ), 2 ); /* Block align */
+   _retrosnd_lsbf( &(hdr[34]), 16, 2 ); /* Bits per sample */
+   maug_mcpy( &(hdr[36]), "data", 4 );
+   _retrosnd_lsbf( &(hdr[40]), data_sz, 4 );
+
+   return p_out->write_block( p_out, hdr, RETROSND_WAV_HDR_SZ );
+}
+
 #endif /* !RETROFLAT_NO_SOUND */
 
 #else
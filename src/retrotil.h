@@ -63,6 +63,32 @@
 #  define RETROTILE_PARSER_FLAG_LITERAL_PATHS 0x02
 #endif /* !RETROTILE_PARSER_FLAG_LITERAL_PATHS */
 
+#ifndef RETROTILE_PARSER_FLAG_CACHE
+/**
+ * \relates RETROTILE_PARSER
+ * \brief Flag for RETROTILE_PARSER::flags indicating to load tilemaps from a
+ *        compiled cache if it is still current, and to write one after
+ *        parsing otherwise. See ::RETROTILE_CACHE_HEADER.
+ * \warning The token_cb passed to retrotile_parse_json_file() is not called
+ *          for tilemaps loaded from the cache, so it should only modify the
+ *          tilemap and tile definitions when this is used.
+ */
+#  define RETROTILE_PARSER_FLAG_CACHE 0x04
+#endif /* !RETROTILE_PARSER_FLAG_CACHE */
+
+#ifndef RETROTILE_CACHE_EXT
+/*! \brief Suffix added to a tilemap's path to get its compiled cache path. */
+#  define RETROTILE_CACHE_EXT ".rtc"
+#endif /* !RETROTILE_CACHE_EXT */
+
+/*! \brief Value of RETROTILE_CACHE_HEADER::magic ("RTC" and a version). */
+#define RETROTILE_CACHE_MAGIC 0x02435452
+
+#ifndef RETROTILE_CACHE_SUM_BUF_SZ
+/*! \brief Bytes read at a time when checksumming a cache source file. */
+#  define RETROTILE_CACHE_SUM_BUF_SZ 512
+#endif /* !RETROTILE_CACHE_SUM_BUF_SZ */
+
 /**
  * \relates RETROTILE_PARSER
  * \brief Value for RETROTILE_PARSER::mode indicating the parser is currently
@@ -274,7 +300,8 @@ struct RETROTILE_DATA_BORDER {
    (retrotile_get_tiles_p( layer )[((y) * (tilemap)->tiles_w) + (x)])
 
 #define retrotile_set_tile( tilemap, layer, x, y, new_val ) \
-   (retrotile_get_tiles_p( layer )[((y) * (tilemap)->tiles_w) + (x)])
+   (retrotile_get_tiles_p( layer )[((y) * (tilemap)->tiles_w) + (x)] = \
+      (new_val))
 
 #define retrotile_get_tiles_p( layer ) \
    ((retroflat_tile_t*)(((uint8_t*)(layer)) + \
@@ -303,6 +330,45 @@ struct RETROTILE_DATA_BORDER {
  * \{
  */
 
+/**
+ * \brief Size and checksum of a file a compiled tilemap cache was built from.
+ */
+struct RETROTILE_CACHE_SRC {
+   uint32_t sz;
+   /*! \brief FNV-1a hash of the file's contents. */
+   uint32_t sum;
+};
+
+/**
+ * \brief Header at the start of a compiled tilemap cache, written next to
+ *        the tilemap JSON by retrotile_parse_json_file() when
+ *        ::RETROTILE_PARSER_FLAG_CACHE is set.
+ *
+ * The header is followed by the ::RETROTILE tilemap exactly as it is laid out
+ * in memory (RETROTILE::total_sz bytes), and then by tile_defs_ct
+ * ::RETROTILE_TILE_DEF structs. These are stored in the native layout, so the
+ * cache is only good for the build that wrote it. The struct sizes recorded
+ * here catch most mismatches, and the cache is rebuilt if the contents of the
+ * tilemap or its tileset change.
+ */
+struct RETROTILE_CACHE_HEADER {
+   /*! \brief Always ::RETROTILE_CACHE_MAGIC. */
+   uint32_t magic;
+   uint32_t hdr_sz;
+   uint32_t tilemap_hdr_sz;
+   uint32_t layer_hdr_sz;
+   uint32_t tile_sz;
+   uint32_t tile_def_sz;
+   /*! \brief Size of the tilemap following this header in bytes. */
+   uint32_t tilemap_sz;
+   /*! \brief Number of tile definitions following the tilemap. */
+   uint32_t tile_defs_ct;
+   struct RETROTILE_CACHE_SRC tilemap_src;
+   struct RETROTILE_CACHE_SRC tileset_src;
+   /*! \brief Filename of the external tileset, relative to the tilemap. */
+   maug_path tileset_filename;
+};
+
 typedef MERROR_RETVAL (*retrotile_tj_parse_cb)(
    const char* dirname, const char* filename, MAUG_MHANDLE* p_tm_h,
    struct MDATA_VECTOR* p_td, mparser_wait_cb_t wait_cb, void* wait_data,
@@ -349,6 +415,8 @@ struct RETROTILE_PARSER {
    struct MDATA_VECTOR* p_tile_defs;
    maug_path dirname;
    uint16_t layer_class;
+   /*! \brief Filename of the last external tileset parsed, for the cache. */
+   maug_path tileset_filename;
 };
 
 /*    State                        Idx JSONKeyWord    Parent       ParseMode */
@@ -426,6 +494,9 @@ mfix_t retrotile_static_rotation_from_dir( const char* dir );
  * \param passes Number of passes to make on parsed tilemap. This can be
  *               combined with token_cb for more advanced operations. The
  *               minimum is 2.
+ * \param flags Parser flags, e.g. ::RETROTILE_PARSER_FLAG_CACHE to skip
+ *              parsing if a current compiled cache is found next to the
+ *              tilemap.
  * \return MERROR_OK if successful or other MERROR_RETVAL otherwise.
  * \note This function ignores RETROFLAT_STATE::assets_path.
  */
@@ -1024,6 +1095,7 @@ MERROR_RETVAL retrotile_parser_parse_token(
 #if RETROTILE_TRACE_LVL > 0
             debug_printf( RETROTILE_TRACE_LVL, "parsing %s...", token );
 #endif /* RETROTILE_TRACE_LVL */
+            mfile_assign_path( parser->tileset_filename, token, 0 );
             parser->tj_parse_cb(
                parser->dirname, token, NULL, parser->p_tile_defs,
                parser->wait_cb, parser->wait_data,
@@ -1250,6 +1322,277 @@ mfix_t retrotile_static_rotation_from_dir( const char* dir ) {
 
 /* === */
 
+static MERROR_RETVAL _retrotile_cache_sum_src(
+   mfile_t* p_src_file, struct RETROTILE_CACHE_SRC* src
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   uint8_t buf[RETROTILE_CACHE_SUM_BUF_SZ];
+   size_t read_sz = 0;
+   size_t i = 0;
+
+   src->sz = mfile_get_sz( p_src_file );
+   src->sum = 2166136261u; /* FNV offset basis. */
+
+   retval = p_src_file->seek( p_src_file, 0 );
+   maug_cleanup_if_not_ok();
+
+   while( p_src_file->has_bytes( p_src_file ) ) {
+      read_sz = p_src_file->has_bytes( p_src_file );
+      if( RETROTILE_CACHE_SUM_BUF_SZ < read_sz ) {
+         read_sz = RETROTILE_CACHE_SUM_BUF_SZ;
+      }
+
+      retval = p_src_file->read_block( p_src_file, buf, read_sz );
+      maug_cleanup_if_not_ok();
+
+      for( i = 0 ; read_sz > i ; i++ ) {
+         src->sum ^= buf[i];
+         src->sum *= 16777619u;
+      }
+   }
+
+   /* Leave the file where the JSON parser expects to find it. */
+   retval = p_src_file->seek( p_src_file, 0 );
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL _retrotile_cache_stat_src(
+   const maug_path path, struct RETROTILE_CACHE_SRC* src
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   mfile_t src_file;
+
+   maug_mzero( &src_file, sizeof( mfile_t ) );
+
+   retval = mfile_open_read( path, &src_file );
+   maug_cleanup_if_not_ok();
+
+   retval = _retrotile_cache_sum_src( &src_file, src );
+
+cleanup:
+
+   mfile_close( &src_file );
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL _retrotile_cache_load(
+   const maug_path cache_path, struct RETROTILE_PARSER* parser,
+   mfile_t* p_tilemap_file, MAUG_MHANDLE* p_tilemap_h,
+   struct MDATA_VECTOR* p_tile_defs
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   mfile_t cache_file;
+   struct RETROTILE_CACHE_HEADER hdr;
+   struct RETROTILE_CACHE_SRC tilemap_src;
+   struct RETROTILE_CACHE_SRC tileset_src;
+   struct RETROTILE* t = NULL;
+   maug_path tileset_path;
+
+   maug_mzero( &cache_file, sizeof( mfile_t ) );
+
+   retval = mfile_open_read( cache_path, &cache_file );
+   if( MERROR_OK != retval ) {
+#if RETROTILE_TRACE_LVL > 0
+      debug_printf( RETROTILE_TRACE_LVL, "no tilemap cache at %s",
+         cache_path );
+#endif /* RETROTILE_TRACE_LVL */
+      goto cleanup;
+   }
+
+   if( sizeof( struct RETROTILE_CACHE_HEADER ) > mfile_get_sz( &cache_file ) ) {
+      error_printf( "tilemap cache %s is too small!", cache_path );
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   retval = cache_file.read_block(
+      &cache_file, (uint8_t*)&hdr, sizeof( struct RETROTILE_CACHE_HEADER ) );
+   maug_cleanup_if_not_ok();
+
+   /* Make sure the cache was written by this build from the same source. */
+   if(
+      RETROTILE_CACHE_MAGIC != hdr.magic ||
+      sizeof( struct RETROTILE_CACHE_HEADER ) != hdr.hdr_sz ||
+      sizeof( struct RETROTILE ) != hdr.tilemap_hdr_sz ||
+      sizeof( struct RETROTILE_LAYER ) != hdr.layer_hdr_sz ||
+      sizeof( retroflat_tile_t ) != hdr.tile_sz ||
+      sizeof( struct RETROTILE_TILE_DEF ) != hdr.tile_def_sz ||
+      mfile_get_sz( &cache_file ) != sizeof( struct RETROTILE_CACHE_HEADER ) +
+         hdr.tilemap_sz + (hdr.tile_defs_ct * hdr.tile_def_sz) ||
+      sizeof( struct RETROTILE ) > hdr.tilemap_sz ||
+      mfile_get_sz( p_tilemap_file ) != hdr.tilemap_src.sz
+   ) {
+#if RETROTILE_TRACE_LVL > 0
+      debug_printf( RETROTILE_TRACE_LVL, "tilemap cache %s is stale!",
+         cache_path );
+#endif /* RETROTILE_TRACE_LVL */
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   /* Sizes match, so only now is it worth reading the whole tilemap. */
+   retval = _retrotile_cache_sum_src( p_tilemap_file, &tilemap_src );
+   maug_cleanup_if_not_ok();
+   if( tilemap_src.sum != hdr.tilemap_src.sum ) {
+#if RETROTILE_TRACE_LVL > 0
+      debug_printf( RETROTILE_TRACE_LVL, "tilemap cache %s is stale!",
+         cache_path );
+#endif /* RETROTILE_TRACE_LVL */
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   if( '\0' != hdr.tileset_filename[0] ) {
+      /* The tile defs came from the tileset, so it must not have changed. */
+      hdr.tileset_filename[MAUG_PATH_SZ_MAX - 1] = '\0';
+      retrotile_format_asset_path(
+         tileset_path, hdr.tileset_filename, parser );
+      retval = _retrotile_cache_stat_src( tileset_path, &tileset_src );
+      maug_cleanup_if_not_ok();
+      if(
+         tileset_src.sz != hdr.tileset_src.sz ||
+         tileset_src.sum != hdr.tileset_src.sum
+      ) {
+#if RETROTILE_TRACE_LVL > 0
+         debug_printf( RETROTILE_TRACE_LVL,
+            "tileset %s changed since tilemap cache %s was written!",
+            tileset_path, cache_path );
+#endif /* RETROTILE_TRACE_LVL */
+         retval = MERROR_FILE;
+         goto cleanup;
+      }
+   }
+
+   /* Read the tilemap straight into its new handle. */
+   maug_malloc_test( *p_tilemap_h, 1, hdr.tilemap_sz );
+   maug_mlock( *p_tilemap_h, t );
+   maug_cleanup_if_null_lock( struct RETROTILE*, t );
+
+   retval = cache_file.read_block( &cache_file, (uint8_t*)t, hdr.tilemap_sz );
+   maug_cleanup_if_not_ok();
+
+   if( hdr.tilemap_sz != t->total_sz ) {
+      error_printf( "tilemap cache %s is corrupt!", cache_path );
+      retval = MERROR_FILE;
+      goto cleanup;
+   }
+
+   /* Then read the tile defs straight into the vector. */
+   if( 0 < hdr.tile_defs_ct ) {
+      mdata_vector_fill( p_tile_defs, hdr.tile_defs_ct,
+         sizeof( struct RETROTILE_TILE_DEF ) );
+      mdata_vector_lock( p_tile_defs );
+      retval = cache_file.read_block( &cache_file,
+         (uint8_t*)mdata_vector_get_void( p_tile_defs, 0 ),
+         hdr.tile_defs_ct * sizeof( struct RETROTILE_TILE_DEF ) );
+      mdata_vector_unlock( p_tile_defs );
+      maug_cleanup_if_not_ok();
+   }
+
+#if RETROTILE_TRACE_LVL > 0
+   debug_printf( RETROTILE_TRACE_LVL,
+      "loaded tilemap and " U32_FMT " tile defs from cache %s",
+      hdr.tile_defs_ct, cache_path );
+#endif /* RETROTILE_TRACE_LVL */
+
+cleanup:
+
+   if( NULL != t ) {
+      maug_munlock( *p_tilemap_h, t );
+   }
+
+   if( MERROR_OK != retval ) {
+      /* Leave things as we found them so the JSON can be parsed instead. */
+      if( (MAUG_MHANDLE)NULL != *p_tilemap_h ) {
+         maug_mfree( *p_tilemap_h );
+         *p_tilemap_h = (MAUG_MHANDLE)NULL;
+      }
+      mdata_vector_free( p_tile_defs );
+   }
+
+   mfile_close( &cache_file );
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL _retrotile_cache_write(
+   const maug_path cache_path, struct RETROTILE_PARSER* parser,
+   mfile_t* p_tilemap_file
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   mfile_t cache_file;
+   struct RETROTILE_CACHE_HEADER hdr;
+   maug_path tileset_path;
+
+   maug_mzero( &cache_file, sizeof( mfile_t ) );
+   maug_mzero( &hdr, sizeof( struct RETROTILE_CACHE_HEADER ) );
+
+   assert( NULL != parser->t );
+
+   hdr.magic = RETROTILE_CACHE_MAGIC;
+   hdr.hdr_sz = sizeof( struct RETROTILE_CACHE_HEADER );
+   hdr.tilemap_hdr_sz = sizeof( struct RETROTILE );
+   hdr.layer_hdr_sz = sizeof( struct RETROTILE_LAYER );
+   hdr.tile_sz = sizeof( retroflat_tile_t );
+   hdr.tile_def_sz = sizeof( struct RETROTILE_TILE_DEF );
+   hdr.tilemap_sz = parser->t->total_sz;
+   hdr.tile_defs_ct = mdata_vector_ct( parser->p_tile_defs );
+   retval = _retrotile_cache_sum_src( p_tilemap_file, &(hdr.tilemap_src) );
+   maug_cleanup_if_not_ok();
+
+   if( '\0' != parser->tileset_filename[0] ) {
+      mfile_assign_path( hdr.tileset_filename, parser->tileset_filename, 0 );
+      retrotile_format_asset_path(
+         tileset_path, parser->tileset_filename, parser );
+      retval = _retrotile_cache_stat_src( tileset_path, &(hdr.tileset_src) );
+      maug_cleanup_if_not_ok();
+   }
+
+   retval = mfile_open_write( cache_path, &cache_file );
+   maug_cleanup_if_not_ok();
+
+   retval = cache_file.write_block( &cache_file, (uint8_t*)&hdr,
+      sizeof( struct RETROTILE_CACHE_HEADER ) );
+   maug_cleanup_if_not_ok();
+
+   retval = cache_file.write_block(
+      &cache_file, (uint8_t*)(parser->t), parser->t->total_sz );
+   maug_cleanup_if_not_ok();
+
+   if( 0 < hdr.tile_defs_ct ) {
+      assert(
+         sizeof( struct RETROTILE_TILE_DEF ) == parser->p_tile_defs->item_sz );
+      mdata_vector_lock( parser->p_tile_defs );
+      retval = cache_file.write_block( &cache_file,
+         (uint8_t*)mdata_vector_get_void( parser->p_tile_defs, 0 ),
+         hdr.tile_defs_ct * sizeof( struct RETROTILE_TILE_DEF ) );
+      mdata_vector_unlock( parser->p_tile_defs );
+      maug_cleanup_if_not_ok();
+   }
+
+#if RETROTILE_TRACE_LVL > 0
+   debug_printf( RETROTILE_TRACE_LVL, "wrote tilemap cache %s", cache_path );
+#endif /* RETROTILE_TRACE_LVL */
+
+cleanup:
+
+   mfile_close( &cache_file );
+
+   return retval;
+}
+
+/* === */
+
 MERROR_RETVAL retrotile_parse_json_file(
    const maug_path dirname, const char* filename, MAUG_MHANDLE* p_tilemap_h,
    struct MDATA_VECTOR* p_tile_defs, mparser_wait_cb_t wait_cb, void* wait_data,
@@ -1261,8 +1604,14 @@ MERROR_RETVAL retrotile_parse_json_file(
    struct RETROTILE_PARSER* parser = NULL;
    maug_path filename_path;
    mfile_t tile_file;
-   char c;
+   uint8_t chunk[MFILE_CHUNK_SZ];
+   size_t chunk_sz = 0;
+   size_t i = 0;
    char* filename_ext = NULL;
+   maug_path cache_path;
+
+   maug_mzero( &tile_file, sizeof( mfile_t ) );
+   maug_mzero( cache_path, MAUG_PATH_SZ_MAX );
 
    /* Initialize parser. */
    maug_malloc_test( parser_h, 1, sizeof( struct RETROTILE_PARSER ) );
@@ -1299,6 +1648,24 @@ MERROR_RETVAL retrotile_parse_json_file(
    retval = mfile_open_read( filename_path, &tile_file );
    maug_cleanup_if_not_ok();
 
+   if(
+      RETROTILE_PARSER_FLAG_CACHE == (RETROTILE_PARSER_FLAG_CACHE & flags) &&
+      /* Only cache tilemaps, which carry their tilesets' defs with them. */
+      NULL != p_tilemap_h && (MAUG_MHANDLE)NULL == *p_tilemap_h &&
+      NULL != p_tile_defs && (MAUG_MHANDLE)NULL == p_tile_defs->data_h &&
+      maug_strlen( filename_path ) + maug_strlen( RETROTILE_CACHE_EXT ) <
+         MAUG_PATH_SZ_MAX - 1
+   ) {
+      maug_snprintf( cache_path, MAUG_PATH_SZ_MAX - 1,
+         "%s" RETROTILE_CACHE_EXT, filename_path );
+      if(
+         MERROR_OK == _retrotile_cache_load(
+            cache_path, parser, &tile_file, p_tilemap_h, p_tile_defs )
+      ) {
+         goto cleanup;
+      }
+   }
+
    /* Parse JSON and react to state. */
    for( parser->pass = 0 ; passes > parser->pass ; parser->pass++ ) {
 #if RETROTILE_TRACE_LVL > 0
@@ -1388,14 +1755,18 @@ MERROR_RETVAL retrotile_parse_json_file(
       }
 
       while( tile_file.has_bytes( &tile_file ) ) {
-         tile_file.read_int( &tile_file, (uint8_t*)&c, 1, 0 );
+         retval = mfile_read_chunk(
+            &tile_file, chunk, MFILE_CHUNK_SZ, &chunk_sz );
+         maug_cleanup_if_not_ok();
+         for( i = 0 ; chunk_sz > i ; i++ ) {
 #if RETROTILE_TRACE_CHARS > 0
-         debug_printf( RETROTILE_TRACE_CHARS, "%c", c );
+            debug_printf( RETROTILE_TRACE_CHARS, "%c", chunk[i] );
 #endif /* RETROTILE_TRACE_CHARS */
-         retval = mjson_parse_c( &(parser->jparser), c );
-         if( MERROR_OK != retval ) {
-            error_printf( "error parsing JSON!" );
-            goto cleanup;
+            retval = mjson_parse_c( &(parser->jparser), chunk[i] );
+            if( MERROR_OK != retval ) {
+               error_printf( "error parsing JSON!" );
+               goto cleanup;
+            }
          }
       }
 
@@ -1422,6 +1793,15 @@ MERROR_RETVAL retrotile_parse_json_file(
       filename_path, retval );
 #endif /* RETROTILE_TRACE_LVL */
 
+   if( '\0' != cache_path[0] ) {
+      /* This just means parsing the JSON again next time. */
+      if(
+         MERROR_OK != _retrotile_cache_write( cache_path, parser, &tile_file )
+      ) {
+         error_printf( "could not write tilemap cache: %s", cache_path );
+      }
+   }
+
 cleanup:
 
    if( NULL != parser ) {
@@ -1435,6 +1815,8 @@ cleanup:
       maug_mfree( parser_h );
    }
 
+   mfile_close( &tile_file );
+
    return retval;
 }
 
@@ -105,8 +105,22 @@ struct RETROWIN {
 #endif /* !RETROWIN_NO_BITMAP */
 };
 
+/**
+ * \brief Redraw windows on the stack that are dirty or damaged (see
+ *        retrogui_redraw_ctls()) and blit them to the screen.
+ */
 MERROR_RETVAL retrowin_redraw_win_stack( struct MDATA_VECTOR* win_stack );
 
+/**
+ * \brief Get a single rectangle in screen coordinates enclosing everything
+ *        that the next retrowin_redraw_win_stack() will redraw in any window
+ *        on the stack.
+ * \param p_rect Pointer to a rect to fill. Its w and h will be 0 if nothing
+ *               will be redrawn.
+ */
+MERROR_RETVAL retrowin_get_win_stack_damage(
+   struct MDATA_VECTOR* win_stack, struct RETROGUI_RECT* p_rect );
+
 /**
  * \brief Force all windows on the stack to redraw.
  */
@@ -290,6 +304,54 @@ cleanup:
 
 /* === */
 
+#ifndef RETROWIN_NO_BITMAP
+
+static MERROR_RETVAL _retrowin_clear_damage( struct RETROWIN* win ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   RETROFLAT_COLOR bg_color = RETROFLAT_COLOR_BLACK;
+   size_t i = 0;
+
+   retval = retrogui_collect_damage( win->gui_p );
+   maug_cleanup_if_not_ok();
+
+   /* Use the same fill as _retrowin_draw_border(). */
+   switch( RETROWIN_FLAG_BORDER_MASK & win->flags ) {
+   case RETROWIN_FLAG_BORDER_GRAY:
+      bg_color = 2 < retroflat_screen_colors() ?
+         RETROFLAT_COLOR_GRAY : RETROFLAT_COLOR_WHITE;
+      break;
+
+   case RETROWIN_FLAG_BORDER_BLUE:
+      bg_color = 2 < retroflat_screen_colors() ?
+         RETROFLAT_COLOR_BLUE : RETROFLAT_COLOR_BLACK;
+      break;
+   }
+
+#if RETROWIN_TRACE_LVL > 0
+   debug_printf( RETROWIN_TRACE_LVL,
+      "clearing " SIZE_T_FMT " damaged regions of window IDC "
+         RETROGUI_IDC_FMT "...", win->gui_p->damage_ct, win->idc );
+#endif /* RETROWIN_TRACE_LVL */
+
+   for( i = 0 ; win->gui_p->damage_ct > i ; i++ ) {
+      retroflat_2d_rect(
+         win->gui_p->draw_bmp, bg_color,
+         win->gui_p->x + win->gui_p->damage[i].x,
+         win->gui_p->y + win->gui_p->damage[i].y,
+         win->gui_p->damage[i].w,
+         win->gui_p->damage[i].h,
+         RETROFLAT_DRAW_FLAG_FILL );
+   }
+
+cleanup:
+
+   return retval;
+}
+
+#endif /* !RETROWIN_NO_BITMAP */
+
+/* === */
+
 static MERROR_RETVAL _retrowin_redraw_win( struct RETROWIN* win ) {
    MERROR_RETVAL retval = MERROR_OK;
    uint8_t autolock_gui = 0;
@@ -323,7 +385,18 @@ static MERROR_RETVAL _retrowin_redraw_win( struct RETROWIN* win ) {
    win->gui_p->x = 0;
    win->gui_p->y = 0;
 #endif /* !RETROWIN_NO_BITMAP */
-   retval = _retrowin_draw_border( win );
+#ifndef RETROWIN_NO_BITMAP
+   if(
+      RETROGUI_FLAGS_DIRTY != (RETROGUI_FLAGS_DIRTY & win->gui_p->flags)
+   ) {
+      /* Only some controls changed, so leave the rest of the bitmap be. */
+      retval = _retrowin_clear_damage( win );
+   } else {
+#endif /* !RETROWIN_NO_BITMAP */
+      retval = _retrowin_draw_border( win );
+#ifndef RETROWIN_NO_BITMAP
+   }
+#endif /* !RETROWIN_NO_BITMAP */
    if( MERROR_OK == retval ) {
       retval = retrogui_redraw_ctls( win->gui_p );
    }
@@ -381,7 +454,8 @@ MERROR_RETVAL retrowin_redraw_win_stack( struct MDATA_VECTOR* win_stack ) {
 
 #ifndef RETROWIN_NO_BITMAP
       if(
-         RETROGUI_FLAGS_DIRTY == (RETROGUI_FLAGS_DIRTY & win->gui_p->flags)
+         RETROGUI_FLAGS_DIRTY == (RETROGUI_FLAGS_DIRTY & win->gui_p->flags) ||
+         RETROGUI_FLAGS_DAMAGED == (RETROGUI_FLAGS_DAMAGED & win->gui_p->flags)
       ) {
 #endif /* !RETROWIN_NO_BITMAP */
 #if RETROWIN_TRACE_LVL > 0
@@ -430,6 +504,79 @@ cleanup:
 
 /* === */
 
+MERROR_RETVAL retrowin_get_win_stack_damage(
+   struct MDATA_VECTOR* win_stack, struct RETROGUI_RECT* p_rect
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t i = 0;
+   struct RETROWIN* win = NULL;
+   struct RETROGUI_RECT win_rect;
+   retroflat_pxxy_t x2 = 0;
+   retroflat_pxxy_t y2 = 0;
+   uint8_t autolock_stack = 0;
+
+   maug_mzero( p_rect, sizeof( struct RETROGUI_RECT ) );
+
+   if( 0 == mdata_vector_ct( win_stack ) ) {
+      goto cleanup;
+   }
+
+   if( !mdata_vector_is_locked( win_stack ) ) {
+      mdata_vector_lock( win_stack );
+      autolock_stack = 1;
+   }
+
+   for( i = 0 ; mdata_vector_ct( win_stack ) > i ; i++ ) {
+      win = mdata_vector_get( win_stack, i, struct RETROWIN );
+      assert( NULL != win );
+
+      if( !retrowin_win_is_active( win ) ) {
+         continue;
+      }
+
+      retrowin_lock_gui( win );
+      retval = retrogui_get_damage( win->gui_p, &win_rect );
+      retrowin_unlock_gui( win );
+      maug_cleanup_if_not_ok();
+
+      if( 0 == win_rect.w || 0 == win_rect.h ) {
+         continue;
+      }
+
+      /* Move the window's damage into screen coordinates. */
+      win_rect.x += win->x;
+      win_rect.y += win->y;
+
+      if( 0 == p_rect->w || 0 == p_rect->h ) {
+         maug_mcpy( p_rect, &win_rect, sizeof( struct RETROGUI_RECT ) );
+         continue;
+      }
+
+      x2 = p_rect->x + p_rect->w > win_rect.x + win_rect.w ?
+         p_rect->x + p_rect->w : win_rect.x + win_rect.w;
+      y2 = p_rect->y + p_rect->h > win_rect.y + win_rect.h ?
+         p_rect->y + p_rect->h : win_rect.y + win_rect.h;
+      if( win_rect.x < p_rect->x ) {
+         p_rect->x = win_rect.x;
+      }
+      if( win_rect.y < p_rect->y ) {
+         p_rect->y = win_rect.y;
+      }
+      p_rect->w = x2 - p_rect->x;
+      p_rect->h = y2 - p_rect->y;
+   }
+
+cleanup:
+
+   if( autolock_stack ) {
+      mdata_vector_unlock( win_stack );
+   }
+
+   return retval;
+}
+
+/* === */
+
 MERROR_RETVAL retrowin_refresh_win_stack( struct MDATA_VECTOR* win_stack ) {
    MERROR_RETVAL retval = MERROR_OK;
    size_t i = 0;
@@ -0,0 +1,214 @@
+#define MAUG_C
+#include <maug.h>
+
+/* Frame-time benchmark for bitmap blitting: draws a tilemap viewport out of a
+ * large tileset every frame, both straight to the screen and through an
+ * off-screen bitmap, touching the tileset now and then so it has to be
+ * re-uploaded. Runs headless under SDL with SDL_VIDEODRIVER=dummy, or on the
+ * soft platform with no display at all.
+ */
+
+#define BLITBENCH_FRAMES_DEFAULT 300
+
+#define BLITBENCH_TILESET_SZ 512
+
+#define BLITBENCH_TILE_SZ 8
+
+#define BLITBENCH_SCREEN_W 320
+
+#define BLITBENCH_SCREEN_H 200
+
+/* Redraw one pixel of the tileset every this many frames. */
+#define BLITBENCH_TOUCH_EVERY 10
+
+/* Whole frames can take well under a millisecond, so time them in
+ * microseconds where the OS has a monotonic clock to do it with.
+ */
+static uint32_t blitbench_get_us( void ) {
+#ifdef RETROFLAT_OS_UNIX
+   struct timespec spec;
+
+   clock_gettime( CLOCK_MONOTONIC, &spec );
+   return (uint32_t)((spec.tv_sec * 1000000) + (spec.tv_nsec / 1000));
+#else
+   return retroflat_get_ms() * 1000;
+#endif /* RETROFLAT_OS_UNIX */
+}
+
+/* === */
+
+static MERROR_RETVAL blitbench_setup_tileset(
+   struct RETROFLAT_BITMAP* tileset
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   retroflat_pxxy_t x = 0,
+      y = 0;
+
+   retval = retroflat_create_bitmap(
+      BLITBENCH_TILESET_SZ, BLITBENCH_TILESET_SZ, tileset, 0 );
+   maug_cleanup_if_not_ok();
+
+   retroflat_draw_lock( tileset );
+   for( y = 0 ; BLITBENCH_TILESET_SZ > y ; y += BLITBENCH_TILE_SZ ) {
+      for( x = 0 ; BLITBENCH_TILESET_SZ > x ; x += BLITBENCH_TILE_SZ ) {
+         retroflat_rect( tileset,
+            ((x + y) / BLITBENCH_TILE_SZ) % 16, x, y,
+            BLITBENCH_TILE_SZ, BLITBENCH_TILE_SZ, RETROFLAT_DRAW_FLAG_FILL );
+      }
+   }
+   retroflat_draw_release( tileset );
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL blitbench_draw_tiles(
+   struct RETROFLAT_BITMAP* target, struct RETROFLAT_BITMAP* tileset,
+   size_t frame
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   retroflat_pxxy_t x = 0,
+      y = 0,
+      s_x = 0,
+      s_y = 0;
+   size_t tile_idx = frame;
+
+   for( y = 0 ; BLITBENCH_SCREEN_H > y ; y += BLITBENCH_TILE_SZ ) {
+      for( x = 0 ; BLITBENCH_SCREEN_W > x ; x += BLITBENCH_TILE_SZ ) {
+         /* Walk through the tileset so every row of it gets used. */
+         tile_idx = (tile_idx + 7) %
+            ((BLITBENCH_TILESET_SZ / BLITBENCH_TILE_SZ) *
+               (BLITBENCH_TILESET_SZ / BLITBENCH_TILE_SZ));
+         s_x = (tile_idx % (BLITBENCH_TILESET_SZ / BLITBENCH_TILE_SZ)) *
+            BLITBENCH_TILE_SZ;
+         s_y = (tile_idx / (BLITBENCH_TILESET_SZ / BLITBENCH_TILE_SZ)) *
+            BLITBENCH_TILE_SZ;
+         retval = retroflat_blit_bitmap( target, tileset, s_x, s_y, x, y,
+            BLITBENCH_TILE_SZ, BLITBENCH_TILE_SZ, 0 );
+         maug_cleanup_if_not_ok();
+      }
+   }
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+int main( int argc, char** argv ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROFLAT_ARGS args;
+   struct RETROFLAT_BITMAP tileset;
+   struct RETROFLAT_BITMAP offscreen;
+   int i = 0;
+   size_t frame = 0;
+   size_t frames = BLITBENCH_FRAMES_DEFAULT;
+   uint32_t start = 0;
+   uint32_t offscreen_us = 0;
+   uint32_t frame_us = 0;
+   uint32_t frame_us_max = 0;
+   uint32_t screen_us_total = 0;
+   uint32_t offscreen_us_total = 0;
+
+   maug_mzero( &args, sizeof( struct RETROFLAT_ARGS ) );
+   maug_mzero( &tileset, sizeof( struct RETROFLAT_BITMAP ) );
+   maug_mzero( &offscreen, sizeof( struct RETROFLAT_BITMAP ) );
+
+   for( i = 1 ; argc > i ; i++ ) {
+      if( 0 == strcmp( argv[i], "-n" ) && argc > i + 1 ) {
+         frames = atoi( argv[++i] );
+      } else {
+         fprintf( stderr, "usage: %s [-n frames]\n", argv[0] );
+         return MERROR_USR;
+      }
+   }
+
+   logging_init();
+
+   args.title = "blitbench";
+   args.screen_w = BLITBENCH_SCREEN_W;
+   args.screen_h = BLITBENCH_SCREEN_H;
+
+   /* Our own args were handled above. */
+   retval = retroflat_init( 1, argv, &args );
+   maug_cleanup_if_not_ok();
+
+   retval = blitbench_setup_tileset( &tileset );
+   maug_cleanup_if_not_ok();
+
+   retval = retroflat_create_bitmap(
+      BLITBENCH_SCREEN_W, BLITBENCH_SCREEN_H, &offscreen,
+      RETROFLAT_BITMAP_FLAG_OPAQUE );
+   maug_cleanup_if_not_ok();
+
+   for( frame = 0 ; frames > frame ; frame++ ) {
+      if( 0 == frame % BLITBENCH_TOUCH_EVERY ) {
+         /* Dirty a single row of the tileset. */
+         retroflat_draw_lock( &tileset );
+         retroflat_px( &tileset, RETROFLAT_COLOR_WHITE,
+            frame % BLITBENCH_TILESET_SZ, frame % BLITBENCH_TILESET_SZ, 0 );
+         retroflat_draw_release( &tileset );
+      }
+
+      /* Tiles straight to the screen. */
+      start = blitbench_get_us();
+      retroflat_draw_lock( NULL );
+      retval = blitbench_draw_tiles( NULL, &tileset, frame );
+      retroflat_draw_release( NULL );
+      maug_cleanup_if_not_ok();
+      frame_us = blitbench_get_us() - start;
+      screen_us_total += frame_us;
+
+      /* Tiles composited off-screen first, then to the screen. */
+      start = blitbench_get_us();
+      retroflat_draw_lock( &offscreen );
+      retval = blitbench_draw_tiles( &offscreen, &tileset, frame );
+      retroflat_draw_release( &offscreen );
+      maug_cleanup_if_not_ok();
+      retroflat_draw_lock( NULL );
+      retval = retroflat_blit_bitmap( NULL, &offscreen, 0, 0, 0, 0,
+         BLITBENCH_SCREEN_W, BLITBENCH_SCREEN_H, 0 );
+      retroflat_draw_release( NULL );
+      maug_cleanup_if_not_ok();
+      offscreen_us = blitbench_get_us() - start;
+      offscreen_us_total += offscreen_us;
+      frame_us += offscreen_us;
+
+      if( frame_us > frame_us_max ) {
+         frame_us_max = frame_us;
+      }
+   }
+
+   if( 0 < frames ) {
+      printf( SIZE_T_FMT " frames of %d tiles: screen: " U32_FMT
+         " us/frame, off-screen: " U32_FMT " us/frame, worst frame: " U32_FMT
+         " us\n", frames,
+         (BLITBENCH_SCREEN_W / BLITBENCH_TILE_SZ) *
+            (BLITBENCH_SCREEN_H / BLITBENCH_TILE_SZ),
+         (uint32_t)(screen_us_total / frames),
+         (uint32_t)(offscreen_us_total / frames),
+         frame_us_max );
+   }
+
+cleanup:
+
+   if( retroflat_bitmap_ok( &offscreen ) ) {
+      retroflat_destroy_bitmap( &offscreen );
+   }
+
+   if( retroflat_bitmap_ok( &tileset ) ) {
+      retroflat_destroy_bitmap( &tileset );
+   }
+
+   retroflat_shutdown( retval );
+
+   logging_shutdown();
+
+   return retval;
+}
+END_OF_MAIN()
+
@@ -0,0 +1,381 @@
+#define MAUG_C
+#include <maug.h>
+#include <mhtml.h>
+#include <retrofnt.h>
+#include <retrogui.h>
+#include <retrohtr.h>
+
+/* Regression tests for mcss selector lookups: parses small stylesheets into
+ * the selector index, growing it along the way, and checks that mcss_select()
+ * finds exactly the styles each selector names, in stylesheet order. Then
+ * checks how retrohtr_apply_styles() merges tag, class and ID styles for
+ * elements with several classes. mcss needs the retroflat types, so this
+ * can't live in the check suite (which builds with MAUG_NO_RETRO); build it
+ * for the soft platform to run it without a display. Exits nonzero if any
+ * check fails.
+ */
+
+#define CSSTEST_MATCHES_MAX 8
+
+/* Longer than MCSS_CLASS_SZ_MAX, but short enough to fit in a parser token. */
+#define CSSTEST_LONG_SZ 200
+
+/* Enough styles to grow the index past MCSS_INDEX_SZ_MIN. */
+#define CSSTEST_FILLERS 16
+
+#define CSSTEST_CSS_SZ 255
+
+#define CSSTEST_DIVS 5
+
+/* Seven styles, so the first index has MCSS_INDEX_SZ_MIN slots. The last two
+ * have no space between them, so the second selector starts right after a
+ * closing brace.
+ */
+static const char* gc_csstest_css =
+   "div{height:1;}\n"
+   ".a{height:2;}\n"
+   "#x{height:3;}\n"
+   ".ab{height:4;}\n"
+   ".b{width:5;}\n"
+   ".c{height:6;}span{height:7;}\n";
+
+/* Classes apply over the tag whatever their order, the last class rule in the
+ * stylesheet wins whatever the order of the classes on the element, and the
+ * ID applies over the classes.
+ */
+static const char* gc_csstest_html =
+   "<html><head><style>"
+   ".a{height:1;} .ab{height:9;} .a{width:3;} .b{width:2;} #x{height:4;} "
+   "div{height:7;width:8;}"
+   "</style></head><body>"
+   "<div class=\"a b\"></div>"
+   "<div class=\"b a\"></div>"
+   "<div class=\"ab\"></div>"
+   "<div class=\"a\" id=\"x\"></div>"
+   "<div></div>"
+   "</body></html>";
+
+static int g_csstest_failures = 0;
+
+#define csstest_check( cond, desc ) \
+   if( !(cond) ) { \
+      error_printf( "check failed: %s", desc ); \
+      g_csstest_failures++; \
+   }
+
+/* === */
+
+static MERROR_RETVAL csstest_parse(
+   struct MCSS_PARSER* parser, const char* css
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t i = 0;
+
+   for( i = 0 ; maug_strlen( css ) > i ; i++ ) {
+      retval = mcss_parse_c( parser, css[i] );
+      maug_cleanup_if_not_ok();
+   }
+
+   /* Outside of any block, this only indexes, like it does for mhtml. */
+   mcss_parser_flush( parser );
+
+   retval = mcss_parser_index( parser );
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static void csstest_check_select(
+   struct MCSS_PARSER* parser, uint8_t select_by, const char* select,
+   size_t select_sz, const ssize_t* expect, size_t expect_sz, const char* desc
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   ssize_t matches[CSSTEST_MATCHES_MAX];
+   size_t matches_sz = 0,
+      i = 0;
+
+   retval = mcss_select( parser, select_by, select, select_sz,
+      matches, &matches_sz, CSSTEST_MATCHES_MAX );
+   if( MERROR_OK != retval ) {
+      error_printf( "%s: select failed: %d", desc, retval );
+      g_csstest_failures++;
+      return;
+   }
+
+   if( expect_sz != matches_sz ) {
+      error_printf( "%s: found " SIZE_T_FMT " styles, expected " SIZE_T_FMT,
+         desc, matches_sz, expect_sz );
+      g_csstest_failures++;
+      return;
+   }
+
+   for( i = 0 ; matches_sz > i ; i++ ) {
+      if( expect[i] != matches[i] ) {
+         error_printf( "%s: match " SIZE_T_FMT " is style " SSIZE_T_FMT
+            ", expected " SSIZE_T_FMT, desc, i, matches[i], expect[i] );
+         g_csstest_failures++;
+      }
+   }
+}
+
+/* === */
+
+static MERROR_RETVAL csstest_select( struct MCSS_PARSER* parser ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   char css[CSSTEST_CSS_SZ + 1];
+   char long_class[CSSTEST_LONG_SZ + 1];
+   struct MCSS_STYLE* style = NULL;
+   ssize_t expect[CSSTEST_MATCHES_MAX];
+   ssize_t long_idx = 0;
+   size_t i = 0;
+
+   retval = csstest_parse( parser, gc_csstest_css );
+   maug_cleanup_if_not_ok();
+   csstest_check( 7 == mdata_vector_ct( &(parser->styles) ), "style count" );
+   csstest_check( MCSS_INDEX_SZ_MIN == parser->index.slots_sz, "index size" );
+
+   /* Each selector type finds its own style, and only with its own type. */
+   expect[0] = 0;
+   csstest_check_select( parser, MCSS_SELECT_TAG, "DIV", 3, expect, 1, "tag" );
+   expect[0] = 1;
+   csstest_check_select( parser, MCSS_SELECT_CLASS, "a", 1, expect, 1,
+      "class" );
+   expect[0] = 2;
+   csstest_check_select( parser, MCSS_SELECT_ID, "x", 1, expect, 1, "ID" );
+   csstest_check_select( parser, MCSS_SELECT_CLASS, "x", 1, expect, 0,
+      "ID as class" );
+   csstest_check_select( parser, MCSS_SELECT_ID, "a", 1, expect, 0,
+      "class as ID" );
+   csstest_check_select( parser, MCSS_SELECT_CLASS, "", 0, expect, 0,
+      "empty class" );
+
+   /* A class only matches exactly, not by prefix either way. */
+   expect[0] = 3;
+   csstest_check_select( parser, MCSS_SELECT_CLASS, "ab", 2, expect, 1,
+      "exact class" );
+   csstest_check_select( parser, MCSS_SELECT_CLASS, "abc", 3, expect, 0,
+      "longer class" );
+
+   /* A selector right after a closing brace is parsed on its own. */
+   expect[0] = 5;
+   csstest_check_select( parser, MCSS_SELECT_CLASS, "c", 1, expect, 1,
+      "before brace" );
+   expect[0] = 6;
+   csstest_check_select( parser, MCSS_SELECT_TAG, "SPAN", 4, expect, 1,
+      "after brace" );
+
+   /* A repeated selector goes into the index without a rebuild. */
+   retval = csstest_parse( parser, ".a{width:8;}" );
+   maug_cleanup_if_not_ok();
+   csstest_check( MCSS_INDEX_SZ_MIN == parser->index.slots_sz,
+      "index size after add" );
+   expect[0] = 1;
+   expect[1] = 7;
+   csstest_check_select( parser, MCSS_SELECT_CLASS, "a", 1, expect, 2,
+      "stylesheet order" );
+
+   /* An over-long selector is truncated to fit, and found by what's left. */
+   maug_mzero( long_class, CSSTEST_LONG_SZ + 1 );
+   memset( long_class, 'l', CSSTEST_LONG_SZ );
+   maug_snprintf( css, CSSTEST_CSS_SZ, ".%s{height:9;}", long_class );
+   retval = csstest_parse( parser, css );
+   maug_cleanup_if_not_ok();
+   long_idx = mdata_vector_ct( &(parser->styles) ) - 1;
+
+   mdata_vector_lock( &(parser->styles) );
+   style = mdata_vector_get( &(parser->styles), long_idx, struct MCSS_STYLE );
+   assert( NULL != style );
+   csstest_check( MCSS_CLASS_SZ_MAX - 1 == style->class_sz, "long class size" );
+   csstest_check( '\0' == style->class[MCSS_CLASS_SZ_MAX - 1],
+      "long class terminated" );
+   mdata_vector_unlock( &(parser->styles) );
+
+   expect[0] = long_idx;
+   csstest_check_select( parser, MCSS_SELECT_CLASS,
+      long_class, MCSS_CLASS_SZ_MAX - 1, expect, 1, "long class" );
+   csstest_check_select( parser, MCSS_SELECT_CLASS,
+      long_class, CSSTEST_LONG_SZ, expect, 0, "long class untruncated" );
+
+   /* Grow the index, then check the order survived the rebuild. */
+   for( i = 0 ; CSSTEST_FILLERS > i ; i++ ) {
+      maug_snprintf( css, CSSTEST_CSS_SZ, ".f" SIZE_T_FMT "{height:10;}", i );
+      retval = csstest_parse( parser, css );
+      maug_cleanup_if_not_ok();
+   }
+   retval = csstest_parse( parser, ".a{height:11;}" );
+   maug_cleanup_if_not_ok();
+   csstest_check( MCSS_INDEX_SZ_MIN < parser->index.slots_sz, "index grew" );
+
+   expect[0] = 1;
+   expect[1] = 7;
+   expect[2] = mdata_vector_ct( &(parser->styles) ) - 1;
+   csstest_check_select( parser, MCSS_SELECT_CLASS, "a", 1, expect, 3,
+      "stylesheet order after rebuild" );
+   expect[0] = 0;
+   csstest_check_select( parser, MCSS_SELECT_TAG, "DIV", 3, expect, 1,
+      "tag after rebuild" );
+   expect[0] = long_idx;
+   csstest_check_select( parser, MCSS_SELECT_CLASS,
+      long_class, MCSS_CLASS_SZ_MAX - 1, expect, 1, "long class after rebuild" );
+
+   /* Without an index, lookups scan, and still only match exactly. */
+   mdata_index_free( &(parser->index) );
+   expect[0] = 1;
+   expect[1] = 7;
+   expect[2] = mdata_vector_ct( &(parser->styles) ) - 1;
+   csstest_check_select( parser, MCSS_SELECT_CLASS, "a", 1, expect, 3,
+      "stylesheet order by scan" );
+   expect[0] = 3;
+   csstest_check_select( parser, MCSS_SELECT_CLASS, "ab", 2, expect, 1,
+      "exact class by scan" );
+   csstest_check_select( parser, MCSS_SELECT_CLASS, "abc", 3, expect, 0,
+      "longer class by scan" );
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static void csstest_check_size(
+   struct MCSS_STYLE* style, ssize_t height, ssize_t width, const char* desc
+) {
+   /* A negative size means the property should not be set at all. */
+   if(
+      (0 > height) == mcss_prop_is_active( style->HEIGHT ) ||
+      (0 <= height && height != style->HEIGHT) ||
+      (0 > width) == mcss_prop_is_active( style->WIDTH ) ||
+      (0 <= width && width != style->WIDTH)
+   ) {
+      error_printf( "%s: height " SSIZE_T_FMT " (%sactive), width "
+         SSIZE_T_FMT " (%sactive), expected " SSIZE_T_FMT ", " SSIZE_T_FMT,
+         desc,
+         style->HEIGHT, mcss_prop_is_active( style->HEIGHT ) ? "" : "in",
+         style->WIDTH, mcss_prop_is_active( style->WIDTH ) ? "" : "in",
+         height, width );
+      g_csstest_failures++;
+   }
+}
+
+/* === */
+
+static MERROR_RETVAL csstest_apply( struct MHTML_PARSER* parser ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROHTR_RENDER_TREE tree;
+   struct MCSS_STYLE effect_style;
+   union MHTML_TAG* tag = NULL;
+   ssize_t divs[CSSTEST_DIVS];
+   size_t divs_sz = 0,
+      i = 0;
+
+   maug_mzero( &tree, sizeof( struct RETROHTR_RENDER_TREE ) );
+
+   retval = retrohtr_tree_init( &tree );
+   maug_cleanup_if_not_ok();
+
+   /* Find the divs in document order. */
+   mdata_vector_lock( &(parser->tags) );
+   for( i = 0 ; mdata_vector_ct( &(parser->tags) ) > i ; i++ ) {
+      tag = mdata_vector_get( &(parser->tags), i, union MHTML_TAG );
+      assert( NULL != tag );
+      if( MHTML_TAG_TYPE_DIV == tag->base.type && CSSTEST_DIVS > divs_sz ) {
+         divs[divs_sz++] = i;
+      }
+   }
+   mdata_vector_unlock( &(parser->tags) );
+   csstest_check( CSSTEST_DIVS == divs_sz, "div count" );
+   if( CSSTEST_DIVS != divs_sz ) {
+      goto cleanup;
+   }
+
+   retval = retrohtr_apply_styles( parser, &tree, NULL, &effect_style, divs[0] );
+   maug_cleanup_if_not_ok();
+   csstest_check_size( &effect_style, 1, 2, "two classes" );
+
+   retval = retrohtr_apply_styles( parser, &tree, NULL, &effect_style, divs[1] );
+   maug_cleanup_if_not_ok();
+   csstest_check_size( &effect_style, 1, 2, "two classes swapped" );
+
+   retval = retrohtr_apply_styles( parser, &tree, NULL, &effect_style, divs[2] );
+   maug_cleanup_if_not_ok();
+   csstest_check_size( &effect_style, 9, 8, "longer class" );
+
+   retval = retrohtr_apply_styles( parser, &tree, NULL, &effect_style, divs[3] );
+   maug_cleanup_if_not_ok();
+   csstest_check_size( &effect_style, 4, 3, "class and ID" );
+
+   retval = retrohtr_apply_styles( parser, &tree, NULL, &effect_style, divs[4] );
+   maug_cleanup_if_not_ok();
+   csstest_check_size( &effect_style, 7, 8, "tag only" );
+
+cleanup:
+
+   retrohtr_tree_free( &tree );
+
+   return retval;
+}
+
+/* === */
+
+int main( int argc, char** argv ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROFLAT_ARGS args;
+   struct MCSS_PARSER styler;
+   struct MHTML_PARSER parser;
+   size_t i = 0;
+
+   maug_mzero( &args, sizeof( struct RETROFLAT_ARGS ) );
+   maug_mzero( &styler, sizeof( struct MCSS_PARSER ) );
+   maug_mzero( &parser, sizeof( struct MHTML_PARSER ) );
+
+   logging_init();
+
+   args.title = "csstest";
+   args.screen_w = 160;
+   args.screen_h = 120;
+
+   retval = retroflat_init( 1, argv, &args );
+   maug_cleanup_if_not_ok();
+
+   retval = mcss_parser_init( &styler );
+   maug_cleanup_if_not_ok();
+
+   retval = csstest_select( &styler );
+   maug_cleanup_if_not_ok();
+
+   retval = mhtml_parser_init( &parser );
+   maug_cleanup_if_not_ok();
+
+   for( i = 0 ; maug_strlen( gc_csstest_html ) > i ; i++ ) {
+      retval = mhtml_parse_c( &parser, gc_csstest_html[i] );
+      maug_cleanup_if_not_ok();
+   }
+
+   retval = csstest_apply( &parser );
+   maug_cleanup_if_not_ok();
+
+cleanup:
+
+   mhtml_parser_free( &parser );
+   mcss_parser_free( &styler );
+
+   if( MERROR_OK != retval ) {
+      error_printf( "CSS tests failed: %d", retval );
+   } else if( 0 < g_csstest_failures ) {
+      error_printf( "%d CSS checks failed!", g_csstest_failures );
+      retval = MERROR_EXEC;
+   } else {
+      printf( "all CSS checks passed\n" );
+   }
+
+   retroflat_shutdown( retval );
+
+   logging_shutdown();
+
+   return retval;
+}
+END_OF_MAIN()
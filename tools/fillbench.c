@@ -0,0 +1,110 @@
+#define MAUG_C
+#include <maug.h>
+
+#include <time.h>
+
+/* Microbenchmark for the retrosoft shape fillers: fills rects and ellipses of
+ * a few sizes on the screen buffer as fast as possible and reports fills per
+ * second. Build it for the soft platform to run it without a display.
+ */
+
+#define FILLBENCH_SECONDS_DEFAULT 1
+
+#define FILLBENCH_SCREEN_W 320
+
+#define FILLBENCH_SCREEN_H 200
+
+#define FILLBENCH_SIZES_CT 3
+
+/* Number of fills between checks of the clock. */
+#define FILLBENCH_BATCH 64
+
+#define FILLBENCH_SHAPE_RECT 0
+
+#define FILLBENCH_SHAPE_ELLIPSE 1
+
+static double fillbench_run(
+   retroflat_pxxy_t w, retroflat_pxxy_t h, uint8_t shape, clock_t clocks
+) {
+   clock_t start = 0;
+   clock_t elapsed = 0;
+   uint32_t fills = 0;
+   size_t i = 0;
+   retroflat_pxxy_t x = 0,
+      y = 0;
+
+   retroflat_draw_lock( NULL );
+   start = clock();
+   while( clocks > elapsed ) {
+      for( i = 0 ; FILLBENCH_BATCH > i ; i++ ) {
+         /* Walk the position and color so every fill does real work. */
+         x = (fills * 7) % (FILLBENCH_SCREEN_W - w + 1);
+         y = (fills * 3) % (FILLBENCH_SCREEN_H - h + 1);
+         if( FILLBENCH_SHAPE_RECT == shape ) {
+            retroflat_rect( NULL, 1 + (fills % 15), x, y, w, h,
+               RETROFLAT_DRAW_FLAG_FILL );
+         } else {
+            retroflat_ellipse( NULL, 1 + (fills % 15), x, y, w, h,
+               RETROFLAT_DRAW_FLAG_FILL );
+         }
+         fills++;
+      }
+      elapsed = clock() - start;
+   }
+   retroflat_draw_release( NULL );
+
+   return fills / ((double)elapsed / CLOCKS_PER_SEC);
+}
+
+/* === */
+
+int main( int argc, char** argv ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROFLAT_ARGS args;
+   int i = 0;
+   uint32_t seconds = FILLBENCH_SECONDS_DEFAULT;
+   retroflat_pxxy_t sizes_w[FILLBENCH_SIZES_CT] = {
+      8, 64, FILLBENCH_SCREEN_W };
+   retroflat_pxxy_t sizes_h[FILLBENCH_SIZES_CT] = {
+      8, 64, FILLBENCH_SCREEN_H };
+
+   maug_mzero( &args, sizeof( struct RETROFLAT_ARGS ) );
+
+   for( i = 1 ; argc > i ; i++ ) {
+      if( 0 == strcmp( argv[i], "-s" ) && argc > i + 1 ) {
+         seconds = atoi( argv[++i] );
+      } else {
+         fprintf( stderr, "usage: %s [-s seconds per size]\n", argv[0] );
+         return MERROR_USR;
+      }
+   }
+
+   logging_init();
+
+   args.title = "fillbench";
+   args.screen_w = FILLBENCH_SCREEN_W;
+   args.screen_h = FILLBENCH_SCREEN_H;
+
+   /* Our own args were handled above. */
+   retval = retroflat_init( 1, argv, &args );
+   maug_cleanup_if_not_ok();
+
+   for( i = 0 ; FILLBENCH_SIZES_CT > i ; i++ ) {
+      printf( "%dx%d: rect: %.0f fills/s, ellipse: %.0f fills/s\n",
+         sizes_w[i], sizes_h[i],
+         fillbench_run( sizes_w[i], sizes_h[i], FILLBENCH_SHAPE_RECT,
+            seconds * CLOCKS_PER_SEC ),
+         fillbench_run( sizes_w[i], sizes_h[i], FILLBENCH_SHAPE_ELLIPSE,
+            seconds * CLOCKS_PER_SEC ) );
+   }
+
+cleanup:
+
+   retroflat_shutdown( retval );
+
+   logging_shutdown();
+
+   return retval;
+}
+END_OF_MAIN()
+
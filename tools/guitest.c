@@ -0,0 +1,197 @@
+#define MAUG_C
+#include <maug.h>
+#include <retrofnt.h>
+#include <retrogui.h>
+
+/* Regression tests for the retrogui IDC index: pushes enough controls to grow
+ * the index a few times, removes some of them so the rest move down and the
+ * index is rebuilt, then checks that every IDC still finds its own control.
+ * retrogui needs the retroflat types, so this can't live in the check suite
+ * (which builds with MAUG_NO_RETRO); build it for the soft platform to run it
+ * without a display. Exits nonzero if any check fails.
+ */
+
+/* Enough to grow the index past RETROGUI_IDC_INDEX_SZ_MIN a few times. */
+#define GUITEST_CTLS 100
+
+/* Every this many controls is removed. */
+#define GUITEST_REMOVE_EVERY 3
+
+#define GUITEST_TEXT_SZ 32
+
+static int g_guitest_failures = 0;
+
+#define guitest_check( cond, desc ) \
+   if( !(cond) ) { \
+      error_printf( "check failed: %s", desc ); \
+      g_guitest_failures++; \
+   }
+
+#define guitest_removed( idc ) (0 == (idc) % GUITEST_REMOVE_EVERY)
+
+/* === */
+
+static MERROR_RETVAL guitest_push_label(
+   struct RETROGUI* gui, retrogui_idc_t idc, const char* text
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   union RETROGUI_CTL ctl;
+
+   retval = retrogui_init_ctl( &ctl, RETROGUI_CTL_TYPE_LABEL, idc );
+   maug_cleanup_if_not_ok();
+
+   ctl.base.w = 80;
+   ctl.base.h = 10;
+   ctl.LABEL.label = (char*)text;
+   ctl.LABEL.label_sz = maug_strlen( text );
+
+   retval = retrogui_push_ctl( gui, &ctl );
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static void guitest_check_text(
+   struct RETROGUI* gui, retrogui_idc_t idc, const char* expect,
+   const char* desc
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   char text[GUITEST_TEXT_SZ + 1];
+
+   maug_mzero( text, GUITEST_TEXT_SZ + 1 );
+   retval = retrogui_get_ctl_text( gui, idc, text, GUITEST_TEXT_SZ );
+   if( NULL == expect ) {
+      if( MERROR_GUI != retval ) {
+         error_printf( "%s: found removed IDC " RETROGUI_IDC_FMT
+            " with text \"%s\"", desc, idc, text );
+         g_guitest_failures++;
+      }
+   } else if( MERROR_OK != retval || 0 != strcmp( expect, text ) ) {
+      error_printf( "%s: IDC " RETROGUI_IDC_FMT " has text \"%s\", "
+         "expected \"%s\"", desc, idc, text, expect );
+      g_guitest_failures++;
+   }
+}
+
+/* === */
+
+static MERROR_RETVAL guitest_index( struct RETROGUI* gui ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROGUI_CTL_SET sets[2];
+   char text[GUITEST_TEXT_SZ + 1];
+   retrogui_idc_t idc = 0;
+
+   for( idc = 1 ; GUITEST_CTLS >= idc ; idc++ ) {
+      maug_snprintf( text, GUITEST_TEXT_SZ, "label %d", idc );
+      retval = guitest_push_label( gui, idc, text );
+      maug_cleanup_if_not_ok();
+   }
+   guitest_check( RETROGUI_IDC_INDEX_SZ_MIN < gui->idc_index.slots_sz,
+      "index grew" );
+
+   for( idc = 1 ; GUITEST_CTLS >= idc ; idc++ ) {
+      maug_snprintf( text, GUITEST_TEXT_SZ, "label %d", idc );
+      guitest_check_text( gui, idc, text, "pushed" );
+   }
+
+   /* Each removal moves the controls after it down a slot. */
+   for( idc = 1 ; GUITEST_CTLS >= idc ; idc++ ) {
+      if( guitest_removed( idc ) ) {
+         retval = retrogui_remove_ctl( gui, idc );
+         maug_cleanup_if_not_ok();
+      }
+   }
+   guitest_check(
+      GUITEST_CTLS - (GUITEST_CTLS / GUITEST_REMOVE_EVERY) ==
+         mdata_vector_ct( &(gui->ctls) ), "removed count" );
+
+   for( idc = 1 ; GUITEST_CTLS >= idc ; idc++ ) {
+      if( guitest_removed( idc ) ) {
+         guitest_check_text( gui, idc, NULL, "removed" );
+      } else {
+         maug_snprintf( text, GUITEST_TEXT_SZ, "label %d", idc );
+         guitest_check_text( gui, idc, text, "kept" );
+      }
+   }
+
+   /* Controls pushed after a rebuild are found, including a removed IDC. */
+   retval = guitest_push_label( gui, GUITEST_REMOVE_EVERY, "pushed again" );
+   maug_cleanup_if_not_ok();
+   retval = guitest_push_label( gui, GUITEST_CTLS + 1, "pushed last" );
+   maug_cleanup_if_not_ok();
+   guitest_check_text( gui, GUITEST_REMOVE_EVERY, "pushed again", "re-push" );
+   guitest_check_text( gui, GUITEST_CTLS + 1, "pushed last", "push after" );
+   guitest_check_text( gui, 1, "label 1", "first after re-push" );
+
+   /* A batch looks up every control with the index held locked. */
+   maug_mzero( sets, sizeof( sets ) );
+   sets[0].idc = 2;
+   sets[0].text = "batch 2";
+   sets[1].idc = GUITEST_CTLS;
+   sets[1].text = "batch last";
+   retval = retrogui_set_ctls( gui, sets, 2 );
+   maug_cleanup_if_not_ok();
+   guitest_check_text( gui, 2, "batch 2", "batch" );
+   guitest_check_text( gui, GUITEST_CTLS, "batch last", "batch" );
+
+   /* Removing a missing IDC changes nothing. */
+   retval = retrogui_remove_ctl( gui, GUITEST_REMOVE_EVERY * 2 );
+   maug_cleanup_if_not_ok();
+   guitest_check_text( gui, 1, "label 1", "after no-op" );
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+int main( int argc, char** argv ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROFLAT_ARGS args;
+   struct RETROGUI gui;
+   int gui_init = 0;
+
+   maug_mzero( &args, sizeof( struct RETROFLAT_ARGS ) );
+
+   logging_init();
+
+   args.title = "guitest";
+   args.screen_w = 160;
+   args.screen_h = 120;
+
+   retval = retroflat_init( 1, argv, &args );
+   maug_cleanup_if_not_ok();
+
+   retval = retrogui_init( &gui );
+   maug_cleanup_if_not_ok();
+   gui_init = 1;
+
+   retval = guitest_index( &gui );
+   maug_cleanup_if_not_ok();
+
+cleanup:
+
+   if( gui_init ) {
+      retrogui_destroy( &gui );
+   }
+
+   if( MERROR_OK != retval ) {
+      error_printf( "GUI tests failed: %d", retval );
+   } else if( 0 < g_guitest_failures ) {
+      error_printf( "%d GUI checks failed!", g_guitest_failures );
+      retval = MERROR_EXEC;
+   } else {
+      printf( "all GUI checks passed\n" );
+   }
+
+   retroflat_shutdown( retval );
+
+   logging_shutdown();
+
+   return retval;
+}
+END_OF_MAIN()
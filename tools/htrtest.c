@@ -0,0 +1,298 @@
+#define MAUG_C
+#include <maug.h>
+#include <mhtml.h>
+#include <retrofnt.h>
+#include <retrogui.h>
+#include <retrohtr.h>
+
+/* Regression tests for the retrohtr dirty flags: lays out a small page,
+ * changes one node and checks how many nodes each pass touched, then checks
+ * that the result matches a full layout of the changed page on a fresh tree
+ * and a clean screen. retrohtr needs the retroflat types, so this can't live
+ * in the check suite (which builds with MAUG_NO_RETRO); build it for the soft
+ * platform to run it without a display. Run it from the repo root so the font
+ * below can be found. Exits nonzero if any check fails.
+ */
+
+#define HTRTEST_SCREEN_W 160
+
+#define HTRTEST_SCREEN_H 120
+
+/* Nodes are created in document order: body, the padded div, its three
+ * children, then the last div.
+ */
+#define HTRTEST_NODES 6
+
+/* The middle child of the padded div, which the tests change. */
+#define HTRTEST_NODE_CHANGED 3
+
+static const char* gc_htrtest_html =
+   "<html><head><style>"
+   "body{font-family:fonts/unscii-8.hex;}"
+   ".w{padding:4;background-color:green;}"
+   ".s{height:10;background-color:blue;}"
+   ".t{height:10;background-color:yellow;}"
+   ".b{height:30;background-color:red;}"
+   "</style></head><body>"
+   "<div class=\"w\">"
+   "<div class=\"s\"></div><div class=\"s\"></div><div class=\"s\"></div>"
+   "</div>"
+   "<div class=\"s\"></div>"
+   "</body></html>";
+
+static uint8_t g_htrtest_screen[HTRTEST_SCREEN_W * HTRTEST_SCREEN_H];
+
+static int g_htrtest_failures = 0;
+
+#define htrtest_check( cond, desc ) \
+   if( !(cond) ) { \
+      error_printf( "check failed: %s", desc ); \
+      g_htrtest_failures++; \
+   }
+
+/* === */
+
+static MERROR_RETVAL htrtest_layout(
+   struct MHTML_PARSER* parser, struct RETROHTR_RENDER_TREE* tree
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+
+   retval = retrohtr_tree_size( parser, tree, NULL, NULL, 0, 0 );
+   maug_cleanup_if_not_ok();
+
+   retval = retrohtr_tree_pos( parser, tree, NULL, NULL, 0, 0 );
+   maug_cleanup_if_not_ok();
+
+   retroflat_draw_lock( NULL );
+   retval = retrohtr_tree_draw( parser, tree, 0, 0 );
+   retroflat_draw_release( NULL );
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static void htrtest_check_touched(
+   struct RETROHTR_RENDER_TREE* tree,
+   size_t sized, size_t posed, size_t drawn, const char* desc
+) {
+   size_t nodes_sized = 0,
+      nodes_posed = 0,
+      nodes_drawn = 0;
+
+   retrohtr_tree_touched( tree, &nodes_sized, &nodes_posed, &nodes_drawn );
+   if(
+      sized != nodes_sized || posed != nodes_posed || drawn != nodes_drawn
+   ) {
+      error_printf( "%s: touched " SIZE_T_FMT "/" SIZE_T_FMT "/" SIZE_T_FMT
+         ", expected " SIZE_T_FMT "/" SIZE_T_FMT "/" SIZE_T_FMT, desc,
+         nodes_sized, nodes_posed, nodes_drawn, sized, posed, drawn );
+      g_htrtest_failures++;
+   }
+}
+
+/* === */
+
+static MERROR_RETVAL htrtest_set_class(
+   struct MHTML_PARSER* parser, struct RETROHTR_RENDER_TREE* tree,
+   ssize_t node_idx, const char* classes
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   union MHTML_TAG* tag = NULL;
+
+   mdata_vector_lock( &(parser->tags) );
+   tag = mdata_vector_get(
+      &(parser->tags), tree->nodes[node_idx].tag, union MHTML_TAG );
+   assert( NULL != tag );
+   maug_mzero( tag->base.classes, MCSS_CLASS_SZ_MAX + 1 );
+   maug_strncpy( tag->base.classes, classes, MCSS_CLASS_SZ_MAX );
+   tag->base.classes_sz = maug_strlen( tag->base.classes );
+
+   retrohtr_tree_set_dirty( tree, node_idx, RETROHTR_NODE_FLAG_DIRTY_STYLE );
+
+cleanup:
+
+   mdata_vector_unlock( &(parser->tags) );
+
+   return retval;
+}
+
+/* === */
+
+/* Lay out the page from scratch on a clean screen and check that the nodes
+ * and pixels match what the passes over the existing tree left behind.
+ */
+static MERROR_RETVAL htrtest_check_full(
+   struct MHTML_PARSER* parser, struct RETROHTR_RENDER_TREE* tree,
+   const char* desc
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROHTR_RENDER_TREE full;
+   struct RETROHTR_RENDER_NODE* node = NULL;
+   struct RETROHTR_RENDER_NODE* node_full = NULL;
+   struct RETROFLAT_BITMAP* screen = retroflat_screen_buffer();
+   size_t i = 0;
+
+   maug_mzero( &full, sizeof( struct RETROHTR_RENDER_TREE ) );
+
+   memcpy( g_htrtest_screen, screen->px, sizeof( g_htrtest_screen ) );
+   maug_mzero( screen->px, sizeof( g_htrtest_screen ) );
+
+   retval = retrohtr_tree_init( &full );
+   maug_cleanup_if_not_ok();
+
+   retrohtr_tree_lock( &full );
+
+   retval = retrohtr_tree_create( parser, &full, 0, 0,
+      HTRTEST_SCREEN_W, HTRTEST_SCREEN_H, parser->body_idx, -1, 0 );
+   maug_cleanup_if_not_ok();
+
+   retval = htrtest_layout( parser, &full );
+   maug_cleanup_if_not_ok();
+
+   htrtest_check( full.nodes_sz == tree->nodes_sz, desc );
+   for( i = 0 ; full.nodes_sz > i && tree->nodes_sz > i ; i++ ) {
+      node = retrohtr_node( tree, i );
+      node_full = retrohtr_node( &full, i );
+      if(
+         node->x != node_full->x || node->y != node_full->y ||
+         node->w != node_full->w || node->h != node_full->h ||
+         node->bg != node_full->bg || node->fg != node_full->fg
+      ) {
+         error_printf( "%s: node " SIZE_T_FMT " is %d, %d %dx%d, "
+            "expected %d, %d %dx%d", desc, i,
+            node->x, node->y, node->w, node->h,
+            node_full->x, node_full->y, node_full->w, node_full->h );
+         g_htrtest_failures++;
+      }
+   }
+
+   htrtest_check(
+      0 == memcmp( g_htrtest_screen, screen->px, sizeof( g_htrtest_screen ) ),
+      desc );
+
+cleanup:
+
+   retrohtr_tree_free( &full );
+
+   /* Put the screen back for the next pass over the existing tree. */
+   memcpy( screen->px, g_htrtest_screen, sizeof( g_htrtest_screen ) );
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL htrtest_dirty( struct MHTML_PARSER* parser ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROHTR_RENDER_TREE tree;
+
+   maug_mzero( &tree, sizeof( struct RETROHTR_RENDER_TREE ) );
+
+   retval = retrohtr_tree_init( &tree );
+   maug_cleanup_if_not_ok();
+
+   retrohtr_tree_lock( &tree );
+
+   retval = retrohtr_tree_create( parser, &tree, 0, 0,
+      HTRTEST_SCREEN_W, HTRTEST_SCREEN_H, parser->body_idx, -1, 0 );
+   maug_cleanup_if_not_ok();
+   htrtest_check( HTRTEST_NODES == tree.nodes_sz, "tree create" );
+
+   /* Everything is new on the first pass. */
+   retval = htrtest_layout( parser, &tree );
+   maug_cleanup_if_not_ok();
+   htrtest_check_touched( &tree, HTRTEST_NODES, HTRTEST_NODES, HTRTEST_NODES,
+      "first pass" );
+
+   /* Nothing changed, so nothing should be touched. */
+   retval = htrtest_layout( parser, &tree );
+   maug_cleanup_if_not_ok();
+   htrtest_check_touched( &tree, 0, 0, 0, "unchanged pass" );
+
+   /* A new colour at the same size is resized along with its ancestors but
+    * only moves itself. It's repainted from the padded div, which has the
+    * nearest background.
+    */
+   retval = htrtest_set_class( parser, &tree, HTRTEST_NODE_CHANGED, "t" );
+   maug_cleanup_if_not_ok();
+   retval = htrtest_layout( parser, &tree );
+   maug_cleanup_if_not_ok();
+   htrtest_check_touched( &tree, 3, 1, 4, "recoloured pass" );
+   retval = htrtest_check_full( parser, &tree, "recoloured vs full" );
+   maug_cleanup_if_not_ok();
+
+   /* A new height grows the padded div, which moves everything after it. */
+   retval = htrtest_set_class( parser, &tree, HTRTEST_NODE_CHANGED, "b" );
+   maug_cleanup_if_not_ok();
+   retval = htrtest_layout( parser, &tree );
+   maug_cleanup_if_not_ok();
+   htrtest_check_touched( &tree, 3, HTRTEST_NODES, HTRTEST_NODES,
+      "resized pass" );
+   retval = htrtest_check_full( parser, &tree, "resized vs full" );
+   maug_cleanup_if_not_ok();
+
+   retval = htrtest_layout( parser, &tree );
+   maug_cleanup_if_not_ok();
+   htrtest_check_touched( &tree, 0, 0, 0, "unchanged pass after resize" );
+
+cleanup:
+
+   retrohtr_tree_free( &tree );
+
+   return retval;
+}
+
+/* === */
+
+int main( int argc, char** argv ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROFLAT_ARGS args;
+   struct MHTML_PARSER parser;
+   size_t i = 0;
+
+   maug_mzero( &args, sizeof( struct RETROFLAT_ARGS ) );
+   maug_mzero( &parser, sizeof( struct MHTML_PARSER ) );
+
+   logging_init();
+
+   args.title = "htrtest";
+   args.screen_w = HTRTEST_SCREEN_W;
+   args.screen_h = HTRTEST_SCREEN_H;
+
+   retval = retroflat_init( 1, argv, &args );
+   maug_cleanup_if_not_ok();
+
+   retval = mhtml_parser_init( &parser );
+   maug_cleanup_if_not_ok();
+
+   for( i = 0 ; maug_strlen( gc_htrtest_html ) > i ; i++ ) {
+      retval = mhtml_parse_c( &parser, gc_htrtest_html[i] );
+      maug_cleanup_if_not_ok();
+   }
+
+   retval = htrtest_dirty( &parser );
+   maug_cleanup_if_not_ok();
+
+cleanup:
+
+   mhtml_parser_free( &parser );
+
+   if( MERROR_OK != retval ) {
+      error_printf( "render tree tests failed: %d", retval );
+   } else if( 0 < g_htrtest_failures ) {
+      error_printf( "%d render tree checks failed!", g_htrtest_failures );
+      retval = MERROR_EXEC;
+   } else {
+      printf( "all render tree checks passed\n" );
+   }
+
+   retroflat_shutdown( retval );
+
+   logging_shutdown();
+
+   return retval;
+}
+END_OF_MAIN()
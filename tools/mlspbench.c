@@ -0,0 +1,139 @@
+#define MAUG_C
+#include <maug.h>
+#include <mlisps.h>
+#include <mlispp.h>
+#include <mlispe.h>
+
+#include <time.h>
+
+/* Benchmark for the mlisp bytecode interpreter: runs each script to the end
+ * with the tree walker and then with bytecode, many times over, and reports
+ * how long the steps took in each mode. Build it with MAUG_NO_RETRO, like the
+ * check suite, so it needs no display.
+ */
+
+#define MLSPBENCH_ITER_DEFAULT 2000
+
+static const char* gc_mlspbench_scripts[] = {
+   "(begin (define x 3) (define y (+ x 6)))",
+   "(begin (define y 1) (define cb1 (lambda (x) (begin (define y (+ x 6)) "
+      "(define x (+ y 8))))) (cb1 3) (define q 3))",
+   "(begin (define x 3) (define y (+ x 6)) (define x 10) (define z (+ x 1)) "
+      "(define w 1.5))",
+   NULL
+};
+
+static MERROR_RETVAL mlspbench_parse(
+   struct MLISP_PARSER* parser, const char* script
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   size_t i = 0;
+
+   maug_mzero( parser, sizeof( struct MLISP_PARSER ) );
+
+   retval = mlisp_parser_init( parser );
+   maug_cleanup_if_not_ok();
+
+   for( i = 0 ; strlen( script ) > i ; i++ ) {
+      retval = mlisp_parse_c( parser, script[i] );
+      maug_cleanup_if_not_ok();
+   }
+
+cleanup:
+
+   return retval;
+}
+
+/* === */
+
+static MERROR_RETVAL mlspbench_run(
+   struct MLISP_PARSER* parser, uint8_t flags,
+   size_t* p_steps, clock_t* p_ticks
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_EXEC_STATE exec;
+   clock_t start = 0;
+
+   maug_mzero( &exec, sizeof( struct MLISP_EXEC_STATE ) );
+
+   retval = mlisp_exec_init( parser, &exec, flags );
+   maug_cleanup_if_not_ok();
+
+   /* Only time the steps, since init is the same for both modes. */
+   start = clock();
+   while( MERROR_OK == retval ) {
+      retval = mlisp_step( parser, &exec );
+      (*p_steps)++;
+   }
+   *p_ticks += clock() - start;
+
+   if( MERROR_EXEC == retval ) {
+      /* Ran out of instructions. */
+      retval = MERROR_OK;
+   }
+
+cleanup:
+
+   mlisp_exec_free( &exec );
+
+   return retval;
+}
+
+/* === */
+
+int main( int argc, char** argv ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MLISP_PARSER parser;
+   size_t iter = MLSPBENCH_ITER_DEFAULT;
+   size_t i = 0;
+   size_t steps_tree = 0;
+   size_t steps_bc = 0;
+   clock_t ticks_tree = 0;
+   clock_t ticks_bc = 0;
+   int s = 0;
+
+   maug_mzero( &parser, sizeof( struct MLISP_PARSER ) );
+
+   for( s = 1 ; argc > s ; s++ ) {
+      if( 0 == strcmp( argv[s], "-n" ) && argc > s + 1 ) {
+         iter = atoi( argv[++s] );
+      } else {
+         fprintf( stderr, "usage: %s [-n iterations]\n", argv[0] );
+         return MERROR_USR;
+      }
+   }
+
+   for( s = 0 ; NULL != gc_mlspbench_scripts[s] ; s++ ) {
+      retval = mlspbench_parse( &parser, gc_mlspbench_scripts[s] );
+      maug_cleanup_if_not_ok();
+
+      steps_tree = 0;
+      steps_bc = 0;
+      ticks_tree = 0;
+      ticks_bc = 0;
+      for( i = 0 ; iter > i ; i++ ) {
+         retval = mlspbench_run( &parser, 0, &steps_tree, &ticks_tree );
+         maug_cleanup_if_not_ok();
+         retval = mlspbench_run(
+            &parser, MLISP_EXEC_FLAG_BYTECODE, &steps_bc, &ticks_bc );
+         maug_cleanup_if_not_ok();
+      }
+
+      printf( "script %d x " SIZE_T_FMT ": tree walk: %ld ms (" SIZE_T_FMT
+         " steps), bytecode: %ld ms (" SIZE_T_FMT " steps)\n",
+         s, iter,
+         (long)(ticks_tree * 1000 / CLOCKS_PER_SEC), steps_tree,
+         (long)(ticks_bc * 1000 / CLOCKS_PER_SEC), steps_bc );
+
+      mlisp_parser_free( &parser );
+   }
+
+cleanup:
+
+   if( MERROR_OK != retval ) {
+      error_printf( "benchmark failed: %d", retval );
+      mlisp_parser_free( &parser );
+   }
+
+   return retval;
+}
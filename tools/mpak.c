@@ -0,0 +1,370 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/* These must match the definitions in src/mfile.h! */
+
+#define MFILE_PACK_MAGIC "MPAK"
+#define MFILE_PACK_VERSION 1
+#define MFILE_PACK_HDR_SZ 16
+#define MFILE_PACK_ENTRY_SZ 24
+#define MFILE_PACK_COMP_NONE 0
+#define MFILE_PACK_COMP_RLE 1
+
+#define PATH_SZ_MAX 255
+#define ALIGN_DEFAULT 16
+
+struct PACK_ENTRY {
+   char name[PATH_SZ_MAX + 1];
+   unsigned long hash;
+   unsigned char comp;
+   unsigned char* data;
+   size_t data_sz;
+   size_t unpacked_sz;
+   unsigned long name_off;
+   unsigned long data_off;
+};
+
+struct PACK_ENTRY* g_entries = NULL;
+size_t g_entries_ct = 0;
+size_t g_entries_ct_max = 0;
+
+/* Same as mfile_pack_hash() in src/mfile.h. */
+unsigned long pack_hash( const char* name, size_t name_sz ) {
+   unsigned long hash_out = 2166136261ul;
+   size_t i = 0;
+
+   for( i = 0 ; name_sz > i ; i++ ) {
+      hash_out ^= (unsigned char)name[i];
+      hash_out = (hash_out * 16777619ul) & 0xfffffffful;
+   }
+
+   return hash_out;
+}
+
+/* Encode data as PackBits RLE. Returns the encoded size, or 0 if the encoded
+ * data would not fit in out_sz.
+ */
+size_t pack_rle(
+   const unsigned char* in, size_t in_sz, unsigned char* out, size_t out_sz
+) {
+   size_t i = 0;
+   size_t o = 0;
+   size_t run = 0;
+   size_t lit_start = 0;
+
+   while( in_sz > i ) {
+      /* Measure the run of identical bytes starting here. */
+      run = 1;
+      while( in_sz > i + run && 128 > run && in[i + run] == in[i] ) {
+         run++;
+      }
+
+      if( 3 <= run ) {
+         if( o + 2 > out_sz ) {
+            return 0;
+         }
+         out[o++] = (unsigned char)(257 - run);
+         out[o++] = in[i];
+         i += run;
+         continue;
+      }
+
+      /* Gather literal bytes until the next run worth encoding. */
+      lit_start = i;
+      while(
+         in_sz > i && 128 > i - lit_start &&
+         !(in_sz > i + 2 && in[i] == in[i + 1] && in[i] == in[i + 2])
+      ) {
+         i++;
+      }
+      if( o + 1 + (i - lit_start) > out_sz ) {
+         return 0;
+      }
+      out[o++] = (unsigned char)(i - lit_start - 1);
+      memcpy( &(out[o]), &(in[lit_start]), i - lit_start );
+      o += i - lit_start;
+   }
+
+   return o;
+}
+
+int pack_add_file( const char* path, int compress ) {
+   FILE* f = NULL;
+   struct PACK_ENTRY* entry = NULL;
+   struct PACK_ENTRY* new_entries = NULL;
+   unsigned char* packed = NULL;
+   size_t packed_sz = 0;
+   long file_sz = 0;
+
+   /* Strip leading ./ so names match what the engine asks for. */
+   while( '.' == path[0] && '/' == path[1] ) {
+      path += 2;
+   }
+
+   if( PATH_SZ_MAX < strlen( path ) ) {
+      fprintf( stderr, "path too long: %s\n", path );
+      return 1;
+   }
+
+   if( g_entries_ct + 1 > g_entries_ct_max ) {
+      g_entries_ct_max = 0 == g_entries_ct_max ? 64 : g_entries_ct_max * 2;
+      new_entries = realloc(
+         g_entries, g_entries_ct_max * sizeof( struct PACK_ENTRY ) );
+      if( NULL == new_entries ) {
+         fprintf( stderr, "could not allocate entries!\n" );
+         return 1;
+      }
+      g_entries = new_entries;
+   }
+   entry = &(g_entries[g_entries_ct]);
+   memset( entry, '\0', sizeof( struct PACK_ENTRY ) );
+   strncpy( entry->name, path, PATH_SZ_MAX );
+   entry->hash = pack_hash( entry->name, strlen( entry->name ) );
+
+   f = fopen( path, "rb" );
+   if( NULL == f ) {
+      fprintf( stderr, "could not open: %s\n", path );
+      return 1;
+   }
+   fseek( f, 0, SEEK_END );
+   file_sz = ftell( f );
+   fseek( f, 0, SEEK_SET );
+
+   entry->unpacked_sz = file_sz;
+   entry->data_sz = file_sz;
+   entry->data = malloc( 0 < file_sz ? file_sz : 1 );
+   if(
+      NULL == entry->data ||
+      (0 < file_sz && 1 != fread( entry->data, file_sz, 1, f ))
+   ) {
+      fprintf( stderr, "could not read: %s\n", path );
+      fclose( f );
+      return 1;
+   }
+   fclose( f );
+
+   if( compress && 0 < file_sz ) {
+      /* Only keep the compressed data if it's actually smaller. */
+      packed = malloc( file_sz );
+      if( NULL != packed ) {
+         packed_sz = pack_rle( entry->data, file_sz, packed, file_sz - 1 );
+      }
+      if( 0 < packed_sz ) {
+         free( entry->data );
+         entry->data = packed;
+         entry->data_sz = packed_sz;
+         entry->comp = MFILE_PACK_COMP_RLE;
+      } else {
+         free( packed );
+      }
+   }
+
+#ifdef DEBUG
+   fprintf( stderr, "added %s (%lu bytes, %lu stored)\n",
+      entry->name, (unsigned long)entry->unpacked_sz,
+      (unsigned long)entry->data_sz );
+#endif /* DEBUG */
+
+   g_entries_ct++;
+
+   return 0;
+}
+
+int pack_add_path( const char* path, int compress ) {
+   struct stat path_stat;
+   DIR* dir = NULL;
+   struct dirent* dir_entry = NULL;
+   char child[PATH_SZ_MAX + 1];
+   int retval = 0;
+
+   if( stat( path, &path_stat ) ) {
+      fprintf( stderr, "could not stat: %s\n", path );
+      return 1;
+   }
+
+   if( !S_ISDIR( path_stat.st_mode ) ) {
+      return pack_add_file( path, compress );
+   }
+
+   dir = opendir( path );
+   if( NULL == dir ) {
+      fprintf( stderr, "could not open directory: %s\n", path );
+      return 1;
+   }
+
+   while( 0 == retval && NULL != (dir_entry = readdir( dir )) ) {
+      if( '.' == dir_entry->d_name[0] ) {
+         /* Skip ., .., and hidden files. */
+         continue;
+      }
+      if(
+         PATH_SZ_MAX <= (size_t)snprintf( child, PATH_SZ_MAX + 1, "%s/%s",
+            path, dir_entry->d_name )
+      ) {
+         fprintf( stderr, "path too long: %s/%s\n", path, dir_entry->d_name );
+         retval = 1;
+         break;
+      }
+      retval = pack_add_path( child, compress );
+   }
+
+   closedir( dir );
+
+   return retval;
+}
+
+int pack_cmp( const void* a, const void* b ) {
+   const struct PACK_ENTRY* e_a = (const struct PACK_ENTRY*)a;
+   const struct PACK_ENTRY* e_b = (const struct PACK_ENTRY*)b;
+
+   if( e_a->hash != e_b->hash ) {
+      return e_a->hash < e_b->hash ? -1 : 1;
+   }
+   return strcmp( e_a->name, e_b->name );
+}
+
+void pack_write_u16( unsigned char* buf, unsigned long v ) {
+   buf[0] = v & 0xff;
+   buf[1] = (v >> 8) & 0xff;
+}
+
+void pack_write_u32( unsigned char* buf, unsigned long v ) {
+   buf[0] = v & 0xff;
+   buf[1] = (v >> 8) & 0xff;
+   buf[2] = (v >> 16) & 0xff;
+   buf[3] = (v >> 24) & 0xff;
+}
+
+int pack_write( const char* out_path, unsigned long align ) {
+   FILE* f = NULL;
+   unsigned char hdr[MFILE_PACK_HDR_SZ];
+   unsigned char dir_entry[MFILE_PACK_ENTRY_SZ];
+   unsigned long offset = 0;
+   size_t i = 0;
+   int retval = 0;
+
+   /* Sort so the engine can binary search the directory by hash. */
+   qsort( g_entries, g_entries_ct, sizeof( struct PACK_ENTRY ), pack_cmp );
+
+   for( i = 1 ; g_entries_ct > i ; i++ ) {
+      if( 0 == strcmp( g_entries[i - 1].name, g_entries[i].name ) ) {
+         fprintf( stderr, "duplicate entry: %s\n", g_entries[i].name );
+         return 1;
+      }
+   }
+
+   /* Lay out the names after the directory, then the aligned data. */
+   offset = MFILE_PACK_HDR_SZ + (g_entries_ct * MFILE_PACK_ENTRY_SZ);
+   for( i = 0 ; g_entries_ct > i ; i++ ) {
+      g_entries[i].name_off = offset;
+      offset += strlen( g_entries[i].name ) + 1;
+   }
+   for( i = 0 ; g_entries_ct > i ; i++ ) {
+      offset = (offset + align - 1) & ~(align - 1);
+      g_entries[i].data_off = offset;
+      offset += g_entries[i].data_sz;
+   }
+
+   if( 0xfffffffful < offset ) {
+      fprintf( stderr, "pack is too big!\n" );
+      return 1;
+   }
+
+   f = fopen( out_path, "wb" );
+   if( NULL == f ) {
+      fprintf( stderr, "could not open output: %s\n", out_path );
+      return 1;
+   }
+
+   memcpy( hdr, MFILE_PACK_MAGIC, 4 );
+   pack_write_u16( &(hdr[4]), MFILE_PACK_VERSION );
+   pack_write_u16( &(hdr[6]), align );
+   pack_write_u32( &(hdr[8]), g_entries_ct );
+   pack_write_u32( &(hdr[12]), MFILE_PACK_HDR_SZ );
+   fwrite( hdr, MFILE_PACK_HDR_SZ, 1, f );
+
+   for( i = 0 ; g_entries_ct > i ; i++ ) {
+      memset( dir_entry, '\0', MFILE_PACK_ENTRY_SZ );
+      pack_write_u32( &(dir_entry[0]), g_entries[i].hash );
+      pack_write_u32( &(dir_entry[4]), g_entries[i].data_off );
+      pack_write_u32( &(dir_entry[8]), g_entries[i].data_sz );
+      pack_write_u32( &(dir_entry[12]), g_entries[i].unpacked_sz );
+      pack_write_u32( &(dir_entry[16]), g_entries[i].name_off );
+      pack_write_u16( &(dir_entry[20]), strlen( g_entries[i].name ) );
+      dir_entry[22] = g_entries[i].comp;
+      fwrite( dir_entry, MFILE_PACK_ENTRY_SZ, 1, f );
+   }
+
+   for( i = 0 ; g_entries_ct > i ; i++ ) {
+      fwrite( g_entries[i].name, strlen( g_entries[i].name ) + 1, 1, f );
+   }
+
+   for( i = 0 ; g_entries_ct > i ; i++ ) {
+      /* Pad up to the aligned start of this entry. */
+      while( (unsigned long)ftell( f ) < g_entries[i].data_off ) {
+         fputc( '\0', f );
+      }
+      if(
+         0 < g_entries[i].data_sz &&
+         1 != fwrite( g_entries[i].data, g_entries[i].data_sz, 1, f )
+      ) {
+         fprintf( stderr, "could not write: %s\n", g_entries[i].name );
+         retval = 1;
+         break;
+      }
+   }
+
+   fclose( f );
+
+   return retval;
+}
+
+int main( int argc, char* argv[] ) {
+   int i = 0;
+   int retval = 0;
+   int compress = 0;
+   unsigned long align = ALIGN_DEFAULT;
+   const char* out_path = NULL;
+   size_t j = 0;
+
+   for( i = 1 ; argc > i ; i++ ) {
+      if( 0 == strcmp( "-o", argv[i] ) && argc > i + 1 ) {
+         out_path = argv[++i];
+      } else if( 0 == strcmp( "-a", argv[i] ) && argc > i + 1 ) {
+         align = strtoul( argv[++i], NULL, 10 );
+      } else if( 0 == strcmp( "-c", argv[i] ) ) {
+         compress = 1;
+      } else {
+         retval = pack_add_path( argv[i], compress );
+         if( retval ) {
+            goto cleanup;
+         }
+      }
+   }
+
+   if( NULL == out_path || 0 == align || 0 != (align & (align - 1)) ) {
+      fprintf( stderr,
+         "usage: %s [-a align] [-c] -o out.pak <file|dir> [...]\n\n"
+         "  -a   power-of-2 alignment of entry data (default %d)\n"
+         "  -c   RLE-compress entries that get smaller\n", argv[0],
+         ALIGN_DEFAULT );
+      retval = 1;
+      goto cleanup;
+   }
+
+   retval = pack_write( out_path, align );
+
+cleanup:
+
+   for( j = 0 ; g_entries_ct > j ; j++ ) {
+      free( g_entries[j].data );
+   }
+   free( g_entries );
+
+   return retval;
+}
+
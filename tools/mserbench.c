@@ -0,0 +1,135 @@
+#define MAUG_C
+#include <maug.h>
+#include <mlisps.h>
+#include <mlispp.h>
+#include <mlispe.h>
+#include <mserial.h>
+
+#include <time.h>
+
+/* Benchmark for vector serialization: round-trips a vector of uint32_t,
+ * which is written packed, and a vector of size_t, which is written as a
+ * sequence of integers, through a temporary file many times over and reports
+ * how long each took. Build it with MAUG_NO_RETRO, like the check suite, so
+ * it needs no display.
+ */
+
+#define MSERBENCH_ITER_DEFAULT 200
+
+#define MSERBENCH_VEC_SZ 1024
+
+#define MSERBENCH_TMP_PATH "mserbench.tmp"
+
+static MERROR_RETVAL mserbench_round_trip(
+   struct MDATA_VECTOR* vec_in, mserialize_cb_t ser_cb,
+   mdeserialize_cb_t deser_cb, size_t item_sz, clock_t* p_ticks
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MDATA_VECTOR vec_out;
+   maug_path tmp_path;
+   mfile_t ser_file;
+   uint8_t value_buf[sizeof( size_t )];
+   ssize_t ser_sz = 0;
+   clock_t start = 0;
+
+   maug_mzero( &vec_out, sizeof( struct MDATA_VECTOR ) );
+   maug_mzero( &ser_file, sizeof( mfile_t ) );
+   maug_mzero( tmp_path, sizeof( maug_path ) );
+   maug_strncpy( tmp_path, MSERBENCH_TMP_PATH, MAUG_PATH_SZ_MAX - 1 );
+
+   remove( tmp_path );
+   retval = mfile_open_write( tmp_path, &ser_file );
+   maug_cleanup_if_not_ok();
+
+   start = clock();
+
+   retval = mserialize_vector( &ser_file, vec_in, 1, ser_cb );
+   maug_cleanup_if_not_ok();
+
+   ser_file.seek( &ser_file, 0 );
+
+   retval = mdeserialize_vector(
+      &ser_file, &vec_out, 1, deser_cb, value_buf, item_sz, &ser_sz );
+   maug_cleanup_if_not_ok();
+
+   *p_ticks += clock() - start;
+
+   if( mdata_vector_ct( &vec_out ) != mdata_vector_ct( vec_in ) ) {
+      error_printf( "read back " SIZE_T_FMT " items, expected " SIZE_T_FMT,
+         mdata_vector_ct( &vec_out ), mdata_vector_ct( vec_in ) );
+      retval = MERROR_FILE;
+   }
+
+cleanup:
+
+   mfile_close( &ser_file );
+   remove( tmp_path );
+
+   mdata_vector_free( &vec_out );
+
+   return retval;
+}
+
+/* === */
+
+int main( int argc, char** argv ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct MDATA_VECTOR vec_packed;
+   struct MDATA_VECTOR vec_seq;
+   size_t iter = MSERBENCH_ITER_DEFAULT;
+   size_t i = 0;
+   uint32_t value_packed = 0;
+   size_t value_seq = 0;
+   clock_t ticks_packed = 0;
+   clock_t ticks_seq = 0;
+   int s = 0;
+
+   maug_mzero( &vec_packed, sizeof( struct MDATA_VECTOR ) );
+   maug_mzero( &vec_seq, sizeof( struct MDATA_VECTOR ) );
+
+   for( s = 1 ; argc > s ; s++ ) {
+      if( 0 == strcmp( argv[s], "-n" ) && argc > s + 1 ) {
+         iter = atoi( argv[++s] );
+      } else {
+         fprintf( stderr, "usage: %s [-n iterations]\n", argv[0] );
+         return MERROR_USR;
+      }
+   }
+
+   for( i = 0 ; MSERBENCH_VEC_SZ > i ; i++ ) {
+      value_packed = i * 2654435761u;
+      mdata_vector_append( &vec_packed, &value_packed, sizeof( uint32_t ) );
+      value_seq = value_packed & 0x7fffffff;
+      mdata_vector_append( &vec_seq, &value_seq, sizeof( size_t ) );
+   }
+
+   for( i = 0 ; iter > i ; i++ ) {
+      retval = mserbench_round_trip( &vec_packed,
+         (mserialize_cb_t)mserialize_uint32_t,
+         (mdeserialize_cb_t)mdeserialize_uint32_t, sizeof( uint32_t ),
+         &ticks_packed );
+      maug_cleanup_if_not_ok();
+
+      retval = mserbench_round_trip( &vec_seq,
+         (mserialize_cb_t)mserialize_size_t,
+         (mdeserialize_cb_t)mdeserialize_size_t, sizeof( size_t ),
+         &ticks_seq );
+      maug_cleanup_if_not_ok();
+   }
+
+   printf( "vector of %d x " SIZE_T_FMT " round trips: packed: %ld ms, "
+      "sequence: %ld ms\n", MSERBENCH_VEC_SZ, iter,
+      (long)(ticks_packed * 1000 / CLOCKS_PER_SEC),
+      (long)(ticks_seq * 1000 / CLOCKS_PER_SEC) );
+
+cleanup:
+
+   if( MERROR_OK != retval ) {
+      error_printf( "benchmark failed: %d", retval );
+   }
+
+   mdata_vector_free( &vec_seq );
+   mdata_vector_free( &vec_packed );
+
+   return retval;
+}
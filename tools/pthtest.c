@@ -0,0 +1,398 @@
+#define MAUG_C
+#include <maug.h>
+#include <retrotil.h>
+#include <retropth.h>
+
+/* Regression tests for retropth on small fixed grids, checked against
+ * routes and distances worked out by hand. retrotile needs the retroflat types, so this
+ * can't live in the check suite (which builds with MAUG_NO_RETRO); build it
+ * for the soft platform to run it without a display. Exits nonzero if any
+ * check fails.
+ */
+
+#define PTHTEST_W 8
+
+#define PTHTEST_H 6
+
+/* Tile values for the test map; the tileset starts at 1. */
+#define PTHTEST_TILE_OPEN 1
+
+#define PTHTEST_TILE_BLOCK 2
+
+/* Expected distance for a blocked tile, which isn't checked. */
+#define PTHTEST_SKIP -1
+
+static const char* gc_pthtest_map[PTHTEST_H] = {
+   "........",
+   ".######.",
+   ".#....#.",
+   ".#.##.#.",
+   ".#.#..#.",
+   "...#....",
+};
+
+/* Steps to (2, 2) with 4-way movement. */
+static const int gc_pthtest_flow_4dir[PTHTEST_H][PTHTEST_W] = {
+   { 10, 11, 12, 13, 14, 15, 14, 13 },
+   {  9, -1, -1, -1, -1, -1, -1, 12 },
+   {  8, -1,  0,  1,  2,  3, -1, 11 },
+   {  7, -1,  1, -1, -1,  4, -1, 10 },
+   {  6, -1,  2, -1,  6,  5, -1,  9 },
+   {  5,  4,  3, -1,  7,  6,  7,  8 },
+};
+
+/* Steps to (2, 2) with 4-way movement after (3, 1) is opened. */
+static const int gc_pthtest_flow_4dir_open[PTHTEST_H][PTHTEST_W] = {
+   {  6,  5,  4,  3,  4,  5,  6,  7 },
+   {  7, -1, -1,  2, -1, -1, -1,  8 },
+   {  8, -1,  0,  1,  2,  3, -1,  9 },
+   {  7, -1,  1, -1, -1,  4, -1, 10 },
+   {  6, -1,  2, -1,  6,  5, -1,  9 },
+   {  5,  4,  3, -1,  7,  6,  7,  8 },
+};
+
+/* Steps to (2, 2) with 8-way movement. Corners can't be cut, so this only
+ * differs at (4, 5).
+ */
+static const int gc_pthtest_flow_8dir[PTHTEST_H][PTHTEST_W] = {
+   { 10, 11, 12, 13, 14, 15, 14, 13 },
+   {  9, -1, -1, -1, -1, -1, -1, 12 },
+   {  8, -1,  0,  1,  2,  3, -1, 11 },
+   {  7, -1,  1, -1, -1,  4, -1, 10 },
+   {  6, -1,  2, -1,  6,  5, -1,  9 },
+   {  5,  4,  3, -1,  6,  6,  7,  8 },
+};
+
+/* Only shortest route from (0, 0) to (2, 2) with 4-way movement. */
+static const uint16_t gc_pthtest_route_4dir[][2] = {
+   { 0, 1 }, { 0, 2 }, { 0, 3 }, { 0, 4 }, { 0, 5 },
+   { 1, 5 }, { 2, 5 }, { 2, 4 }, { 2, 3 }, { 2, 2 }
+};
+
+/* Only shortest route from (2, 2) to (4, 5) with 8-way movement. The wall at
+ * (4, 3) keeps it from cutting the corner from (4, 2) to (5, 3).
+ */
+static const uint16_t gc_pthtest_route_8dir[][2] = {
+   { 3, 2 }, { 4, 2 }, { 5, 2 }, { 5, 3 }, { 5, 4 }, { 4, 5 }
+};
+
+static int g_pthtest_failures = 0;
+
+#define pthtest_check( cond, desc ) \
+   if( !(cond) ) { \
+      error_printf( "check failed: %s", desc ); \
+      g_pthtest_failures++; \
+   }
+
+/* === */
+
+static MERROR_RETVAL pthtest_map_alloc(
+   MAUG_MHANDLE* p_t_h, struct MDATA_VECTOR* tile_defs
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROTILE* t = NULL;
+   struct RETROTILE_LAYER* layer = NULL;
+   struct RETROTILE_TILE_DEF tile_def;
+   ssize_t append_idx = 0;
+   size_t x = 0,
+      y = 0;
+
+   /* Tile def 0 is open and tile def 1 blocks. */
+   maug_mzero( &tile_def, sizeof( struct RETROTILE_TILE_DEF ) );
+   append_idx = mdata_vector_append(
+      tile_defs, &tile_def, sizeof( struct RETROTILE_TILE_DEF ) );
+   if( 0 > append_idx ) {
+      retval = merror_sz_to_retval( append_idx );
+      goto cleanup;
+   }
+   tile_def.flags = RETROTILE_TILE_FLAG_BLOCK;
+   append_idx = mdata_vector_append(
+      tile_defs, &tile_def, sizeof( struct RETROTILE_TILE_DEF ) );
+   if( 0 > append_idx ) {
+      retval = merror_sz_to_retval( append_idx );
+      goto cleanup;
+   }
+
+   retval = retrotile_alloc(
+      p_t_h, PTHTEST_W, PTHTEST_H, 1, "pthtest", "pthtest" );
+   maug_cleanup_if_not_ok();
+
+   maug_mlock( *p_t_h, t );
+   maug_cleanup_if_null_lock( struct RETROTILE*, t );
+
+   t->tileset_fgid = PTHTEST_TILE_OPEN;
+   layer = retrotile_get_layer_p( t, 0 );
+   for( y = 0 ; PTHTEST_H > y ; y++ ) {
+      for( x = 0 ; PTHTEST_W > x ; x++ ) {
+         retrotile_set_tile( t, layer, x, y,
+            '#' == gc_pthtest_map[y][x] ?
+               PTHTEST_TILE_BLOCK : PTHTEST_TILE_OPEN );
+      }
+   }
+
+cleanup:
+
+   if( NULL != t ) {
+      maug_munlock( *p_t_h, t );
+   }
+
+   return retval;
+}
+
+/* === */
+
+static void pthtest_check_flow(
+   struct RETROTILE_FLOW* flow, const int expect[PTHTEST_H][PTHTEST_W],
+   const char* desc
+) {
+   size_t x = 0,
+      y = 0;
+   retroflat_dir8_t dir = RETROFLAT_DIR8_NONE;
+   uint16_t dist = 0;
+
+   for( y = 0 ; PTHTEST_H > y ; y++ ) {
+      for( x = 0 ; PTHTEST_W > x ; x++ ) {
+         if( PTHTEST_SKIP == expect[y][x] ) {
+            continue;
+         }
+         dist = retrotile_flow_dist( flow, x, y );
+         if( expect[y][x] != dist ) {
+            error_printf( "%s: distance at " SIZE_T_FMT ", " SIZE_T_FMT
+               " is %u, expected %d", desc, x, y, dist, expect[y][x] );
+            g_pthtest_failures++;
+            continue;
+         }
+
+         /* Each step should lead one tile closer. */
+         dir = retrotile_flow_dir( flow, x, y );
+         if( 0 == dist ) {
+            pthtest_check( RETROFLAT_DIR8_NONE == dir, desc );
+            continue;
+         }
+         pthtest_check(
+            RETROFLAT_DIR8_NONE != dir &&
+            dist - 1 == expect
+               [y + gc_retroflat_offsets8_y[dir]]
+               [x + gc_retroflat_offsets8_x[dir]], desc );
+      }
+   }
+}
+
+/* === */
+
+static MERROR_RETVAL pthtest_flow(
+   struct RETROTILE* t, struct MDATA_VECTOR* tile_defs
+) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROTILE_FLOW flow;
+   struct RETROTILE_LAYER* layer = NULL;
+
+   maug_mzero( &flow, sizeof( struct RETROTILE_FLOW ) );
+
+   layer = retrotile_get_layer_p( t, 0 );
+
+   /* 4-way field, patched as a wall opens and closed again. */
+   retval = retrotile_flow_init( &flow, t, 0, tile_defs, 0, NULL, NULL );
+   maug_cleanup_if_not_ok();
+   retval = retrotile_flow_add_target( &flow, 2, 2 );
+   maug_cleanup_if_not_ok();
+   retval = retrotile_flow_update( &flow, t );
+   maug_cleanup_if_not_ok();
+   pthtest_check_flow( &flow, gc_pthtest_flow_4dir, "flow 4dir" );
+
+   retval = retrotile_flow_set_tile(
+      &flow, t, layer, 3, 1, PTHTEST_TILE_OPEN );
+   maug_cleanup_if_not_ok();
+   pthtest_check( 1 == flow.patches, "opening a tile is patched" );
+   retval = retrotile_flow_update( &flow, t );
+   maug_cleanup_if_not_ok();
+   pthtest_check( 1 == flow.rebuilds, "opening a tile doesn't rebuild" );
+   pthtest_check_flow( &flow, gc_pthtest_flow_4dir_open, "flow 4dir open" );
+
+   retval = retrotile_flow_set_tile(
+      &flow, t, layer, 3, 1, PTHTEST_TILE_BLOCK );
+   maug_cleanup_if_not_ok();
+   retval = retrotile_flow_update( &flow, t );
+   maug_cleanup_if_not_ok();
+   pthtest_check( 2 == flow.rebuilds, "closing a route rebuilds" );
+   pthtest_check_flow( &flow, gc_pthtest_flow_4dir, "flow 4dir closed" );
+
+   /* Tiles off the map are refused without touching the field. */
+   pthtest_check( MERROR_OVERFLOW == retrotile_flow_set_tile(
+      &flow, t, layer, PTHTEST_W, 0, PTHTEST_TILE_OPEN ),
+      "set_tile past right edge" );
+   pthtest_check( MERROR_OVERFLOW == retrotile_flow_set_tile(
+      &flow, t, layer, 0, PTHTEST_H, PTHTEST_TILE_OPEN ),
+      "set_tile past bottom edge" );
+   pthtest_check( MERROR_OVERFLOW == retrotile_flow_set_tile(
+      &flow, t, layer, -1, 0, PTHTEST_TILE_OPEN ),
+      "set_tile past left edge" );
+   pthtest_check(
+      RETROTILE_FLOW_FLAG_DIRTY != (RETROTILE_FLOW_FLAG_DIRTY & flow.flags),
+      "set_tile off the map leaves the field" );
+
+   retrotile_flow_free( &flow );
+
+   /* 8-way field. */
+   retval = retrotile_flow_init(
+      &flow, t, 0, tile_defs, RETROTILE_PATH_FLAG_8DIR, NULL, NULL );
+   maug_cleanup_if_not_ok();
+   retval = retrotile_flow_add_target( &flow, 2, 2 );
+   maug_cleanup_if_not_ok();
+   retval = retrotile_flow_update( &flow, t );
+   maug_cleanup_if_not_ok();
+   pthtest_check_flow( &flow, gc_pthtest_flow_8dir, "flow 8dir" );
+
+cleanup:
+
+   retrotile_flow_free( &flow );
+
+   return retval;
+}
+
+/* === */
+
+static RETROTILE_RETVAL pthtest_blocked(
+   uint16_t x, uint16_t y, uint8_t dir8, struct RETROTILE* t, void* data
+) {
+   struct RETROTILE_LAYER* layer = (struct RETROTILE_LAYER*)data;
+
+   if(
+      PTHTEST_TILE_BLOCK == retrotile_get_tile( t, layer,
+         x + gc_retroflat_offsets8_x[dir8], y + gc_retroflat_offsets8_y[dir8] )
+   ) {
+      return RETROTILE_RETVAL_BLOCKED;
+   }
+
+   return MERROR_OK;
+}
+
+/* === */
+
+static void pthtest_check_route(
+   struct RETROTILE_PATH_NODE* path, size_t path_sz,
+   const uint16_t expect[][2], size_t expect_sz,
+   retrotile_path_cost_t expect_g, const char* desc
+) {
+   size_t i = 0;
+
+   if( expect_sz != path_sz ) {
+      error_printf( "%s: path is " SIZE_T_FMT " steps, expected " SIZE_T_FMT,
+         desc, path_sz, expect_sz );
+      g_pthtest_failures++;
+      return;
+   }
+
+   for( i = 0 ; path_sz > i ; i++ ) {
+      if( expect[i][0] != path[i].x || expect[i][1] != path[i].y ) {
+         error_printf( "%s: step " SIZE_T_FMT " is %u, %u, expected %u, %u",
+            desc, i, path[i].x, path[i].y, expect[i][0], expect[i][1] );
+         g_pthtest_failures++;
+      }
+   }
+
+   pthtest_check( expect_g == path[path_sz - 1].g, desc );
+}
+
+/* === */
+
+static MERROR_RETVAL pthtest_astar( struct RETROTILE* t ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROTILE_PATH_POOL pool;
+   struct RETROTILE_PATH_NODE path[PTHTEST_W * PTHTEST_H];
+   size_t path_sz = 0;
+   struct RETROTILE_LAYER* layer = NULL;
+
+   maug_mzero( &pool, sizeof( struct RETROTILE_PATH_POOL ) );
+
+   layer = retrotile_get_layer_p( t, 0 );
+
+   retval = retrotile_path_pool_init( &pool, PTHTEST_W, PTHTEST_H );
+   maug_cleanup_if_not_ok();
+
+   /* The pool is reused between each of these. */
+   retval = retrotile_path_find( &pool, 0, 0, 2, 2,
+      path, &path_sz, PTHTEST_W * PTHTEST_H, t, 0, pthtest_blocked, layer );
+   maug_cleanup_if_not_ok();
+   pthtest_check_route( path, path_sz, gc_pthtest_route_4dir,
+      sizeof( gc_pthtest_route_4dir ) / sizeof( gc_pthtest_route_4dir[0] ),
+      10 * RETROTILE_PATH_COST_ORTHO, "astar 4dir" );
+
+   retval = retrotile_path_find( &pool, 2, 2, 4, 5,
+      path, &path_sz, PTHTEST_W * PTHTEST_H, t, RETROTILE_PATH_FLAG_8DIR,
+      pthtest_blocked, layer );
+   maug_cleanup_if_not_ok();
+   pthtest_check_route( path, path_sz, gc_pthtest_route_8dir,
+      sizeof( gc_pthtest_route_8dir ) / sizeof( gc_pthtest_route_8dir[0] ),
+      (5 * RETROTILE_PATH_COST_ORTHO) + RETROTILE_PATH_COST_DIAG,
+      "astar 8dir" );
+
+   /* Long paths are cut off after the first steps. */
+   retval = retrotile_path_find( &pool, 0, 0, 2, 2,
+      path, &path_sz, 3, t, 0, pthtest_blocked, layer );
+   maug_cleanup_if_not_ok();
+   pthtest_check_route( path, path_sz, gc_pthtest_route_4dir, 3,
+      3 * RETROTILE_PATH_COST_ORTHO, "astar truncated" );
+
+   /* A blocked target can't be reached. */
+   pthtest_check( RETROTILE_RETVAL_BLOCKED == retrotile_path_find(
+      &pool, 0, 0, 3, 3, path, &path_sz, PTHTEST_W * PTHTEST_H, t,
+      RETROTILE_PATH_FLAG_8DIR, pthtest_blocked, layer ),
+      "astar blocked target" );
+
+cleanup:
+
+   retrotile_path_pool_free( &pool );
+
+   return retval;
+}
+
+/* === */
+
+int main( int argc, char** argv ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   MAUG_MHANDLE t_h = (MAUG_MHANDLE)NULL;
+   struct RETROTILE* t = NULL;
+   struct MDATA_VECTOR tile_defs;
+
+   maug_mzero( &tile_defs, sizeof( struct MDATA_VECTOR ) );
+
+   retval = pthtest_map_alloc( &t_h, &tile_defs );
+   maug_cleanup_if_not_ok();
+
+   maug_mlock( t_h, t );
+   maug_cleanup_if_null_lock( struct RETROTILE*, t );
+
+   mdata_vector_lock( &tile_defs );
+
+   retval = pthtest_astar( t );
+   maug_cleanup_if_not_ok();
+
+   retval = pthtest_flow( t, &tile_defs );
+   maug_cleanup_if_not_ok();
+
+cleanup:
+
+   mdata_vector_unlock( &tile_defs );
+
+   if( NULL != t ) {
+      maug_munlock( t_h, t );
+   }
+
+   if( (MAUG_MHANDLE)NULL != t_h ) {
+      maug_mfree( t_h );
+   }
+
+   mdata_vector_free( &tile_defs );
+
+   if( MERROR_OK != retval ) {
+      error_printf( "pathfinding tests failed: %d", retval );
+   } else if( 0 < g_pthtest_failures ) {
+      error_printf( "%d pathfinding checks failed!", g_pthtest_failures );
+      retval = MERROR_EXEC;
+   } else {
+      printf( "all pathfinding checks passed\n" );
+   }
+
+   return retval;
+}
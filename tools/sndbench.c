@@ -0,0 +1,121 @@
+#define MAUG_C
+#include <maug.h>
+
+#include <time.h>
+
+/* Offline benchmark for the retrosnd software synthesizer: renders a few
+ * seconds of all channels playing into a WAV file without any audio hardware
+ * and reports how many samples per second the mixer managed.
+ */
+
+#define SNDBENCH_SECONDS_DEFAULT 10
+
+static void sndbench_setup_channels(
+   struct RETROSND_CHANNEL* channels, retroflat_ms_t now
+) {
+   int i = 0;
+
+   maug_mzero(
+      channels, sizeof( struct RETROSND_CHANNEL ) * RETROSND_CHANNEL_CT_MAX );
+
+   /* Spread voices and notes across every channel so they all get mixed. */
+   for( i = 0 ; RETROSND_CHANNEL_CT_MAX > i ; i++ ) {
+      channels[i].voice = i % 3;
+      channels[i].vol = 128;
+      channels[i].note = RETROSND_NOTES_START + ((i * 7) % RETROSND_NOTES_SZ);
+      if( RETROSND_TUNE_CHANNEL_CT <= i ) {
+         /* Effect channels cut off mid-block to exercise deadlines. */
+         channels[i].deadline = now + 250 + (i * 10);
+      }
+   }
+}
+
+/* === */
+
+int main( int argc, char** argv ) {
+   MERROR_RETVAL retval = MERROR_OK;
+   struct RETROSND_CHANNEL channels[RETROSND_CHANNEL_CT_MAX];
+   int16_t out[RETROSND_SAMPLES_CT];
+   uint8_t out_lsbf[RETROSND_SAMPLES_CT * sizeof( int16_t )];
+   maug_path wav_path;
+   mfile_t wav;
+   int i = 0;
+   uint32_t seconds = SNDBENCH_SECONDS_DEFAULT;
+   uint32_t samples_total = 0;
+   uint32_t samples_done = 0;
+   uint32_t restart_at = 0;
+   size_t block_ct = 0;
+   retroflat_ms_t now = 0;
+   clock_t render_clocks = 0;
+   clock_t start = 0;
+   double render_secs = 0;
+
+   maug_mzero( &wav, sizeof( mfile_t ) );
+   maug_mzero( wav_path, sizeof( maug_path ) );
+   maug_strncpy( wav_path, "sndbench.wav", MAUG_PATH_SZ_MAX - 1 );
+
+   for( i = 1 ; argc > i ; i++ ) {
+      if( 0 == strcmp( argv[i], "-s" ) && argc > i + 1 ) {
+         seconds = atoi( argv[++i] );
+      } else if( 0 == strcmp( argv[i], "-o" ) && argc > i + 1 ) {
+         maug_strncpy( wav_path, argv[++i], MAUG_PATH_SZ_MAX - 1 );
+      } else {
+         fprintf( stderr, "usage: %s [-s seconds] [-o out.wav]\n", argv[0] );
+         retval = MERROR_USR;
+         goto cleanup;
+      }
+   }
+
+   samples_total = seconds * RETROSND_SAMPLE_RATE;
+
+   retval = mfile_open_write( wav_path, &wav );
+   maug_cleanup_if_not_ok();
+
+   retval = _retrosnd_write_wav_hdr( &wav, samples_total );
+   maug_cleanup_if_not_ok();
+
+   while( samples_total > samples_done ) {
+      block_ct = samples_total - samples_done;
+      if( RETROSND_SAMPLES_CT < block_ct ) {
+         block_ct = RETROSND_SAMPLES_CT;
+      }
+
+      /* Time is simulated from the samples rendered so far, so deadlines land
+       * where they would in realtime playback.
+       */
+      now = ((samples_done / RETROSND_SAMPLE_RATE) * 1000) +
+         (((samples_done % RETROSND_SAMPLE_RATE) * 1000) /
+            RETROSND_SAMPLE_RATE);
+      if( restart_at <= samples_done ) {
+         /* Restart the notes every second so channels stay busy. */
+         sndbench_setup_channels( channels, now );
+         restart_at += RETROSND_SAMPLE_RATE;
+      }
+
+      start = clock();
+      _retrosnd_render_block( channels, now, out, block_ct );
+      render_clocks += clock() - start;
+
+      _retrosnd_pcm_lsbf( out, block_ct, out_lsbf );
+
+      retval = wav.write_block( &wav, out_lsbf, block_ct * sizeof( int16_t ) );
+      maug_cleanup_if_not_ok();
+
+      samples_done += block_ct;
+   }
+
+   render_secs = (double)render_clocks / CLOCKS_PER_SEC;
+   printf( "rendered " U32_FMT " samples on %d channels in %f seconds",
+      samples_done, RETROSND_CHANNEL_CT_MAX, render_secs );
+   if( 0 < render_secs ) {
+      printf( " (%.0f samples/sec)", samples_done / render_secs );
+   }
+   printf( "\n" );
+
+cleanup:
+
+   mfile_close( &wav );
+
+   return retval;
+}
+